@@ -15,6 +15,7 @@
 #include <se.editor.hpp>
 #include <imgui.h>
 #include "../addon/pass-postprocess/ex.pass.postprocess.hpp"
+#include "../addon/pass-lighting/ex.pass.lighting.hpp"
 
 namespace nb = nanobind;
 using namespace nb::literals;
@@ -291,6 +292,7 @@ NB_MODULE(pycore, m) {
     .value("COOPERATIVE_MATRIX", se::rhi::ContextExtensionEnum::COOPERATIVE_MATRIX)
     .value("CUDA_INTEROPERABILITY", se::rhi::ContextExtensionEnum::CUDA_INTEROPERABILITY)
     .value("USE_AFTERMATH", se::rhi::ContextExtensionEnum::USE_AFTERMATH)
+    .value("MULTIVIEW", se::rhi::ContextExtensionEnum::MULTIVIEW)
     .def("__or__", [](se::rhi::ContextExtensionEnum a, se::rhi::ContextExtensionEnum b) {
     return se::Flags<se::rhi::ContextExtensionEnum>(a | b);
       }, nb::is_operator());
@@ -737,7 +739,8 @@ NB_MODULE(pycore, m) {
     .def(nb::init<std::vector<se::rhi::RenderPassColorAttachment> const&>())
     .def(nb::init<std::vector<se::rhi::RenderPassColorAttachment> const&,
       se::rhi::RenderPassDepthStencilAttachment const&>())
-    .def_rw("maxDrawCount", &se::rhi::RenderPassDescriptor::maxDrawCount);
+    .def_rw("maxDrawCount", &se::rhi::RenderPassDescriptor::maxDrawCount)
+    .def_rw("viewMask", &se::rhi::RenderPassDescriptor::viewMask);
 
   nb::class_<se::rhi::CUDASemaphore> class_cudaSemaphore(ns_rhi, "CUDASemaphore");
   class_cudaSemaphore.def("signal", nb::overload_cast<uintptr_t>(&se::rhi::CUDASemaphore::signal))
@@ -805,7 +808,11 @@ NB_MODULE(pycore, m) {
   // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
   auto ns_gfx = nb::class_<::namespace_gfx>(m, "gfx");
 
-  auto gfx_buffer = nb::class_<se::gfx::Buffer>(ns_gfx, "Buffer");
+  auto gfx_buffer = nb::class_<se::gfx::Buffer>(ns_gfx, "Buffer")
+    .def_rw("resident_on_host", &se::gfx::Buffer::m_residentOnHost)
+    .def("host_bytes", &se::gfx::Buffer::host_bytes)
+    .def("device_bytes", &se::gfx::Buffer::device_bytes)
+    .def("release_host", &se::gfx::Buffer::release_host);
 
   nb::class_<se::gfx::Buffer::ConsumeEntry>(gfx_buffer, "ConsumeEntry")
     .def(nb::init<>())
@@ -874,16 +881,62 @@ NB_MODULE(pycore, m) {
     .def("binding_resource_medium_grid", &se::gfx::Scene::GPUScene::binding_resource_medium_grid)
     .def("binding_resource_camera", &se::gfx::Scene::GPUScene::binding_resource_camera);
 
+  nb::class_<se::gfx::Scene::View>(gfx_scene, "View")
+    .def(nb::init<>())
+    .def_rw("eye", &se::gfx::Scene::View::eye)
+    .def_rw("target", &se::gfx::Scene::View::target)
+    .def_rw("up", &se::gfx::Scene::View::up)
+    .def_rw("yfov", &se::gfx::Scene::View::yfov)
+    .def_rw("aspect_ratio", &se::gfx::Scene::View::aspectRatio)
+    .def_rw("znear", &se::gfx::Scene::View::znear)
+    .def_rw("zfar", &se::gfx::Scene::View::zfar)
+    .def_rw("height", &se::gfx::Scene::View::height);
+
+  nb::class_<se::gfx::Scene::LightClusterStats>(gfx_scene, "LightClusterStats")
+    .def_ro("clusters", &se::gfx::Scene::LightClusterStats::clusters)
+    .def_ro("occupied", &se::gfx::Scene::LightClusterStats::occupied)
+    .def_ro("overflowed", &se::gfx::Scene::LightClusterStats::overflowed)
+    .def_ro("max_lights", &se::gfx::Scene::LightClusterStats::maxLights)
+    .def_ro("average_lights", &se::gfx::Scene::LightClusterStats::averageLights)
+    .def_ro("average_occupied_lights", &se::gfx::Scene::LightClusterStats::averageOccupiedLights);
+
   nb::class_<se::gfx::SceneHandle>(ns_gfx, "SceneHandle")
     .def("update_scripts", [](se::gfx::SceneHandle& self) { return self->update_scripts(); })
     .def("update_transform", [](se::gfx::SceneHandle& self) { return self->update_transform(); })
     .def("update_gpu_scene", [](se::gfx::SceneHandle& self) { return self->update_gpu_scene(); })
+    .def("set_geometry_arena", [](se::gfx::SceneHandle& self, bool enabled) { self->m_geometryArena = enabled; })
+    .def("defragment_geometry", [](se::gfx::SceneHandle& self) { return self->defragment_geometry(); })
+    .def("stream_geometry", [](se::gfx::SceneHandle& self, std::string const& path) { return self->stream_geometry(path); })
+    .def("set_views", [](se::gfx::SceneHandle& self, std::vector<se::gfx::Scene::View> const& views) { self->set_views(views); })
+    .def("set_streaming_budget", [](se::gfx::SceneHandle& self, uint64_t bytes) { self->m_streamingConfig.budget = bytes; })
+    .def("set_light_clusters", [](se::gfx::SceneHandle& self, se::ivec3 grid, uint32_t capacity, float cutoff) {
+      self->m_lightClusterConfig = { se::uvec3(grid), capacity, cutoff }; }, nb::arg("grid"), nb::arg("capacity") = 64, nb::arg("cutoff") = 0.01f)
+    .def("light_cluster_lists", [](se::gfx::SceneHandle& self) { return self->cluster_lights_reference().lists; })
+    .def("check_light_clusters", [](se::gfx::SceneHandle& self) { return self->check_light_clusters(); })
+    .def("light_cluster_stats", [](se::gfx::SceneHandle& self) {
+      return se::gfx::Scene::light_cluster_stats(self->cluster_lights_reference()); })
     .def("load_gltf", [](se::gfx::SceneHandle& self, std::string const& path) { return self->load_gltf(path); })
+    .def("load_archive", [](se::gfx::SceneHandle& self, std::string const& path) { return self->load_archive(path); })
+    .def("save_cache", [](se::gfx::SceneHandle& self, std::string const& path) {
+      return self->save_cache(path); }, nb::arg("path"))
+    .def("load_cache", [](se::gfx::SceneHandle& self, std::string const& path) {
+      return self->load_cache(path); }, nb::arg("path"))
+    .def("save", [](se::gfx::SceneHandle& self, std::string const& path) { return self->save(path); })
+    .def("save_incremental", [](se::gfx::SceneHandle& self, std::string const& path, bool wait) {
+      auto saved = self->save_incremental(path);
+      return wait ? saved.get() : true; }, nb::arg("path"), nb::arg("wait") = false)
     .def("gpu_scene", [](se::gfx::SceneHandle& self) { return self->gpu_scene(); }, nb::rv_policy::reference)
     .def("draw_meshes", [](se::gfx::SceneHandle& self, se::rhi::RenderPassEncoder* encoder, int32_t geometryIDOffset)
       { return self->draw_meshes(encoder, geometryIDOffset); });
 
-  nb::class_<se::gfx::GFXContext>(ns_gfx, "GFXContext")
+  auto gfx_context = nb::class_<se::gfx::GFXContext>(ns_gfx, "GFXContext");
+
+  nb::class_<se::gfx::GFXContext::ResourceBytes>(gfx_context, "ResourceBytes")
+    .def_ro("name", &se::gfx::GFXContext::ResourceBytes::name)
+    .def_ro("host", &se::gfx::GFXContext::ResourceBytes::host)
+    .def_ro("device", &se::gfx::GFXContext::ResourceBytes::device);
+
+  gfx_context
     .def_static("initialize", &se::gfx::GFXContext::initialize,
       nb::arg("window").none() = nb::none(), nb::arg("ext") = 0)
     .def_static("device", &se::gfx::GFXContext::device, nb::rv_policy::reference)
@@ -898,11 +951,12 @@ NB_MODULE(pycore, m) {
       nb::arg("path"), nb::arg("entrypoints"), nb::arg("macros") =
       std::vector<std::pair<char const*, char const*>>{}, nb::arg("glsl_intermediate") = false,
       nb::rv_policy::reference)
-    .def_static("load_scene_gltf", &se::gfx::GFXContext::load_scene_gltf)
-    .def_static("load_scene_xml", &se::gfx::GFXContext::load_scene_xml)
-    .def_static("load_scene_pbrt", &se::gfx::GFXContext::load_scene_pbrt)
+    .def_static("load_scene_gltf", &se::gfx::GFXContext::load_scene_gltf, nb::arg("path"), nb::arg("cache") = false)
+    .def_static("load_scene_xml", &se::gfx::GFXContext::load_scene_xml, nb::arg("path"), nb::arg("cache") = false)
+    .def_static("load_scene_pbrt", &se::gfx::GFXContext::load_scene_pbrt, nb::arg("path"), nb::arg("cache") = false)
     .def_static("clean_texture_cache", &se::gfx::GFXContext::clean_texture_cache)
     .def_static("clean_cache", &se::gfx::GFXContext::clean_cache)
+    .def_static("report_buffer_bytes", &se::gfx::GFXContext::report_buffer_bytes)
     .def_static("frame_end", &se::gfx::GFXContext::frame_end)
     .def_static("finalize", &se::gfx::GFXContext::finalize);
 
@@ -939,6 +993,7 @@ NB_MODULE(pycore, m) {
     .def("with_size_relative", &se::rdg::TextureInfo::with_size_relative, nb::rv_policy::reference)
     .def("with_levels", &se::rdg::TextureInfo::with_levels, nb::rv_policy::reference)
     .def("with_layers", &se::rdg::TextureInfo::with_layers, nb::rv_policy::reference)
+    .def("with_view_layers", &se::rdg::TextureInfo::with_view_layers, nb::rv_policy::reference)
     .def("with_samples", &se::rdg::TextureInfo::with_samples, nb::rv_policy::reference)
     .def("with_format", &se::rdg::TextureInfo::with_format, nb::rv_policy::reference)
     .def("with_stages", &se::rdg::TextureInfo::with_stages, nb::rv_policy::reference)
@@ -1010,6 +1065,7 @@ NB_MODULE(pycore, m) {
      .def("update_binding_scene", &se::rdg::RenderPass::update_binding_scene)
      .def("update_bindings", &se::rdg::ComputePass::update_bindings)
      .def("begin_pass", &se::rdg::ComputePass::begin_pass, nb::rv_policy::reference)
+     .def("dispatch_views", &se::rdg::ComputePass::dispatch_views)
      .def("init", nb::overload_cast<std::string const&>(&se::rdg::ComputePass::init))
      .def("init", nb::overload_cast<se::gfx::ShaderModule*>(&se::rdg::ComputePass::init));
 
@@ -1026,6 +1082,7 @@ NB_MODULE(pycore, m) {
     .def("mark_output", &se::rdg::Graph::mark_output)
     .def("get_output", &se::rdg::Graph::get_output)
     .def("set_standard_size", &se::rdg::Graph::set_standard_size)
+    .def("set_view_count", &se::rdg::Graph::set_view_count)
     .def("render_ui", &se::rdg::Graph::render_ui)
     .def("get_render_data", &se::rdg::Graph::get_render_data, nb::rv_policy::reference)
     //.def("getBufferResource", &se::rdg::Graph::getBufferResource)
@@ -1034,6 +1091,7 @@ NB_MODULE(pycore, m) {
     //.def("getPass", static_cast<se::rdg::Pass* (se::rdg::Graph::*)(std::string const&)>(&se::rdg::Graph::getPass), nb::rv_policy::reference)
     .def("add_pass", &se::rdg::Graph::add_pass)
     .def("add_edge", &se::rdg::Graph::add_edge);
+  ns_rdg.def("view_mask", &se::rdg::view_mask);
 
   //py::class_<se::rdg::Pipeline, se::rdg::PyPipeline<>>(namespace_rdg, "Pipeline")
   //  .def(py::init<>())
@@ -1167,5 +1225,10 @@ NB_MODULE(pycore, m) {
       .def("reflect", &AccumulatePass::reflect)
       .def("execute", &AccumulatePass::execute)
       .def("render_ui", &AccumulatePass::update_bindings);
+    nb::class_<LightClusterPass, se::rdg::ComputePass>(ns_addon, "LightClusterPass")
+      .def(nb::init<>())
+      .def("reflect", &LightClusterPass::reflect)
+      .def("execute", &LightClusterPass::execute)
+      .def("render_ui", &LightClusterPass::render_ui);
 
 }
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "ex.pass.lighting.hpp"
+#include <se.editor.hpp>
+
+auto LightClusterPass::reflect(rdg::PassReflection& reflector) noexcept -> rdg::PassReflection {
+	// the cluster buffers belong to the scene, not to the graph
+	return reflector;
+}
+
+auto LightClusterPass::execute(
+	rdg::RenderContext* rdrCtx,
+	rdg::RenderData const& rdrDat
+) noexcept -> void {
+	m_scene = rdrDat.get_scene();
+	auto& clusters = m_scene->gpu_scene()->lightClusters;
+	// without point or spot lights the lists are cleared once, then left
+	if (!clusters.dispatch) return;
+	update_binding_scene(rdrCtx, m_scene);
+	update_bindings(rdrCtx, {
+		{ "se_light_cluster_grid", m_scene->gpu_scene()->binding_resource_light_cluster_grid() },
+		{ "se_light_cluster_spheres", m_scene->gpu_scene()->binding_resource_light_cluster_spheres() },
+		{ "se_light_cluster_lists", m_scene->gpu_scene()->binding_resource_light_cluster_lists() },
+		});
+
+	// the grid the scene clamped and wrote for this frame, not the raw config
+	uvec3 const dims = clusters.dims;
+	uint32_t const clusters = dims.x * dims.y * dims.z;
+	auto encoder = begin_pass(rdrCtx);
+	encoder->dispatch_workgroups((clusters + 63) / 64, 1, 1);
+	encoder->end();
+
+	// the lists are read by every shading stage after the pass
+	rdrCtx->cmdEncoder->pipeline_barrier(rhi::BarrierDescriptor{
+		rhi::PipelineStageEnum::COMPUTE_SHADER_BIT,
+		rhi::PipelineStageEnum::VERTEX_SHADER_BIT
+		| rhi::PipelineStageEnum::FRAGMENT_SHADER_BIT
+		| rhi::PipelineStageEnum::COMPUTE_SHADER_BIT, 0, {},
+		{ rhi::BufferMemoryBarrierDescriptor{
+			clusters.listBuffer->m_buffer.get(),
+			rhi::AccessFlagEnum::SHADER_WRITE_BIT,
+			rhi::AccessFlagEnum::SHADER_READ_BIT } }, {} });
+	clusters.listsEmpty = clusters.lightCount == 0;
+}
+
+auto LightClusterPass::render_ui() noexcept -> void {
+	if (m_scene.get() != nullptr) {
+		auto& config = m_scene->m_lightClusterConfig;
+		int grid[3] = { int(config.grid.x), int(config.grid.y), int(config.grid.z) };
+		if (ImGui::DragInt3("Grid", grid, 1, 1, 128))
+			config.grid = uvec3{ uint32_t(grid[0]), uint32_t(grid[1]), uint32_t(grid[2]) };
+		int capacity = int(config.capacity);
+		if (ImGui::DragInt("Capacity", &capacity, 1, 1, 1024))
+			config.capacity = uint32_t(capacity);
+		ImGui::DragFloat("Cutoff", &config.cutoff, 0.001f, 1e-5f, 1.f);
+		// binning on the host is slow, so only on request
+		if (ImGui::Button("Measure"))
+			m_stats = gfx::Scene::light_cluster_stats(m_scene->cluster_lights_reference());
+		ImGui::SameLine();
+		if (ImGui::Button("Check against host"))
+			m_mismatched = m_scene->check_light_clusters();
+	}
+	ImGui::Text("Occupied: %zu / %zu, overflowed %zu", m_stats.occupied, m_stats.clusters, m_stats.overflowed);
+	ImGui::Text("Lights per cluster: %.2f (occupied %.2f), max %u",
+		m_stats.averageLights, m_stats.averageOccupiedLights, m_stats.maxLights);
+	if (m_mismatched.has_value())
+		ImGui::Text("Clusters differing from the host: %zu", *m_mismatched);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "se.rdg.hpp"
+#include "../../source/se.editor.helper.hpp"
+
+using namespace se;
+
+// Bins the scene lights into the froxels of the main camera, raster
+// passes after it read the lists through scene_light_cluster_*.
+struct LightClusterPass : public rdg::ComputePass {
+	// initialize pass, by defining the shader
+	LightClusterPass() { init("./shaders/passes/light-clusters.slang"); }
+
+	virtual auto reflect(rdg::PassReflection& reflector) noexcept -> rdg::PassReflection;
+
+	virtual auto execute(
+		rdg::RenderContext* rdrCtx,
+		rdg::RenderData const& rdrDat
+	) noexcept -> void;
+
+	virtual auto render_ui() noexcept -> void;
+
+	gfx::SceneHandle m_scene;
+	gfx::Scene::LightClusterStats m_stats;
+	// result of the last check against the host reference
+	std::optional<size_t> m_mismatched;
+};
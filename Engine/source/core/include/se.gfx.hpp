@@ -6,6 +6,10 @@
 #include <tinygltf/tiny_gltf.h>
 #include <typeindex>
 #include <stack>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
 namespace ex = entt;
 
 namespace se {
@@ -34,9 +38,18 @@ namespace gfx {
     std::string m_job = "UNKNOWN";
     bool m_dirtyToGPU = true;
     bool m_dirtyToFile = false;
+    /** the pending GPU upload of a resource created off the main thread */
+    std::shared_future<void> m_upload;
 
     virtual ~IResource() = default;
     auto get_name() const noexcept -> std::string const& { return m_name; }
+    /** whether the device copy is usable, never blocks */
+    auto ready() const noexcept -> bool {
+      return !m_upload.valid() || m_upload.wait_for(std::chrono::seconds(0))
+        == std::future_status::ready; }
+    /** block until the upload is done, the upload runs at the main thread
+     * frame end, so this must not be called from the main thread */
+    auto wait_ready() const noexcept -> void { if (m_upload.valid()) m_upload.wait(); }
     virtual auto draw_gui(editor::IFragment* fragment) noexcept -> void {};
   };
 
@@ -132,6 +145,9 @@ namespace gfx {
     std::unique_ptr<rhi::Buffer> m_previous = nullptr; 
     /** the host resource of buffer */
     std::vector<std::byte> m_host;
+    /** keep the host copy after an upload, otherwise it is released once
+     * the device copy is current and read back again when needed */
+    bool m_residentOnHost = true;
     /** the stamps of the buffer update */
     size_t m_bufferStamp = 0; 
     size_t m_previousStamp = 0;
@@ -149,8 +165,19 @@ namespace gfx {
 
     /** lazy update host buffer to device */
     auto host_to_device() noexcept -> void;
+    /** upload only the given byte ranges, which must cover every host change
+     * since the last upload; falls back to host_to_device on a size change */
+    auto host_to_device_ranges(std::vector<std::pair<size_t, size_t>> const& ranges) noexcept -> void;
     /** lazy update host device to host */
     auto device_to_host() noexcept -> void;
+    /** read the device copy back into the host copy, the transfer is in
+     * flight until the returned future is waited */
+    auto device_to_host_async() noexcept -> std::future<void>;
+    /** drop the host copy of a buffer not resident on host, if the device is current */
+    auto release_host() noexcept -> void;
+    /** bytes held by the host copy and by the device buffers */
+    auto host_bytes() const noexcept -> size_t;
+    auto device_bytes() const noexcept -> size_t;
     /** create the device buffer if not exists */
     auto create_device() noexcept -> void;
     /** mapping local and device memory */
@@ -222,6 +249,7 @@ namespace gfx {
           m_buffer->m_host.resize(std::max(size_t(4) * sizeof(T), m_buffer->m_host.size() * 2));
       }
       std::memcpy(&m_buffer->m_host[idx * sizeof(T)], &value, sizeof(T));
+      m_buffer->m_hostStamp++;
       return idx;
     }
 
@@ -232,6 +260,7 @@ namespace gfx {
       if (m_size * sizeof(T) >= m_buffer->m_host.size())
         m_buffer->m_host.resize(std::max(m_size * sizeof(T), m_buffer->m_host.size() * 2));
       std::memcpy(&m_buffer->m_host[idx * sizeof(T)], value.data(), sizeof(T) * value.size());
+      m_buffer->m_hostStamp++;
       return idx;
     }
 
@@ -254,10 +283,103 @@ namespace gfx {
     }
   };
 
+  // Entity keyed map stored as a sparse set. Records live densely in
+  // insertion order and are found through the entity index, without
+  // hashing. Erasing moves the last record into the hole.
+  template <class T>
+  struct EntityMap {
+    using value_type = std::pair<ex::entity, T>;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+    static constexpr uint32_t null = uint32_t(-1);
+
+    std::vector<uint32_t> m_sparse;
+    std::vector<value_type> m_dense;
+
+    auto begin() noexcept -> iterator { return m_dense.begin(); }
+    auto end() noexcept -> iterator { return m_dense.end(); }
+    auto begin() const noexcept -> const_iterator { return m_dense.begin(); }
+    auto end() const noexcept -> const_iterator { return m_dense.end(); }
+    auto size() const noexcept -> size_t { return m_dense.size(); }
+    auto empty() const noexcept -> bool { return m_dense.empty(); }
+    auto clear() noexcept -> void { m_sparse.clear(); m_dense.clear(); }
+
+    auto slot(ex::entity entity) const noexcept -> uint32_t {
+      size_t const index = size_t(ex::to_entity(entity));
+      if (index >= m_sparse.size()) return null;
+      uint32_t const dense = m_sparse[index];
+      // a recycled entity has another version than the stored one
+      return (dense != null && m_dense[dense].first == entity) ? dense : null;
+    }
+    auto find(ex::entity entity) noexcept -> iterator {
+      uint32_t const dense = slot(entity);
+      return dense == null ? end() : m_dense.begin() + dense;
+    }
+    auto find(ex::entity entity) const noexcept -> const_iterator {
+      uint32_t const dense = slot(entity);
+      return dense == null ? end() : m_dense.begin() + dense;
+    }
+    auto contains(ex::entity entity) const noexcept -> bool { return slot(entity) != null; }
+
+    auto operator[](ex::entity entity) noexcept -> T& {
+      uint32_t dense = slot(entity);
+      if (dense == null) {
+        size_t const index = size_t(ex::to_entity(entity));
+        if (index >= m_sparse.size()) m_sparse.resize(std::max(index + 1, m_sparse.size() * 2), null);
+        dense = uint32_t(m_dense.size());
+        m_sparse[index] = dense;
+        m_dense.emplace_back(entity, T{});
+      }
+      return m_dense[dense].second;
+    }
+
+    auto erase(iterator iter) noexcept -> iterator {
+      size_t const dense = size_t(iter - m_dense.begin());
+      m_sparse[size_t(ex::to_entity(iter->first))] = null;
+      if (dense + 1 != m_dense.size()) {
+        m_dense[dense] = std::move(m_dense.back());
+        m_sparse[size_t(ex::to_entity(m_dense[dense].first))] = uint32_t(dense);
+      }
+      m_dense.pop_back();
+      return m_dense.begin() + dense;
+    }
+    auto erase(ex::entity entity) noexcept -> size_t {
+      auto iter = find(entity);
+      if (iter == end()) return 0;
+      erase(iter);
+      return 1;
+    }
+  };
+
+  // Suballocates byte ranges of one large buffer. Free ranges are kept
+  // sorted by offset and coalesced with their neighbours on release.
+  struct OffsetAllocator {
+    static constexpr uint64_t invalid = uint64_t(-1);
+    /** the offset and size of every free range */
+    std::map<uint64_t, uint64_t> m_free;
+    /** the size of every allocated range */
+    std::unordered_map<uint64_t, uint64_t> m_allocated;
+    uint64_t m_capacity = 0;
+    uint64_t m_used = 0;
+
+    /** first fit allocation, returns invalid if no free range is large enough */
+    auto allocate(uint64_t size, uint64_t alignment = 4) noexcept -> uint64_t;
+    /** release a range returned by allocate */
+    auto free(uint64_t offset) noexcept -> void;
+    /** extend the managed range, existing allocations keep their offsets */
+    auto grow(uint64_t capacity) noexcept -> void;
+    /** drop all allocations and manage a range of the given capacity */
+    auto reset(uint64_t capacity) noexcept -> void;
+    /** the size of the largest free range */
+    auto largest_free() const noexcept -> uint64_t;
+  };
+
   // Sampler, but gfx resource.
   // ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
   struct Sampler : public IResource {
     std::unique_ptr<rhi::Sampler> m_sampler = nullptr;
+    /** the description the sampler was created from */
+    rhi::SamplerDescriptor m_desc;
   };
   // The handle of sampler
   using SamplerHandle = ResourceHandle<Sampler>;
@@ -277,6 +399,18 @@ namespace gfx {
   // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
   // Texture, but gfx resource.
   // ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+  /** 128-bit hash of decoded texels, textures with equal hashes are merged,
+   * so it has to be wide enough that distinct images never meet */
+  struct TextureContentHash {
+    uint64_t lo = 0, hi = 0;
+    explicit operator bool() const noexcept { return (lo | hi) != 0; }
+    auto operator==(TextureContentHash const& h) const noexcept -> bool { return lo == h.lo && hi == h.hi; }
+    auto operator!=(TextureContentHash const& h) const noexcept -> bool { return !(*this == h); }
+    struct Hasher {
+      auto operator()(TextureContentHash const& h) const noexcept -> size_t { return size_t(h.lo); }
+    };
+  };
+
   struct Texture : public IResource {
     // Definition to describe how a texture is consumed by a pass
     // ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
@@ -405,6 +539,8 @@ namespace gfx {
     std::unique_ptr<rhi::Texture> m_texture = nullptr;
     /** path string */
     std::optional<std::string> m_resourcePath;
+    /** hash of the decoded texels and their layout, zero if not decoded from an image */
+    TextureContentHash m_contentHash;
     /** differentiable attributes */
     uint32_t m_differentiable_channels = 0u;
     /** the state machine of current texture */
@@ -450,11 +586,13 @@ namespace gfx {
   struct TextureLoader {
     using result_type = std::shared_ptr<Texture>;
 
+    struct from_empty_tag {};
     struct from_desc_tag {};
     struct from_file_tag {};
     struct from_binary_tag {};
     struct from_desc_buf_tag {};
 
+    result_type operator()(from_empty_tag);
     result_type operator()(from_desc_tag, rhi::TextureDescriptor const& desc);
     result_type operator()(from_file_tag, std::string const& path);
     result_type operator()(from_binary_tag, int width, int height, int channel, int bits, const char* data);
@@ -690,7 +828,43 @@ namespace gfx {
   // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
   // ┃ resource :: mesh                                                          ┃
   // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+  /** Storage encodings of the mesh payloads, with no bit set the buffers hold
+   * the float layout of MeshDataLayout. Decoded by scene_read_* in shaders. */
+  enum struct MeshEncodingEnum : uint32_t {
+    POSITION_SNORM16 = 1 << 0, // xyz snorm16 relative to the primitive bounds
+    NORMAL_OCT16     = 1 << 1, // octahedral snorm16x2
+    TANGENT_OCT16    = 1 << 2, // octahedral snorm16x2
+    TEXCOORD_FLOAT16 = 1 << 3,
+    TEXCOORD_UNORM16 = 1 << 4,
+    INDEX_UINT16     = 1 << 5,
+  };
+  ENABLE_BITMASK_OPERATORS(MeshEncodingEnum);
+
+  struct GeometryStore;
+  struct GeometryStreamer;
+  struct SceneArchive;
+
   struct Mesh : public IResource {
+    /** A cluster of a primitive with bounded vertex and triangle counts */
+    struct Meshlet {
+      uint32_t vertexOffset;   // first entry in MeshPrimitive::meshletVertices
+      uint32_t triangleOffset; // first byte in MeshPrimitive::meshletTriangles
+      uint32_t vertexCount;
+      uint32_t triangleCount;
+      vec3 center; float radius;
+      // the cluster is backfacing for every view with
+      // dot(normalize(coneApex - eye), coneAxis) >= coneCutoff
+      vec3 coneApex;
+      vec3 coneAxis; float coneCutoff;
+    };
+
+    /** A simplified index range of a primitive, sharing its vertices */
+    struct LOD {
+      size_t offset;  // first index in the index buffer
+      size_t size;    // number of indices
+      float error;    // object space deviation from the full detail surface
+    };
+
     struct MeshPrimitive {
       size_t offset;
       size_t size;
@@ -700,6 +874,13 @@ namespace gfx {
       MediumHandle exterior;
       MediumHandle interior;
       vec3 max, min;
+      // meshlets built at import, vertices are relative to baseVertex
+      // and every triangle is three bytes indexing the meshlet vertices
+      std::vector<Meshlet> meshlets;
+      std::vector<uint32_t> meshletVertices;
+      std::vector<uint8_t> meshletTriangles;
+      // lod chain built at import, from fine to coarse
+      std::vector<LOD> lods;
       rhi::BLASDescriptor blasDesc;
       rhi::BLASDescriptor uvblasDesc;
       // blas for ray tracing the geometry
@@ -733,6 +914,40 @@ namespace gfx {
     BufferHandle m_indexBuffer;
     std::vector<MeshPrimitive> m_primitives;
     std::vector<CustomPrimitive> m_customPrimitives;
+    /** content hash of the payload assigned at import, 0 if unknown */
+    uint64_t m_contentHash = 0;
+    /** storage encoding of the buffers */
+    Flags<MeshEncodingEnum> m_encoding = 0;
+    /** out-of-core payload set by Scene::stream_geometry, the chunk holding
+     * it on disk and the coarse stand-in drawn while it is not resident */
+    struct Streaming {
+      std::shared_ptr<GeometryStore> store;
+      int32_t chunk = -1;
+      bool resident = true;
+      ResourceHandle<Mesh> proxy;
+    } m_streaming;
+
+    /** the mesh the scene draws, the proxy while the payload is on disk */
+    auto drawn() noexcept -> Mesh* {
+      return m_streaming.resident || m_streaming.proxy.get() == nullptr
+        ? this : m_streaming.proxy.get(); }
+
+    /** stride of a vertex in the vertex buffer, in 32-bit words */
+    auto vertex_stride() const noexcept -> uint32_t;
+    static auto vertex_stride(Flags<MeshEncodingEnum> encoding) noexcept -> uint32_t;
+    /** center and half extent the SNORM16 positions of a primitive are relative to */
+    static auto position_frame(MeshPrimitive const& primitive) noexcept -> std::pair<vec3, vec3>;
+    /** wait for the device buffers created off the main thread */
+    auto wait_buffers() noexcept -> void;
+    /** read back the buffers whose host copy was released, all at once,
+     * from the geometry store if the payload is not on device */
+    auto fetch_host() noexcept -> void;
+    /** release the host copies again, only for buffers not resident on host */
+    auto release_host() noexcept -> void;
+    /** decode from the host copies of the buffers, vertices include baseVertex */
+    auto host_index(size_t index) noexcept -> uint32_t;
+    auto host_position(MeshPrimitive const& primitive, size_t vertex) noexcept -> vec3;
+    auto host_normal(size_t vertex) noexcept -> vec3;
 
     virtual auto draw_gui(editor::IFragment* fragment) noexcept -> void override;
   };
@@ -766,6 +981,11 @@ namespace gfx {
     auto get_component() const -> T* { return m_registry->try_get<T>(m_entity); }
     template<class T>
     auto remove_component() -> void { m_registry->remove<T>(m_entity); }
+    /** flag a component for the next gpu update, writes to the flag
+     * alone are not seen by the change lists of the scene */
+    template<class T>
+    auto mark_dirty_to_gpu() -> void {
+      m_registry->patch<T>(m_entity, [](T& component) { component.m_dirtyToGPU = true; }); }
   };
 
   struct Scene;
@@ -774,16 +994,44 @@ namespace gfx {
     std::vector<Node> nodes;
   };
 
+  /** What an incremental save keeps between saves: the archive and the
+   * payload chunks of the meshes with the buffers they were taken from */
+  struct IncrementalSaveState {
+    struct MeshRecord {
+      std::string chunk;
+      std::array<BufferHandle, 3> buffers;
+      std::array<size_t, 3> stamps;
+      std::array<uint64_t, 3> sizes;
+      bool seen = false;
+    };
+    std::string path;
+    std::shared_ptr<SceneArchive> archive;
+    std::unordered_map<Mesh*, MeshRecord> meshes;
+    uint64_t materialHash = 0;
+    uint64_t nextChunk = 0;
+    std::shared_future<bool> pending;
+
+    /** the mesh has no chunk yet or its buffers changed since it was taken */
+    auto changed(Mesh& mesh) noexcept -> bool;
+  };
+
   struct SerializeData {
     tinygltf::Model* model;
     gfx::Scene* gfx_scene;
     std::unordered_map<ex::entity, int32_t> nodes;
     std::unordered_map<ex::entity, int32_t> lights;
     std::unordered_map<Material*, int32_t> m_materials;
+    std::unordered_map<Mesh*, int32_t> m_meshes;
+    /** set by incremental saves, mesh buffers then name archive chunks
+     * and only the payloads changed since the last save are copied */
+    IncrementalSaveState* incremental = nullptr;
+    std::vector<std::pair<std::string, std::vector<std::byte>>> chunks;
     auto add_buffer(
       std::vector<std::byte> const& data,
       std::string const& name
     ) noexcept -> int32_t;
+    /** the position, index and vertex buffers of a mesh in the float layout */
+    auto add_mesh_buffers(Mesh& mesh) noexcept -> std::array<int32_t, 3>;
     auto add_view_accessor(
       tinygltf::BufferView bufferView,
       tinygltf::Accessor accessor
@@ -815,6 +1063,7 @@ namespace gfx {
       component_dirty dirtyToGPU;
       component_dirty dirtyToFile;
       bool couldRemove;
+      component_node touch;
     };
 
     std::map<int32_t, ComponentDictionary> m_components;
@@ -837,8 +1086,9 @@ namespace gfx {
       component_deserialize deserialize = [](DeserializeData& data) -> void { T::deserialize(data); };
       component_dirty dirtyToGPU = [](void* component) -> bool { return ((T*)component)->is_dirty_to_gpu(); };
       component_dirty dirtyToFile = [](void* component) -> bool { return ((T*)component)->is_dirty_to_file(); };
+      component_node touch = [](Node& node) -> void { node.m_registry->patch<T>(node.m_entity); };
       Singleton<ComponentManager>::instance()->m_components[i] = ComponentDictionary{
-        display, retrival, draw, add, remove, serialize, deserialize, dirtyToGPU, dirtyToFile, could_remove
+        display, retrival, draw, add, remove, serialize, deserialize, dirtyToGPU, dirtyToFile, could_remove, touch
       };
     }
 
@@ -853,6 +1103,7 @@ namespace gfx {
     std::string name;
     std::vector<Node> children;
     bool m_dirtyToFile;
+    ex::entity parent = ex::null;
 
     static auto draw_component(void* component) noexcept -> void;
     static auto serialize(SerializeData& data) noexcept -> void;
@@ -889,8 +1140,16 @@ namespace gfx {
     MeshHandle m_mesh;
     std::vector<rhi::BLASInstance> m_blasInstance;
     std::optional<std::vector<rhi::BLASInstance>> m_uvblasInstance;
+    /** per-instance object transforms, applied as global * instance;
+     * empty means the mesh is drawn once with the node transform */
+    std::vector<se::mat4> m_instances;
     bool m_dirtyToFile; bool m_dirtyToGPU;
 
+    auto instance_count() const noexcept -> uint32_t {
+      return m_instances.empty() ? 1 : uint32_t(m_instances.size()); }
+    auto instance_transform(se::mat4 const& global, uint32_t i) const noexcept -> se::mat4 {
+      return m_instances.empty() ? global : global * m_instances[i]; }
+
     static auto draw_component(void* component) noexcept -> void;
     static auto serialize(SerializeData& data) noexcept -> void;
     static auto deserialize(DeserializeData& data) noexcept -> void {};
@@ -898,21 +1157,46 @@ namespace gfx {
     auto is_dirty_to_file() noexcept -> bool { return m_dirtyToFile; }
   };
 
-  /** mesh / geometry draw call data */
+  enum struct GeometryFlagEnum : uint16_t {
+    ODD_NEGATIVE_SCALING = 1 << 0,
+    // rotation and uniform scale, the inverse is the scaled transpose
+    SIMILARITY_TRANSFORM = 1 << 1,
+  };
+  ENABLE_BITMASK_OPERATORS(GeometryFlagEnum);
+
+  /** mesh / geometry draw call data,
+   * instances of one primitive occupy a consecutive range of records.
+   * Only the 3x4 object to world transform is stored, shaders derive the
+   * inverse and the normal matrix, see GeometryData in spt-definition.slang */
   struct GeometryDrawData {
     uint32_t vertexOffset;
     uint32_t indexOffset;
-    int materialID = -1;
     uint32_t indexSize;
+    int32_t lightID;
+    int16_t materialID = -1;
     int16_t mediumIDExterior = -1;
     int16_t mediumIDInterior = -1;
-    int16_t primitiveType;
     int16_t meshID;
-    int32_t lightID;
-    float oddNegativeScaling;
+    int16_t primitiveType;
+    uint16_t flags = 0;     // GeometryFlagEnum
+    uint16_t encoding = 0;  // MeshEncodingEnum of the mesh
+    uint16_t lod = 0;       // lod selected for raster draws, 0 is full detail
     rhi::AffineTransformMatrix geometryTransform = {};
-    rhi::AffineTransformMatrix geometryTransformInverse = {};
+    // the frame of SNORM16 positions, and the index range of the lod
+    vec3 positionCenter = { 0.f, 0.f, 0.f };
+    uint32_t lodIndexOffset;
+    vec3 positionExtent = { 1.f, 1.f, 1.f };
+    uint32_t lodIndexSize;
+    // word offsets of the payload in the geometry arena, zero otherwise
+    uint32_t positionBase = 0;
+    uint32_t vertexBase = 0;
+    uint32_t indexBase = 0;
+    uint32_t padding = 0;
+
+    auto odd_negative_scaling() const noexcept -> float {
+      return (flags & uint16_t(GeometryFlagEnum::ODD_NEGATIVE_SCALING)) ? -1.f : 1.f; }
   };
+  static_assert(sizeof(GeometryDrawData) == 128, "GeometryDrawData must match GeometryData in spt-definition.slang");
 
   // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
   // ┃ component :: camera                                                       ┃
@@ -977,6 +1261,7 @@ namespace gfx {
     se::vec2 clipToWindowBias;
     CameraData() = default;
     CameraData(gfx::Camera const& camera, gfx::Transform const& transform);
+    CameraData(gfx::Camera const& camera, se::vec3 eye, se::vec3 target, se::vec3 up);
   };
 
   // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
@@ -1115,7 +1400,105 @@ namespace gfx {
     std::vector<Node> m_roots;
     std::string m_name;
     std::string m_filepath;
+    /** the files the loaders read, the scene description first; textures
+     * are known by their resource paths, a .sescene cache is keyed by both */
+    std::vector<std::string> m_sourceFiles;
     se::timer m_timer;
+    /** projected error in pixels a raster lod may have, negative disables lods */
+    float m_lodPixelError = 1.f;
+    /** suballocate mesh payloads from the shared buffers of the geometry
+     * arena instead of binding one buffer per mesh, set before the first update */
+    bool m_geometryArena = false;
+    /** residency of streamed geometry, see stream_geometry */
+    struct StreamingConfig {
+      /** device bytes the full payloads may take */
+      uint64_t budget = 1ull << 30;
+      /** payload reads in flight */
+      uint32_t maxLoads = 4;
+      /** projected radius in pixels below which a mesh keeps its proxy */
+      float minPixels = 4.f;
+    } m_streamingConfig;
+    struct StreamingStats {
+      size_t chunks = 0;
+      size_t resident = 0;
+      size_t loading = 0;
+      uint64_t residentBytes = 0;
+      uint64_t storedBytes = 0;
+    };
+
+    /** a view of the multiview passes, a pose seen through a lens */
+    struct View {
+      vec3 eye;
+      vec3 target;
+      vec3 up = { 0.f, 1.f, 0.f };
+      float yfov = 45.f;
+      float aspectRatio = 1.f;
+      float znear = 0.1f, zfar = 10000.f;
+      // pixel rows of the target, for lods and streaming
+      uint32_t height = 1080;
+
+      auto camera_data() const noexcept -> CameraData;
+    };
+    /** views rendered by one pass, view i reads scene_read_view(i) and
+     * writes layer i of the targets, see set_views */
+    std::vector<View> m_views;
+    bool m_viewsDirty = false;
+
+    /** a view as lods and streaming measure it, the camera the shaders
+     * read as scene_read_camera(0) or each of m_views */
+    struct ViewMetrics {
+      vec3 eye;
+      // world size of a pixel at unit distance, or at any distance if orthographic
+      float pixelSize;
+      float znear;
+      bool perspective;
+
+      auto operator==(ViewMetrics const& other) const noexcept -> bool {
+        return eye == other.eye && pixelSize == other.pixelSize
+          && znear == other.znear && perspective == other.perspective; }
+      auto operator!=(ViewMetrics const& other) const noexcept -> bool { return !(*this == other); }
+    };
+
+    /** froxels of the main camera the lights are binned into, tiles over
+     * the screen times slices growing exponentially from znear to zfar */
+    struct LightClusterConfig {
+      uvec3 grid = { 16, 9, 24 };
+      /** light indices a cluster holds, more are dropped */
+      uint32_t capacity = 64;
+      /** irradiance below which a light no longer reaches a cluster */
+      float cutoff = 0.01f;
+    } m_lightClusterConfig;
+    /** the grid as the shaders read it, matches LightClusterGrid in spt-definition.slang */
+    struct LightClusterGrid {
+      uvec3 dims;
+      uint32_t capacity;
+      float znear;
+      float zfar;
+      float cutoff;
+      uint32_t lightCount;
+    };
+    /** the sphere a light reaches, matches LightClusterSphere in spt-definition.slang */
+    struct LightClusterSphere {
+      vec3 center;
+      float radius;
+      int32_t lightID;
+      int32_t padding[3];
+    };
+    /** per cluster a count followed by capacity light indices, the layout
+     * of the lists the cluster pass writes */
+    struct LightClusters {
+      LightClusterGrid grid;
+      std::vector<uint32_t> lists;
+    };
+    struct LightClusterStats {
+      size_t clusters = 0;
+      size_t occupied = 0;
+      // clusters reached by more lights than they hold
+      size_t overflowed = 0;
+      uint32_t maxLights = 0;
+      float averageLights = 0.f;
+      float averageOccupiedLights = 0.f;
+    };
 
     struct IndexInfo {
       int32_t assignedIndex;
@@ -1123,27 +1506,112 @@ namespace gfx {
       int32_t length = 1;
     };
 
+    /** entities whose component was created, updated or destroyed since the
+     * last gpu update, fed by the signals of the registry so that the update
+     * stages only visit what changed */
+    struct ChangeList {
+      enum : uint8_t { CREATED = 1 << 0, UPDATED = 1 << 1, DESTROYED = 1 << 2 };
+      EntityMap<uint8_t> entries;
+
+      auto record(ex::entity entity, uint8_t change) noexcept -> void { entries[entity] |= change; }
+      auto on_construct(ex::registry&, ex::entity entity) noexcept -> void { record(entity, CREATED); }
+      auto on_update(ex::registry&, ex::entity entity) noexcept -> void { record(entity, UPDATED); }
+      auto on_destroy(ex::registry&, ex::entity entity) noexcept -> void { record(entity, DESTROYED); }
+    };
+    struct Changes {
+      ChangeList transforms;
+      ChangeList renderers;
+      ChangeList lights;
+      ChangeList cameras;
+
+      auto clear() noexcept -> void {
+        transforms.entries.clear(); renderers.entries.clear();
+        lights.entries.clear(); cameras.entries.clear(); }
+    } m_changes;
+    /** entities touched since the last incremental save, the flags the
+     * editor sets without a patch are checked besides */
+    ChangeList m_fileChanges;
+    IncrementalSaveState m_incrementalSave;
+
     struct GPUScene {
       DynamicVectorBufferView<uint64_t> positionBuffer;
       DynamicVectorBufferView<uint64_t> indexBuffer;
       DynamicVectorBufferView<uint64_t> vertexBuffer;
       std::unordered_map<gfx::Mesh*, IndexInfo> meshList;
+      // heartbeat of the mesh update, meshes not seen in it are released
+      int32_t meshHeartBeat = 0;
+
+      /** mesh payloads suballocated from three shared buffers, the address
+       * tables then hold a single entry and the geometry records the offsets */
+      struct GeometryArena {
+        struct Pool {
+          std::unique_ptr<rhi::Buffer> buffer;
+          OffsetAllocator allocator;
+          Flags<rhi::BufferUsageEnum> usages = 0;
+          char const* job = "";
+
+          auto address() noexcept -> uint64_t;
+        } positions, indices, vertices;
+
+        // byte offsets of a payload, shared by meshes with the same buffers
+        struct Allocation {
+          BufferHandle payload;
+          uint64_t position;
+          uint64_t index;
+          uint64_t vertex;
+          int32_t users = 0;
+        };
+        std::unordered_map<gfx::Buffer*, Allocation> allocations;
+        std::unordered_map<gfx::Mesh*, gfx::Buffer*> meshes;
+
+        // copies into the pools, recorded on insert and submitted at once
+        struct PendingCopy {
+          BufferHandle source;
+          Pool* pool;
+          uint64_t offset;
+          uint64_t size;
+        };
+        std::vector<PendingCopy> pending;
+        bool released = false;
+
+        /** allocate the payload of a mesh, the copy is deferred to flush */
+        auto insert(Mesh* mesh) noexcept -> void;
+        /** release the ranges of a mesh no longer referenced by the scene */
+        auto remove(Mesh* mesh) noexcept -> void;
+        /** the offsets of a registered mesh */
+        auto find(Mesh* mesh) const noexcept -> Allocation const*;
+        /** submit the pending copies, drops the device copies of uploaded meshes */
+        auto flush() noexcept -> void;
+        /** repack all live ranges to the front of right-sized pools */
+        auto defragment() noexcept -> void;
+        /** allocated and reserved bytes of the three pools */
+        auto used_bytes() const noexcept -> uint64_t;
+        auto capacity_bytes() const noexcept -> uint64_t;
+      } geometryArena;
 
       DynamicVectorBufferView<CameraData> cameraBuffer;
-      std::unordered_map<ex::entity, IndexInfo> cameraList;
+      EntityMap<IndexInfo> cameraList;
+      // the cameras of m_views, in view order
+      DynamicVectorBufferView<CameraData> viewBuffer;
 
       DynamicVectorBufferView<GeometryDrawData> geometryBuffer;
-      std::unordered_map<ex::entity, std::vector<IndexInfo>> geometryList;
+      EntityMap<std::vector<IndexInfo>> geometryList;
 
       DynamicVectorBufferView<Material::MaterialPacket> materialBuffer;
       std::unordered_map<gfx::Material*, IndexInfo> materialList;
+      // packets interned by content, materials with equal packets share a record
+      std::unordered_multimap<uint64_t, int32_t> materialPackets;
+      std::vector<int32_t> materialUsers;
+      // the renderers whose geometry records name a material, entries
+      // of renderers that dropped it are pruned when it is next patched
+      std::unordered_map<gfx::Material*, std::unordered_set<ex::entity>> materialRenderers;
 
       DynamicVectorBufferView<LightData> lightBuffer;
-      std::unordered_map<ex::entity, std::vector<IndexInfo>> lightList;
+      EntityMap<std::vector<IndexInfo>> lightList;
 
       struct TLAS {
         rhi::TLASDescriptor desc = {};
-        std::unordered_map<ex::entity, std::vector<IndexInfo>> instanceList;
+        EntityMap<std::vector<IndexInfo>> instanceList;
 
         std::unique_ptr<rhi::TLAS> prim = nullptr;
         std::unique_ptr<rhi::TLAS> back = nullptr;
@@ -1156,8 +1624,29 @@ namespace gfx {
         bounds3 allLightBounds;
       } lightSampler;
 
+      // lights binned into the froxels of the main camera by the cluster pass
+      struct LightClusterBuffers {
+        BufferHandle gridBuffer;
+        BufferHandle sphereBuffer;
+        BufferHandle listBuffer;
+        uint32_t sphereCount = 0;
+        size_t lightStamp = size_t(-1);
+        // the clamped grid written to gridBuffer this frame, the pass dispatches over it
+        uvec3 dims = { 1, 1, 1 };
+        // lights binned this frame, none unless the scene has point or spot lights
+        uint32_t lightCount = 0;
+        bool punctual = false;
+        // whether the pass runs this frame; over no lights it only clears
+        // the lists, which is done once
+        bool dispatch = true;
+        bool listsEmpty = false;
+      } lightClusters;
+
       struct ImagePool {
         std::unordered_map<UID, std::pair<int, TextureHandle>> texture_loc_index;
+        // textures sharing a view share its bindless slot
+        std::unordered_map<rhi::TextureView*, int> view_loc_index;
+        SamplerHandle sampler;
         std::vector<rhi::TextureView*> prim_t;
         std::vector<rhi::TextureView*> back_t;
         std::vector<rhi::Sampler*> prim_s;
@@ -1174,6 +1663,16 @@ namespace gfx {
         auto try_fetch_index(MediumHandle media) noexcept -> int;
       } mediumPool;
 
+      // residency of the streamed meshes, null until stream_geometry
+      std::shared_ptr<GeometryStreamer> streamer;
+
+      // the views the lods were last selected for
+      struct LodView {
+        std::vector<ViewMetrics> views;
+        float pixelError = 0.f;
+        bool valid = false;
+      } lodView;
+
       struct SceneData {
         vec3 light_bounds_min;
         int nondistant_light_count = 0;
@@ -1191,6 +1690,7 @@ namespace gfx {
       auto binding_resource_index() noexcept -> rhi::BindingResource;
       auto binding_resource_vertex() noexcept -> rhi::BindingResource;
       auto binding_resource_camera() noexcept -> rhi::BindingResource;
+      auto binding_resource_view() noexcept -> rhi::BindingResource;
       auto binding_resource_geometry() noexcept -> rhi::BindingResource;
       auto binding_resource_material() noexcept -> rhi::BindingResource;
       auto binding_resource_textures() noexcept -> rhi::BindingResource;
@@ -1198,6 +1698,9 @@ namespace gfx {
       auto binding_resource_sceneinfo() noexcept -> rhi::BindingResource;
       auto binding_resource_lightbvh_tree() noexcept -> rhi::BindingResource;
       auto binding_resource_lightbvh_trail() noexcept -> rhi::BindingResource;
+      auto binding_resource_light_cluster_grid() noexcept -> rhi::BindingResource;
+      auto binding_resource_light_cluster_spheres() noexcept -> rhi::BindingResource;
+      auto binding_resource_light_cluster_lists() noexcept -> rhi::BindingResource;
       auto binding_resource_tlas() noexcept -> rhi::BindingResource;
       auto binding_resource_medium() noexcept -> rhi::BindingResource;
       auto binding_resource_medium_grid() noexcept -> rhi::BindingResource;
@@ -1208,12 +1711,44 @@ namespace gfx {
     auto update_scripts() noexcept -> void;
     auto update_transform() noexcept -> void;
     auto update_gpu_scene() noexcept -> void;
+    auto update_gpu_materials() noexcept -> void;
     auto update_gpu_meshes() noexcept -> void;
     auto update_gpu_camera() noexcept -> void;
+    auto update_gpu_views() noexcept -> void;
     auto update_gpu_lights() noexcept -> void;
     auto update_gpu_medium() noexcept -> void;
     auto update_gpu_lightbvh() noexcept -> void;
+    auto update_gpu_light_clusters() noexcept -> void;
     auto update_gpu_bvh() noexcept -> void;
+    auto update_gpu_lods() noexcept -> void;
+    auto update_gpu_streaming() noexcept -> void;
+    /** the views a frame renders, empty without a camera */
+    auto view_metrics() noexcept -> std::vector<ViewMetrics>;
+    /** pixels per object space unit of a bounding sphere, the largest over
+     * the instances of the renderer and the views */
+    static auto pixel_scale(std::vector<ViewMetrics> const& views, Transform const& transform,
+      MeshRenderer const& renderer, vec3 center, float radius) noexcept -> float;
+    /** render the scene from all views at once; scene upload, lods and
+     * streaming are shared by the views */
+    auto set_views(std::vector<View> const& views) noexcept -> void;
+    /** move the payloads of the scene meshes into a chunked store at path,
+     * drawing a coarse proxy of each until the streamer makes it resident
+     * again within m_streamingConfig; emitters and custom primitives stay */
+    auto stream_geometry(std::string const& path) noexcept -> bool;
+    auto streaming_stats() const noexcept -> StreamingStats;
+    /** the spheres the lights reach, in light buffer order */
+    auto light_cluster_spheres() noexcept -> std::vector<LightClusterSphere>;
+    /** bin the lights on the host as the cluster pass does on the device,
+     * for the camera the shaders read as scene_read_camera(0) */
+    auto cluster_lights_reference() noexcept -> LightClusters;
+    /** read back the lists of the last cluster pass and compare them with
+     * cluster_lights_reference, meant for small light sets and a still
+     * camera; returns the clusters that differ by more than a light
+     * grazing their box, and reports them */
+    auto check_light_clusters() noexcept -> size_t;
+    static auto light_cluster_stats(LightClusters const& clusters) noexcept -> LightClusterStats;
+    /** compact the geometry arena, records are rewritten on the next update */
+    auto defragment_geometry() noexcept -> void;
 
     auto draw_meshes(rhi::RenderPassEncoder*, int32_t geometryIDOffset = 0) noexcept -> void;
 
@@ -1221,14 +1756,41 @@ namespace gfx {
     auto create_node(std::string const& name = "nameless") noexcept -> Node;
     auto create_node(Node parent, std::string const& name = "nameless") noexcept -> Node;
 
+    /** load a .gltf, or a .glb parsed from the mapped file */
     auto load_gltf(std::string const& path) noexcept -> void;
+    /** build the scene from a parsed glTF, images are found in directory */
+    auto load_gltf_model(tinygltf::Model& model, std::string const& directory) noexcept -> void;
+    /** load a scene written by save_incremental */
+    auto load_archive(std::string const& path) noexcept -> void;
     auto load_xml(std::string const& path) noexcept -> void;
     auto load_pbrt(std::string const& path) noexcept -> void;
 
     auto draw_gui(editor::IFragment* fragment = nullptr) noexcept -> void;
     auto open_node_with_geometry_index(int32_t index) noexcept -> void;
     auto reset() noexcept -> void;
+    /** save as glTF, or as a single-chunk glb when the path ends in .glb */
     auto save(std::string const& path) noexcept -> void;
+    /** save to a chunked archive, writing only the document and the mesh
+     * payloads changed since the last save to the same path. The scene is
+     * snapshot here and written on a worker, the future tells the outcome */
+    auto save_incremental(std::string const& path) noexcept -> std::shared_future<bool>;
+    /** key of a .sescene cache: the loader options, the content of the scene
+     * description, the first file, and the size and write time of the
+     * others; 0 if one of them can't be read */
+    static auto cache_key(std::vector<std::string> const& files) noexcept -> uint64_t;
+    /** write the loaded scene as a .sescene cache: nodes, components,
+     * materials, media and the mesh payloads in their storage encoding,
+     * keyed by m_sourceFiles and the texture files. Textures are kept as
+     * their files, a scene with others is not cached */
+    auto save_cache(std::string const& path) noexcept -> bool;
+    /** rebuild the scene from a cache whose key still matches the files it
+     * lists, the file is mapped and the payloads uploaded in batched copies;
+     * a stale or damaged cache returns false and leaves the scene untouched */
+    auto load_cache(std::string const& path) noexcept -> bool;
+    /** load from the cache beside path if it is current, otherwise with
+     * load and write the cache for the next time */
+    auto load_cached(std::string const& path,
+      void (Scene::* load)(std::string const&) noexcept) noexcept -> void;
   };
   // The handle of texture
   using SceneHandle = ResourceHandle<Scene>;
@@ -1241,9 +1803,9 @@ namespace gfx {
     struct from_pbrt_tag {};
     //struct from_scratch_tag {};
 
-    result_type operator()(from_gltf_tag, std::string const& path);
-    result_type operator()(from_xml_tag, std::string const& path);
-    result_type operator()(from_pbrt_tag, std::string const& path);
+    result_type operator()(from_gltf_tag, std::string const& path, bool cache);
+    result_type operator()(from_xml_tag, std::string const& path, bool cache);
+    result_type operator()(from_pbrt_tag, std::string const& path, bool cache);
     //result_type operator()(from_scratch_tag);
   };
 
@@ -1268,13 +1830,42 @@ namespace gfx {
     ex::resource_cache<Material, MaterialLoader> m_materials;
     ex::resource_cache<Medium, MediumLoader> m_mediums;
     ex::resource_cache<Scene, SceneLoader> m_scenes;
+    /** textures interned by decoded content, and the loads redirected to them */
+    std::unordered_map<TextureContentHash, UID, TextureContentHash::Hasher> m_textureContents;
+    std::unordered_map<UID, UID> m_textureAliases;
     std::list<std::function<void()>> m_jobsFrameEnd;
+    /** one lock per cache, held around every load, erase and walk of it;
+     * recursive since loaders create resources of other caches in turn */
+    struct CacheLocks {
+      std::recursive_mutex buffers, samplers, textures, shaders;
+      std::recursive_mutex meshs, materials, mediums, scenes;
+    } m_locks;
+    /** guards m_jobsFrameEnd, which any thread may append to */
+    std::mutex m_jobsMutex;
+    /** the thread owning the device queue, uploads from others are deferred */
+    std::thread::id m_mainThread;
+
+    /** host and device bytes held by a resource */
+    struct ResourceBytes {
+      std::string name;
+      size_t host = 0;
+      size_t device = 0;
+    };
 
     static auto initialize(Window* window, Flags<rhi::ContextExtensionEnum> ext) noexcept -> void;
     static auto device() noexcept -> rhi::Device*;
     static auto create_flights(int maxFlightNum, rhi::SwapChain* swapchain) -> void;
     static auto get_flights() -> rhi::FrameResources*;
     static auto finalize() noexcept -> void;
+    /** whether the caller may submit to the device queue */
+    static auto on_main_thread() noexcept -> bool;
+    /** run a job on the main thread at the end of the frame */
+    static auto enqueue_frame_end(std::function<void()> job) noexcept -> void;
+    /** run the queued frame end jobs, and the ones they queue, on the main thread */
+    static auto run_frame_end_jobs() noexcept -> void;
+    /** block until the upload of a resource is done; on the main thread the
+     * queued jobs are run instead, as nothing else would run them */
+    static auto wait_upload(IResource const& resource) noexcept -> void;
 
     static auto on_draw_gui_resources() noexcept -> void;
 
@@ -1282,6 +1873,8 @@ namespace gfx {
     static auto clean_buffer_cache() noexcept -> void;
     static auto clean_texture_cache() noexcept -> void;
     static auto clean_shader_cache() noexcept -> void;
+    /** host and device bytes of every cached buffer, largest host first */
+    static auto report_buffer_bytes() noexcept -> std::vector<ResourceBytes>;
 
     // create buffer resource
     // -------------------------------------------
@@ -1292,9 +1885,20 @@ namespace gfx {
       rhi::BufferDescriptor const& desc
     ) noexcept -> BufferHandle;
 
+    // keepHost leaves the bytes in m_host as well, set before any upload
+    // is queued; callers must not write m_host afterwards
     static auto create_buffer_host(
       MiniBuffer const& buffer,
-      Flags<rhi::BufferUsageEnum> usages
+      Flags<rhi::BufferUsageEnum> usages,
+      bool keepHost = false
+    ) noexcept -> BufferHandle;
+
+    // the host data is copied at once, the device buffer is created at the
+    // next frame end; wait_upload() before touching m_buffer
+    static auto create_buffer_host_async(
+      MiniBuffer const& buffer,
+      Flags<rhi::BufferUsageEnum> usages,
+      bool keepHost = false
     ) noexcept -> BufferHandle;
 
     // create texture resource
@@ -1307,11 +1911,28 @@ namespace gfx {
       std::string const& path
     ) noexcept -> TextureHandle;
 
+    // decodes on the calling thread and uploads at the next frame end
+    static auto load_texture_file_async(
+      std::string const& path
+    ) noexcept -> TextureHandle;
+
     static auto load_texture_binary(
       int width, int height, int channel,
       int bits, const char* data
     ) noexcept -> TextureHandle;
 
+    // decodes the files in parallel, and uploads the new textures in
+    // batched submissions as they are decoded, holding about one batch
+    // of decoded texels at a time
+    static auto load_texture_files(
+      std::vector<std::string> const& paths
+    ) noexcept -> std::vector<TextureHandle>;
+
+    // as load_texture_files, for encoded images held in memory
+    static auto load_texture_encoded(
+      std::vector<ext::span<std::byte const>> const& images
+    ) noexcept -> std::vector<TextureHandle>;
+
     // create sampler resource
     // -------------------------------------------
     static auto create_sampler_desc(
@@ -1365,9 +1986,11 @@ namespace gfx {
 
     // load scene resource
     // -------------------------------------------
-    static auto load_scene_gltf(std::string const& path) noexcept -> SceneHandle;
-    static auto load_scene_xml(std::string const& path) noexcept -> SceneHandle;
-    static auto load_scene_pbrt(std::string const& path) noexcept -> SceneHandle;
+    // with cache, the scene is read from a .sescene file beside it when
+    // that is current, and the file is written after a full load
+    static auto load_scene_gltf(std::string const& path, bool cache = false) noexcept -> SceneHandle;
+    static auto load_scene_xml(std::string const& path, bool cache = false) noexcept -> SceneHandle;
+    static auto load_scene_pbrt(std::string const& path, bool cache = false) noexcept -> SceneHandle;
 
     static auto frame_end() noexcept -> void;
   };
@@ -1416,6 +2039,9 @@ namespace image {
   /** A unifing interface to load an image file from path. 
     * The file format is inferenced from path extension. */
   auto load_image(std::string const& path) noexcept -> std::unique_ptr<Image>;
+  /** Load an encoded image from memory, the format is told by its content.
+    * Supports whatever stb_image decodes, and OpenEXR. */
+  auto load_image_memory(void const* data, size_t size) noexcept -> std::unique_ptr<Image>;
 
   struct PNG {
     static auto write_png(std::string const& path, uint32_t width,
@@ -38,6 +38,8 @@ namespace rdg {
     uint32_t m_levels = 1;
     uint32_t m_layers = 1;
     uint32_t m_samples = 1;
+    // one layer per view of the graph, overrides m_layers
+    bool m_perView = false;
     rhi::TextureFormat m_format = rhi::TextureFormat::RGBA8_UNORM;
     Flags<rhi::TextureUsageEnum> m_usages = 0;
     Flags<rhi::TextureFeatureEnum> m_tflags = 0;
@@ -63,6 +65,7 @@ namespace rdg {
     auto with_size_relative(std::string const& src, se::vec3 relative = { 1. }) noexcept -> TextureInfo&;
     auto with_levels(uint32_t levels) noexcept -> TextureInfo&;
     auto with_layers(uint32_t layers) noexcept -> TextureInfo&;
+    auto with_view_layers() noexcept -> TextureInfo&;
     auto with_samples(uint32_t samples) noexcept -> TextureInfo&;
     auto with_format(rhi::TextureFormat format) noexcept -> TextureInfo&;
     auto with_stages(Flags<rhi::ShaderStageEnum> flags) noexcept -> TextureInfo&;
@@ -146,6 +149,8 @@ namespace rdg {
 
   auto to_buffer_descriptor(BufferInfo const& info) noexcept -> rhi::BufferDescriptor;
   auto to_texture_descriptor(TextureInfo const& info, se::ivec3 ref_size) noexcept -> rhi::TextureDescriptor;
+  /** the render pass view mask drawing the first views at once */
+  auto view_mask(uint32_t views) noexcept -> uint32_t;
   
   struct RenderContext {
     rhi::CommandEncoder* cmdEncoder;
@@ -309,6 +314,10 @@ namespace rdg {
 
     auto begin_pass(rdg::RenderContext* context) noexcept -> rhi::ComputePassEncoder*;
     auto prepare_dispatch(rdg::RenderContext* context) noexcept -> void;
+    /** dispatch x * y workgroups per view of the graph, the view index is
+     * the z of the workgroup id */
+    auto dispatch_views(rdg::RenderContext* context, RenderData const& renderData,
+      uint32_t x, uint32_t y) noexcept -> void;
     virtual auto generate_marker() noexcept -> void;
     virtual auto init(gfx::ShaderModule* comp) noexcept -> void;
     virtual auto init(std::string const& comp) noexcept -> void;
@@ -326,6 +335,10 @@ namespace rdg {
     std::string m_outputPass;
     std::string m_outputResource;
     se::ivec3 m_standardSize = { 1280, 720, 1 };
+    /** views rendered per execute, textures declared with view layers get
+     * one layer per view; raster passes draw them with a view mask and
+     * compute passes along the z of the workgroup id */
+    uint32_t m_viewCount = 1;
     std::vector<size_t> m_flattenedPasses;
     std::unordered_map<size_t, Pass*> m_passes;
     std::unordered_map<size_t, TextureResource> m_textureResources;
@@ -341,6 +354,7 @@ namespace rdg {
       std::string const& dst_pass, std::string const& dst_resource) noexcept -> void;
 
     auto set_standard_size(int width, int height) noexcept -> void;
+    auto set_view_count(uint32_t views) noexcept -> void;
     auto get_output() noexcept -> std::optional<gfx::TextureHandle>;
     auto get_output_index() noexcept -> std::optional<uint32_t>;
     auto mark_output(std::string const& pass, std::string const& output) noexcept -> void;
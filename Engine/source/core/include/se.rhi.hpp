@@ -65,6 +65,7 @@ namespace rhi {
     COOPERATIVE_MATRIX = 1 << 9,
     CUDA_INTEROPERABILITY = 1 << 10,
     USE_AFTERMATH = 1 << 11,
+    MULTIVIEW = 1 << 12,
   };
   ENABLE_BITMASK_OPERATORS(ContextExtensionEnum);
 
@@ -487,7 +488,8 @@ namespace rhi {
     uint32_t vertexByteOffset = 0;
     enum struct VertexFormat {
       RGB32,
-      RG32
+      RG32,
+      RGBA16_SNORM
     } vertexFormat = VertexFormat::RGB32;
   };
 
@@ -914,6 +916,9 @@ namespace rhi {
     // std::unique_ptr<QuerySet> occlusionQuerySet = nullptr;
     std::vector<RenderPassTimestampWrite> timestampWrites = {};
     uint64_t maxDrawCount = 50000000;
+    /** views drawn at once, bit i renders view i into layer i of every
+     * attachment, 0 renders a single view; requires MULTIVIEW */
+    uint32_t viewMask = 0;
 
     RenderPassDescriptor() {}
     RenderPassDescriptor(
@@ -1257,6 +1262,8 @@ namespace rhi {
     std::unique_ptr<BindGroupPool> m_bindGroupPool = nullptr;
     /** whether the debug layer is enabled */
     bool m_debugLayerEnabled = false;
+    /** views a render pass may draw at once, 0 without the multiview feature */
+    uint32_t m_maxMultiviewViews = 0;
 
     /** device ray tracing properties */
     VkPhysicalDeviceRayTracingPipelinePropertiesKHR m_vkRayTracingProperties;
@@ -107,6 +107,26 @@ namespace se {
     static auto resolve_path(std::string const& path, std::vector<std::string> const& s) noexcept -> std::string;
   };
 
+  /** A read-only mapping of a whole file, pages are only read from disk when
+    * they are touched. Move-only, the view is unmapped on destruction. */
+  struct MappedFile {
+    MappedFile() = default; ~MappedFile();
+    MappedFile(MappedFile&& f) noexcept;
+    auto operator=(MappedFile&& f) noexcept -> MappedFile&;
+    MappedFile(MappedFile const&) = delete;
+    auto operator=(MappedFile const&) -> MappedFile& = delete;
+    /** map the file, returns false and stays empty if it can't be opened */
+    auto open(std::string const& path) noexcept -> bool;
+    auto close() noexcept -> void;
+    auto data() const noexcept -> std::byte const* { return m_data; }
+    auto size() const noexcept -> size_t { return m_size; }
+    auto as_span() const noexcept -> ext::span<std::byte const> { return { m_data, m_size }; }
+    std::byte const* m_data = nullptr;
+    size_t m_size = 0;
+    /** the file mapping object, only used on windows */
+    void* m_mapping = nullptr;
+  };
+
 
   // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
   // ┃ resource                                                                  ┃
@@ -2,6 +2,7 @@
 #include <map>
 #include <set>
 #include <thread>
+#include <future>
 #include <vector>
 #include <string>
 #include <sstream>
@@ -10,12 +11,21 @@
 #include <functional>
 #include <iostream>
 #include <string_view>
-#include <libdeflate/libdeflate.h>
+#include <filesystem>
+#include <charconv>
+#include <zlib.h>
 #ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#define PBRT_IS_WINDOWS
 #else
 #include <fcntl.h>     // for O_RDONLY
 #include <unistd.h>    // for open, read, close
 #include <sys/stat.h>  // for struct stat and fstat
+#include <sys/mman.h>  // for mmap, madvise and munmap
+#define PBRT_HAVE_MMAP
 #include <memory_resource>
 #include <atomic>
 #include <utility>
@@ -45,7 +55,9 @@ namespace tiny_pbrt_loader {
   static std::string path_of_the_main_file = "";
 
   std::string ResolveFilename(std::string const& name) {
-    return path_of_the_main_file + name;
+    if (path_of_the_main_file.empty())
+      return name;
+    return (std::filesystem::path(path_of_the_main_file) / name).string();
   }
 
   // helpers, fwiw
@@ -653,10 +665,9 @@ namespace tiny_pbrt_loader {
       LOG_FATAL("TODO");
     }
 
-    std::vector<T> finalize() {
-      std::vector<T> vec(size());
-      memcpy(vec.data(), data(), size() * sizeof(T));
-      return vec;
+    // the result shares this vector's memory resource
+    ArenaVector<T> finalize() {
+      return ArenaVector<T>(data(), data() + size(), alloc);
     }
 
   private:
@@ -734,6 +745,8 @@ namespace tiny_pbrt_loader {
     virtual void ObjectBegin(const std::string& name, FileLoc loc) = 0;
     virtual void ObjectEnd(FileLoc loc) = 0;
     virtual void ObjectInstance(const std::string& name, FileLoc loc) = 0;
+    virtual void Import(const std::string& filename, FileLoc loc) = 0;
+    virtual void Include(const std::string& filename, FileLoc loc) = 0;
 
     virtual void EndOfFiles() = 0;
 
@@ -764,7 +777,7 @@ namespace tiny_pbrt_loader {
 
   void ParsedParameter::AddString(std::string_view str) {
     CHECK(floats.empty() && ints.empty() && bools.empty());
-    strings.push_back({ str.begin(), str.end() });
+    strings.emplace_back(str);
   }
 
   void ParsedParameter::AddBool(bool v) {
@@ -774,7 +787,11 @@ namespace tiny_pbrt_loader {
 
   std::string ParsedParameter::ToString() const {
     std::string str;
-    str += std::string("\"") + type + " " + name + std::string("\" [ ");
+    str += "\"";
+    str += std::string_view(type);
+    str += " ";
+    str += std::string_view(name);
+    str += "\" [ ";
     if (!floats.empty())
       for (Float d : floats)
         str += StringPrintf("%f ", d);
@@ -782,8 +799,11 @@ namespace tiny_pbrt_loader {
       for (int i : ints)
         str += StringPrintf("%d ", i);
     else if (!strings.empty())
-      for (const auto& s : strings)
-        str += '\"' + s + "\" ";
+      for (const auto& s : strings) {
+        str += '\"';
+        str += std::string_view(s);
+        str += "\" ";
+      }
     else if (!bools.empty())
       for (bool b : bools)
         str += b ? "true " : "false ";
@@ -824,6 +844,10 @@ namespace tiny_pbrt_loader {
       std::function<void(const char*, const FileLoc*)> errorCallback);
 
     std::optional<Token> Next();
+    // Reads a run of plain numbers straight from the buffer into values
+    // and stops in front of anything else, which is left for Next().
+    template <typename T>
+    void ScanNumbers(std::vector<T>& values);
 
     // Just for parse().
     // TODO? Have a method to set this?
@@ -834,7 +858,7 @@ namespace tiny_pbrt_loader {
     void CheckUTF(const void* ptr, int len) const;
 
     int getChar() {
-      if (pos == end)
+      if (pos == end && !(inflater && Refill()))
         return EOF;
       int ch = *pos++;
       if (ch == '\n') {
@@ -863,8 +887,22 @@ namespace tiny_pbrt_loader {
     // unmapped in the destructor.
     void* unmapPtr = nullptr;
     size_t unmapLength = 0;
+    // Mapped pages the lexer has moved past are handed back in large
+    // steps, so a huge file does not stay resident behind the parser.
+    // They are paged in again if an earlier token is read once more.
+    static constexpr size_t releaseStep = size_t(16) << 20;
+    const char* releasedUpTo = nullptr;
+    void ReleaseConsumed();
 #endif
 
+    // A gzip file is inflated through a window held in contents. When the
+    // lexer runs out, the token being read is moved to the front and more
+    // is inflated after it, so only the longest token has to fit.
+    struct Inflater;
+    static constexpr size_t inflateStep = size_t(4) << 20;
+    std::unique_ptr<Inflater> inflater;
+    bool Refill();
+
     // If the input is stdin, then we copy everything until EOF into this
     // string and then start lexing.  This is a little wasteful (versus
     // tokenizing directly from stdin), but makes the implementation
@@ -874,6 +912,8 @@ namespace tiny_pbrt_loader {
     // Pointers to the current position in the file and one past the end of
     // the file.
     const char* pos, * end;
+    // Start of the token being lexed, the window keeps it on a refill.
+    const char* tokenStart = nullptr;
 
     // If there are escaped characters in the string, we can't just return
     // a std::string_view into the mapped file. In that case, we handle the
@@ -908,58 +948,63 @@ namespace tiny_pbrt_loader {
 #endif
   }
 
-  std::string ReadDecompressedFileContents(std::string filename) {
-    std::string compressed = ReadFileContents(filename);
-
-    // Get the size of the uncompressed file: with gzip, it's stored in the
-    // last 4 bytes of the file.  (One nit is that only 4 bytes are used,
-    // so it's actually the uncompressed size mod 2^32.)
-    CHECK_GT(compressed.size(), 4);
-    size_t sizeOffset = compressed.size() - 4;
+  struct Tokenizer::Inflater {
+    std::ifstream file;
+    z_stream stream = {};
+    std::vector<unsigned char> input = std::vector<unsigned char>(size_t(1) << 20);
+    bool initialized = false;
+    bool done = false;
 
-    // It's stored in little-endian, so manually reconstruct the value to
-    // be sure that it ends up in the right order for the target system.
-    const unsigned char* s = (const unsigned char*)compressed.data() + sizeOffset;
-    size_t size = (uint32_t(s[0]) | (uint32_t(s[1]) << 8) | (uint32_t(s[2]) << 16) |
-      (uint32_t(s[3]) << 24));
+    ~Inflater() {
+      if (initialized)
+        inflateEnd(&stream);
+    }
+  };
 
-    libdeflate_decompressor* d = libdeflate_alloc_decompressor();
-    std::string decompressed(size, '\0');
-    int retries = 0;
-    while (true) {
-      size_t actualOut;
-      libdeflate_result result = libdeflate_gzip_decompress(
-        d, compressed.data(), compressed.size(), decompressed.data(),
-        decompressed.size(), &actualOut);
-      switch (result) {
-      case LIBDEFLATE_SUCCESS:
-        CHECK_EQ(actualOut, decompressed.size());
-        LOG_VERBOSE("Decompressed %s from %d to %d bytes", filename,
-          compressed.size(), decompressed.size());
-        return decompressed;
-
-      case LIBDEFLATE_BAD_DATA:
-        ErrorExit("%s: invalid or corrupt compressed data", filename);
-
-      case LIBDEFLATE_INSUFFICIENT_SPACE:
-        // Assume that the decompressed contents are > 4GB and that
-        // thus the size reported in the file didn't tell the whole
-        // story.  Since the stored size is mod 2^32, try increasing
-        // the allocation by that much.
-        decompressed.resize(decompressed.size() + (1ull << 32));
-
-        // But if we keep going around in circles, then fail eventually
-        // since there is probably some other problem.
-        CHECK_LT(++retries, 10);
-        break;
+  bool Tokenizer::Refill() {
+    Inflater& z = *inflater;
+    if (z.done)
+      return false;
 
-      default:
-      case LIBDEFLATE_SHORT_OUTPUT:
-        // This should never be returned by libdeflate, since we are
-        // passing a non-null actualOut pointer...
-        LOG_FATAL("Unexpected return value from libdeflate");
+    const size_t start = size_t(tokenStart - contents.data());
+    const size_t keep = size_t(end - tokenStart);
+    const size_t offset = size_t(pos - tokenStart);
+    std::memmove(contents.data(), contents.data() + start, keep);
+    if (contents.size() < keep + inflateStep)
+      contents.resize(keep + inflateStep);
+
+    z.stream.next_out = (Bytef*)contents.data() + keep;
+    z.stream.avail_out = uInt(contents.size() - keep);
+    while (z.stream.avail_out > 0 && !z.done) {
+      if (z.stream.avail_in == 0) {
+        z.file.read((char*)z.input.data(), std::streamsize(z.input.size()));
+        z.stream.next_in = z.input.data();
+        z.stream.avail_in = uInt(z.file.gcount());
+        if (z.stream.avail_in == 0) {
+          errorCallback("premature end of compressed data", &loc);
+          z.done = true;
+          break;
+        }
+      }
+      int result = inflate(&z.stream, Z_NO_FLUSH);
+      if (result == Z_STREAM_END) {
+        // gzip allows several members back to back
+        if (z.stream.avail_in == 0 && z.file.peek() == EOF)
+          z.done = true;
+        else
+          inflateReset(&z.stream);
+      }
+      else if (result != Z_OK) {
+        errorCallback("invalid or corrupt compressed data", &loc);
+        z.done = true;
       }
     }
+
+    const size_t produced = contents.size() - keep - z.stream.avail_out;
+    tokenStart = contents.data();
+    pos = tokenStart + offset;
+    end = tokenStart + keep + produced;
+    return produced > 0;
   }
 
   std::unique_ptr<Tokenizer> Tokenizer::CreateFromFile(
@@ -975,16 +1020,84 @@ namespace tiny_pbrt_loader {
         std::move(errorCallback));
     }
 
-    if (filename.substr(filename.size() - 3) == ".gz") {
-      std::string str = ReadDecompressedFileContents(filename);
+    // compressed files are inflated as the lexer goes
+    if (filename.size() >= 3 && filename.substr(filename.size() - 3) == ".gz") {
+      auto z = std::make_unique<Inflater>();
+      z->file.open(filename, std::ios::binary);
+      // 16 + MAX_WBITS: expect a gzip header
+      if (!z->file || inflateInit2(&z->stream, 16 + MAX_WBITS) != Z_OK) {
+        errorCallback(StringPrintf("%s: unable to open file", filename).c_str(), nullptr);
+        return nullptr;
+      }
+      z->initialized = true;
+      auto t = std::make_unique<Tokenizer>(std::string(), filename, std::move(errorCallback));
+      t->inflater = std::move(z);
+      t->tokenStart = t->pos;
+      if (t->Refill())
+        t->CheckUTF(t->pos, int(std::min<ptrdiff_t>(t->end - t->pos, 2)));
+      return t;
+    }
+
+    // Everything else is lexed straight from a read-only mapping, so the
+    // file is paged in as the parser walks it instead of being copied
+    // into memory first. Empty files can't be mapped and are read.
+#if defined(PBRT_HAVE_MMAP)
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) {
+      errorCallback(StringPrintf("%s: unable to open file", filename).c_str(), nullptr);
+      return nullptr;
+    }
+    struct stat stat;
+    if (fstat(fd, &stat) != 0 || stat.st_size == 0) {
+      close(fd);
+      std::string str = ReadFileContents(filename);
       return std::make_unique<Tokenizer>(std::move(str), filename,
         std::move(errorCallback));
     }
-    else {
+    size_t len = size_t(stat.st_size);
+    void* ptr = mmap(nullptr, len, PROT_READ, MAP_PRIVATE | MAP_NORESERVE, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) {
+      errorCallback(StringPrintf("%s: unable to map file", filename).c_str(), nullptr);
+      return nullptr;
+    }
+    // pages behind the lexer are not needed again
+    madvise(ptr, len, MADV_SEQUENTIAL);
+    return std::make_unique<Tokenizer>(ptr, len, filename, std::move(errorCallback));
+#elif defined(PBRT_IS_WINDOWS)
+    HANDLE fileHandle = CreateFileW(std::filesystem::u8path(filename).c_str(), GENERIC_READ,
+      FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+      errorCallback(StringPrintf("%s: unable to open file", filename).c_str(), nullptr);
+      return nullptr;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0) {
+      CloseHandle(fileHandle);
       std::string str = ReadFileContents(filename);
       return std::make_unique<Tokenizer>(std::move(str), filename,
         std::move(errorCallback));
     }
+    HANDLE mapping = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(fileHandle);
+    if (mapping == nullptr) {
+      errorCallback(StringPrintf("%s: unable to map file", filename).c_str(), nullptr);
+      return nullptr;
+    }
+    // the view keeps the mapping alive on its own
+    LPVOID ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (ptr == nullptr) {
+      errorCallback(StringPrintf("%s: unable to map file", filename).c_str(), nullptr);
+      return nullptr;
+    }
+    return std::make_unique<Tokenizer>(ptr, size_t(size.QuadPart), filename,
+      std::move(errorCallback));
+#else
+    std::string str = ReadFileContents(filename);
+    return std::make_unique<Tokenizer>(std::move(str), filename,
+      std::move(errorCallback));
+#endif
   }
 
   std::unique_ptr<Tokenizer> Tokenizer::CreateFromString(
@@ -1003,7 +1116,39 @@ namespace tiny_pbrt_loader {
     CheckUTF(contents.data(), contents.size());
   }
 
-  Tokenizer::~Tokenizer() {}
+#if defined(PBRT_HAVE_MMAP) || defined(PBRT_IS_WINDOWS)
+  Tokenizer::Tokenizer(void* ptr, size_t len, std::string filename,
+    std::function<void(const char*, const FileLoc*)> errorCallback)
+    : errorCallback(std::move(errorCallback)), unmapPtr(ptr), unmapLength(len) {
+    loc = FileLoc(*new std::string(filename));
+    pos = (const char*)ptr;
+    end = pos + len;
+    releasedUpTo = pos;
+    CheckUTF(ptr, int(std::min<size_t>(len, 2)));
+  }
+
+  void Tokenizer::ReleaseConsumed() {
+#if defined(PBRT_HAVE_MMAP)
+    // keep the step before the current position, a token may start there
+    const char* upTo = (const char*)unmapPtr +
+      (size_t(pos - (const char*)unmapPtr) - releaseStep) / releaseStep * releaseStep;
+    if (upTo > releasedUpTo) {
+      madvise((void*)releasedUpTo, size_t(upTo - releasedUpTo), MADV_DONTNEED);
+      releasedUpTo = upTo;
+    }
+#endif
+  }
+#endif
+
+  Tokenizer::~Tokenizer() {
+#if defined(PBRT_HAVE_MMAP)
+    if (unmapPtr && unmapLength > 0)
+      munmap(unmapPtr, unmapLength);
+#elif defined(PBRT_IS_WINDOWS)
+    if (unmapPtr)
+      UnmapViewOfFile(unmapPtr);
+#endif
+  }
 
   void Tokenizer::CheckUTF(const void* ptr, int len) const {
     const unsigned char* c = (const unsigned char*)ptr;
@@ -1042,8 +1187,12 @@ namespace tiny_pbrt_loader {
   }
 
   pstd::optional<Token> Tokenizer::Next() {
+#if defined(PBRT_HAVE_MMAP)
+    if (unmapPtr && size_t(pos - releasedUpTo) >= 2 * releaseStep)
+      ReleaseConsumed();
+#endif
     while (true) {
-      const char* tokenStart = pos;
+      tokenStart = pos;
       FileLoc startLoc = loc;
 
       int ch = getChar();
@@ -1119,6 +1268,55 @@ namespace tiny_pbrt_loader {
     }
   }
 
+  static bool isTokenDelimiter(char ch) {
+    return ch == ' ' || ch == '\n' || ch == '\t' || ch == '\r' || ch == '"' ||
+      ch == '[' || ch == ']';
+  }
+
+  template <typename T>
+  void Tokenizer::ScanNumbers(std::vector<T>& values) {
+    while (true) {
+      // whitespace between the numbers
+      while (true) {
+        if (pos == end) {
+          tokenStart = pos;
+          if (!(inflater && Refill()))
+            return;
+        }
+        if (*pos == '\n') {
+          ++loc.line;
+          loc.column = 0;
+        }
+        else if (*pos == ' ' || *pos == '\t' || *pos == '\r')
+          ++loc.column;
+        else
+          break;
+        ++pos;
+      }
+
+      // from_chars stops at the first byte that is not part of the
+      // number, which has to be where the token ends as well
+      tokenStart = pos;
+      const char* first = pos + (*pos == '+' ? 1 : 0);
+      if (first == end || (first != pos && (*first == '-' || *first == '+')))
+        return;
+      T value;
+      std::from_chars_result result = std::from_chars(first, end, value);
+      if (result.ptr == end && inflater && Refill()) {
+        // the number may go on past the window
+        first = pos + (*pos == '+' ? 1 : 0);
+        result = std::from_chars(first, end, value);
+      }
+      if (result.ec != std::errc() ||
+        (result.ptr != end && !isTokenDelimiter(*result.ptr)))
+        return;
+
+      values.push_back(value);
+      loc.column += int(result.ptr - pos);
+      pos = result.ptr;
+    }
+  }
+
   constexpr int TokenOptional = 0;
   constexpr int TokenRequired = 1;
 
@@ -1154,53 +1352,25 @@ namespace tiny_pbrt_loader {
     return negate ? -value : value;
   }
 
-  static double parseFloat(const Token& t) {
-    // Fast path for a single digit
-    if (t.token.size() == 1) {
-      if (!(t.token[0] >= '0' && t.token[0] <= '9'))
-        ErrorExit(&t.loc, "\"%c\": expected a number", t.token[0]);
-      return t.token[0] - '0';
-    }
-
-    // Copy to a buffer so we can NUL-terminate it, as strto[idf]() expect.
-    char buf[64];
-    char* bufp = buf;
-    std::unique_ptr<char[]> allocBuf;
-    CHECK_RARE(1e-5, t.token.size() + 1 >= sizeof(buf));
-    if (t.token.size() + 1 >= sizeof(buf)) {
-      // This should be very unusual, but is necessary in case we get a
-      // goofball number with lots of leading zeros, for example.
-      allocBuf = std::make_unique<char[]>(t.token.size() + 1);
-      bufp = allocBuf.get();
-    }
-
-    std::copy(t.token.begin(), t.token.end(), bufp);
-    bufp[t.token.size()] = '\0';
-
-    // Can we just use strtol?
-    auto isInteger = [](std::string_view str) {
-      for (char ch : str)
-        if (!(ch >= '0' && ch <= '9'))
-          return false;
-      return true;
-    };
+  static void numberError(const Token& t, const char* what) {
+    std::cerr << t.loc.ToString() << ": \"" << t.token << "\": " << what << std::endl;
+  }
 
-    int length = 0;
+  static double parseFloat(const Token& t) {
+    // from_chars is a correctly rounded parser that needs no terminated
+    // copy; like strtod it reads the number at the start of the token
+    const char* first = t.token.data();
+    const char* last = first + t.token.size();
+    if (first != last && *first == '+')
+      ++first;
     double val = 0;
-    if (isInteger(t.token)) {
-      char* endptr;
-      val = double(strtol(bufp, &endptr, 10));
-      length = endptr - bufp;
-    }
-    try {
-      val = std::stod(std::string(bufp, t.token.size()));
-    }
-    catch (const std::invalid_argument& e) {
-      std::cerr << "Invalid argument: " << e.what() << std::endl;
-    }
-    catch (const std::out_of_range& e) {
-      std::cerr << "Out of range: " << e.what() << std::endl;
-    }
+    // ErrorExit is compiled out, so bad numbers are reported here; from_chars
+    // leaves val at 0 for both errors rather than returning inf or 0
+    const std::errc ec = std::from_chars(first, last, val).ec;
+    if (ec == std::errc::invalid_argument)
+      numberError(t, "expected a number");
+    else if (ec == std::errc::result_out_of_range)
+      numberError(t, "number out of range");
     return val;
   }
 
@@ -1218,11 +1388,21 @@ namespace tiny_pbrt_loader {
     return str;
   }
 
-  template <typename Next, typename Unget>
+  // Parse-time storage of one parse() call. Parameters go to the arena of
+  // the scene; number lists are gathered in the scratch arrays, which are
+  // reused from list to list, and copied to the arena once complete.
+  struct ParameterStorage {
+    std::pmr::memory_resource* arena;
+    std::vector<Float> floats;
+    std::vector<int> ints;
+  };
+
+  template <typename Next, typename Unget, typename Scan>
   static ParsedParameterVector parseParameters(
-    Next nextToken, Unget ungetToken, bool formatting,
+    Next nextToken, Unget ungetToken, Scan scanNumbers, ParameterStorage& storage,
+    bool formatting,
     const std::function<void(const Token& token, const char*)>& errorCallback) {
-    ParsedParameterVector parameterVector;
+    ParsedParameterVector parameterVector(storage.arena);
 
     while (true) {
       pstd::optional<Token> t = nextToken(TokenOptional);
@@ -1234,7 +1414,8 @@ namespace tiny_pbrt_loader {
         return parameterVector;
       }
 
-      ParsedParameter* param = new ParsedParameter(t->loc);
+      ParsedParameter* param = new (storage.arena->allocate(
+        sizeof(ParsedParameter), alignof(ParsedParameter))) ParsedParameter(t->loc, storage.arena);
 
       std::string_view decl = dequoteString(*t);
 
@@ -1349,16 +1530,32 @@ namespace tiny_pbrt_loader {
           }
 
           if (valType == Int)
-            param->AddInt(parseInt(t));
+            storage.ints.push_back(parseInt(t));
           else
-            param->AddFloat(parseFloat(t));
+            storage.floats.push_back(parseFloat(t));
         }
       };
 
       Token val = *nextToken(TokenRequired);
 
       if (val.token == "[") {
+        // plain numbers of a numeric list skip the tokens and go straight
+        // into the value array, anything else goes through addVal
+        const bool numeric = valType == Int || param->type == "float" ||
+          param->type == "point2" || param->type == "vector2" ||
+          param->type == "point3" || param->type == "vector3" ||
+          param->type == "normal" || param->type == "normal3" ||
+          param->type == "point" || param->type == "vector" ||
+          param->type == "rgb" || param->type == "color" || param->type == "blackbody";
         while (true) {
+          if (numeric && valType != String && valType != Bool) {
+            if (valType == Int)
+              scanNumbers(storage.ints);
+            else
+              scanNumbers(storage.floats);
+            if (valType == Unknown && !storage.floats.empty())
+              valType = Float;
+          }
           val = *nextToken(TokenRequired);
           if (val.token == "]")
             break;
@@ -1369,6 +1566,12 @@ namespace tiny_pbrt_loader {
         addVal(val);
       }
 
+      // sized once, the arena can't give back what a growing array leaves
+      param->floats.assign(storage.floats.begin(), storage.floats.end());
+      param->ints.assign(storage.ints.begin(), storage.ints.end());
+      storage.floats.clear();
+      storage.ints.clear();
+
       if (formatting && param->type == "bool") {
         for (const auto& b : param->strings) {
           if (b == "true")
@@ -1390,10 +1593,11 @@ namespace tiny_pbrt_loader {
     return parameterVector;
   }
 
-  void parse(ParserTarget* target, std::unique_ptr<Tokenizer> t) {
+  void parse(ParserTarget* target, std::unique_ptr<Tokenizer> t,
+    std::pmr::memory_resource* arena) {
     static std::atomic<bool> warnedTransformBeginEndDeprecated{ false };
 
-    //std::vector<std::pair<AsyncJob<int>*, BasicSceneBuilder*>> imports;
+    ParameterStorage storage{ arena, {}, {} };
 
     std::vector<std::unique_ptr<Tokenizer>> fileStack;
     fileStack.push_back(std::move(t));
@@ -1444,6 +1648,13 @@ namespace tiny_pbrt_loader {
       ungetToken = t;
     };
 
+    // numbers are read from the current file only when no token is held
+    // back, otherwise they would come out of order
+    auto scanNumbers = [&](auto& values) {
+      if (!ungetToken.has_value() && !fileStack.empty())
+        fileStack.back()->ScanNumbers(values);
+    };
+
     // Helper function for pbrt API entrypoints that take a single string
     // parameter and a ParameterVector (e.g. pbrtShape()).
     auto basicParamListEntrypoint =
@@ -1454,7 +1665,7 @@ namespace tiny_pbrt_loader {
           std::string_view dequoted = dequoteString(t);
           std::string n = toString(dequoted);
           ParsedParameterVector parameterVector = parseParameters(
-            nextToken, unget, false, [&](const Token& t, const char* msg) {
+            nextToken, unget, scanNumbers, storage, false, [&](const Token& t, const char* msg) {
               std::string token = toString(t.token);
           std::string str = StringPrintf("%s: %s", token, msg);
           parseError(str.c_str(), &t.loc);
@@ -1544,6 +1755,7 @@ namespace tiny_pbrt_loader {
           std::string filename = toString(dequoteString(filenameToken));
           if (true) {
             filename = ResolveFilename(filename);
+            target->Include(filename, tok->loc);
             std::unique_ptr<Tokenizer> tinc =
               Tokenizer::CreateFromFile(filename, parseError);
             if (tinc) {
@@ -1555,43 +1767,9 @@ namespace tiny_pbrt_loader {
           }
         }
         else if (tok->token == "Import") {
-          //Token filenameToken = *nextToken(TokenRequired);
-          //std::string filename = toString(dequoteString(filenameToken));
-          //if (true) {
-          //  BasicSceneBuilder* builder =
-          //    dynamic_cast<BasicSceneBuilder*>(target);
-          //  CHECK(builder);
-
-          //  if (builder->currentBlock !=
-          //    BasicSceneBuilder::BlockState::WorldBlock)
-          //    ErrorExit(&tok->loc, "Import statement only allowed inside world "
-          //      "definition block.");
-
-          //  filename = ResolveFilename(filename);
-          //  BasicSceneBuilder* importBuilder = builder->CopyForImport();
-
-          //  if (RunningThreads() == 1) {
-          //    std::unique_ptr<Tokenizer> timport =
-          //      Tokenizer::CreateFromFile(filename, parseError);
-          //    if (timport)
-          //      parse(importBuilder, std::move(timport));
-          //    builder->MergeImported(importBuilder);
-          //  }
-          //  else {
-          //    auto job = [=](std::string filename) {
-          //      Timer timer;
-          //      std::unique_ptr<Tokenizer> timport =
-          //        Tokenizer::CreateFromFile(filename, parseError);
-          //      if (timport)
-          //        parse(importBuilder, std::move(timport));
-          //      LOG_VERBOSE("Elapsed time to parse \"%s\": %.2fs", filename,
-          //        timer.ElapsedSeconds());
-          //      return 0;
-          //    };
-          //    AsyncJob<int>* jobFinished = RunAsync(job, filename);
-          //    imports.push_back(std::make_pair(jobFinished, importBuilder));
-          //  }
-          //}
+          Token filenameToken = *nextToken(TokenRequired);
+          std::string filename = toString(dequoteString(filenameToken));
+          target->Import(ResolveFilename(filename), tok->loc);
         }
         else if (tok->token == "Identity")
           target->Identity(tok->loc);
@@ -1754,7 +1932,7 @@ namespace tiny_pbrt_loader {
           std::string_view dequoted = dequoteString(t);
           std::string texName = toString(dequoted);
           ParsedParameterVector params = parseParameters(
-            nextToken, unget, false, [&](const Token& t, const char* msg) {
+            nextToken, unget, scanNumbers, storage, false, [&](const Token& t, const char* msg) {
               std::string token = toString(t.token);
           std::string str = StringPrintf("%s: %s", token, msg);
           parseError(str.c_str(), &t.loc);
@@ -1779,25 +1957,30 @@ namespace tiny_pbrt_loader {
         syntaxError(*tok);
       }
     }
+  }
 
-    //for (auto& import : imports) {
-    //  import.first->Wait();
+  void ParseString(ParserTarget* target, std::string str,
+    std::pmr::memory_resource* arena) {
+    auto tokError = [](const char* msg, const FileLoc* loc) {
+      ErrorExit(loc, "%s", msg);
+    };
+    std::unique_ptr<Tokenizer> t = Tokenizer::CreateFromString(std::move(str), tokError);
+    if (!t)
+      return;
+    parse(target, std::move(t), arena);
 
-    //  BasicSceneBuilder* builder = dynamic_cast<BasicSceneBuilder*>(target);
-    //  CHECK(builder);
-    //  builder->MergeImported(import.second);
-    //  // HACK: let import.second leak so that its TransformCache isn't deallocated...
-    //}
+    target->EndOfFiles();
   }
 
-  void ParseString(ParserTarget* target, std::string str) {
+  void ParseFile(ParserTarget* target, std::string const& filename,
+    std::pmr::memory_resource* arena) {
     auto tokError = [](const char* msg, const FileLoc* loc) {
       ErrorExit(loc, "%s", msg);
     };
-    std::unique_ptr<Tokenizer> t = Tokenizer::CreateFromString(std::move(str), tokError);
+    std::unique_ptr<Tokenizer> t = Tokenizer::CreateFromFile(filename, tokError);
     if (!t)
       return;
-    parse(target, std::move(t));
+    parse(target, std::move(t), arena);
 
     target->EndOfFiles();
   }
@@ -2527,11 +2710,15 @@ namespace tiny_pbrt_loader {
     void ObjectBegin(const std::string& name, FileLoc loc);
     void ObjectEnd(FileLoc loc);
     void ObjectInstance(const std::string& name, FileLoc loc);
+    void Import(const std::string& filename, FileLoc loc);
+    void Include(const std::string& filename, FileLoc loc);
 
     void EndOfFiles();
 
     BasicSceneBuilder* CopyForImport();
     void MergeImported(BasicSceneBuilder*);
+    void ParseImport();
+    void MergeImports();
 
     std::string ToString() const;
 
@@ -2595,23 +2782,31 @@ namespace tiny_pbrt_loader {
     //InternCache<class Transform> transformCache;
     std::vector<GraphicsState> pushedGraphicsStates;
     std::vector<std::pair<char, FileLoc>> pushStack;  // 'a': attribute, 'o': object
-    //struct ActiveInstanceDefinition {
-    //  ActiveInstanceDefinition(std::string name, FileLoc loc) : entity(name, loc) {}
+    struct ActiveInstanceDefinition {
+      ActiveInstanceDefinition(std::string name, FileLoc loc) {
+        entity.name = std::move(name); entity.loc = loc; }
 
-    //  std::mutex mutex;
-    //  std::atomic<int> activeImports{ 1 };
-    //  InstanceDefinitionSceneEntity entity;
-    //  ActiveInstanceDefinition* parent = nullptr;
-    //};
-    //ActiveInstanceDefinition* activeInstanceDefinition = nullptr;
+      InstanceDefinitionSceneEntity entity;
+      ActiveInstanceDefinition* parent = nullptr;
+    };
+    ActiveInstanceDefinition* activeInstanceDefinition = nullptr;
 
     //// Buffer these both to avoid mutex contention and so that they are
     //// consistently ordered across runs.
     std::vector<ShapeSceneEntity> shapes;
     std::vector<InstanceSceneEntity> instanceUses;
 
-    std::set<std::string> namedMaterialNames, mediumNames;
-    //std::set<std::string> floatTextureNames, spectrumTextureNames, instanceNames;
+    std::set<std::string> namedMaterialNames, mediumNames, instanceNames;
+
+    // An imported file is parsed by a copy of the builder into a scene of
+    // its own. Its material indices start at materialBase, and its shapes
+    // are spliced in at the offsets the Import statement was seen at.
+    std::unique_ptr<BasicScene> importScene;
+    std::string importFilename;
+    int materialBase = 0;
+    size_t shapeOffset = 0, instanceOffset = 0;
+    std::vector<std::unique_ptr<BasicSceneBuilder>> imports;
+    //std::set<std::string> floatTextureNames, spectrumTextureNames;
     //int currentMaterialIndex = 0, currentLightIndex = -1;
     SceneEntity sampler;
     SceneEntity film, integrator, filter, accelerator;
@@ -2786,7 +2981,7 @@ namespace tiny_pbrt_loader {
     camera.dict.params = params.finalize();
     memcpy(&(camera.cameraFromWorld.m[0][0]), &(cameraFromWorld[0].m[0][0]), sizeof(Float) * 16);
 
-    scene->camera = camera;
+    scene->camera = std::move(camera);
   }
   void BasicSceneBuilder::MakeNamedMedium(const std::string& origName, ParsedParameterVector params,
     FileLoc loc) {
@@ -2808,13 +3003,13 @@ namespace tiny_pbrt_loader {
     
     mediumEntity.dict.nOwnedParams = params.size();
     mediumEntity.dict.params = params.finalize();
-    std::vector<ParsedParameter*> medium_param_state =
+    auto medium_param_state =
       graphicsState.mediumAttributes.finalize();
     mediumEntity.dict.params.insert(mediumEntity.dict.params.end(),
       medium_param_state.begin(), medium_param_state.end());
     mediumEntity.loc = loc;
     mediumEntity.name = name;
-    scene->AddMedium(mediumEntity);
+    scene->AddMedium(std::move(mediumEntity));
   }
   void BasicSceneBuilder::MediumInterface(const std::string& insideName, const std::string& outsideName,
     FileLoc loc) {
@@ -2900,14 +3095,14 @@ namespace tiny_pbrt_loader {
     SceneEntity materialEntity;
     materialEntity.dict.nOwnedParams = params.size();
     materialEntity.dict.params = params.finalize();
-    std::vector<ParsedParameter*> material_param_state =
+    auto material_param_state =
       graphicsState.materialAttributes.finalize();
     materialEntity.dict.params.insert(materialEntity.dict.params.end(),
       material_param_state.begin(), material_param_state.end());
     materialEntity.loc = loc;
     materialEntity.name = name;
 
-    graphicsState.currentMaterialIndex = scene->AddMaterial(materialEntity);
+    graphicsState.currentMaterialIndex = materialBase + scene->AddMaterial(std::move(materialEntity));
     graphicsState.currentMaterialName.clear();
   }
   void BasicSceneBuilder::MakeNamedMaterial(const std::string& name, ParsedParameterVector params,
@@ -2915,7 +3110,7 @@ namespace tiny_pbrt_loader {
     SceneEntity materialEntity;
     materialEntity.dict.nOwnedParams = params.size();
     materialEntity.dict.params = params.finalize();
-    std::vector<ParsedParameter*> material_param_state =
+    auto material_param_state =
       graphicsState.materialAttributes.finalize();
     materialEntity.dict.params.insert(materialEntity.dict.params.end(),
       material_param_state.begin(), material_param_state.end());
@@ -2924,7 +3119,7 @@ namespace tiny_pbrt_loader {
       return;
     }
     namedMaterialNames.insert(name);
-    scene->AddNamedMaterial(name, materialEntity);
+    scene->AddNamedMaterial(name, std::move(materialEntity));
 
   }
   void BasicSceneBuilder::NamedMaterial(const std::string& name, FileLoc loc) {
@@ -2940,14 +3135,14 @@ namespace tiny_pbrt_loader {
   void BasicSceneBuilder::AreaLightSource(const std::string& name, ParsedParameterVector params,
     FileLoc loc) {
     graphicsState.areaLightName = name;
-    graphicsState.areaLightParams = ParameterDictionary(std::move(params.finalize()));
+    graphicsState.areaLightParams = ParameterDictionary(params.finalize());
     graphicsState.areaLightLoc = loc;
   }
   void BasicSceneBuilder::Shape(const std::string& name, ParsedParameterVector params, FileLoc loc) {
     ShapeSceneEntity shapeEntity;
     shapeEntity.dict.nOwnedParams = params.size();
     shapeEntity.dict.params = params.finalize();
-    std::vector<ParsedParameter*> shape_param_state =
+    auto shape_param_state =
       graphicsState.shapeAttributes.finalize();
     shapeEntity.dict.params.insert(shapeEntity.dict.params.end(),
       shape_param_state.begin(), shape_param_state.end());
@@ -2994,26 +3189,99 @@ namespace tiny_pbrt_loader {
       //   graphicsState.reverseOrientation, graphicsState.currentMaterialIndex,
       //   graphicsState.currentMaterialName, areaLightIndex,
       //   graphicsState.currentInsideMedium, graphicsState.currentOutsideMedium });
-      //if (activeInstanceDefinition)
-      //  activeInstanceDefinition->entity.shapes.push_back(std::move(entity));
-      //else
-      shapes.push_back(std::move(shapeEntity));
+      if (activeInstanceDefinition)
+        activeInstanceDefinition->entity.shapes.push_back(std::move(shapeEntity));
+      else
+        shapes.push_back(std::move(shapeEntity));
     }
   }
   void BasicSceneBuilder::ReverseOrientation(FileLoc loc) {
 
   }
   void BasicSceneBuilder::ObjectBegin(const std::string& name, FileLoc loc) {
+    pushedGraphicsStates.push_back(graphicsState);
+    pushStack.push_back(std::make_pair('o', loc));
 
+    if (activeInstanceDefinition) {
+      ErrorExitDeferred(&loc, "ObjectBegin called inside of instance definition");
+      return;
+    }
+    if (instanceNames.find(name) != instanceNames.end()) {
+      ErrorExitDeferred(&loc, "%s: trying to redefine an object instance", name);
+      return;
+    }
+    instanceNames.insert(name);
+    activeInstanceDefinition = new ActiveInstanceDefinition(name, loc);
   }
   void BasicSceneBuilder::ObjectEnd(FileLoc loc) {
+    if (!activeInstanceDefinition) {
+      ErrorExitDeferred(&loc, "ObjectEnd called outside of instance definition");
+      return;
+    }
+    if (activeInstanceDefinition->parent) {
+      ErrorExitDeferred(&loc, "ObjectEnd called inside Import for instance definition");
+      return;
+    }
+
+    // NOTE: Must keep the following consistent with AttributeEnd
+    graphicsState = std::move(pushedGraphicsStates.back());
+    pushedGraphicsStates.pop_back();
 
+    if (pushStack.back().first == 'a')
+      ErrorExitDeferred(&loc,
+        "Mismatched nesting: open AttributeBegin from %s at ObjectEnd",
+        pushStack.back().second);
+    else
+      CHECK_EQ(pushStack.back().first, 'o');
+    pushStack.pop_back();
+
+    scene->AddInstanceDefinition(std::move(activeInstanceDefinition->entity));
+    delete activeInstanceDefinition;
+    activeInstanceDefinition = nullptr;
   }
   void BasicSceneBuilder::ObjectInstance(const std::string& name, FileLoc loc) {
+    if (activeInstanceDefinition) {
+      ErrorExitDeferred(&loc, "ObjectInstance can't be called inside instance definition");
+      return;
+    }
 
+    // shapes of the definition are kept in their own object space,
+    // the instance only carries the transform to the render space
+    const class Transform renderFromInstance = RenderFromObject(0);
+    InstanceSceneEntity instance;
+    instance.name = name;
+    instance.loc = loc;
+    memcpy(&(instance.renderFromInstance.m), &(renderFromInstance.m[0][0]), sizeof(Float) * 16);
+    instanceUses.push_back(std::move(instance));
+  }
+
+  void BasicSceneBuilder::Import(const std::string& filename, FileLoc loc) {
+    if (currentBlock != BlockState::WorldBlock) {
+      ErrorExitDeferred(&loc, "Import statement only allowed inside world "
+        "definition block.");
+      return;
+    }
+
+    scene->files.push_back(filename);
+    std::unique_ptr<BasicSceneBuilder> importBuilder(CopyForImport());
+    importBuilder->importFilename = filename;
+    // shapes of an instance definition must be in it before ObjectEnd,
+    // so such a file is parsed right away
+    if (activeInstanceDefinition) {
+      importBuilder->ParseImport();
+      MergeImported(importBuilder.get());
+    }
+    else
+      imports.push_back(std::move(importBuilder));
+  }
+
+  void BasicSceneBuilder::Include(const std::string& filename, FileLoc loc) {
+    scene->files.push_back(filename);
   }
 
   void BasicSceneBuilder::EndOfFiles() {
+    MergeImports();
+
     if (currentBlock != BlockState::WorldBlock)
       ErrorExitDeferred("End of files before \"WorldBegin\".");
 
@@ -3028,16 +3296,142 @@ namespace tiny_pbrt_loader {
 
     if (!shapes.empty())
       scene->AddShapes(shapes);
-    //if (!instanceUses.empty())
-    //  scene->AddInstanceUses(instanceUses);
+    if (!instanceUses.empty())
+      scene->AddInstanceUses(instanceUses);
   }
 
   BasicSceneBuilder* BasicSceneBuilder::CopyForImport() {
-    return nullptr;
+    std::unique_ptr<BasicScene> importScene = std::make_unique<BasicScene>();
+    BasicSceneBuilder* importBuilder = new BasicSceneBuilder(importScene.get());
+    importBuilder->importScene = std::move(importScene);
+    importBuilder->currentBlock = currentBlock;
+    importBuilder->graphicsState = graphicsState;
+    importBuilder->namedCoordinateSystems = namedCoordinateSystems;
+    importBuilder->renderFromWorld = renderFromWorld;
+    importBuilder->namedMaterialNames = namedMaterialNames;
+    importBuilder->mediumNames = mediumNames;
+    importBuilder->instanceNames = instanceNames;
+    // indices below the base are the ones inherited with the graphics state
+    importBuilder->materialBase = materialBase + int(scene->materials.size());
+    importBuilder->shapeOffset = shapes.size();
+    importBuilder->instanceOffset = instanceUses.size();
+    if (activeInstanceDefinition) {
+      importBuilder->activeInstanceDefinition = new ActiveInstanceDefinition(
+        activeInstanceDefinition->entity.name, activeInstanceDefinition->entity.loc);
+      importBuilder->activeInstanceDefinition->parent = activeInstanceDefinition;
+    }
+    return importBuilder;
+  }
+
+  void BasicSceneBuilder::MergeImported(BasicSceneBuilder* imported) {
+    errorExit = errorExit || imported->errorExit;
+
+    // materials of the import go after the ones known here, inherited
+    // indices are left as they are
+    const int materialShift =
+      materialBase + int(scene->materials.size()) - imported->materialBase;
+    auto remap = [&](ShapeSceneEntity& shape) {
+      if (shape.materialIndex >= imported->materialBase)
+        shape.materialIndex += materialShift;
+    };
+
+    BasicScene& from = *imported->importScene;
+    // the parameters of the import stay where they are, its arenas move
+    for (auto& arena : from.arenas)
+      scene->arenas.push_back(std::move(arena));
+    scene->files.insert(scene->files.end(), from.files.begin(), from.files.end());
+    for (SceneEntity& material : from.materials)
+      scene->AddMaterial(std::move(material));
+    for (auto& [name, material] : from.namedMaterials) {
+      if (!namedMaterialNames.insert(name).second) {
+        ErrorExitDeferred(&material.loc, "%s: named material redefined.", name);
+        continue;
+      }
+      scene->AddNamedMaterial(name, std::move(material));
+    }
+    for (MediumSceneEntity& medium : from.mediums) {
+      if (!mediumNames.insert(medium.name).second) {
+        ErrorExitDeferred(&medium.loc, "Named medium \"%s\" redefined.", medium.name);
+        continue;
+      }
+      scene->AddMedium(std::move(medium));
+    }
+    for (InstanceDefinitionSceneEntity& definition : from.instanceDefinitions) {
+      if (!instanceNames.insert(definition.name).second) {
+        ErrorExitDeferred(&definition.loc, "%s: trying to redefine an object instance",
+          definition.name);
+        continue;
+      }
+      for (ShapeSceneEntity& shape : definition.shapes)
+        remap(shape);
+      scene->AddInstanceDefinition(std::move(definition));
+    }
+
+    if (imported->activeInstanceDefinition) {
+      std::vector<ShapeSceneEntity>& into = activeInstanceDefinition->entity.shapes;
+      for (ShapeSceneEntity& shape : imported->activeInstanceDefinition->entity.shapes) {
+        remap(shape);
+        into.push_back(std::move(shape));
+      }
+      delete imported->activeInstanceDefinition;
+      imported->activeInstanceDefinition = nullptr;
+    }
+
+    for (ShapeSceneEntity& shape : imported->shapes)
+      remap(shape);
+    shapes.insert(shapes.begin() + imported->shapeOffset,
+      std::make_move_iterator(imported->shapes.begin()),
+      std::make_move_iterator(imported->shapes.end()));
+    instanceUses.insert(instanceUses.begin() + imported->instanceOffset,
+      std::make_move_iterator(imported->instanceUses.begin()),
+      std::make_move_iterator(imported->instanceUses.end()));
+  }
+
+  void BasicSceneBuilder::ParseImport() {
+    auto parseError = [](const char* msg, const FileLoc* loc) {
+      ErrorExit(loc, "%s", msg);
+    };
+    std::unique_ptr<Tokenizer> timport = Tokenizer::CreateFromFile(importFilename, parseError);
+    if (timport)
+      parse(this, std::move(timport), scene->ParameterArena());
+    // files imported by this one are merged before it is merged itself
+    MergeImports();
+
+    if (!pushedGraphicsStates.empty())
+      ErrorExitDeferred("%s: missing end to AttributeBegin", importFilename);
   }
 
-  void BasicSceneBuilder::MergeImported(BasicSceneBuilder*) {
+  void BasicSceneBuilder::MergeImports() {
+    if (imports.empty())
+      return;
 
+    // the imported files are parsed across the cores, in no set order
+    const size_t workerCount = std::min<size_t>(imports.size(),
+      std::max<unsigned>(std::thread::hardware_concurrency(), 1u));
+    std::atomic<size_t> next = 0;
+    auto worker = [&]() {
+      for (size_t i = next++; i < imports.size(); i = next++)
+        imports[i]->ParseImport();
+    };
+    std::vector<std::future<void>> jobs;
+    jobs.reserve(workerCount);
+    for (size_t i = 1; i < workerCount; ++i)
+      jobs.emplace_back(std::async(std::launch::async, worker));
+    worker();
+    for (auto& job : jobs)
+      job.get();
+
+    // but merged in statement order, so the scene does not depend on which
+    // file finished first; every splice moves the offsets after it
+    size_t shapeShift = 0, instanceShift = 0;
+    for (auto& imported : imports) {
+      imported->shapeOffset += shapeShift;
+      imported->instanceOffset += instanceShift;
+      shapeShift += imported->shapes.size();
+      instanceShift += imported->instanceUses.size();
+      MergeImported(imported.get());
+    }
+    imports.clear();
   }
 
   std::string BasicSceneBuilder::ToString() const {
@@ -3080,6 +3474,14 @@ namespace tiny_pbrt_loader {
     std::move(std::begin(s), std::end(s), std::back_inserter(shapes));
   }
 
+  void BasicScene::AddInstanceDefinition(InstanceDefinitionSceneEntity instance) {
+    instanceDefinitions.push_back(std::move(instance));
+  }
+
+  void BasicScene::AddInstanceUses(tcb::span<InstanceSceneEntity> in) {
+    std::move(std::begin(in), std::end(in), std::back_inserter(instances));
+  }
+
   //void BasicScene::AddAnimatedShape(AnimatedShapeSceneEntity shape) {
   //  //animatedShapes.push_back(std::move(shape));
   //}
@@ -3088,9 +3490,14 @@ namespace tiny_pbrt_loader {
     mediums.push_back(std::move(medium));
   }
 
+  std::pmr::memory_resource* BasicScene::ParameterArena() {
+    if (arenas.empty())
+      arenas.push_back(std::make_unique<std::pmr::monotonic_buffer_resource>(size_t(1) << 20));
+    return arenas.front().get();
+  }
+
   void ParameterDictionary::FreeParameters() {
-    for (int i = 0; i < nOwnedParams; ++i)
-      delete params[i];
+    // the parameters are released with the arena they came from
     params.clear();
   }
 
@@ -3098,10 +3505,19 @@ namespace tiny_pbrt_loader {
     std::unique_ptr<BasicScene> scene = std::make_unique<BasicScene>();
     path_of_the_main_file = dir_path;
     BasicSceneBuilder target(scene.get());
-    ParseString(&target, str);
+    ParseString(&target, str, scene->ParameterArena());
     return std::move(scene);
   }
 
+  std::unique_ptr<BasicScene> load_scene_from_file(std::string const& filename) {
+    std::unique_ptr<BasicScene> scene = std::make_unique<BasicScene>();
+    path_of_the_main_file = std::filesystem::u8path(filename).parent_path().string();
+    scene->files.push_back(filename);
+    BasicSceneBuilder target(scene.get());
+    ParseFile(&target, filename, scene->ParameterArena());
+    return scene;
+  }
+
   template <ParameterType PT>
   typename ParameterTypeTraits<PT>::ReturnType ParameterDictionary::lookupSingle(
     const std::string& name,
@@ -3109,7 +3525,7 @@ namespace tiny_pbrt_loader {
     // Search _params_ for parameter _name_
     using traits = ParameterTypeTraits<PT>;
     for (const ParsedParameter* p : params) {
-      if (p->name != name || p->type != traits::typeName)
+      if (std::string_view(p->name) != name || p->type != traits::typeName)
         continue;
       // Extract parameter values from _p_
       const auto& values = traits::GetValues(*p);
@@ -3200,7 +3616,7 @@ namespace tiny_pbrt_loader {
     int nPerItem, G getValues,
     C convert) const {
     for (const ParsedParameter* p : params)
-      if (p->name == name && p->type == typeName)
+      if (std::string_view(p->name) == name && p->type == typeName)
         return returnArray<ReturnType>(getValues(*p), *p, nPerItem, convert);
     return {};
   }
@@ -3248,11 +3664,12 @@ namespace tiny_pbrt_loader {
     return lookupArray<ParameterType::Normal3f>(name);
   }
 
-  std::vector<Float> const& ParameterDictionary::GetAllFloats(const std::string& name) const {
+  std::pmr::vector<Float> const& ParameterDictionary::GetAllFloats(const std::string& name) const {
+    static const std::pmr::vector<Float> none;
     for (const ParsedParameter* p : params)
-      if (p->name == name)
+      if (std::string_view(p->name) == name)
         return p->floats;
-    return {};
+    return none;
   }
 
   static std::map<std::string, Spectrum> cachedSpectra;
@@ -5,6 +5,7 @@
 #include <string>
 #include <memory>
 #include <string_view>
+#include <memory_resource>
 
 namespace tiny_pbrt_loader {
   // Hack the pbrt code features
@@ -108,10 +109,49 @@ namespace tiny_pbrt_loader {
     int line = 1, column = 0;
   };
 
+  // Allocator over a memory resource that, unlike polymorphic_allocator,
+  // follows its container on move assignment, so parameter lists can be
+  // moved into entities without leaving the arena; copies are made with the
+  // default resource.
+  template <typename T>
+  struct ArenaAllocator {
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    ArenaAllocator() noexcept = default;
+    ArenaAllocator(std::pmr::memory_resource* r) noexcept : resource(r) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& a) noexcept : resource(a.resource) {}
+    template <typename U>
+    ArenaAllocator(const std::pmr::polymorphic_allocator<U>& a) noexcept : resource(a.resource()) {}
+
+    T* allocate(size_t n) {
+      return static_cast<T*>(resource->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* p, size_t n) noexcept { resource->deallocate(p, n * sizeof(T), alignof(T)); }
+    ArenaAllocator select_on_container_copy_construction() const { return {}; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& a) const noexcept { return *resource == *a.resource; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& a) const noexcept { return !(*this == a); }
+
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource();
+  };
+
+  template <typename T>
+  using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
   // ParsedParameter provides the parameter type and name as strings 
   // as well as the location of the parameter in the scene description file.
+  // Made by the parser in the arena of the scene, with its strings and
+  // value arrays in the same arena; it is never freed on its own.
   struct ParsedParameter {
-    ParsedParameter(FileLoc loc) : loc(loc) {}
+    ParsedParameter(FileLoc loc,
+      std::pmr::memory_resource* arena = std::pmr::get_default_resource())
+      : type(arena), name(arena), loc(loc), floats(arena), ints(arena),
+      strings(arena), bools(arena) {}
 
     void AddFloat(Float v);
     void AddInt(int i);
@@ -119,13 +159,13 @@ namespace tiny_pbrt_loader {
     void AddBool(bool v);
 
     std::string ToString() const;
-    std::string type, name;
+    std::pmr::string type, name;
     FileLoc loc;
 
-    std::vector<Float> floats;
-    std::vector<int> ints;
-    std::vector<std::string> strings;
-    std::vector<uint8_t> bools;
+    std::pmr::vector<Float> floats;
+    std::pmr::vector<int> ints;
+    std::pmr::vector<std::pmr::string> strings;
+    std::pmr::vector<uint8_t> bools;
     mutable bool lookedUp = false;
   };
 
@@ -270,7 +310,9 @@ namespace tiny_pbrt_loader {
     static constexpr char typeName[] = "string";
     static constexpr int nPerItem = 1;
     using ReturnType = std::string;
-    static std::string Convert(const std::string* s, const FileLoc* loc) { return *s; }
+    static std::string Convert(const std::pmr::string* s, const FileLoc* loc) {
+      return std::string(s->data(), s->size());
+    }
     static const auto& GetValues(const ParsedParameter& param) { return param.strings; }
   };
 
@@ -278,12 +320,12 @@ namespace tiny_pbrt_loader {
 
   // adds both semantics and convenience to vectors of ParsedParameters
   struct ParameterDictionary {
-    std::vector<ParsedParameter*> params;
+    ArenaVector<ParsedParameter*> params;
     const RGBColorSpace* colorSpace = nullptr;
     int nOwnedParams;
 
     ParameterDictionary() = default;
-    ParameterDictionary(std::vector<ParsedParameter*>&& i) : params(i) {}
+    ParameterDictionary(ArenaVector<ParsedParameter*>&& i) : params(std::move(i)) {}
 
     const FileLoc* loc(const std::string&) const;
 
@@ -319,7 +361,7 @@ namespace tiny_pbrt_loader {
 
     void ReportUnused() const;
 
-    std::vector<Float> const& GetAllFloats(const std::string& name) const;
+    std::pmr::vector<Float> const& GetAllFloats(const std::string& name) const;
 
     // ParameterDictionary Private Methods
     template <ParameterType PT>
@@ -348,7 +390,7 @@ namespace tiny_pbrt_loader {
   };
 
   struct InstanceSceneEntity : public SceneEntity {
-
+    TransformData renderFromInstance;
   };
 
   struct CameraSceneEntity : public SceneEntity {
@@ -377,6 +419,12 @@ namespace tiny_pbrt_loader {
     int materialIndex;
   };
 
+  struct InstanceDefinitionSceneEntity {
+    std::string name;
+    FileLoc loc;
+    std::vector<ShapeSceneEntity> shapes;
+  };
+
   struct BasicScene {
     //void SetOptions(SceneEntity filter, SceneEntity film, CameraSceneEntity camera,
     //  SceneEntity sampler, SceneEntity integrator, SceneEntity accelerator);
@@ -389,8 +437,16 @@ namespace tiny_pbrt_loader {
     int AddAreaLight(SceneEntity light);
     void AddShapes(tcb::span<ShapeSceneEntity> shape);
     //void AddAnimatedShape(AnimatedShapeSceneEntity shape);
-    //void AddInstanceDefinition(InstanceDefinitionSceneEntity instance);
-    //void AddInstanceUses(std::span<InstanceSceneEntity> in);
+    void AddInstanceDefinition(InstanceDefinitionSceneEntity instance);
+    void AddInstanceUses(tcb::span<InstanceSceneEntity> in);
+
+    // Parameters of the entities below are allocated from these, declared
+    // first so they outlive the entities. The first one is made on demand,
+    // the others are adopted from the scenes of imported files.
+    std::pmr::memory_resource* ParameterArena();
+    std::vector<std::unique_ptr<std::pmr::monotonic_buffer_resource>> arenas;
+    // the main file, then the files it includes and imports
+    std::vector<std::string> files;
 
     CameraSceneEntity camera;
     std::vector<SceneEntity> materials;
@@ -398,7 +454,12 @@ namespace tiny_pbrt_loader {
     std::vector<MediumSceneEntity> mediums;
     std::vector<ShapeSceneEntity> shapes;
     std::vector<std::pair<std::string, SceneEntity>> namedMaterials;
+    std::vector<InstanceDefinitionSceneEntity> instanceDefinitions;
+    std::vector<InstanceSceneEntity> instances;
+
   };
 
   std::unique_ptr<BasicScene> load_scene_from_string(std::string str, std::string dir_path = "");
+  // lexes the file from a memory mapping, relative paths resolve next to it
+  std::unique_ptr<BasicScene> load_scene_from_file(std::string const& filename);
 }
\ No newline at end of file
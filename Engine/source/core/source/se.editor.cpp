@@ -662,7 +662,7 @@ namespace editor {
         if (ImGui::Button("Save image")) {
           std::string filepath = se::Platform::save_file(
             "", Worldtime::get().to_string() + ".exr");
-          Singleton<gfx::GFXContext>::instance()->m_jobsFrameEnd.push_back(
+          gfx::GFXContext::enqueue_frame_end(
             [tex = texture.m_handle.handle(),
             filepath = filepath]() {tex->save_image(filepath); });
         }
@@ -901,7 +901,7 @@ namespace editor {
     if (transform != nullptr) {
       if (isDirty) {
         transform->m_dirtyToFile = true;
-        transform->m_dirtyToGPU = true;
+        node.mark_dirty_to_gpu<gfx::Transform>();
       }
       m_interpolatingCameraState.update_transform(*transform);
     }
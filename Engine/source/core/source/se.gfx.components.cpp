@@ -1,4 +1,5 @@
 #include "se.gfx.hpp"
+#include "se.gfx.scene-loader.hpp"
 #include "imgui.h"
 #include "imgui_internal.h"
 #include "se.editor.helper.hpp"
@@ -63,6 +64,8 @@ namespace gfx {
         iter.second.draw(component);
         ImGui::Dummy(ImVec2(0.0f, 20.0f));
         ImGui::TreePop();
+        // edits only raise the flag, notify the scene of them
+        if (iter.second.dirtyToGPU(component)) iter.second.touch(node);
       }
       if (iter.second.couldRemove && removeComponent)
         iter.second.remove(node);
@@ -231,6 +234,8 @@ namespace gfx {
 
   auto MeshRenderer::draw_component(void* component) noexcept -> void {
     MeshRenderer* mr = (MeshRenderer*)component;
+    if (!mr->m_instances.empty())
+      ImGui::Text("Instances: %d", int(mr->m_instances.size()));
     mr->m_mesh->draw_gui(nullptr);
   }
 
@@ -239,16 +244,59 @@ namespace gfx {
     auto node_view = data.gfx_scene->m_registry.view<MeshRenderer>();
     for (auto [entity, _meshRender] : node_view.each()) {
       int const node_id = data.nodes[entity];
+      if (!_meshRender.m_instances.empty()) {
+        // write the instances with EXT_mesh_gpu_instancing
+        std::vector<float> trs(_meshRender.m_instances.size() * 10);
+        for (size_t i = 0; i < _meshRender.m_instances.size(); ++i) {
+          se::vec3 t, s; se::Quaternion quat;
+          se::decompose(_meshRender.m_instances[i], &t, &quat, &s);
+          float* translation = &trs[i * 3];
+          float* rotation = &trs[_meshRender.m_instances.size() * 3 + i * 4];
+          float* scale = &trs[_meshRender.m_instances.size() * 7 + i * 3];
+          translation[0] = t.x; translation[1] = t.y; translation[2] = t.z;
+          rotation[0] = quat.x; rotation[1] = quat.y; rotation[2] = quat.z; rotation[3] = quat.w;
+          scale[0] = s.x; scale[1] = s.y; scale[2] = s.z;
+        }
+        std::vector<std::byte> bytes(trs.size() * sizeof(float));
+        memcpy(bytes.data(), trs.data(), bytes.size());
+        int32_t instance_buffer = data.add_buffer(bytes, "Instance Buffer");
+        tinygltf::Value::Object attributes;
+        size_t const count = _meshRender.m_instances.size();
+        std::pair<char const*, size_t> entries[] = {
+          { "TRANSLATION", 0 }, { "ROTATION", count * 3 }, { "SCALE", count * 7 } };
+        for (auto& entry : entries) {
+          bool const is_rotation = entry.second == count * 3;
+          tinygltf::BufferView bufferView;
+          bufferView.buffer = instance_buffer;
+          bufferView.byteOffset = entry.second * sizeof(float);
+          bufferView.byteLength = count * sizeof(float) * (is_rotation ? 4 : 3);
+          tinygltf::Accessor accessor;
+          accessor.byteOffset = 0;
+          accessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+          accessor.count = count;
+          accessor.type = is_rotation ? TINYGLTF_TYPE_VEC4 : TINYGLTF_TYPE_VEC3;
+          attributes[entry.first] = tinygltf::Value(data.add_view_accessor(bufferView, accessor));
+        }
+        tinygltf::Value::Object extension;
+        extension["attributes"] = tinygltf::Value(attributes);
+        m->nodes[node_id].extensions["EXT_mesh_gpu_instancing"] = tinygltf::Value(extension);
+        if (std::find(m->extensionsUsed.begin(), m->extensionsUsed.end(),
+          "EXT_mesh_gpu_instancing") == m->extensionsUsed.end())
+          m->extensionsUsed.push_back("EXT_mesh_gpu_instancing");
+      }
+      // nodes sharing one mesh resource also share the glTF mesh
+      auto shared = data.m_meshes.find(_meshRender.m_mesh.get());
+      if (shared != data.m_meshes.end()) {
+        m->nodes[node_id].mesh = shared->second;
+        continue;
+      }
       int const mesh_id = m->meshes.size();
+      data.m_meshes[_meshRender.m_mesh.get()] = mesh_id;
       m->meshes.emplace_back(tinygltf::Mesh{}); 
       auto& gltf_mesh = m->meshes.back();
 
-      int32_t position_buffer = data.add_buffer(
-        _meshRender.m_mesh->m_positionBuffer->get_host(), "Position Buffer");
-      int32_t index_buffer = data.add_buffer(
-        _meshRender.m_mesh->m_indexBuffer->get_host(), "Index Buffer");
-      int32_t vertex_buffer = data.add_buffer(
-        _meshRender.m_mesh->m_vertexBuffer->get_host(), "Vertex Buffer");
+      auto const [position_buffer, index_buffer, vertex_buffer] =
+        data.add_mesh_buffers(*_meshRender.m_mesh.get());
 
       for (auto& primitive : _meshRender.m_mesh->m_primitives) {
         tinygltf::Primitive gltf_primitive;
@@ -438,12 +486,16 @@ namespace gfx {
     }
   }
 
-  CameraData::CameraData(gfx::Camera const& camera, gfx::Transform const& transform) {
+  CameraData::CameraData(gfx::Camera const& camera, gfx::Transform const& transform)
+    : CameraData(camera, transform.translation,
+      transform.translation + transform.forward(), se::vec3(0, 1, 0)) {}
+
+  CameraData::CameraData(gfx::Camera const& camera, se::vec3 eye, se::vec3 target, se::vec3 up) {
     nearZ = camera.znear;
     farZ = camera.zfar;
-    posW = transform.translation;
-    target = transform.translation + transform.forward();
-    viewMat = se::transpose(se::look_at(posW, target, se::vec3(0, 1, 0)).m);
+    posW = eye;
+    this->target = target;
+    viewMat = se::transpose(se::look_at(posW, target, up).m);
     invViewMat = se::inverse(viewMat);
     projMat = se::transpose(camera.get_projection_mat());
     invProjMat = se::inverse(projMat);
@@ -452,9 +504,9 @@ namespace gfx {
     // Ray tracing related vectors
     focalDistance = 1;
     aspectRatio = camera.aspectRatio;
-    up = se::vec3(0, 1, 0);
+    this->up = up;
     cameraW = se::normalize(target - posW) * focalDistance;
-    cameraU = se::normalize(se::cross(cameraW, up));
+    cameraU = se::normalize(se::cross(cameraW, this->up));
     cameraV = se::normalize(se::cross(cameraU, cameraW));
     const float ulen = focalDistance * std::tan(se::radians(camera.yfov) * 0.5f) * aspectRatio;
     cameraU *= ulen;
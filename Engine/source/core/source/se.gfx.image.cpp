@@ -6,6 +6,7 @@
 #pragma warning(disable:4996)
 #include <stb/image-write.hpp>
 #include <filesystem>
+#include <limits>
 
 namespace se {
 namespace image {
@@ -274,5 +275,46 @@ namespace image {
     }
     return nullptr;
   }
+
+  auto load_image_memory(void const* data, size_t size) noexcept -> std::unique_ptr<Image> {
+    unsigned char const* bytes = static_cast<unsigned char const*>(data);
+    if (size > size_t(std::numeric_limits<int>::max())) {
+      se::error("Image :: encoded image of {} bytes is too large", size);
+      return nullptr;
+    }
+    // the OpenEXR magic number, everything else goes to stb
+    if (size >= 4 && bytes[0] == 0x76 && bytes[1] == 0x2f && bytes[2] == 0x31 && bytes[3] == 0x01) {
+      float* out; int width, height;
+      const char* err = nullptr;
+      if (LoadEXRFromMemory(&out, &width, &height, bytes, size, &err) != TINYEXR_SUCCESS) {
+        se::error("Image :: failed to decode exr image: {}", err ? err : "");
+        if (err) FreeEXRErrorMessage(err);
+        return nullptr;
+      }
+      std::unique_ptr<Image> image = std::make_unique<Image>();
+      image->m_buffer = se::MiniBuffer(width * height * sizeof(float) * 4);
+      memcpy(image->m_buffer.m_data, out, width * height * sizeof(float) * 4);
+      image->m_extend = uvec3{ (uint32_t)width, (uint32_t)height, 1 };
+      image->m_format = rhi::TextureFormat::RGBA32_FLOAT;
+      image->m_dimension = rhi::TextureDimension::TEX2D;
+      image->m_dataSize = image->m_buffer.m_size;
+      image->m_mipLevels = 1;
+      image->m_arrayLayers = 1;
+      image->m_subResources.push_back(Image::SubResource{ 0, 0, 0,
+        uint32_t(image->m_buffer.m_size), uint32_t(width), uint32_t(height) });
+      free(out);
+      return image;
+    }
+    int texWidth, texHeight, texChannels;
+    stbi_uc* pixels = stbi_load_from_memory(bytes, int(size), &texWidth, &texHeight,
+      &texChannels, STBI_rgb_alpha);
+    if (!pixels) {
+      se::error("Image :: failed to decode image: {}", stbi_failure_reason());
+      return nullptr;
+    }
+    std::unique_ptr<Image> image = Binary::from_binary(texWidth, texHeight, 4, 8, (const char*)pixels);
+    stbi_image_free(pixels);
+    return image;
+  }
 }
 }
\ No newline at end of file
@@ -8,6 +8,11 @@
 #include <filesystem>
 #include "se.editor.hpp"
 #include <algorithm>
+#include <deque>
+#include <atomic>
+#include <future>
+#include <condition_variable>
+#include <mutex>
 #include "se.rdg.hpp"
 
 namespace slang_inline {
@@ -303,12 +308,43 @@ namespace gfx {
     Singleton<GFXContext>::instance()->m_ctx = std::make_unique<se::rhi::Context>(window, ext);
     Singleton<GFXContext>::instance()->m_adapter = Singleton<GFXContext>::instance()->m_ctx->request_adapter();
     Singleton<GFXContext>::instance()->m_device = Singleton<GFXContext>::instance()->m_adapter->request_device();
+    Singleton<GFXContext>::instance()->m_mainThread = std::this_thread::get_id();
   }
 
   auto GFXContext::device() noexcept -> rhi::Device* {
     return Singleton<GFXContext>::instance()->m_device.get();
   }
 
+  auto GFXContext::on_main_thread() noexcept -> bool {
+    return std::this_thread::get_id() == Singleton<GFXContext>::instance()->m_mainThread;
+  }
+
+  auto GFXContext::enqueue_frame_end(std::function<void()> job) noexcept -> void {
+    GFXContext* context = Singleton<GFXContext>::instance();
+    std::lock_guard<std::mutex> lock(context->m_jobsMutex);
+    context->m_jobsFrameEnd.emplace_back(std::move(job));
+  }
+
+  auto GFXContext::run_frame_end_jobs() noexcept -> void {
+    // jobs may enqueue more jobs, and workers append while these run
+    GFXContext* context = Singleton<GFXContext>::instance();
+    while (true) {
+      std::list<std::function<void()>> jobs;
+      {
+        std::lock_guard<std::mutex> lock(context->m_jobsMutex);
+        jobs.swap(context->m_jobsFrameEnd);
+      }
+      if (jobs.empty()) break;
+      for (auto& job : jobs) job();
+    }
+  }
+
+  auto GFXContext::wait_upload(IResource const& resource) noexcept -> void {
+    if (resource.ready()) return;
+    if (on_main_thread()) run_frame_end_jobs();
+    resource.wait_ready();
+  }
+
   auto GFXContext::create_flights(int maxFlightNum, rhi::SwapChain* swapchain) -> void {
     Singleton<GFXContext>::instance()->m_flights = device()->create_frame_resources(
       maxFlightNum, swapchain);
@@ -353,138 +389,206 @@ namespace gfx {
     return result;
   }
 
-  TextureLoader::result_type TextureLoader::operator()(from_file_tag, std::string const& path) {
-    TextureLoader::result_type result = std::make_shared<Texture>();
-    std::unique_ptr<image::Image> host_tex = image::load_image(path);
-    // create staging buffer
-    rhi::BufferDescriptor stagingBufferDescriptor;
-    stagingBufferDescriptor.size = host_tex->m_dataSize;
-    stagingBufferDescriptor.usage = rhi::BufferUsageEnum::COPY_SRC;
-    stagingBufferDescriptor.memoryProperties =
-      rhi::MemoryPropertyEnum::HOST_VISIBLE_BIT |
-      rhi::MemoryPropertyEnum::HOST_COHERENT_BIT;
-    stagingBufferDescriptor.mappedAtCreation = true;
-    std::unique_ptr<rhi::Buffer> stagingBuffer = GFXContext::device()->create_buffer(stagingBufferDescriptor);
-    std::future<bool> mapped = stagingBuffer->map_async(0, 0, stagingBufferDescriptor.size);
-    if (mapped.get()) {
-      void* mapdata = stagingBuffer->get_mapped_range(0);
-      memcpy(mapdata, host_tex->get_data(), (size_t)stagingBufferDescriptor.size);
-      stagingBuffer->unmap();
-    }
-    std::unique_ptr<rhi::CommandEncoder> commandEncoder = GFXContext::device()->create_command_encoder(nullptr);
-    // create texture image
-    result->m_texture = GFXContext::device()->create_texture(host_tex->get_descriptor());
-    result->m_resourcePath = { path };
-    // copy to target
-    commandEncoder->pipeline_barrier(rhi::BarrierDescriptor{
-      rhi::PipelineStageEnum::TOP_OF_PIPE_BIT,
-      rhi::PipelineStageEnum::TRANSFER_BIT,
-      rhi::DependencyTypeEnum::NONE,
-      {}, {}, { rhi::TextureMemoryBarrierDescriptor{
-        result->m_texture.get(),
-        rhi::TextureRange{rhi::TextureAspectEnum::COLOR_BIT, 0,
-                          host_tex->m_mipLevels, 0, host_tex->m_arrayLayers},
-        rhi::AccessFlagEnum::NONE,
-        rhi::AccessFlagEnum::TRANSFER_WRITE_BIT,
-        rhi::TextureLayoutEnum::UNDEFINED,
-        rhi::TextureLayoutEnum::TRANSFER_DST_OPTIMAL}} });
+  static inline auto rotl64(uint64_t x, int r) noexcept -> uint64_t {
+    return (x << r) | (x >> (64 - r));
+  }
+
+  static inline auto fmix64(uint64_t k) noexcept -> uint64_t {
+    k ^= k >> 33; k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33; k *= 0xc4ceb9fe1a85ec53ull;
+    return k ^ (k >> 33);
+  }
+
+  // MurmurHash3 x64_128 over the texels, seeded with the texel layout;
+  // every input bit reaches both halves, unlike a word-folding FNV
+  static auto hash_image(image::Image& image) noexcept -> TextureContentHash {
+    uint64_t seed = 14695981039346656037ull;
+    auto mix = [&](uint64_t value) { seed = fmix64(seed ^ value); };
+    mix(image.m_extend.x); mix(image.m_extend.y); mix(image.m_extend.z);
+    mix(uint64_t(image.m_format)); mix(uint64_t(image.m_dimension));
+    mix(image.m_mipLevels); mix(image.m_arrayLayers); mix(image.m_dataSize);
+
+    constexpr uint64_t c1 = 0x87c37b91114253d5ull, c2 = 0x4cf5ad432745937full;
+    char const* data = image.get_data();
+    size_t const size = image.m_dataSize;
+    size_t const blocks = size / 16;
+    uint64_t h1 = seed, h2 = seed ^ c1;
+    for (size_t i = 0; i < blocks; ++i) {
+      uint64_t k1, k2;
+      memcpy(&k1, data + i * 16, 8);
+      memcpy(&k2, data + i * 16 + 8, 8);
+      k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+      h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+      k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+      h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+    // the tail, zero padded to a block
+    unsigned char tail[16] = {};
+    memcpy(tail, data + blocks * 16, size - blocks * 16);
+    if (size % 16 != 0) {
+      uint64_t k1, k2;
+      memcpy(&k1, tail, 8);
+      memcpy(&k2, tail + 8, 8);
+      k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+      k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+    }
+    h1 ^= size; h2 ^= size;
+    h1 += h2; h2 += h1;
+    h1 = fmix64(h1); h2 = fmix64(h2);
+    h1 += h2; h2 += h1;
+    TextureContentHash hash = { h1, h2 };
+    // zero means not hashed
+    return hash ? hash : TextureContentHash{ 1, 0 };
+  }
+
+  // staging memory a single texture upload submission may take
+  static constexpr uint64_t kTextureUploadBatchBytes = 256ull << 20;
+
+  // creates the device textures of decoded images and copies the texels in.
+  // Images are packed into staging buffers of up to the batch budget, one
+  // submission each; submit only waits for the oldest batch when two are
+  // already in flight, so the images may be dropped once it returns, and
+  // finish waits for the rest
+  struct TextureUploader {
+    struct Batch {
+      std::unique_ptr<rhi::Buffer> staging;
+      std::unique_ptr<rhi::CommandEncoder> encoder;
+      std::unique_ptr<rhi::Fence> fence;
+    };
+    std::deque<Batch> in_flight;
 
-    for (auto const& subresource : host_tex->m_subResources) {
-      commandEncoder->copy_buffer_to_texture(
-        { subresource.offset, 0, 0, stagingBuffer.get() },
-        { result->m_texture.get(),
-        subresource.mip,
-        {},
-        rhi::TextureAspectEnum::COLOR_BIT },
-        { subresource.width, subresource.height, 1 });
+    auto submit(std::vector<std::pair<Texture*, image::Image*>> const& images) noexcept -> void;
+    auto finish() noexcept -> void {
+      for (Batch& batch : in_flight) batch.fence->wait();
+      in_flight.clear();
     }
+  };
 
-    commandEncoder->pipeline_barrier(rhi::BarrierDescriptor{
+  auto TextureUploader::submit(std::vector<std::pair<Texture*, image::Image*>> const& images) noexcept -> void {
+    rhi::Device* device = GFXContext::device();
+    size_t begin = 0;
+    while (begin < images.size()) {
+      // take images until the budget is full, at least one per batch;
+      // 16-byte offsets keep every texel format aligned
+      std::vector<uint64_t> offsets;
+      uint64_t size = 0;
+      size_t end = begin;
+      for (; end < images.size(); ++end) {
+        uint64_t const offset = (size + 15) & ~uint64_t(15);
+        uint64_t const bytes = images[end].second->m_dataSize;
+        if (end > begin && offset + bytes > kTextureUploadBatchBytes) break;
+        offsets.push_back(offset);
+        size = offset + bytes;
+      }
+      if (in_flight.size() >= 2) {
+        in_flight.front().fence->wait();
+        in_flight.pop_front();
+      }
+
+      Batch batch;
+      rhi::BufferDescriptor stagingBufferDescriptor;
+      stagingBufferDescriptor.size = std::max<uint64_t>(size, 16);
+      stagingBufferDescriptor.usage = rhi::BufferUsageEnum::COPY_SRC;
+      stagingBufferDescriptor.memoryProperties =
+        rhi::MemoryPropertyEnum::HOST_VISIBLE_BIT |
+        rhi::MemoryPropertyEnum::HOST_COHERENT_BIT;
+      stagingBufferDescriptor.mappedAtCreation = true;
+      batch.staging = device->create_buffer(stagingBufferDescriptor);
+      std::future<bool> mapped = batch.staging->map_async(0, 0, stagingBufferDescriptor.size);
+      if (mapped.get()) {
+        char* mapdata = static_cast<char*>(batch.staging->get_mapped_range(0));
+        for (size_t i = begin; i < end; ++i)
+          memcpy(mapdata + offsets[i - begin], images[i].second->get_data(), images[i].second->m_dataSize);
+        batch.staging->unmap();
+      }
+
+      // create the texture images, and move them all to transfer at once
+      std::vector<rhi::TextureMemoryBarrierDescriptor> to_transfer, to_shader;
+      for (size_t i = begin; i < end; ++i) {
+        Texture* result = images[i].first;
+        image::Image* host_tex = images[i].second;
+        result->m_texture = device->create_texture(host_tex->get_descriptor());
+        rhi::TextureRange const range{ rhi::TextureAspectEnum::COLOR_BIT, 0,
+          host_tex->m_mipLevels, 0, host_tex->m_arrayLayers };
+        to_transfer.push_back(rhi::TextureMemoryBarrierDescriptor{
+          result->m_texture.get(), range,
+          rhi::AccessFlagEnum::NONE,
+          rhi::AccessFlagEnum::TRANSFER_WRITE_BIT,
+          rhi::TextureLayoutEnum::UNDEFINED,
+          rhi::TextureLayoutEnum::TRANSFER_DST_OPTIMAL });
+        to_shader.push_back(rhi::TextureMemoryBarrierDescriptor{
+          result->m_texture.get(), range,
+          rhi::AccessFlagEnum::TRANSFER_WRITE_BIT,
+          rhi::AccessFlagEnum::SHADER_READ_BIT,
+          rhi::TextureLayoutEnum::TRANSFER_DST_OPTIMAL,
+          rhi::TextureLayoutEnum::SHADER_READ_ONLY_OPTIMAL });
+      }
+      batch.encoder = device->create_command_encoder(nullptr);
+      batch.encoder->pipeline_barrier(rhi::BarrierDescriptor{
+        rhi::PipelineStageEnum::TOP_OF_PIPE_BIT,
+        rhi::PipelineStageEnum::TRANSFER_BIT,
+        rhi::DependencyTypeEnum::NONE,
+        {}, {}, to_transfer });
+      for (size_t i = begin; i < end; ++i) {
+        for (auto const& subresource : images[i].second->m_subResources) {
+          batch.encoder->copy_buffer_to_texture(
+            { offsets[i - begin] + subresource.offset, 0, 0, batch.staging.get() },
+            { images[i].first->m_texture.get(),
+            subresource.mip,
+            {},
+            rhi::TextureAspectEnum::COLOR_BIT },
+            { subresource.width, subresource.height, 1 });
+        }
+      }
+      batch.encoder->pipeline_barrier(rhi::BarrierDescriptor{
         rhi::PipelineStageEnum::TRANSFER_BIT,
         rhi::PipelineStageEnum::FRAGMENT_SHADER_BIT,
         rhi::DependencyTypeEnum::NONE,
-        {}, {},
-        {rhi::TextureMemoryBarrierDescriptor{
-            result->m_texture.get(),
-            rhi::TextureRange{rhi::TextureAspectEnum::COLOR_BIT, 0,
-                                       host_tex->m_mipLevels, 0, host_tex->m_arrayLayers},
-            rhi::AccessFlagEnum::TRANSFER_WRITE_BIT,
-            rhi::AccessFlagEnum::SHADER_READ_BIT,
-            rhi::TextureLayoutEnum::TRANSFER_DST_OPTIMAL,
-            rhi::TextureLayoutEnum::SHADER_READ_ONLY_OPTIMAL}} });
-
-    GFXContext::device()->get_graphics_queue().submit({commandEncoder->finish()});
-    GFXContext::device()->wait_idle();
+        {}, {}, to_shader });
+      batch.fence = device->create_fence();
+      batch.fence->reset();
+      device->get_graphics_queue().submit({ batch.encoder->finish() }, batch.fence.get());
+      in_flight.emplace_back(std::move(batch));
+      begin = end;
+    }
+  }
+
+  static auto upload_images(std::vector<std::pair<Texture*, image::Image*>> const& images) noexcept -> void {
+    TextureUploader uploader;
+    uploader.submit(images);
+    uploader.finish();
+  }
+
+  // create the device texture of a decoded image and copy the texels in
+  static auto upload_image(Texture* result, image::Image* host_tex) noexcept -> void {
+    upload_images({ { result, host_tex } });
+  }
+
+  TextureLoader::result_type TextureLoader::operator()(from_empty_tag) {
+    return std::make_shared<Texture>();
+  }
+
+  TextureLoader::result_type TextureLoader::operator()(from_file_tag, std::string const& path) {
+    TextureLoader::result_type result = std::make_shared<Texture>();
+    std::unique_ptr<image::Image> host_tex = image::load_image(path);
+    result->m_contentHash = hash_image(*host_tex);
+    result->m_resourcePath = { path };
+    upload_image(result.get(), host_tex.get());
     return result;
   }
-  
+
   TextureLoader::result_type TextureLoader::operator()(TextureLoader::from_binary_tag, int width, int height, int channel, int bits, const char* data) {
     TextureLoader::result_type result = std::make_shared<Texture>();
     std::unique_ptr<image::Image> host_tex = image::Binary::from_binary(width, height, channel, bits, data);
-    // create staging buffer
-    rhi::BufferDescriptor stagingBufferDescriptor;
-    stagingBufferDescriptor.size = host_tex->m_dataSize;
-    stagingBufferDescriptor.usage = (uint32_t)rhi::BufferUsageEnum::COPY_SRC;
-    stagingBufferDescriptor.memoryProperties =
-      (uint32_t)rhi::MemoryPropertyEnum::HOST_VISIBLE_BIT |
-      (uint32_t)rhi::MemoryPropertyEnum::HOST_COHERENT_BIT;
-    stagingBufferDescriptor.mappedAtCreation = true;
-    std::unique_ptr<rhi::Buffer> stagingBuffer = GFXContext::device()->create_buffer(stagingBufferDescriptor);
-    std::future<bool> mapped = stagingBuffer->map_async(0, 0, stagingBufferDescriptor.size);
-    if (mapped.get()) {
-      void* mapdata = stagingBuffer->get_mapped_range(0);
-      memcpy(mapdata, host_tex->get_data(), (size_t)stagingBufferDescriptor.size);
-      stagingBuffer->unmap();
-    }
-    std::unique_ptr<rhi::CommandEncoder> commandEncoder = GFXContext::device()->create_command_encoder({ nullptr });
-    // create texture image
-    result->m_texture = GFXContext::device()->create_texture(host_tex->get_descriptor());
-    // copy to target
-    commandEncoder->pipeline_barrier(rhi::BarrierDescriptor{
-      (uint32_t)rhi::PipelineStageEnum::TOP_OF_PIPE_BIT,
-      (uint32_t)rhi::PipelineStageEnum::TRANSFER_BIT,
-      (uint32_t)rhi::DependencyTypeEnum::NONE,
-      {}, {}, { rhi::TextureMemoryBarrierDescriptor{
-        result->m_texture.get(),
-        rhi::TextureRange{(uint32_t)rhi::TextureAspectEnum::COLOR_BIT, 0,
-          host_tex->m_mipLevels, 0, host_tex->m_arrayLayers},
-        (uint32_t)rhi::AccessFlagEnum::NONE,
-        (uint32_t)rhi::AccessFlagEnum::TRANSFER_WRITE_BIT,
-        rhi::TextureLayoutEnum::UNDEFINED,
-        rhi::TextureLayoutEnum::TRANSFER_DST_OPTIMAL}} });
-
-    for (auto const& subresource : host_tex->m_subResources) {
-      commandEncoder->copy_buffer_to_texture(
-        { subresource.offset, 0, 0, stagingBuffer.get() },
-        { result->m_texture.get(),
-        subresource.mip,
-        {},
-        (uint32_t)rhi::TextureAspectEnum::COLOR_BIT },
-        { subresource.width, subresource.height, 1 });
-    }
-
-    commandEncoder->pipeline_barrier(rhi::BarrierDescriptor{
-        (uint32_t)rhi::PipelineStageEnum::TRANSFER_BIT,
-        (uint32_t)rhi::PipelineStageEnum::FRAGMENT_SHADER_BIT,
-        (uint32_t)rhi::DependencyTypeEnum::NONE,
-        {}, {},
-        {rhi::TextureMemoryBarrierDescriptor{
-            result->m_texture.get(),
-            rhi::TextureRange{(uint32_t)rhi::TextureAspectEnum::COLOR_BIT, 0,
-              host_tex->m_mipLevels, 0, host_tex->m_arrayLayers},
-            (uint32_t)rhi::AccessFlagEnum::TRANSFER_WRITE_BIT,
-            (uint32_t)rhi::AccessFlagEnum::SHADER_READ_BIT,
-            rhi::TextureLayoutEnum::TRANSFER_DST_OPTIMAL,
-            rhi::TextureLayoutEnum::SHADER_READ_ONLY_OPTIMAL}} });
-
-    GFXContext::device()->get_graphics_queue().submit({commandEncoder->finish()});
-    GFXContext::device()->wait_idle();
+    result->m_contentHash = hash_image(*host_tex);
+    upload_image(result.get(), host_tex.get());
     return result;
   }
 
   auto GFXContext::create_buffer_empty(
   ) noexcept -> BufferHandle {
     UID const ruid = Resources::query_runtime_uid();
+    std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.buffers);
     auto ret = Singleton<GFXContext>::instance()->m_buffers.load(
       ruid, BufferLoader::from_empty_tag{});
     return BufferHandle{ ret.first->second };
@@ -494,6 +598,7 @@ namespace gfx {
     rhi::BufferDescriptor const& desc
   ) noexcept -> BufferHandle {
     UID const ruid = Resources::query_runtime_uid();
+    std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.buffers);
     auto ret = Singleton<GFXContext>::instance()->m_buffers.load(
       ruid, BufferLoader::from_desc_tag{}, desc);
     return BufferHandle{ ret.first->second };
@@ -501,12 +606,44 @@ namespace gfx {
 
   auto GFXContext::create_buffer_host(
     MiniBuffer const& buffer,
-    Flags<rhi::BufferUsageEnum> usages
+    Flags<rhi::BufferUsageEnum> usages,
+    bool keepHost
   ) noexcept -> BufferHandle {
+    // only the main thread submits to the queue
+    if (!on_main_thread()) return create_buffer_host_async(buffer, usages, keepHost);
     UID const ruid = Resources::query_runtime_uid();
+    std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.buffers);
     auto ret = Singleton<GFXContext>::instance()->m_buffers.load(
       ruid, BufferLoader::from_host_tag{}, buffer, usages);
-    return BufferHandle{ ret.first->second };
+    BufferHandle handle{ ret.first->second };
+    handle->m_usages = usages;
+    handle->m_residentOnHost = keepHost;
+    if (keepHost) {
+      std::byte const* bytes = static_cast<std::byte const*>(buffer.m_data);
+      handle->m_host.assign(bytes, bytes + buffer.m_size);
+    }
+    return handle;
+  }
+
+  auto GFXContext::create_buffer_host_async(
+    MiniBuffer const& buffer,
+    Flags<rhi::BufferUsageEnum> usages,
+    bool keepHost
+  ) noexcept -> BufferHandle {
+    BufferHandle handle = create_buffer_empty();
+    handle->m_usages = usages;
+    handle->m_residentOnHost = keepHost;
+    // staged in the host copy until the upload, then dropped unless kept
+    handle->m_host.resize(buffer.m_size);
+    memcpy(handle->m_host.data(), buffer.m_data, buffer.m_size);
+    auto done = std::make_shared<std::promise<void>>();
+    handle->m_upload = done->get_future().share();
+    enqueue_frame_end([buffer = handle.m_handle.handle(), done]() {
+      buffer->m_buffer = GFXContext::device()->create_device_local_buffer(
+        static_cast<void const*>(buffer->m_host.data()), buffer->m_host.size(), buffer->m_usages);
+      if (!buffer->m_residentOnHost) std::vector<std::byte>().swap(buffer->m_host);
+      done->set_value(); });
+    return handle;
   }
 
   auto Texture::save_image(std::string const& path) noexcept -> void {
@@ -620,6 +757,7 @@ namespace gfx {
     rhi::TextureDescriptor const& desc
   ) noexcept -> TextureHandle {
     UID const ruid = Resources::query_runtime_uid();
+    std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.textures);
     auto ret = Singleton<GFXContext>::instance()->m_textures.load(
       ruid, TextureLoader::from_desc_tag{}, desc);
     entt::resource<Texture> res = ret.first->second;
@@ -628,15 +766,41 @@ namespace gfx {
     return TextureHandle{ ret.first->second };
   }
 
+  // a newly decoded texture with the same texels as a loaded one is
+  // dropped, and the loaded one is returned in its place;
+  // the caller holds the texture cache lock
+  static auto intern_texture(UID ruid, TextureHandle texture) noexcept -> TextureHandle {
+    GFXContext* context = Singleton<GFXContext>::instance();
+    if (!texture->m_contentHash) return texture;
+    auto iter = context->m_textureContents.find(texture->m_contentHash);
+    if (iter == context->m_textureContents.end() || iter->second == ruid
+      || !context->m_textures.contains(iter->second)) {
+      context->m_textureContents[texture->m_contentHash] = ruid;
+      return texture;
+    }
+    UID const canonical = iter->second;
+    context->m_textureAliases[ruid] = canonical;
+    context->m_textures.erase(ruid);
+    return TextureHandle{ context->m_textures[canonical] };
+  }
+
   auto GFXContext::load_texture_file(
     std::string const& path
   ) noexcept -> TextureHandle {
+    // only the main thread submits to the queue
+    if (!on_main_thread()) return load_texture_file_async(path);
     std::string abs_path = Filesys::resolve_path(path, {
       Configuration::string_property("engine_path"),
       Configuration::string_property("project_path")
     });
     UID const ruid = Resources::query_string_uid(abs_path);
-    auto ret = Singleton<GFXContext>::instance()->m_textures.load(
+    GFXContext* context = Singleton<GFXContext>::instance();
+    std::lock_guard<std::recursive_mutex> lock(context->m_locks.textures);
+    // the path was found to duplicate another texture before
+    auto alias = context->m_textureAliases.find(ruid);
+    if (alias != context->m_textureAliases.end() && context->m_textures.contains(alias->second))
+      return TextureHandle{ context->m_textures[alias->second] };
+    auto ret = context->m_textures.load(
       ruid, TextureLoader::from_file_tag{}, abs_path);
     // true only if the resource was not already present
     const bool loaded = ret.second;
@@ -644,7 +808,46 @@ namespace gfx {
     entt::resource<Texture> res = ret.first->second;
     res->m_uid = ruid;
     res->init();
-    return TextureHandle{ ret.first->second };
+    if (!loaded) return TextureHandle{ ret.first->second };
+    return intern_texture(ruid, TextureHandle{ ret.first->second });
+  }
+
+  auto GFXContext::load_texture_file_async(
+    std::string const& path
+  ) noexcept -> TextureHandle {
+    std::string abs_path = Filesys::resolve_path(path, {
+      Configuration::string_property("engine_path"),
+      Configuration::string_property("project_path")
+    });
+    UID const ruid = Resources::query_string_uid(abs_path);
+    GFXContext* context = Singleton<GFXContext>::instance();
+    {
+      std::lock_guard<std::recursive_mutex> lock(context->m_locks.textures);
+      auto alias = context->m_textureAliases.find(ruid);
+      if (alias != context->m_textureAliases.end() && context->m_textures.contains(alias->second))
+        return TextureHandle{ context->m_textures[alias->second] };
+      if (context->m_textures.contains(ruid))
+        return TextureHandle{ context->m_textures[ruid] };
+    }
+    // decode without the lock, so that other threads decode alongside
+    std::shared_ptr<image::Image> host_tex = image::load_image(abs_path);
+    std::lock_guard<std::recursive_mutex> lock(context->m_locks.textures);
+    auto ret = context->m_textures.load(ruid, TextureLoader::from_empty_tag{});
+    // another thread finished the same path first
+    if (!ret.second) return TextureHandle{ ret.first->second };
+    TextureHandle handle{ ret.first->second };
+    handle->m_uid = ruid;
+    handle->m_resourcePath = { abs_path };
+    handle->m_contentHash = hash_image(*host_tex);
+    // later loads with the same texels are interned to this one
+    context->m_textureContents.emplace(handle->m_contentHash, ruid);
+    auto done = std::make_shared<std::promise<void>>();
+    handle->m_upload = done->get_future().share();
+    enqueue_frame_end([texture = handle.m_handle.handle(), host_tex, done]() {
+      upload_image(texture.get(), host_tex.get());
+      texture->init();
+      done->set_value(); });
+    return handle;
   }
 
   auto GFXContext::load_texture_binary(
@@ -652,16 +855,204 @@ namespace gfx {
     int bits, const char* data
   ) noexcept -> TextureHandle {
     UID const ruid = Resources::query_runtime_uid();
+    std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.textures);
     auto ret = Singleton<GFXContext>::instance()->m_textures.load(
       ruid, TextureLoader::from_binary_tag{},
       width, height, channel, bits, data);
-    // true only if the resource was not already present
-    const bool loaded = ret.second;
     // takes the resource handle pointed to by the returned iterator
     entt::resource<Texture> res = ret.first->second;
     res->m_uid = ruid;
     res->init();
-    return TextureHandle{ ret.first->second };
+    return intern_texture(ruid, TextureHandle{ ret.first->second });
+  }
+
+  struct TextureSource {
+    UID ruid;
+    std::optional<std::string> path;
+  };
+
+  // Decodes and hashes the images on the workers, while the calling thread
+  // interns each one as it finishes and uploads the new ones in batches of
+  // the upload budget. Workers hold back while a budget of decoded texels
+  // waits, so the host keeps about one batch, plus the images being decoded,
+  // instead of the whole set. The cache lock is only held to intern, and
+  // every new texture is ready() once its batch is submitted; off the main
+  // thread the batches are submitted at the next frame end.
+  template <class Decode>
+  static auto load_textures(std::vector<TextureSource> const& sources, Decode const& decode) noexcept -> std::vector<TextureHandle> {
+    GFXContext* context = Singleton<GFXContext>::instance();
+    std::vector<TextureHandle> handles(sources.size());
+    if (sources.empty()) return handles;
+
+    struct Decoded {
+      size_t index;
+      std::shared_ptr<image::Image> image;
+      TextureContentHash hash;
+    };
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<Decoded> finished;
+    // texels decoded and not yet uploaded or dropped
+    uint64_t queued = 0;
+    std::atomic<size_t> next = 0;
+    auto worker = [&]() {
+      for (size_t i = next++; i < sources.size(); i = next++) {
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          changed.wait(lock, [&]() { return queued < kTextureUploadBatchBytes; });
+        }
+        Decoded decoded = { i, decode(i), {} };
+        if (decoded.image) decoded.hash = hash_image(*decoded.image);
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (decoded.image) queued += decoded.image->m_dataSize;
+          finished.emplace_back(std::move(decoded));
+        }
+        changed.notify_all();
+      }
+    };
+    size_t const worker_count = std::min<size_t>(sources.size(),
+      std::max<unsigned>(std::thread::hardware_concurrency(), 1u));
+    std::vector<std::future<void>> jobs;
+    jobs.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i)
+      jobs.emplace_back(std::async(std::launch::async, worker));
+
+    bool const on_main = GFXContext::on_main_thread();
+    TextureUploader uploader;
+    std::vector<std::pair<std::shared_ptr<Texture>, std::shared_ptr<image::Image>>> batch;
+    uint64_t batch_bytes = 0;
+    auto done = std::make_shared<std::promise<void>>();
+    std::shared_future<void> ready = done->get_future().share();
+    auto release = [&](uint64_t bytes) {
+      { std::lock_guard<std::mutex> lock(mutex); queued -= bytes; }
+      changed.notify_all();
+    };
+    auto flush = [&]() {
+      if (batch.empty()) return;
+      if (on_main) {
+        std::vector<std::pair<Texture*, image::Image*>> images;
+        images.reserve(batch.size());
+        for (auto const& entry : batch) images.emplace_back(entry.first.get(), entry.second.get());
+        uploader.submit(images);
+        for (auto const& entry : batch) entry.first->init();
+        done->set_value();
+      }
+      else {
+        // only the main thread submits to the queue, the frame end job
+        // keeps the images until then
+        GFXContext::enqueue_frame_end([batch, done]() {
+          std::vector<std::pair<Texture*, image::Image*>> images;
+          images.reserve(batch.size());
+          for (auto const& entry : batch) images.emplace_back(entry.first.get(), entry.second.get());
+          upload_images(images);
+          for (auto const& entry : batch) entry.first->init();
+          done->set_value(); });
+      }
+      batch.clear();
+      release(batch_bytes);
+      batch_bytes = 0;
+      done = std::make_shared<std::promise<void>>();
+      ready = done->get_future().share();
+    };
+
+    for (size_t received = 0; received < sources.size(); ++received) {
+      Decoded decoded;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&]() { return !finished.empty(); });
+        decoded = std::move(finished.front());
+        finished.pop_front();
+      }
+      if (decoded.image == nullptr) continue;
+      uint64_t const bytes = decoded.image->m_dataSize;
+      TextureSource const& source = sources[decoded.index];
+      std::shared_ptr<Texture> created;
+      {
+        std::lock_guard<std::recursive_mutex> lock(context->m_locks.textures);
+        auto content = context->m_textureContents.find(decoded.hash);
+        // another thread finished the same path first
+        if (context->m_textures.contains(source.ruid))
+          handles[decoded.index] = TextureHandle{ context->m_textures[source.ruid] };
+        // the texels of a loaded texture
+        else if (content != context->m_textureContents.end() && context->m_textures.contains(content->second)) {
+          context->m_textureAliases[source.ruid] = content->second;
+          handles[decoded.index] = TextureHandle{ context->m_textures[content->second] };
+        }
+        else {
+          auto ret = context->m_textures.load(source.ruid, TextureLoader::from_empty_tag{});
+          TextureHandle handle{ ret.first->second };
+          handle->m_uid = source.ruid;
+          handle->m_resourcePath = source.path;
+          handle->m_contentHash = decoded.hash;
+          context->m_textureContents[decoded.hash] = source.ruid;
+          created = handle.m_handle.handle();
+          handles[decoded.index] = handle;
+        }
+      }
+      if (created == nullptr) {
+        decoded.image = nullptr;
+        release(bytes);
+        continue;
+      }
+      if (!batch.empty() && batch_bytes + bytes > kTextureUploadBatchBytes) flush();
+      created->m_upload = ready;
+      batch.emplace_back(std::move(created), std::move(decoded.image));
+      batch_bytes += bytes;
+      // a full batch goes at once, the workers wait for its bytes
+      if (batch_bytes >= kTextureUploadBatchBytes) flush();
+    }
+    flush();
+    uploader.finish();
+    for (auto& job : jobs) job.get();
+    return handles;
+  }
+
+  auto GFXContext::load_texture_files(
+    std::vector<std::string> const& paths
+  ) noexcept -> std::vector<TextureHandle> {
+    GFXContext* context = Singleton<GFXContext>::instance();
+    std::vector<TextureHandle> handles(paths.size());
+    // the paths not loaded yet, each is decoded once however often it is asked for
+    std::vector<TextureSource> sources;
+    std::vector<size_t> slots(paths.size(), SIZE_MAX);
+    {
+      std::unordered_map<UID, size_t> pending;
+      std::lock_guard<std::recursive_mutex> lock(context->m_locks.textures);
+      for (size_t i = 0; i < paths.size(); ++i) {
+        std::string abs_path = Filesys::resolve_path(paths[i], {
+          Configuration::string_property("engine_path"),
+          Configuration::string_property("project_path")
+        });
+        UID const ruid = Resources::query_string_uid(abs_path);
+        auto alias = context->m_textureAliases.find(ruid);
+        if (alias != context->m_textureAliases.end() && context->m_textures.contains(alias->second)) {
+          handles[i] = TextureHandle{ context->m_textures[alias->second] };
+          continue;
+        }
+        if (context->m_textures.contains(ruid)) {
+          handles[i] = TextureHandle{ context->m_textures[ruid] };
+          continue;
+        }
+        auto iter = pending.emplace(ruid, sources.size());
+        if (iter.second) sources.push_back(TextureSource{ ruid, abs_path });
+        slots[i] = iter.first->second;
+      }
+    }
+    std::vector<TextureHandle> loaded = load_textures(sources, [&](size_t i) {
+      return std::shared_ptr<image::Image>(image::load_image(*sources[i].path)); });
+    for (size_t i = 0; i < paths.size(); ++i)
+      if (slots[i] != SIZE_MAX) handles[i] = loaded[slots[i]];
+    return handles;
+  }
+
+  auto GFXContext::load_texture_encoded(
+    std::vector<ext::span<std::byte const>> const& images
+  ) noexcept -> std::vector<TextureHandle> {
+    std::vector<TextureSource> sources(images.size());
+    for (auto& source : sources) source.ruid = Resources::query_runtime_uid();
+    return load_textures(sources, [&](size_t i) {
+      return std::shared_ptr<image::Image>(image::load_image_memory(images[i].data(), images[i].size())); });
   }
 
   inline auto combineResourceFlags(
@@ -830,6 +1221,7 @@ namespace gfx {
     SamplerLoader::from_desc_tag, rhi::SamplerDescriptor const& desc) {
     std::shared_ptr<Sampler> ret = std::make_shared<Sampler>();
     ret->m_sampler = GFXContext::device()->create_sampler(desc);
+    ret->m_desc = desc;
     return ret;
   }
 
@@ -1640,12 +2032,120 @@ namespace gfx {
       m_bufferStamp = m_hostStamp;
       m_previousStamp = m_bufferStamp;
     }
+    release_host();
+  }
+
+  auto Buffer::host_to_device_ranges(std::vector<std::pair<size_t, size_t>> const& ranges) noexcept -> void {
+    if (ranges.empty() || m_buffer == nullptr || m_buffer->size() != m_host.size()
+      || m_memoryCopyMode != MemoryCopyMode::TEMPORARY_STAGING) {
+      host_to_device();
+      return;
+    }
+    size_t staging_size = 0;
+    for (auto const& range : ranges) staging_size += range.second;
+    rhi::Device* device = GFXContext::device();
+    rhi::BufferDescriptor staging_desc;
+    staging_desc.size = staging_size;
+    staging_desc.usage = rhi::BufferUsageEnum::COPY_SRC;
+    staging_desc.memoryProperties = rhi::MemoryPropertyEnum::HOST_VISIBLE_BIT
+      | rhi::MemoryPropertyEnum::HOST_COHERENT_BIT;
+    staging_desc.mappedAtCreation = true;
+    std::unique_ptr<rhi::Buffer> staging = device->create_buffer(staging_desc);
+    if (!staging->map_async(0, 0, staging_size).get()) {
+      host_to_device();
+      return;
+    }
+    std::byte* mapped = static_cast<std::byte*>(staging->get_mapped_range(0));
+    size_t cursor = 0;
+    for (auto const& range : ranges) {
+      memcpy(mapped + cursor, &m_host[range.first], range.second);
+      cursor += range.second;
+    }
+    staging->unmap();
+
+    // the copies wait for earlier submissions still reading the buffer
+    std::unique_ptr<rhi::CommandEncoder> encoder = device->create_command_encoder({ nullptr });
+    encoder->pipeline_barrier(rhi::BarrierDescriptor{
+      rhi::PipelineStageEnum::ALL_COMMANDS_BIT,
+      rhi::PipelineStageEnum::TRANSFER_BIT, 0, {},
+      { rhi::BufferMemoryBarrierDescriptor{ m_buffer.get(),
+        rhi::AccessFlagEnum::SHADER_READ_BIT,
+        rhi::AccessFlagEnum::TRANSFER_WRITE_BIT } }, {} });
+    cursor = 0;
+    for (auto const& range : ranges) {
+      encoder->copy_buffer_to_buffer(staging.get(), cursor, m_buffer.get(), range.first, range.second);
+      cursor += range.second;
+    }
+    encoder->pipeline_barrier(rhi::BarrierDescriptor{
+      rhi::PipelineStageEnum::TRANSFER_BIT,
+      rhi::PipelineStageEnum::ALL_COMMANDS_BIT, 0, {},
+      { rhi::BufferMemoryBarrierDescriptor{ m_buffer.get(),
+        rhi::AccessFlagEnum::TRANSFER_WRITE_BIT,
+        rhi::AccessFlagEnum::SHADER_READ_BIT } }, {} });
+    std::unique_ptr<rhi::Fence> fence = device->create_fence();
+    fence->reset();
+    device->get_graphics_queue().submit({ encoder->finish() }, fence.get());
+    fence->wait();
+    m_bufferStamp = m_hostStamp;
+    m_previousStamp = m_bufferStamp;
+    release_host();
   }
 
   auto Buffer::device_to_host() noexcept -> void {
-    if (m_host.size() < m_buffer->size()) 
-      m_host.resize(m_buffer->size());
-    GFXContext::device()->readback_device_local_buffer(m_buffer.get(), m_host.data(), m_buffer->size());
+    device_to_host_async().wait();
+  }
+
+  auto Buffer::device_to_host_async() noexcept -> std::future<void> {
+    // the device copy was released, the host copy is the newest
+    if (m_buffer == nullptr) {
+      std::promise<void> done;
+      done.set_value();
+      return done.get_future();
+    }
+    rhi::Device* device = GFXContext::device();
+    size_t const size = m_buffer->size();
+    rhi::BufferDescriptor staging_desc;
+    staging_desc.size = size;
+    staging_desc.usage = rhi::BufferUsageEnum::COPY_DST;
+    staging_desc.memoryProperties = rhi::MemoryPropertyEnum::HOST_VISIBLE_BIT
+      | rhi::MemoryPropertyEnum::HOST_COHERENT_BIT;
+    staging_desc.mappedAtCreation = true;
+    std::unique_ptr<rhi::Buffer> staging = device->create_buffer(staging_desc);
+    std::unique_ptr<rhi::CommandEncoder> encoder = device->create_command_encoder({ nullptr });
+    encoder->pipeline_barrier(rhi::BarrierDescriptor{
+      rhi::PipelineStageEnum::ALL_COMMANDS_BIT,
+      rhi::PipelineStageEnum::TRANSFER_BIT, 0, {},
+      { rhi::BufferMemoryBarrierDescriptor{ m_buffer.get(),
+        rhi::AccessFlagEnum::SHADER_WRITE_BIT,
+        rhi::AccessFlagEnum::TRANSFER_READ_BIT } }, {} });
+    encoder->copy_buffer_to_buffer(m_buffer.get(), 0, staging.get(), 0, size);
+    std::unique_ptr<rhi::Fence> fence = device->create_fence();
+    fence->reset();
+    device->get_graphics_queue().submit({ encoder->finish() }, fence.get());
+    // the host only blocks once the data is asked for, so several
+    // readbacks could be in flight together
+    return std::async(std::launch::deferred, [this, size, staging = std::move(staging),
+      encoder = std::move(encoder), fence = std::move(fence)]() {
+      fence->wait();
+      if (!staging->map_async(0, 0, size).get()) return;
+      if (m_host.size() < size) m_host.resize(size);
+      memcpy(m_host.data(), staging->get_mapped_range(0), size);
+      staging->unmap();
+    });
+  }
+
+  auto Buffer::release_host() noexcept -> void {
+    // keep the host copy until the device holds every change
+    if (m_residentOnHost || m_buffer == nullptr || m_previousStamp != m_hostStamp) return;
+    std::vector<std::byte>().swap(m_host);
+  }
+
+  auto Buffer::host_bytes() const noexcept -> size_t {
+    return m_host.capacity();
+  }
+
+  auto Buffer::device_bytes() const noexcept -> size_t {
+    return (m_buffer ? m_buffer->size() : 0) + (m_previous ? m_previous->size() : 0);
   }
 
   auto Buffer::create_device() noexcept -> void {
@@ -1704,6 +2204,18 @@ namespace gfx {
       ImGui::TableSetColumnIndex(1);
       ImGui::Text("%s", m_job.c_str());
 
+      ImGui::TableNextRow();
+      ImGui::TableSetColumnIndex(0);
+      ImGui::Text("Host bytes");
+      ImGui::TableSetColumnIndex(1);
+      ImGui::Text("%zu%s", host_bytes(), m_residentOnHost ? "" : " (released after upload)");
+
+      ImGui::TableNextRow();
+      ImGui::TableSetColumnIndex(0);
+      ImGui::Text("Device bytes");
+      ImGui::TableSetColumnIndex(1);
+      ImGui::Text("%zu", device_bytes());
+
       //// Example row 2
       //ImGui::TableNextRow();
       //ImGui::TableSetColumnIndex(0);
@@ -1855,7 +2367,7 @@ namespace gfx {
     if (ImGui::Button("Save image")) {
       std::string filepath = se::Platform::save_file(
         "", Worldtime::get().to_string() + ".exr");
-      Singleton<gfx::GFXContext>::instance()->m_jobsFrameEnd.push_back(
+      gfx::GFXContext::enqueue_frame_end(
         [tex = this, filepath = filepath]() {tex->save_image(filepath); });
     }
     ImGui::SameLine();
@@ -2004,6 +2516,11 @@ namespace gfx {
         ImGui::Text("Bounds Max"); ImGui::NextColumn();
         ImGui::Text("(%.2f, %.2f, %.2f)", mesh.max.x, mesh.max.y, mesh.max.z); ImGui::NextColumn();
 
+        for (size_t k = 0; k < mesh.lods.size(); ++k) {
+          ImGui::Text("LOD %zu", k + 1); ImGui::NextColumn();
+          ImGui::Text("%zu triangles | error %.4g", mesh.lods[k].size / 3, mesh.lods[k].error); ImGui::NextColumn();
+        }
+
         ImGui::Text("Material"); ImGui::NextColumn();
         bool open_mat = ImGui::TreeNodeEx("##MyRightArrow", 
           ImGuiTreeNodeFlags_Framed | ImGuiTreeNodeFlags_NoTreePushOnOpen | 
@@ -2325,6 +2842,7 @@ namespace gfx {
 
         static gfx_content_gui::AssetsBrowser buffer_browser;
         auto& buffer_cache = Singleton<GFXContext>::instance()->m_buffers;
+        std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.buffers);
         std::function<void(ex::resource<se::gfx::Buffer>)> callback_click =
           [](ex::resource<se::gfx::Buffer> item) {
           BufferHandle handle = { item };
@@ -2346,6 +2864,7 @@ namespace gfx {
 
         static gfx_content_gui::AssetsBrowser texture_browser;
         auto& texture_cache = Singleton<GFXContext>::instance()->m_textures;
+        std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.textures);
         std::function<void(ex::resource<se::gfx::Texture>)> callback_click =
           [](ex::resource<se::gfx::Texture> item) {
           TextureHandle handle = { item };
@@ -2391,6 +2910,7 @@ namespace gfx {
 
         static gfx_content_gui::AssetsBrowser shader_browser;
         auto& shader_cache = Singleton<GFXContext>::instance()->m_shaders;
+        std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.shaders);
 
         std::function<void(ex::resource<se::gfx::ShaderModule>)> callback_click = 
           [](ex::resource<se::gfx::ShaderModule> item) {
@@ -2412,6 +2932,7 @@ namespace gfx {
 
         static gfx_content_gui::AssetsBrowser mesh_browser;
         auto& mesh_cache = Singleton<GFXContext>::instance()->m_meshs;
+        std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.meshs);
 
         std::function<void(ex::resource<se::gfx::Mesh>)> callback_click =
           [](ex::resource<se::gfx::Mesh> item) {
@@ -2433,6 +2954,7 @@ namespace gfx {
 
         static gfx_content_gui::AssetsBrowser material_browser;
         auto& material_cache = Singleton<GFXContext>::instance()->m_materials;
+        std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.materials);
 
         std::function<void(ex::resource<se::gfx::Material>)> callback_click =
           [](ex::resource<se::gfx::Material> item) {
@@ -2457,6 +2979,7 @@ namespace gfx {
 
   auto GFXContext::clean_buffer_cache() noexcept -> void {
     auto& buffers = Singleton<GFXContext>::instance()->m_buffers;
+    std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.buffers);
     for (auto it = buffers.begin(); it != buffers.end(); ) {
       if (it->second.handle().use_count() <= 2) {
         it->second->m_countDown--;
@@ -2469,8 +2992,27 @@ namespace gfx {
     }
   }
   
+  auto GFXContext::report_buffer_bytes() noexcept -> std::vector<ResourceBytes> {
+    std::vector<ResourceBytes> report;
+    size_t host = 0, device = 0;
+    std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.buffers);
+    for (auto [id, buffer] : Singleton<GFXContext>::instance()->m_buffers) {
+      ResourceBytes bytes = { buffer->m_name.empty() ? buffer->m_job : buffer->m_name,
+        buffer->host_bytes(), buffer->device_bytes() };
+      host += bytes.host;
+      device += bytes.device;
+      report.emplace_back(std::move(bytes));
+    }
+    std::sort(report.begin(), report.end(), [](ResourceBytes const& a, ResourceBytes const& b) {
+      return a.host > b.host; });
+    se::info("gfx :: memory :: {} buffers hold {} MB on host and {} MB on device",
+      report.size(), host >> 20, device >> 20);
+    return report;
+  }
+
   auto GFXContext::clean_texture_cache() noexcept -> void {
     auto& textures = Singleton<GFXContext>::instance()->m_textures;
+    std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.textures);
     for (auto it = textures.begin(); it != textures.end(); ) {
       if (it->second.handle().use_count() <= 2) {
         it->second->m_countDown--;
@@ -2488,6 +3030,7 @@ namespace gfx {
 
   auto GFXContext::clean_shader_cache() noexcept -> void {
     auto& shaders = Singleton<GFXContext>::instance()->m_shaders;
+    std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.shaders);
     for (auto it = shaders.begin(); it != shaders.end(); ) {
       if (it->second.handle().use_count() <= 2) {
         it = shaders.erase(it); // erase returns the next iterator
@@ -2499,24 +3042,45 @@ namespace gfx {
 
   }
 
+  // every field takes part, descriptors differing only in lod range or
+  // anisotropy must not share a sampler
   inline uint64_t hash(rhi::SamplerDescriptor const& desc) {
-    uint64_t hashed_value = 0;
-    hashed_value |= (uint64_t)(desc.addressModeU) << 62;
-    hashed_value |= (uint64_t)(desc.addressModeV) << 60;
-    hashed_value |= (uint64_t)(desc.addressModeW) << 58;
-    hashed_value |= (uint64_t)(desc.magFilter) << 57;
-    hashed_value |= (uint64_t)(desc.minFilter) << 56;
-    hashed_value |= (uint64_t)(desc.mipmapFilter) << 55;
-    hashed_value |= (uint64_t)(desc.compare) << 50;
+    uint64_t hashed_value = 14695981039346656037ull;
+    auto mix = [&](uint64_t value) { hashed_value = (hashed_value ^ value) * 1099511628211ull; };
+    auto bits = [](float value) { uint32_t word; memcpy(&word, &value, sizeof(float)); return word; };
+    mix(uint64_t(desc.addressModeU));
+    mix(uint64_t(desc.addressModeV));
+    mix(uint64_t(desc.addressModeW));
+    mix(uint64_t(desc.magFilter));
+    mix(uint64_t(desc.minFilter));
+    mix(uint64_t(desc.mipmapFilter));
+    mix(bits(desc.lodMinClamp));
+    mix(bits(desc.lodMapClamp));
+    mix(uint64_t(desc.compare));
+    mix(desc.maxAnisotropy);
+    mix(bits(desc.maxLod));
     return hashed_value;
   }
 
+  inline bool same_sampler(rhi::SamplerDescriptor const& a, rhi::SamplerDescriptor const& b) {
+    return a.addressModeU == b.addressModeU && a.addressModeV == b.addressModeV
+      && a.addressModeW == b.addressModeW && a.magFilter == b.magFilter
+      && a.minFilter == b.minFilter && a.mipmapFilter == b.mipmapFilter
+      && a.lodMinClamp == b.lodMinClamp && a.lodMapClamp == b.lodMapClamp
+      && a.compare == b.compare && a.maxAnisotropy == b.maxAnisotropy
+      && a.maxLod == b.maxLod;
+  }
+
   auto GFXContext::create_sampler_desc(
     rhi::SamplerDescriptor const& desc
   ) noexcept -> SamplerHandle {
-    const uint64_t id = hash(desc);
-    auto ret = Singleton<GFXContext>::instance()->m_samplers.load(
-      id, SamplerLoader::from_desc_tag{}, desc);
+    auto& samplers = Singleton<GFXContext>::instance()->m_samplers;
+    std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.samplers);
+    // the cache keys are 32 bits wide, probe past colliding descriptors
+    uint64_t const hashed_value = hash(desc);
+    entt::id_type id = entt::id_type(hashed_value ^ (hashed_value >> 32));
+    while (samplers.contains(id) && !same_sampler(samplers[id]->m_desc, desc)) ++id;
+    auto ret = samplers.load(id, SamplerLoader::from_desc_tag{}, desc);
     return SamplerHandle{ ret.first->second };
   }
 
@@ -2530,10 +3094,7 @@ namespace gfx {
     desc.magFilter = filter;
     desc.minFilter = filter;
     desc.mipmapFilter = mipmap;
-    const uint64_t id = hash(desc);
-    auto ret = Singleton<GFXContext>::instance()->m_samplers.load(
-      id, SamplerLoader::from_desc_tag{}, desc);
-    return SamplerHandle{ ret.first->second };
+    return create_sampler_desc(desc);
   }
 
   auto GFXContext::load_shader_spirv(
@@ -2542,6 +3103,7 @@ namespace gfx {
   ) noexcept -> ShaderHandle {
     std::string_view sv(static_cast<const char*>(buffer->m_data), buffer->m_size);
     UID const ruid = Resources::query_string_uid(sv);
+    std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.shaders);
     auto ret = Singleton<GFXContext>::instance()->m_shaders.load(
       ruid, ShaderLoader::from_spirv_tag{}, buffer, stage);
     // true only if the resource was not already present
@@ -2776,6 +3338,7 @@ namespace gfx {
 
   auto GFXContext::create_mesh_empty() noexcept -> MeshHandle {
     UID const ruid = se::Resources::query_runtime_uid();
+    std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.meshs);
     auto ret = Singleton<GFXContext>::instance()->m_meshs.load(ruid, MeshLoader::from_empty_tag{});
     ret.first->second->m_uid = ruid;
     return MeshHandle{ ret.first->second };
@@ -2797,6 +3360,7 @@ namespace gfx {
 
   auto GFXContext::create_material_empty() noexcept -> MaterialHandle {
     UID const ruid = se::Resources::query_runtime_uid();
+    std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.materials);
     auto ret = Singleton<GFXContext>::instance()->m_materials.load(ruid, MaterialLoader::from_empty_tag{});
     ret.first->second->m_uid = ruid;
     return MaterialHandle{ ret.first->second };
@@ -2804,6 +3368,7 @@ namespace gfx {
   
   auto GFXContext::create_medium_empty() noexcept -> MediumHandle {
     UID const ruid = se::Resources::query_runtime_uid();
+    std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.mediums);
     auto ret = Singleton<GFXContext>::instance()->m_mediums.load(ruid, MediumLoader::from_empty_tag{});
     ret.first->second->m_uid = ruid;
     return MediumHandle{ ret.first->second };
@@ -0,0 +1,387 @@
+#include "se.gfx.hpp"
+#include "se.gfx.scene-loader.hpp"
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <sstream>
+
+namespace se {
+namespace gfx {
+  // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+  // ┃ Scene Archive                                                             ┃
+  // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+
+  static constexpr char archive_magic[8] = { 'S', 'E', 'A', 'R', 'C', 0, 0, 1 };
+
+  // magic, then the offset and the size of the chunk table
+  struct ArchiveHeader {
+    char magic[8];
+    uint64_t tableOffset;
+    uint64_t chunkCount;
+  };
+
+  // stale bytes below this are not worth a compaction
+  static constexpr uint64_t archive_compact_threshold = 16ull << 20;
+
+  static auto write_table(std::ostream& file, std::map<std::string, SceneArchive::Chunk> const& chunks,
+    uint64_t offset) noexcept -> void {
+    file.seekp(offset);
+    for (auto const& [name, chunk] : chunks) {
+      uint32_t const length = uint32_t(name.size());
+      file.write(reinterpret_cast<char const*>(&chunk), sizeof(chunk));
+      file.write(reinterpret_cast<char const*>(&length), sizeof(length));
+      file.write(name.data(), length);
+    }
+    ArchiveHeader header;
+    memcpy(header.magic, archive_magic, sizeof(archive_magic));
+    header.tableOffset = offset;
+    header.chunkCount = chunks.size();
+    // the header goes last, a save cut short leaves the old table valid
+    file.flush();
+    file.seekp(0);
+    file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    file.flush();
+  }
+
+  static auto table_bytes(std::map<std::string, SceneArchive::Chunk> const& chunks) noexcept -> uint64_t {
+    uint64_t bytes = 0;
+    for (auto const& [name, chunk] : chunks)
+      bytes += sizeof(chunk) + sizeof(uint32_t) + name.size();
+    return bytes;
+  }
+
+  auto SceneArchive::create(std::string const& path) noexcept -> std::shared_ptr<SceneArchive> {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      se::error("gfx :: archive :: cannot write scene archive {}", path);
+      return nullptr;
+    }
+    auto archive = std::make_shared<SceneArchive>();
+    archive->m_path = path;
+    archive->m_end = sizeof(ArchiveHeader);
+    write_table(file, archive->m_chunks, archive->m_end);
+    return archive;
+  }
+
+  auto SceneArchive::open(std::string const& path) noexcept -> std::shared_ptr<SceneArchive> {
+    std::ifstream file(path, std::ios::binary);
+    ArchiveHeader header;
+    if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header))
+      || memcmp(header.magic, archive_magic, sizeof(archive_magic)) != 0) {
+      se::error("gfx :: archive :: {} is not a scene archive", path);
+      return nullptr;
+    }
+    auto archive = std::make_shared<SceneArchive>();
+    archive->m_path = path;
+    archive->m_end = header.tableOffset;
+    file.seekg(header.tableOffset);
+    for (uint64_t i = 0; i < header.chunkCount; ++i) {
+      Chunk chunk; uint32_t length;
+      file.read(reinterpret_cast<char*>(&chunk), sizeof(chunk));
+      file.read(reinterpret_cast<char*>(&length), sizeof(length));
+      std::string name(length, '\0');
+      file.read(name.data(), length);
+      archive->m_chunks[name] = chunk;
+    }
+    if (!file) {
+      se::error("gfx :: archive :: truncated chunk table in {}", path);
+      return nullptr;
+    }
+    return archive;
+  }
+
+  auto SceneArchive::read(std::string const& name) const noexcept -> std::vector<std::byte> {
+    auto iter = m_chunks.find(name);
+    if (iter == m_chunks.end()) {
+      se::error("gfx :: archive :: no chunk {} in {}", name, m_path);
+      return {};
+    }
+    std::vector<std::byte> bytes(iter->second.size);
+    std::ifstream file(m_path, std::ios::binary);
+    file.seekg(iter->second.offset);
+    file.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+    return bytes;
+  }
+
+  auto SceneArchive::view(MappedFile const& file, std::string const& name) const noexcept -> ext::span<std::byte const> {
+    auto iter = m_chunks.find(name);
+    if (iter == m_chunks.end()) return {};
+    Chunk const& chunk = iter->second;
+    if (chunk.offset > file.size() || chunk.size > file.size() - chunk.offset) {
+      se::error("gfx :: archive :: chunk {} exceeds {}", name, m_path);
+      return {};
+    }
+    return file.as_span().subspan(chunk.offset, chunk.size);
+  }
+
+  auto SceneArchive::live_bytes() const noexcept -> uint64_t {
+    uint64_t bytes = 0;
+    for (auto const& [name, chunk] : m_chunks) bytes += chunk.size;
+    return bytes;
+  }
+
+  auto SceneArchive::commit(std::vector<std::pair<std::string, std::vector<std::byte>>> const& chunks,
+    std::set<std::string> const& live) noexcept -> bool {
+    // chunks not live any more, or rewritten now, turn stale
+    std::map<std::string, Chunk> kept;
+    for (auto const& [name, chunk] : m_chunks)
+      if (live.count(name)) kept[name] = chunk;
+    for (auto const& [name, bytes] : chunks) kept.erase(name);
+    uint64_t kept_bytes = 0, written_bytes = 0;
+    for (auto const& [name, chunk] : kept) kept_bytes += chunk.size;
+    for (auto const& [name, bytes] : chunks) written_bytes += bytes.size();
+    uint64_t const stale = m_end - sizeof(ArchiveHeader) - kept_bytes;
+
+    if (stale > archive_compact_threshold && stale > kept_bytes + written_bytes) {
+      // copy the kept chunks into a fresh file which then replaces the archive
+      std::string const temp = m_path + ".tmp";
+      {
+        std::ifstream source(m_path, std::ios::binary);
+        std::ofstream target(temp, std::ios::binary | std::ios::trunc);
+        if (!source || !target) {
+          se::error("gfx :: archive :: cannot compact {}", m_path);
+          return false;
+        }
+        uint64_t end = sizeof(ArchiveHeader);
+        std::vector<char> bytes;
+        target.seekp(end);
+        for (auto& [name, chunk] : kept) {
+          bytes.resize(chunk.size);
+          source.seekg(chunk.offset);
+          source.read(bytes.data(), bytes.size());
+          target.write(bytes.data(), bytes.size());
+          chunk.offset = end;
+          end += chunk.size;
+        }
+        m_chunks = std::move(kept);
+        m_end = end;
+        write_table(target, m_chunks, m_end);
+      }
+      // replaces the archive in one step, there is always a valid file
+      std::error_code error;
+      std::filesystem::rename(temp, m_path, error);
+      if (error) {
+        se::error("gfx :: archive :: cannot replace {}: {}", m_path, error.message());
+        return false;
+      }
+      kept = m_chunks;
+    }
+
+    std::fstream file(m_path, std::ios::binary | std::ios::in | std::ios::out);
+    if (!file) {
+      se::error("gfx :: archive :: cannot open {}", m_path);
+      return false;
+    }
+    // new chunks and the new table go after the old table, which stays
+    // valid until the header points past it
+    uint64_t end = m_end + table_bytes(m_chunks);
+    file.seekp(end);
+    for (auto const& [name, bytes] : chunks) {
+      file.write(reinterpret_cast<char const*>(bytes.data()), bytes.size());
+      kept[name] = Chunk{ end, bytes.size() };
+      end += bytes.size();
+    }
+    m_chunks = std::move(kept);
+    m_end = end;
+    write_table(file, m_chunks, m_end);
+    return bool(file);
+  }
+
+  // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+  // ┃ Incremental Save                                                          ┃
+  // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+
+  auto IncrementalSaveState::changed(Mesh& mesh) noexcept -> bool {
+    auto iter = meshes.find(&mesh);
+    if (iter == meshes.end() || iter->second.chunk.empty()) return true;
+    std::array<Buffer*, 3> const buffers = { mesh.m_positionBuffer.get(),
+      mesh.m_indexBuffer.get(), mesh.m_vertexBuffer.get() };
+    for (int i = 0; i < 3; ++i)
+      if (iter->second.buffers[i].get() != buffers[i]
+        || iter->second.stamps[i] != buffers[i]->m_hostStamp) return true;
+    return false;
+  }
+
+  // FNV-1a over the bytes
+  static auto hash_bytes(void const* data, size_t size, uint64_t hash = 14695981039346656037ull) noexcept -> uint64_t {
+    unsigned char const* bytes = static_cast<unsigned char const*>(data);
+    for (size_t i = 0; i < size; ++i) hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return hash;
+  }
+
+  // materials are edited in place without a flag, so their packets are hashed
+  static auto hash_materials(ex::registry& registry) noexcept -> uint64_t {
+    uint64_t hash = 14695981039346656037ull;
+    for (auto [entity, renderer] : registry.view<MeshRenderer>().each())
+      for (auto& primitive : renderer.m_mesh->m_primitives) {
+        Material* material = primitive.material.get();
+        if (material == nullptr) continue;
+        hash = hash_bytes(&material->m_packet, sizeof(material->m_packet), hash);
+        hash = hash_bytes(material->m_customString.data(), material->m_customString.size(), hash);
+      }
+    return hash;
+  }
+
+  // the editor flags edits without a patch, these are seen only by their flag
+  template<class T>
+  static auto take_dirty_to_file(ex::registry& registry) noexcept -> bool {
+    bool dirty = false;
+    for (auto [entity, component] : registry.view<T>().each()) {
+      dirty = dirty || component.m_dirtyToFile;
+      component.m_dirtyToFile = false;
+    }
+    return dirty;
+  }
+
+  auto Scene::save_incremental(std::string const& path) noexcept -> std::shared_future<bool> {
+    IncrementalSaveState& state = m_incrementalSave;
+    auto settled = [](bool value) {
+      std::promise<bool> promise;
+      promise.set_value(value);
+      return promise.get_future().share();
+    };
+    // one save at a time, the next snapshot waits for the last write,
+    // after a failed one the records are not trusted and all is written anew
+    if (state.pending.valid() && !state.pending.get()) state.archive = nullptr;
+    if (state.path != path || state.archive == nullptr) {
+      state = {};
+      state.path = path;
+      state.archive = SceneArchive::create(path);
+      if (state.archive == nullptr) return settled(false);
+    }
+
+    bool dirty = state.archive->m_chunks.empty() || !m_fileChanges.entries.empty();
+    dirty = take_dirty_to_file<NodeProperty>(m_registry) || dirty;
+    dirty = take_dirty_to_file<Transform>(m_registry) || dirty;
+    dirty = take_dirty_to_file<Light>(m_registry) || dirty;
+    dirty = take_dirty_to_file<Camera>(m_registry) || dirty;
+    uint64_t const material_hash = hash_materials(m_registry);
+    dirty = dirty || material_hash != state.materialHash;
+    for (auto [entity, renderer] : m_registry.view<MeshRenderer>().each())
+      dirty = dirty || state.changed(*renderer.m_mesh.get());
+    if (!dirty) return settled(true);
+
+    // the snapshot: the document and the payloads of the changed meshes
+    auto model = std::make_shared<tinygltf::Model>();
+    tinygltf::Scene scene;
+    SerializeData data;
+    data.model = model.get();
+    data.gfx_scene = this;
+    data.incremental = &state;
+    for (auto& [mesh, record] : state.meshes) record.seen = false;
+    for (auto& iter : Singleton<ComponentManager>::instance()->m_components)
+      iter.second.serialize(data);
+    scene.nodes.reserve(m_roots.size());
+    for (auto& node : m_roots)
+      scene.nodes.emplace_back(data.nodes[node.m_entity]);
+    model->scenes.emplace_back(scene);
+    // meshes gone from the scene drop their chunks
+    for (auto iter = state.meshes.begin(); iter != state.meshes.end();)
+      if (!iter->second.seen) iter = state.meshes.erase(iter); else ++iter;
+
+    // the buffers move into a table of chunk ranges, those holding data
+    // belong to the document and are written along with it
+    std::set<std::string> live = { "document" };
+    std::vector<std::pair<std::string, std::vector<std::byte>>> document_chunks;
+    tinygltf::Value::Array table;
+    for (size_t i = 0; i < model->buffers.size(); ++i) {
+      tinygltf::Buffer& buffer = model->buffers[i];
+      tinygltf::Value::Object entry;
+      if (buffer.uri.empty()) {
+        std::string const name = "document/buffer" + std::to_string(i);
+        std::vector<std::byte> bytes(buffer.data.size());
+        memcpy(bytes.data(), buffer.data.data(), bytes.size());
+        entry["chunk"] = tinygltf::Value(name);
+        entry["offset"] = tinygltf::Value(0.0);
+        entry["size"] = tinygltf::Value(double(bytes.size()));
+        document_chunks.emplace_back(name, std::move(bytes));
+      }
+      else {
+        entry["chunk"] = tinygltf::Value(buffer.uri);
+        entry["offset"] = buffer.extras.Get("offset");
+        entry["size"] = buffer.extras.Get("size");
+      }
+      entry["name"] = tinygltf::Value(buffer.name);
+      live.insert(entry["chunk"].Get<std::string>());
+      table.emplace_back(std::move(entry));
+    }
+    model->buffers.clear();
+    tinygltf::Value::Object extras;
+    extras["se_buffers"] = tinygltf::Value(std::move(table));
+    model->extras = tinygltf::Value(std::move(extras));
+
+    m_fileChanges.entries.clear();
+    state.materialHash = material_hash;
+    size_t const mesh_chunks = data.chunks.size();
+    se::info("gfx :: archive :: saving {}, {} changed mesh payloads", path, mesh_chunks);
+
+    // the worker only touches the snapshot and the archive
+    state.pending = std::async(std::launch::async,
+      [model, archive = state.archive, live = std::move(live),
+      chunks = std::move(data.chunks), document_chunks = std::move(document_chunks)]() mutable -> bool {
+      std::stringstream stream;
+      tinygltf::TinyGLTF gltf;
+      if (!gltf.WriteGltfSceneToStream(model.get(), stream, false, false)) {
+        se::error("gfx :: archive :: cannot serialize the scene document");
+        return false;
+      }
+      std::string const json = stream.str();
+      uint64_t hash = hash_bytes(json.data(), json.size());
+      for (auto const& [name, bytes] : document_chunks)
+        hash = hash_bytes(bytes.data(), bytes.size(), hash);
+      // an unchanged document is not written again
+      if (hash != archive->m_documentHash || archive->m_chunks.count("document") == 0) {
+        std::vector<std::byte> bytes(json.size());
+        memcpy(bytes.data(), json.data(), json.size());
+        chunks.emplace_back("document", std::move(bytes));
+        for (auto& chunk : document_chunks) chunks.emplace_back(std::move(chunk));
+      }
+      if (!archive->commit(chunks, live)) return false;
+      archive->m_documentHash = hash;
+      return true;
+    }).share();
+    return state.pending;
+  }
+
+  auto Scene::load_archive(std::string const& path) noexcept -> void {
+    std::shared_ptr<SceneArchive> archive = SceneArchive::open(path);
+    if (archive == nullptr) return;
+    std::vector<std::byte> const document = archive->read("document");
+    tinygltf::TinyGLTF loader;
+    loader.SetImageLoader(keep_encoded_image, nullptr);
+    tinygltf::Model model;
+    std::string err;
+    std::string warn;
+    bool ret = loader.LoadASCIIFromString(&model, &err, &warn,
+      reinterpret_cast<char const*>(document.data()), uint32_t(document.size()),
+      Filesys::get_parent_path(path));
+    if (!warn.empty()) {
+      se::error("Scene::deserialize warn::" + warn); return;
+    } if (!err.empty()) {
+      se::error("Scene::deserialize error::" + err); return;
+    } if (!ret) {
+      se::error("Failed to parse the archived glTF"); return;
+    }
+
+    // the buffers are cut from the chunks the table names
+    tinygltf::Value const& table = model.extras.Get("se_buffers");
+    std::map<std::string, std::vector<std::byte>> chunks;
+    model.buffers.resize(table.ArrayLen());
+    for (size_t i = 0; i < table.ArrayLen(); ++i) {
+      tinygltf::Value const& entry = table.Get(int(i));
+      std::string const name = entry.Get("chunk").Get<std::string>();
+      size_t const offset = size_t(entry.Get("offset").GetNumberAsDouble());
+      size_t const size = size_t(entry.Get("size").GetNumberAsDouble());
+      auto iter = chunks.find(name);
+      if (iter == chunks.end()) iter = chunks.emplace(name, archive->read(name)).first;
+      if (offset + size > iter->second.size()) {
+        se::error("gfx :: archive :: buffer {} exceeds chunk {}", i, name); return;
+      }
+      model.buffers[i].name = entry.Get("name").Get<std::string>();
+      model.buffers[i].data.resize(size);
+      memcpy(model.buffers[i].data.data(), iter->second.data() + offset, size);
+    }
+    load_gltf_model(model, Filesys::get_parent_path(path));
+  }
+}
+}
@@ -0,0 +1,298 @@
+#include "se.gfx.hpp"
+#include <algorithm>
+
+namespace se {
+namespace gfx {
+  // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+  // ┃ Offset Allocator                                                          ┃
+  // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+
+  static inline auto align_up(uint64_t value, uint64_t alignment) noexcept -> uint64_t {
+    return (value + alignment - 1) / alignment * alignment;
+  }
+
+  auto OffsetAllocator::allocate(uint64_t size, uint64_t alignment) noexcept -> uint64_t {
+    for (auto iter = m_free.begin(); iter != m_free.end(); ++iter) {
+      uint64_t const range_begin = iter->first;
+      uint64_t const range_end = iter->first + iter->second;
+      uint64_t const begin = align_up(range_begin, alignment);
+      if (begin + size > range_end) continue;
+      m_free.erase(iter);
+      // the alignment gap and the tail stay free
+      if (begin > range_begin) m_free.emplace(range_begin, begin - range_begin);
+      if (begin + size < range_end) m_free.emplace(begin + size, range_end - begin - size);
+      m_allocated.emplace(begin, size);
+      m_used += size;
+      return begin;
+    }
+    return invalid;
+  }
+
+  auto OffsetAllocator::free(uint64_t offset) noexcept -> void {
+    auto iter = m_allocated.find(offset);
+    if (iter == m_allocated.end()) {
+      se::error("gfx :: offset allocator :: release of unknown offset {}", offset);
+      return;
+    }
+    uint64_t begin = offset;
+    uint64_t size = iter->second;
+    m_allocated.erase(iter);
+    m_used -= size;
+    // merge with the free neighbours on both sides
+    auto next = m_free.lower_bound(begin);
+    if (next != m_free.end() && next->first == begin + size) {
+      size += next->second;
+      next = m_free.erase(next);
+    }
+    if (next != m_free.begin()) {
+      auto prev = std::prev(next);
+      if (prev->first + prev->second == begin) {
+        begin = prev->first;
+        size += prev->second;
+        m_free.erase(prev);
+      }
+    }
+    m_free.emplace(begin, size);
+  }
+
+  auto OffsetAllocator::grow(uint64_t capacity) noexcept -> void {
+    if (capacity <= m_capacity) return;
+    uint64_t begin = m_capacity;
+    if (!m_free.empty()) {
+      auto last = std::prev(m_free.end());
+      if (last->first + last->second == m_capacity) {
+        begin = last->first;
+        m_free.erase(last);
+      }
+    }
+    m_free.emplace(begin, capacity - begin);
+    m_capacity = capacity;
+  }
+
+  auto OffsetAllocator::reset(uint64_t capacity) noexcept -> void {
+    m_free.clear();
+    m_allocated.clear();
+    m_capacity = capacity;
+    m_used = 0;
+    if (capacity > 0) m_free.emplace(0, capacity);
+  }
+
+  auto OffsetAllocator::largest_free() const noexcept -> uint64_t {
+    uint64_t largest = 0;
+    for (auto const& range : m_free)
+      largest = std::max(largest, range.second);
+    return largest;
+  }
+
+  // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+  // ┃ Geometry Arena                                                            ┃
+  // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+
+  using GeometryArena = Scene::GPUScene::GeometryArena;
+
+  // pools start at 4 MB and at least double when they run out of space
+  static constexpr uint64_t arena_initial_bytes = uint64_t(4) << 20;
+
+  struct ArenaCopy {
+    rhi::Buffer* source;
+    uint64_t sourceOffset;
+    rhi::Buffer* destination;
+    uint64_t destinationOffset;
+    uint64_t size;
+  };
+
+  static auto submit_copies(std::vector<ArenaCopy> const& copies) noexcept -> void {
+    if (copies.empty()) return;
+    rhi::Device* device = GFXContext::device();
+    std::unique_ptr<rhi::CommandEncoder> encoder = device->create_command_encoder({ nullptr });
+    for (auto const& copy : copies)
+      encoder->copy_buffer_to_buffer(copy.source, copy.sourceOffset,
+        copy.destination, copy.destinationOffset, copy.size);
+    std::unique_ptr<rhi::Fence> fence = device->create_fence();
+    fence->reset();
+    device->get_graphics_queue().submit({ encoder->finish() }, fence.get());
+    device->get_graphics_queue().wait_idle();
+    fence->wait();
+  }
+
+  static auto create_pool_buffer(GeometryArena::Pool const& pool, uint64_t size) noexcept -> std::unique_ptr<rhi::Buffer> {
+    bool const need_rt = bool(GFXContext::device()->from_which_adapter()->from_which_context()
+      ->get_context_extensions_flags() & rhi::ContextExtensionEnum::RAY_TRACING);
+    rhi::BufferDescriptor descriptor;
+    descriptor.size = size;
+    descriptor.usage = pool.usages | rhi::BufferUsageEnum::SHADER_DEVICE_ADDRESS
+      | rhi::BufferUsageEnum::COPY_SRC | rhi::BufferUsageEnum::COPY_DST;
+    if (need_rt) descriptor.usage |= rhi::BufferUsageEnum::ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY;
+    descriptor.memoryProperties = rhi::MemoryPropertyEnum::DEVICE_LOCAL_BIT;
+    descriptor.mappedAtCreation = false;
+    std::unique_ptr<rhi::Buffer> buffer = GFXContext::device()->create_buffer(descriptor);
+    buffer->set_name(pool.job);
+    return buffer;
+  }
+
+  // bytes of a mesh payload, the host copy is exact while the device copy may be padded
+  static auto payload_bytes(gfx::Buffer const& buffer) noexcept -> uint64_t {
+    uint64_t const size = buffer.m_host.size() > 0 ? buffer.m_host.size()
+      : (buffer.m_buffer ? buffer.m_buffer->size() : 0);
+    return align_up(std::max<uint64_t>(size, 4), 4);
+  }
+
+  static auto grow_pool(GeometryArena::Pool& pool, uint64_t size) noexcept -> void {
+    uint64_t capacity = std::max(pool.allocator.m_capacity, arena_initial_bytes / 2) * 2;
+    while (capacity - pool.allocator.m_capacity < size) capacity *= 2;
+    std::unique_ptr<rhi::Buffer> buffer = create_pool_buffer(pool, capacity);
+    if (pool.buffer != nullptr) {
+      // frames in flight may still read the old pool
+      GFXContext::device()->wait_idle();
+      submit_copies({ ArenaCopy{ pool.buffer.get(), 0, buffer.get(), 0, pool.allocator.m_capacity } });
+    }
+    pool.buffer = std::move(buffer);
+    pool.allocator.grow(capacity);
+  }
+
+  static auto reserve(GeometryArena::Pool& pool, BufferHandle const& source,
+    std::vector<GeometryArena::PendingCopy>& pending) noexcept -> uint64_t {
+    uint64_t const size = payload_bytes(*source.get());
+    uint64_t offset = pool.allocator.allocate(size);
+    if (offset == OffsetAllocator::invalid) {
+      grow_pool(pool, size);
+      offset = pool.allocator.allocate(size);
+    }
+    pending.push_back(GeometryArena::PendingCopy{ source, &pool, offset, size });
+    return offset;
+  }
+
+  auto GeometryArena::Pool::address() noexcept -> uint64_t {
+    return buffer ? buffer->get_device_address() : 0;
+  }
+
+  auto GeometryArena::insert(Mesh* mesh) noexcept -> void {
+    if (meshes.find(mesh) != meshes.end()) return;
+    gfx::Buffer* key = mesh->m_positionBuffer.get();
+    meshes.emplace(mesh, key);
+    // meshes deduplicated at import share their buffers and their ranges
+    auto iter = allocations.find(key);
+    if (iter != allocations.end()) {
+      iter->second.users++;
+      return;
+    }
+    Allocation allocation;
+    allocation.payload = mesh->m_positionBuffer;
+    allocation.position = reserve(positions, mesh->m_positionBuffer, pending);
+    allocation.index = reserve(indices, mesh->m_indexBuffer, pending);
+    allocation.vertex = reserve(vertices, mesh->m_vertexBuffer, pending);
+    allocation.users = 1;
+    allocations.emplace(key, allocation);
+  }
+
+  auto GeometryArena::remove(Mesh* mesh) noexcept -> void {
+    auto registered = meshes.find(mesh);
+    if (registered == meshes.end()) return;
+    auto iter = allocations.find(registered->second);
+    meshes.erase(registered);
+    if (iter == allocations.end() || --iter->second.users > 0) return;
+    // drop the copies that were not submitted yet
+    Allocation const& allocation = iter->second;
+    pending.erase(std::remove_if(pending.begin(), pending.end(), [&](PendingCopy const& copy) {
+      return (copy.pool == &positions && copy.offset == allocation.position)
+        || (copy.pool == &indices && copy.offset == allocation.index)
+        || (copy.pool == &vertices && copy.offset == allocation.vertex); }), pending.end());
+    positions.allocator.free(allocation.position);
+    indices.allocator.free(allocation.index);
+    vertices.allocator.free(allocation.vertex);
+    allocations.erase(iter);
+    released = true;
+  }
+
+  auto GeometryArena::find(Mesh* mesh) const noexcept -> Allocation const* {
+    auto registered = meshes.find(mesh);
+    if (registered == meshes.end()) return nullptr;
+    auto iter = allocations.find(registered->second);
+    return iter == allocations.end() ? nullptr : &iter->second;
+  }
+
+  auto GeometryArena::flush() noexcept -> void {
+    if (pending.empty()) return;
+    // released ranges may be reused, frames in flight could still read them
+    if (released) {
+      GFXContext::device()->wait_idle();
+      released = false;
+    }
+    std::vector<ArenaCopy> copies;
+    copies.reserve(pending.size());
+    for (auto& copy : pending) {
+      gfx::Buffer* source = copy.source.get();
+      if (source->m_buffer == nullptr) source->host_to_device();
+      // the range is rounded up past the payload, never read beyond the source
+      copy.size = source->m_buffer ? std::min<uint64_t>(copy.size, source->m_buffer->size()) : 0;
+      if (copy.size == 0) continue;
+      copies.push_back(ArenaCopy{ source->m_buffer.get(), 0,
+        copy.pool->buffer.get(), copy.offset, copy.size });
+    }
+    submit_copies(copies);
+    // the arena now holds the device payload, meshes keeping their host
+    // copy drop their own buffers, the others still serve as readback source
+    for (auto& copy : pending) {
+      gfx::Buffer* source = copy.source.get();
+      if (copy.size > 0 && source->m_host.size() >= copy.size) {
+        source->m_buffer.reset();
+        source->m_previous.reset();
+      }
+    }
+    pending.clear();
+  }
+
+  auto GeometryArena::defragment() noexcept -> void {
+    flush();
+    uint64_t const before = capacity_bytes();
+    GFXContext::device()->wait_idle();
+    std::vector<ArenaCopy> copies;
+    std::vector<std::unique_ptr<rhi::Buffer>> retired;
+    auto repack = [&](Pool& pool, uint64_t Allocation::* member) {
+      if (pool.buffer == nullptr) return;
+      // keep the relative order so the copies never overlap in a fresh pool
+      std::vector<Allocation*> order;
+      for (auto& iter : allocations) order.push_back(&iter.second);
+      std::sort(order.begin(), order.end(), [&](Allocation* a, Allocation* b) {
+        return a->*member < b->*member; });
+      uint64_t const capacity = std::max<uint64_t>(pool.allocator.m_used, 4);
+      std::unique_ptr<rhi::Buffer> buffer = create_pool_buffer(pool, capacity);
+      OffsetAllocator allocator;
+      allocator.reset(capacity);
+      for (Allocation* allocation : order) {
+        uint64_t const size = pool.allocator.m_allocated[allocation->*member];
+        uint64_t const offset = allocator.allocate(size);
+        copies.push_back(ArenaCopy{ pool.buffer.get(), allocation->*member, buffer.get(), offset, size });
+        allocation->*member = offset;
+      }
+      retired.push_back(std::move(pool.buffer));
+      pool.buffer = std::move(buffer);
+      pool.allocator = std::move(allocator);
+    };
+    repack(positions, &Allocation::position);
+    repack(indices, &Allocation::index);
+    repack(vertices, &Allocation::vertex);
+    submit_copies(copies);
+    retired.clear();
+    released = false;
+    se::info("gfx :: geometry arena :: defragmented {} ranges, {} -> {} bytes",
+      allocations.size(), before, capacity_bytes());
+  }
+
+  auto GeometryArena::used_bytes() const noexcept -> uint64_t {
+    return positions.allocator.m_used + indices.allocator.m_used + vertices.allocator.m_used;
+  }
+
+  auto GeometryArena::capacity_bytes() const noexcept -> uint64_t {
+    return positions.allocator.m_capacity + indices.allocator.m_capacity + vertices.allocator.m_capacity;
+  }
+
+  auto Scene::defragment_geometry() noexcept -> void {
+    if (!m_geometryArena) return;
+    m_gpuScene.geometryArena.defragment();
+    // the base offsets moved, rewrite the geometry records
+    for (auto entity : m_registry.view<MeshRenderer>())
+      m_registry.patch<MeshRenderer>(entity, [](MeshRenderer& renderer) { renderer.m_dirtyToGPU = true; });
+  }
+}
+}
@@ -0,0 +1,872 @@
+#include "se.gfx.hpp"
+#include "se.gfx.scene-loader.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <type_traits>
+
+namespace se {
+namespace gfx {
+  // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+  // ┃ Scene Cache                                                               ┃
+  // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+
+  // bumped whenever a record below changes its layout
+  static constexpr uint32_t cache_version = 2;
+  // payload bytes staged by one submission of the upload
+  static constexpr uint64_t cache_upload_batch_bytes = 256ull << 20;
+
+  // FNV-1a folded over 64-bit words, as the mesh payload hash
+  static constexpr uint64_t fnv_offset_basis = 14695981039346656037ull;
+  static constexpr uint64_t fnv_prime = 1099511628211ull;
+
+  static inline auto hash_bytes(uint64_t hash, void const* data, size_t size) noexcept -> uint64_t {
+    std::byte const* bytes = static_cast<std::byte const*>(data);
+    size_t const words = size / sizeof(uint64_t);
+    for (size_t i = 0; i < words; ++i) {
+      uint64_t word;
+      memcpy(&word, bytes + i * sizeof(uint64_t), sizeof(uint64_t));
+      hash = (hash ^ word) * fnv_prime;
+    }
+    for (size_t i = words * sizeof(uint64_t); i < size; ++i)
+      hash = (hash ^ uint64_t(bytes[i])) * fnv_prime;
+    return hash;
+  }
+
+  static inline auto hash_value(uint64_t hash, uint64_t value) noexcept -> uint64_t {
+    return hash_bytes(hash, &value, sizeof(uint64_t));
+  }
+
+  auto Scene::cache_key(std::vector<std::string> const& files) noexcept -> uint64_t {
+    uint64_t hash = fnv_offset_basis;
+    hash = hash_value(hash, cache_version);
+    // records hold raw copies of these
+    hash = hash_value(hash, sizeof(Material::MaterialPacket));
+    hash = hash_value(hash, sizeof(Medium::MediumPacket));
+    hash = hash_value(hash, sizeof(LightData));
+    hash = hash_value(hash, sizeof(Mesh::Meshlet));
+    hash = hash_value(hash, sizeof(Mesh::LOD));
+    // the loader options shaping the meshes
+    MeshLoaderConfig const& config = defaultMeshLoadConfig;
+    for (auto const& entry : config.layout.layout) {
+      hash = hash_value(hash, uint64_t(entry.format));
+      hash = hash_value(hash, uint64_t(entry.info));
+    }
+    hash = hash_value(hash, uint64_t(config.layout.format));
+    hash = hash_value(hash, config.layout.encoding.mask());
+    hash = hash_value(hash, config.usePositionBuffer);
+    hash = hash_value(hash, config.deduplication);
+    hash = hash_value(hash, config.optimizeVertexOrder);
+    hash = hash_value(hash, config.buildMeshlets);
+    hash = hash_value(hash, config.meshletMaxVertices);
+    hash = hash_value(hash, config.meshletMaxTriangles);
+    hash = hash_value(hash, config.lodLevels);
+    hash = hash_bytes(hash, &config.lodReduction, sizeof(float));
+    hash = hash_bytes(hash, &config.lodMaxError, sizeof(float));
+
+    // the scene description by content
+    if (files.empty()) return 0;
+    MappedFile file;
+    if (!file.open(files.front())) return 0;
+    hash = hash_value(hash, file.size());
+    hash = hash_bytes(hash, file.data(), file.size());
+
+    // the includes, meshes, textures and volumes the loaders read, by size
+    // and write time; one that is gone leaves the scene without a key
+    namespace fs = std::filesystem;
+    for (size_t i = 1; i < files.size(); ++i) {
+      std::error_code error;
+      uint64_t const size = fs::file_size(files[i], error);
+      if (error) return 0;
+      int64_t const time = int64_t(fs::last_write_time(files[i], error).time_since_epoch().count());
+      if (error) return 0;
+      hash = hash_bytes(hash, files[i].data(), files[i].size());
+      hash = hash_value(hash, size);
+      hash = hash_value(hash, uint64_t(time));
+    }
+    // reserve 0 for a scene without a key
+    return hash == 0 ? fnv_offset_basis : hash;
+  }
+
+  // Records are raw copies of trivially copyable values, vectors and
+  // strings are preceded by their length.
+  struct CacheWriter {
+    std::vector<std::byte> bytes;
+
+    template<class T>
+    auto put(T const& value) noexcept -> void {
+      static_assert(std::is_trivially_copyable_v<T>, "cached records are raw copies");
+      size_t const size = bytes.size();
+      bytes.resize(size + sizeof(T));
+      memcpy(bytes.data() + size, &value, sizeof(T));
+    }
+    template<class T>
+    auto put_vector(std::vector<T> const& values) noexcept -> void {
+      static_assert(std::is_trivially_copyable_v<T>, "cached records are raw copies");
+      put(uint64_t(values.size()));
+      size_t const size = bytes.size();
+      bytes.resize(size + values.size() * sizeof(T));
+      if (!values.empty()) memcpy(bytes.data() + size, values.data(), values.size() * sizeof(T));
+    }
+    auto put_string(std::string const& value) noexcept -> void {
+      put(uint64_t(value.size()));
+      std::byte const* data = reinterpret_cast<std::byte const*>(value.data());
+      bytes.insert(bytes.end(), data, data + value.size());
+    }
+  };
+
+  // reads past the end of the chunk clear ok and leave the values as they are
+  struct CacheReader {
+    ext::span<std::byte const> bytes;
+    size_t at = 0;
+    bool ok = true;
+
+    auto take(uint64_t size) noexcept -> std::byte const* {
+      if (!ok || size > bytes.size() - at) { ok = false; return nullptr; }
+      std::byte const* data = bytes.data() + at;
+      at += size;
+      return data;
+    }
+    template<class T>
+    auto get(T& value) noexcept -> void {
+      if (std::byte const* data = take(sizeof(T))) memcpy(&value, data, sizeof(T));
+    }
+    template<class T>
+    auto get_vector(std::vector<T>& values) noexcept -> void {
+      uint64_t count = 0;
+      get(count);
+      if (!ok || count > (bytes.size() - at) / sizeof(T)) { ok = false; return; }
+      values.resize(count);
+      if (std::byte const* data = take(count * sizeof(T)))
+        if (count > 0) memcpy(values.data(), data, count * sizeof(T));
+    }
+    auto get_string(std::string& value) noexcept -> void {
+      uint64_t size = 0;
+      get(size);
+      if (std::byte const* data = take(size))
+        value.assign(reinterpret_cast<char const*>(data), size);
+    }
+  };
+
+  // the fixed part of a mesh primitive, its meshlet and lod vectors follow
+  struct PrimitiveRecord {
+    uint64_t offset, size, baseVertex, numVertex;
+    int32_t material, exterior, interior;
+    vec3 max, min;
+  };
+
+  // the import-time clusters and lods of a mesh primitive
+  struct PrimitiveClusters {
+    std::vector<Mesh::Meshlet> meshlets;
+    std::vector<uint32_t> meshletVertices;
+    std::vector<uint8_t> meshletTriangles;
+    std::vector<Mesh::LOD> lods;
+  };
+
+  struct CustomPrimitiveRecord {
+    uint32_t primitiveType;
+    uint32_t bitfield;
+    float scalarField0, scalarField1;
+    vec4 vecField0, vecField1, vecField2;
+    int32_t material, exterior, interior;
+    vec3 max, min;
+  };
+
+  enum struct CachedComponentEnum : uint32_t {
+    TRANSFORM     = 1 << 0,
+    MESH_RENDERER = 1 << 1,
+    LIGHT         = 1 << 2,
+    CAMERA        = 1 << 3,
+  };
+
+  // the fixed part of a node, its name and instances follow
+  struct NodeRecord {
+    int32_t parent;
+    uint32_t components;  // CachedComponentEnum
+    vec3 translation;
+    vec3 scale;
+    float oddScaling;
+    Quaternion rotation;
+    int32_t mesh;
+    LightData light;
+    float aspectRatio, yfov, znear, zfar, left_right, bottom_top;
+    int32_t projectType;
+    int32_t cameraMedium;
+  };
+
+  static auto put_grid(CacheWriter& writer, std::optional<Medium::SampledGrid> const& grid) noexcept -> void {
+    writer.put(uint8_t(grid.has_value()));
+    if (!grid) return;
+    writer.put(ivec3{ grid->nx, grid->ny, grid->nz });
+    writer.put_vector(grid->values);
+    writer.put(grid->bounds);
+    writer.put(int32_t(grid->gridChannel));
+  }
+
+  static auto get_grid(CacheReader& reader, std::optional<Medium::SampledGrid>& grid) noexcept -> void {
+    uint8_t present = 0;
+    reader.get(present);
+    if (!present) return;
+    Medium::SampledGrid sampled;
+    ivec3 size; int32_t channel = 1;
+    reader.get(size);
+    reader.get_vector(sampled.values);
+    reader.get(sampled.bounds);
+    reader.get(channel);
+    sampled.nx = size.x; sampled.ny = size.y; sampled.nz = size.z;
+    sampled.gridChannel = channel;
+    grid = std::move(sampled);
+  }
+
+  auto Scene::save_cache(std::string const& path) noexcept -> bool {
+    // nodes in depth first order from the roots, so appending each to
+    // its parent keeps the order of the children
+    std::vector<ex::entity> nodes;
+    std::unordered_map<ex::entity, int32_t> node_ids;
+    std::function<void(ex::entity)> visit = [&](ex::entity entity) {
+      if (!node_ids.emplace(entity, int32_t(nodes.size())).second) return;
+      nodes.push_back(entity);
+      for (Node const& child : m_registry.get<NodeProperty>(entity).children)
+        visit(child.m_entity);
+    };
+    for (Node const& root : m_roots) visit(root.m_entity);
+    for (auto [entity, property] : m_registry.view<NodeProperty>().each())
+      if (property.parent == ex::null) visit(entity);
+    for (auto [entity, property] : m_registry.view<NodeProperty>().each()) visit(entity);
+
+    // the resources the nodes reach, each numbered on first use
+    std::vector<Mesh*> meshes;
+    std::vector<Material*> materials;
+    std::vector<Medium*> media;
+    std::vector<Texture*> textures;
+    std::unordered_map<void const*, int32_t> ids;
+    auto number = [&](auto* resource, auto& list) -> int32_t {
+      if (resource == nullptr) return -1;
+      auto [iter, inserted] = ids.emplace(resource, int32_t(list.size()));
+      if (inserted) list.push_back(resource);
+      return iter->second;
+    };
+    for (ex::entity entity : nodes) {
+      if (MeshRenderer* renderer = m_registry.try_get<MeshRenderer>(entity))
+        number(renderer->m_mesh.get(), meshes);
+      if (Camera* camera = m_registry.try_get<Camera>(entity))
+        number(camera->medium.get(), media);
+    }
+    for (Mesh* mesh : meshes) {
+      for (auto& primitive : mesh->m_primitives) {
+        number(primitive.material.get(), materials);
+        number(primitive.exterior.get(), media);
+        number(primitive.interior.get(), media);
+      }
+      for (auto& primitive : mesh->m_customPrimitives) {
+        number(primitive.material.get(), materials);
+        number(primitive.exterior.get(), media);
+        number(primitive.interior.get(), media);
+      }
+    }
+    for (Material* material : materials) {
+      // textures are found again by their files, buffers would be lost
+      if (material->m_additionalBuffer1.get() != nullptr || material->m_additionalBuffer2.get() != nullptr) {
+        se::info("gfx :: cache :: material {} holds buffers, {} is not cached", material->m_name, m_name);
+        return false;
+      }
+      for (Texture* texture : { material->m_basecolorTex.get(), material->m_normalTex.get(),
+        material->m_additionalTex1.get(), material->m_additionalTex2.get() }) {
+        if (texture != nullptr && !texture->m_resourcePath) {
+          se::info("gfx :: cache :: a texture of {} has no file, {} is not cached", material->m_name, m_name);
+          return false;
+        }
+        number(texture, textures);
+      }
+    }
+
+    // the files the scene was read from, each once and the description first
+    std::vector<std::string> sources;
+    std::set<std::string> listed;
+    for (std::string const& file : m_sourceFiles)
+      if (listed.insert(file).second) sources.push_back(file);
+    for (Texture* texture : textures)
+      if (listed.insert(*texture->m_resourcePath).second) sources.push_back(*texture->m_resourcePath);
+    uint64_t const key = cache_key(sources);
+    if (key == 0) {
+      se::info("gfx :: cache :: the source files of {} can't be read, it is not cached", m_name);
+      return false;
+    }
+
+    CacheWriter writer;
+    writer.put(uint32_t(textures.size()));
+    for (Texture* texture : textures) writer.put_string(*texture->m_resourcePath);
+
+    writer.put(uint32_t(media.size()));
+    for (Medium* medium : media) {
+      writer.put(medium->packet);
+      put_grid(writer, medium->density);
+      put_grid(writer, medium->LeScale);
+      put_grid(writer, medium->temperatureGrid);
+      writer.put(uint8_t(medium->majorantGrid.has_value()));
+      if (medium->majorantGrid) {
+        writer.put(medium->majorantGrid->bounds);
+        writer.put_vector(medium->majorantGrid->voxels);
+        writer.put(medium->majorantGrid->res);
+      }
+    }
+
+    writer.put(uint32_t(materials.size()));
+    for (Material* material : materials) {
+      writer.put(material->m_packet);
+      writer.put_string(material->m_name);
+      writer.put_string(material->m_customString);
+      std::array<int32_t, 4> const texture_ids = {
+        number(material->m_basecolorTex.get(), textures), number(material->m_normalTex.get(), textures),
+        number(material->m_additionalTex1.get(), textures), number(material->m_additionalTex2.get(), textures) };
+      writer.put(texture_ids);
+    }
+
+    // payloads in their storage encoding, one chunk each; meshes
+    // deduplicated onto the same buffers share the chunk
+    std::vector<std::pair<std::string, std::vector<std::byte>>> chunks;
+    std::map<std::array<Buffer*, 3>, int32_t> payloads;
+    CacheWriter payload_sizes;
+    writer.put(uint32_t(meshes.size()));
+    for (Mesh* mesh : meshes) {
+      int32_t payload = -1;
+      if (mesh->m_positionBuffer.get() != nullptr) {
+        std::array<Buffer*, 3> const buffers = { mesh->m_positionBuffer.get(),
+          mesh->m_vertexBuffer.get(), mesh->m_indexBuffer.get() };
+        auto [iter, inserted] = payloads.emplace(buffers, int32_t(payloads.size()));
+        if (inserted) {
+          mesh->fetch_host();
+          std::vector<std::byte> bytes;
+          for (Buffer* buffer : buffers) {
+            payload_sizes.put(uint64_t(buffer->m_host.size()));
+            bytes.insert(bytes.end(), buffer->m_host.begin(), buffer->m_host.end());
+          }
+          mesh->release_host();
+          chunks.emplace_back("payload/" + std::to_string(iter->second), std::move(bytes));
+        }
+        payload = iter->second;
+      }
+      writer.put_string(mesh->m_name);
+      writer.put(uint32_t(mesh->m_encoding.mask()));
+      writer.put(mesh->m_contentHash);
+      writer.put(payload);
+      writer.put(uint32_t(mesh->m_primitives.size()));
+      for (auto& primitive : mesh->m_primitives) {
+        writer.put(PrimitiveRecord{ primitive.offset, primitive.size, primitive.baseVertex, primitive.numVertex,
+          number(primitive.material.get(), materials), number(primitive.exterior.get(), media),
+          number(primitive.interior.get(), media), primitive.max, primitive.min });
+        writer.put_vector(primitive.meshlets);
+        writer.put_vector(primitive.meshletVertices);
+        writer.put_vector(primitive.meshletTriangles);
+        writer.put_vector(primitive.lods);
+      }
+      writer.put(uint32_t(mesh->m_customPrimitives.size()));
+      for (auto& primitive : mesh->m_customPrimitives)
+        writer.put(CustomPrimitiveRecord{ primitive.primitiveType, primitive.bitfield,
+          primitive.scalarField0, primitive.scalarField1,
+          primitive.vecField0, primitive.vecField1, primitive.vecField2,
+          number(primitive.material.get(), materials), number(primitive.exterior.get(), media),
+          number(primitive.interior.get(), media), primitive.max, primitive.min });
+    }
+    writer.put(uint32_t(payloads.size()));
+    writer.bytes.insert(writer.bytes.end(), payload_sizes.bytes.begin(), payload_sizes.bytes.end());
+
+    writer.put(uint32_t(nodes.size()));
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      ex::entity const entity = nodes[i];
+      NodeProperty const& property = m_registry.get<NodeProperty>(entity);
+      NodeRecord record = {};
+      // a parent not listing the node as its child leaves it detached
+      auto parent = node_ids.find(property.parent);
+      record.parent = parent == node_ids.end() || parent->second >= int32_t(i) ? -1 : parent->second;
+      record.mesh = -1;
+      record.cameraMedium = -1;
+      std::vector<se::mat4> instances;
+      if (Transform* transform = m_registry.try_get<Transform>(entity)) {
+        record.components |= uint32_t(CachedComponentEnum::TRANSFORM);
+        record.translation = transform->translation;
+        record.scale = transform->scale;
+        record.oddScaling = transform->oddScaling;
+        record.rotation = transform->rotation;
+      }
+      if (MeshRenderer* renderer = m_registry.try_get<MeshRenderer>(entity)) {
+        record.components |= uint32_t(CachedComponentEnum::MESH_RENDERER);
+        record.mesh = number(renderer->m_mesh.get(), meshes);
+        instances = renderer->m_instances;
+      }
+      if (Light* light = m_registry.try_get<Light>(entity)) {
+        record.components |= uint32_t(CachedComponentEnum::LIGHT);
+        record.light = light->light;
+      }
+      if (Camera* camera = m_registry.try_get<Camera>(entity)) {
+        record.components |= uint32_t(CachedComponentEnum::CAMERA);
+        record.aspectRatio = camera->aspectRatio;
+        record.yfov = camera->yfov;
+        record.znear = camera->znear;
+        record.zfar = camera->zfar;
+        record.left_right = camera->left_right;
+        record.bottom_top = camera->bottom_top;
+        record.projectType = int32_t(camera->projectType);
+        record.cameraMedium = number(camera->medium.get(), media);
+      }
+      writer.put(record);
+      writer.put_string(property.name);
+      writer.put_vector(instances);
+    }
+    std::vector<int32_t> roots;
+    for (Node const& root : m_roots) roots.push_back(node_ids[root.m_entity]);
+    writer.put_vector(roots);
+
+    CacheWriter header;
+    header.put(cache_version);
+    header.put(key);
+    header.put(uint32_t(sources.size()));
+    for (std::string const& source : sources) header.put_string(source);
+    chunks.emplace_back("cache/key", std::move(header.bytes));
+    chunks.emplace_back("cache/scene", std::move(writer.bytes));
+
+    // written aside and moved in place, a cache cut short is never read
+    std::string const temp = path + ".tmp";
+    std::shared_ptr<SceneArchive> archive = SceneArchive::create(temp);
+    if (archive == nullptr) return false;
+    std::set<std::string> live;
+    for (auto const& chunk : chunks) live.insert(chunk.first);
+    if (!archive->commit(chunks, live)) {
+      std::remove(temp.c_str());
+      return false;
+    }
+    std::remove(path.c_str());
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+      se::error("gfx :: cache :: cannot replace {}", path);
+      return false;
+    }
+    return true;
+  }
+
+  // Create the buffers of the payloads and copy them in from the mapped
+  // file, packed into a few staging buffers rather than one submission
+  // and wait per buffer. Off the main thread each takes the async upload.
+  static auto upload_payloads(std::vector<std::array<ext::span<std::byte const>, 3>> const& payloads,
+    bool keepHost) noexcept -> std::vector<std::array<BufferHandle, 3>> {
+    auto const usages = mesh_buffer_usages();
+    char const* jobs[3] = { "Mesh position buffer", "Mesh vertex buffer", "Mesh index buffer" };
+    bool const batched = GFXContext::on_main_thread();
+    rhi::Device* device = GFXContext::device();
+    struct Copy {
+      rhi::Buffer* target;
+      ext::span<std::byte const> bytes;
+    };
+    std::vector<Copy> copies;
+    std::vector<std::array<BufferHandle, 3>> buffers(payloads.size());
+    for (size_t i = 0; i < payloads.size(); ++i)
+      for (int k = 0; k < 3; ++k) {
+        ext::span<std::byte const> const bytes = payloads[i][k];
+        BufferHandle handle;
+        if (batched) {
+          handle = GFXContext::create_buffer_empty();
+          rhi::BufferDescriptor descriptor;
+          descriptor.size = std::max<uint64_t>(bytes.size(), 4);
+          descriptor.usage = usages[k] | rhi::BufferUsageEnum::COPY_DST | rhi::BufferUsageEnum::COPY_SRC;
+          descriptor.memoryProperties = rhi::MemoryPropertyEnum::DEVICE_LOCAL_BIT;
+          handle->m_buffer = device->create_buffer(descriptor);
+          if (!bytes.empty()) copies.push_back({ handle->m_buffer.get(), bytes });
+        }
+        else {
+          MiniBuffer buffer;
+          buffer.m_isReference = true;
+          buffer.m_data = const_cast<std::byte*>(bytes.data());
+          buffer.m_size = bytes.size();
+          handle = GFXContext::create_buffer_host(buffer, usages[k], keepHost);
+        }
+        if (batched) {
+          handle->m_usages = usages[k];
+          handle->m_residentOnHost = keepHost;
+          if (keepHost) handle->m_host.assign(bytes.begin(), bytes.end());
+        }
+        handle->m_job = jobs[k];
+        buffers[i][k] = handle;
+      }
+
+    struct Batch {
+      std::unique_ptr<rhi::Buffer> staging;
+      std::unique_ptr<rhi::CommandEncoder> encoder;
+      std::unique_ptr<rhi::Fence> fence;
+    };
+    std::deque<Batch> in_flight;
+    size_t begin = 0;
+    while (begin < copies.size()) {
+      std::vector<uint64_t> offsets;
+      uint64_t size = 0;
+      size_t end = begin;
+      for (; end < copies.size(); ++end) {
+        uint64_t const offset = (size + 15) & ~uint64_t(15);
+        if (end > begin && offset + copies[end].bytes.size() > cache_upload_batch_bytes) break;
+        offsets.push_back(offset);
+        size = offset + copies[end].bytes.size();
+      }
+      if (in_flight.size() >= 2) {
+        in_flight.front().fence->wait();
+        in_flight.pop_front();
+      }
+
+      Batch batch;
+      rhi::BufferDescriptor stagingBufferDescriptor;
+      stagingBufferDescriptor.size = size;
+      stagingBufferDescriptor.usage = rhi::BufferUsageEnum::COPY_SRC;
+      stagingBufferDescriptor.memoryProperties =
+        rhi::MemoryPropertyEnum::HOST_VISIBLE_BIT |
+        rhi::MemoryPropertyEnum::HOST_COHERENT_BIT;
+      stagingBufferDescriptor.mappedAtCreation = true;
+      batch.staging = device->create_buffer(stagingBufferDescriptor);
+      std::future<bool> mapped = batch.staging->map_async(0, 0, size);
+      if (mapped.get()) {
+        // the pages of the mapped file are read in here
+        char* mapdata = static_cast<char*>(batch.staging->get_mapped_range(0));
+        for (size_t i = begin; i < end; ++i)
+          memcpy(mapdata + offsets[i - begin], copies[i].bytes.data(), copies[i].bytes.size());
+        batch.staging->unmap();
+      }
+      batch.encoder = device->create_command_encoder(nullptr);
+      batch.encoder->pipeline_barrier(rhi::BarrierDescriptor{
+        rhi::PipelineStageEnum::HOST_BIT,
+        rhi::PipelineStageEnum::TRANSFER_BIT,
+        rhi::DependencyTypeEnum::NONE,
+        {}, { rhi::BufferMemoryBarrierDescriptor{ batch.staging.get(),
+          rhi::AccessFlagEnum::HOST_WRITE_BIT,
+          rhi::AccessFlagEnum::TRANSFER_READ_BIT } }, {} });
+      for (size_t i = begin; i < end; ++i)
+        batch.encoder->copy_buffer_to_buffer(batch.staging.get(), offsets[i - begin],
+          copies[i].target, 0, copies[i].bytes.size());
+      batch.fence = device->create_fence();
+      batch.fence->reset();
+      device->get_graphics_queue().submit({ batch.encoder->finish() }, batch.fence.get());
+      in_flight.emplace_back(std::move(batch));
+      begin = end;
+    }
+    for (Batch& batch : in_flight) batch.fence->wait();
+    return buffers;
+  }
+
+  auto Scene::load_cache(std::string const& path) noexcept -> bool {
+    if (!Filesys::file_exists(path)) return false;
+    std::shared_ptr<SceneArchive> archive = SceneArchive::open(path);
+    MappedFile file;
+    if (archive == nullptr || !file.open(path)) return false;
+
+    CacheReader header{ archive->view(file, "cache/key") };
+    uint32_t version = 0; uint64_t written_key = 0;
+    header.get(version);
+    header.get(written_key);
+    // the key is built again from the files the cache lists
+    std::vector<std::string> sources;
+    uint32_t source_count = 0;
+    header.get(source_count);
+    if (header.ok && version == cache_version && source_count <= header.bytes.size() - header.at) {
+      sources.resize(source_count);
+      for (std::string& source : sources) header.get_string(source);
+    }
+    if (!header.ok || version != cache_version || written_key != cache_key(sources)) {
+      se::info("gfx :: cache :: {} is stale", path);
+      return false;
+    }
+
+    // everything is read and checked before the first resource is made,
+    // so a damaged cache leaves the scene untouched
+    CacheReader reader{ archive->view(file, "cache/scene") };
+    // every record takes a byte at least, larger counts are damage
+    auto count = [&]() -> uint32_t {
+      uint32_t n = 0;
+      reader.get(n);
+      if (n > reader.bytes.size() - reader.at) reader.ok = false;
+      return reader.ok ? n : 0; };
+    auto check = [&](int32_t index, size_t size) {
+      if (index < -1 || index >= int64_t(size)) reader.ok = false; };
+
+    std::vector<std::string> texture_paths(count());
+    for (std::string& texture_path : texture_paths) reader.get_string(texture_path);
+
+    struct MediumRecord {
+      Medium::MediumPacket packet;
+      std::optional<Medium::SampledGrid> density, LeScale, temperatureGrid;
+      std::optional<Medium::MajorantGrid> majorantGrid;
+    };
+    std::vector<MediumRecord> media(count());
+    for (MediumRecord& medium : media) {
+      reader.get(medium.packet);
+      get_grid(reader, medium.density);
+      get_grid(reader, medium.LeScale);
+      get_grid(reader, medium.temperatureGrid);
+      uint8_t majorant = 0;
+      reader.get(majorant);
+      if (majorant) {
+        Medium::MajorantGrid grid;
+        reader.get(grid.bounds);
+        reader.get_vector(grid.voxels);
+        reader.get(grid.res);
+        medium.majorantGrid = std::move(grid);
+      }
+    }
+
+    struct MaterialRecord {
+      Material::MaterialPacket packet;
+      std::string name, customString;
+      std::array<int32_t, 4> textures;
+    };
+    std::vector<MaterialRecord> materials(count());
+    for (MaterialRecord& material : materials) {
+      reader.get(material.packet);
+      reader.get_string(material.name);
+      reader.get_string(material.customString);
+      reader.get(material.textures);
+      for (int32_t texture : material.textures) check(texture, texture_paths.size());
+    }
+
+    struct MeshRecord {
+      std::string name;
+      uint32_t encoding;
+      uint64_t contentHash;
+      int32_t payload;
+      std::vector<PrimitiveRecord> primitives;
+      std::vector<PrimitiveClusters> clusters;
+      std::vector<CustomPrimitiveRecord> customs;
+    };
+    std::vector<MeshRecord> meshes(count());
+    for (MeshRecord& mesh : meshes) {
+      reader.get_string(mesh.name);
+      reader.get(mesh.encoding);
+      reader.get(mesh.contentHash);
+      reader.get(mesh.payload);
+      mesh.primitives.resize(count());
+      mesh.clusters.resize(mesh.primitives.size());
+      for (size_t i = 0; i < mesh.primitives.size(); ++i) {
+        PrimitiveRecord& primitive = mesh.primitives[i];
+        reader.get(primitive);
+        reader.get_vector(mesh.clusters[i].meshlets);
+        reader.get_vector(mesh.clusters[i].meshletVertices);
+        reader.get_vector(mesh.clusters[i].meshletTriangles);
+        reader.get_vector(mesh.clusters[i].lods);
+        check(primitive.material, materials.size());
+        check(primitive.exterior, media.size());
+        check(primitive.interior, media.size());
+      }
+      mesh.customs.resize(count());
+      for (CustomPrimitiveRecord& primitive : mesh.customs) {
+        reader.get(primitive);
+        check(primitive.material, materials.size());
+        check(primitive.exterior, media.size());
+        check(primitive.interior, media.size());
+      }
+    }
+
+    std::vector<std::array<ext::span<std::byte const>, 3>> payloads(count());
+    for (size_t i = 0; i < payloads.size(); ++i) {
+      std::array<uint64_t, 3> sizes = {};
+      for (uint64_t& size : sizes) reader.get(size);
+      ext::span<std::byte const> const chunk = archive->view(file, "payload/" + std::to_string(i));
+      if (!reader.ok || sizes[0] + sizes[1] + sizes[2] != chunk.size()) { reader.ok = false; break; }
+      payloads[i] = { chunk.subspan(0, sizes[0]), chunk.subspan(sizes[0], sizes[1]),
+        chunk.subspan(sizes[0] + sizes[1], sizes[2]) };
+    }
+    for (MeshRecord const& mesh : meshes) check(mesh.payload, payloads.size());
+
+    // the ranges are drawn and copied as they are, so each must lie in its payload
+    auto in_range = [](uint64_t offset, uint64_t size, uint64_t count) {
+      return size <= count && offset <= count - size; };
+    for (MeshRecord const& mesh : meshes) {
+      if (!reader.ok) break;
+      Flags<MeshEncodingEnum> const encoding(mesh.encoding);
+      uint64_t indices = 0, vertices = 0;
+      if (mesh.payload >= 0) {
+        auto const& payload = payloads[mesh.payload];
+        indices = payload[2].size() / ((encoding & MeshEncodingEnum::INDEX_UINT16) ? sizeof(uint16_t) : sizeof(uint32_t));
+        uint64_t const position_stride = (encoding & MeshEncodingEnum::POSITION_SNORM16)
+          ? sizeof(int16_t) * 4 : sizeof(float) * 3;
+        uint64_t const vertex_stride = Mesh::vertex_stride(encoding) * sizeof(uint32_t);
+        vertices = payload[0].empty() ? payload[1].size() / vertex_stride
+          : payload[1].empty() ? payload[0].size() / position_stride
+          : std::min(payload[0].size() / position_stride, payload[1].size() / vertex_stride);
+      }
+      for (size_t i = 0; i < mesh.primitives.size(); ++i) {
+        PrimitiveRecord const& primitive = mesh.primitives[i];
+        PrimitiveClusters const& clusters = mesh.clusters[i];
+        if (!in_range(primitive.offset, primitive.size, indices)
+          || !in_range(primitive.baseVertex, primitive.numVertex, vertices))
+          reader.ok = false;
+        for (Mesh::LOD const& lod : clusters.lods)
+          if (!in_range(lod.offset, lod.size, indices)) reader.ok = false;
+        for (Mesh::Meshlet const& meshlet : clusters.meshlets)
+          if (!in_range(meshlet.vertexOffset, meshlet.vertexCount, clusters.meshletVertices.size())
+            || !in_range(meshlet.triangleOffset, uint64_t(meshlet.triangleCount) * 3, clusters.meshletTriangles.size()))
+            reader.ok = false;
+        for (uint32_t vertex : clusters.meshletVertices)
+          if (vertex >= primitive.numVertex) reader.ok = false;
+      }
+    }
+
+    std::vector<NodeRecord> nodes(count());
+    std::vector<std::string> names(nodes.size());
+    std::vector<std::vector<se::mat4>> instances(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      reader.get(nodes[i]);
+      reader.get_string(names[i]);
+      reader.get_vector(instances[i]);
+      // parents come first in the depth first order
+      check(nodes[i].parent, i);
+      check(nodes[i].mesh, meshes.size());
+      check(nodes[i].cameraMedium, media.size());
+    }
+    std::vector<int32_t> roots;
+    reader.get_vector(roots);
+    for (int32_t root : roots) check(root, nodes.size());
+    if (!reader.ok) {
+      se::error("gfx :: cache :: {} is damaged", path);
+      return false;
+    }
+
+    // the resources, textures are decoded again from their files
+    std::vector<TextureHandle> const textures = GFXContext::load_texture_files(texture_paths);
+    auto texture_of = [&](int32_t index) { return index < 0 ? TextureHandle{} : textures[index]; };
+
+    std::vector<MediumHandle> medium_handles(media.size());
+    for (size_t i = 0; i < media.size(); ++i) {
+      MediumHandle medium = GFXContext::create_medium_empty();
+      medium->packet = media[i].packet;
+      medium->density = std::move(media[i].density);
+      medium->LeScale = std::move(media[i].LeScale);
+      medium->temperatureGrid = std::move(media[i].temperatureGrid);
+      medium->majorantGrid = std::move(media[i].majorantGrid);
+      medium_handles[i] = medium;
+    }
+    auto medium_of = [&](int32_t index) { return index < 0 ? MediumHandle{} : medium_handles[index]; };
+
+    std::vector<MaterialHandle> material_handles(materials.size());
+    for (size_t i = 0; i < materials.size(); ++i) {
+      MaterialHandle material = GFXContext::create_material_empty();
+      material->m_packet = materials[i].packet;
+      material->m_name = std::move(materials[i].name);
+      material->m_customString = std::move(materials[i].customString);
+      material->m_basecolorTex = texture_of(materials[i].textures[0]);
+      material->m_normalTex = texture_of(materials[i].textures[1]);
+      material->m_additionalTex1 = texture_of(materials[i].textures[2]);
+      material->m_additionalTex2 = texture_of(materials[i].textures[3]);
+      material_handles[i] = material;
+    }
+    auto material_of = [&](int32_t index) { return index < 0 ? MaterialHandle{} : material_handles[index]; };
+
+    std::vector<std::array<BufferHandle, 3>> const buffers =
+      upload_payloads(payloads, defaultMeshLoadConfig.residentOnHost);
+    std::vector<MeshHandle> mesh_handles(meshes.size());
+    for (size_t i = 0; i < meshes.size(); ++i) {
+      MeshRecord& record = meshes[i];
+      MeshHandle mesh = GFXContext::create_mesh_empty();
+      mesh->m_name = std::move(record.name);
+      mesh->m_encoding = Flags<MeshEncodingEnum>(record.encoding);
+      mesh->m_contentHash = record.contentHash;
+      if (record.payload >= 0) {
+        mesh->m_positionBuffer = buffers[record.payload][0];
+        mesh->m_vertexBuffer = buffers[record.payload][1];
+        mesh->m_indexBuffer = buffers[record.payload][2];
+      }
+      for (size_t k = 0; k < record.primitives.size(); ++k) {
+        PrimitiveRecord const& fixed = record.primitives[k];
+        Mesh::MeshPrimitive& primitive = mesh->m_primitives.emplace_back();
+        primitive.offset = fixed.offset;
+        primitive.size = fixed.size;
+        primitive.baseVertex = fixed.baseVertex;
+        primitive.numVertex = fixed.numVertex;
+        primitive.material = material_of(fixed.material);
+        primitive.exterior = medium_of(fixed.exterior);
+        primitive.interior = medium_of(fixed.interior);
+        primitive.max = fixed.max;
+        primitive.min = fixed.min;
+        primitive.meshlets = std::move(record.clusters[k].meshlets);
+        primitive.meshletVertices = std::move(record.clusters[k].meshletVertices);
+        primitive.meshletTriangles = std::move(record.clusters[k].meshletTriangles);
+        primitive.lods = std::move(record.clusters[k].lods);
+      }
+      for (CustomPrimitiveRecord const& fixed : record.customs) {
+        Mesh::CustomPrimitive& primitive = mesh->m_customPrimitives.emplace_back();
+        primitive.primitiveType = fixed.primitiveType;
+        primitive.bitfield = fixed.bitfield;
+        primitive.scalarField0 = fixed.scalarField0;
+        primitive.scalarField1 = fixed.scalarField1;
+        primitive.vecField0 = fixed.vecField0;
+        primitive.vecField1 = fixed.vecField1;
+        primitive.vecField2 = fixed.vecField2;
+        primitive.material = material_of(fixed.material);
+        primitive.exterior = medium_of(fixed.exterior);
+        primitive.interior = medium_of(fixed.interior);
+        primitive.max = fixed.max;
+        primitive.min = fixed.min;
+      }
+      mesh_handles[i] = mesh;
+    }
+
+    // the nodes and their components
+    std::vector<Node> scene_nodes(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      NodeRecord const& record = nodes[i];
+      Node node = create_node(names[i]);
+      scene_nodes[i] = node;
+      if (record.parent >= 0) {
+        Node const parent = scene_nodes[record.parent];
+        m_registry.get<NodeProperty>(parent.m_entity).children.push_back(node);
+        m_registry.get<NodeProperty>(node.m_entity).parent = parent.m_entity;
+      }
+      if (record.components & uint32_t(CachedComponentEnum::TRANSFORM)) {
+        Transform& transform = m_registry.get<Transform>(node.m_entity);
+        transform.translation = record.translation;
+        transform.scale = record.scale;
+        transform.oddScaling = record.oddScaling;
+        transform.rotation = record.rotation;
+      }
+      else node.remove_component<Transform>();
+      if (record.components & uint32_t(CachedComponentEnum::MESH_RENDERER)) {
+        MeshRenderer& renderer = node.add_component<MeshRenderer>();
+        if (record.mesh >= 0) renderer.m_mesh = mesh_handles[record.mesh];
+        renderer.m_instances = std::move(instances[i]);
+        renderer.m_dirtyToFile = false;
+        renderer.m_dirtyToGPU = true;
+      }
+      if (record.components & uint32_t(CachedComponentEnum::LIGHT)) {
+        Light& light = node.add_component<Light>();
+        light.light = record.light;
+        light.m_dirtyToFile = false;
+        light.m_dirtyToGPU = true;
+      }
+      if (record.components & uint32_t(CachedComponentEnum::CAMERA)) {
+        Camera& camera = node.add_component<Camera>();
+        camera.aspectRatio = record.aspectRatio;
+        camera.yfov = record.yfov;
+        camera.znear = record.znear;
+        camera.zfar = record.zfar;
+        camera.left_right = record.left_right;
+        camera.bottom_top = record.bottom_top;
+        camera.projectType = Camera::ProjectType(record.projectType);
+        camera.medium = medium_of(record.cameraMedium);
+        camera.m_dirtyToFile = false;
+        camera.m_dirtyToGPU = true;
+      }
+    }
+    for (int32_t root : roots)
+      if (root >= 0) m_roots.push_back(scene_nodes[root]);
+    return true;
+  }
+
+  auto Scene::load_cached(std::string const& path,
+    void (Scene::* load)(std::string const&) noexcept) noexcept -> void {
+    std::string const cache = path + ".sescene";
+    if (load_cache(cache)) {
+      se::info("gfx :: cache :: {} loaded from {}", path, cache);
+      return;
+    }
+    // the loader lists the files it reads, its description first
+    m_sourceFiles.clear();
+    (this->*load)(path);
+    if (save_cache(cache))
+      se::info("gfx :: cache :: {} cached to {}", path, cache);
+  }
+}
+}
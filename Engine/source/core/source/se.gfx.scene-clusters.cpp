@@ -0,0 +1,264 @@
+#include "se.gfx.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <unordered_map>
+
+namespace se {
+namespace gfx {
+  // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+  // ┃ Light Clusters                                                            ┃
+  // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+
+  static_assert(sizeof(Scene::LightClusterGrid) == 32, "matches LightClusterGrid in spt-definition.slang");
+  static_assert(sizeof(Scene::LightClusterSphere) == 32, "matches LightClusterSphere in spt-definition.slang");
+
+  // The camera space the froxels are laid out in, the same basis
+  // light-clusters.slang builds from scene_read_camera(0).
+  struct ClusterFrame {
+    vec3 origin;
+    vec3 right, up, forward;
+    float tanX, tanY;
+
+    ClusterFrame(CameraData const& camera) {
+      origin = camera.posW;
+      tanX = camera.cameraU.length();
+      tanY = camera.cameraV.length();
+      right = camera.cameraU / tanX;
+      up = camera.cameraV / tanY;
+      forward = se::normalize(camera.cameraW);
+    }
+
+    auto to_camera(vec3 p) const noexcept -> vec3 {
+      vec3 const d = p - origin;
+      return { se::dot(d, right), se::dot(d, up), se::dot(d, forward) };
+    }
+  };
+
+  // The camera space box around a froxel, slices split the depth range
+  // exponentially so near clusters are not stretched along the view.
+  static auto cluster_box(Scene::LightClusterGrid const& grid, ClusterFrame const& frame,
+    uint32_t x, uint32_t y, uint32_t z) noexcept -> bounds3 {
+    float const ratio = grid.zfar / grid.znear;
+    float const d0 = grid.znear * std::pow(ratio, float(z) / grid.dims.z);
+    float const d1 = grid.znear * std::pow(ratio, float(z + 1) / grid.dims.z);
+    float const x0 = -1.f + 2.f * x / grid.dims.x, x1 = -1.f + 2.f * (x + 1) / grid.dims.x;
+    float const y0 = -1.f + 2.f * y / grid.dims.y, y1 = -1.f + 2.f * (y + 1) / grid.dims.y;
+    bounds3 box;
+    box.pMin = { std::min(x0 * d0, x0 * d1) * frame.tanX, std::min(y0 * d0, y0 * d1) * frame.tanY, d0 };
+    box.pMax = { std::max(x1 * d0, x1 * d1) * frame.tanX, std::max(y1 * d0, y1 * d1) * frame.tanY, d1 };
+    return box;
+  }
+
+  static auto sphere_overlaps(bounds3 const& box, vec3 center, float radius) noexcept -> bool {
+    vec3 const closest = se::max(box.pMin, se::min(center, box.pMax));
+    vec3 const d = center - closest;
+    return se::dot(d, d) <= radius * radius;
+  }
+
+  auto Scene::light_cluster_spheres() noexcept -> std::vector<LightClusterSphere> {
+    std::vector<LightClusterSphere> spheres;
+    float const cutoff = std::max(m_lightClusterConfig.cutoff, 1e-6f);
+    for (auto& entity_lights : m_gpuScene.lightList) {
+      for (auto& lights_index : entity_lights.second) {
+        for (int32_t i = 0; i < lights_index.length; ++i) {
+          int32_t const index = lights_index.assignedIndex + i;
+          LightData const& light = m_gpuScene.lightBuffer[index];
+          float const phi = light.floatvec_0.x;
+          if (phi <= 0) continue;
+          // the emitter bounds grown by the distance its power falls
+          // below the cutoff, as if all of it left a point
+          vec3 const pmin = light.floatvec_1.xyz();
+          vec3 const pmax = light.floatvec_2.xyz();
+          LightClusterSphere sphere = {};
+          sphere.center = (pmin + pmax) * 0.5f;
+          sphere.radius = (pmax - pmin).length() * 0.5f
+            + std::sqrt(phi / (4 * M_FLOAT_PI * cutoff));
+          sphere.lightID = index;
+          spheres.push_back(sphere);
+        }
+      }
+    }
+    return spheres;
+  }
+
+  auto Scene::cluster_lights_reference() noexcept -> LightClusters {
+    LightClusters clusters;
+    if (m_gpuScene.lightClusters.gridBuffer.get() != nullptr &&
+      m_gpuScene.lightClusters.gridBuffer->m_host.size() >= sizeof(LightClusterGrid))
+      clusters.grid = *reinterpret_cast<LightClusterGrid const*>(
+        m_gpuScene.lightClusters.gridBuffer->m_host.data());
+    else return clusters;
+    LightClusterGrid const& grid = clusters.grid;
+    uint32_t const stride = grid.capacity + 1;
+    size_t const count = size_t(grid.dims.x) * grid.dims.y * grid.dims.z;
+    clusters.lists.assign(count * stride, 0);
+    if (m_gpuScene.cameraBuffer.m_size == 0 || grid.lightCount == 0) return clusters;
+
+    ClusterFrame const frame(m_gpuScene.cameraBuffer[0]);
+    std::vector<LightClusterSphere> spheres = light_cluster_spheres();
+    for (LightClusterSphere& sphere : spheres)
+      sphere.center = frame.to_camera(sphere.center);
+    for (uint32_t z = 0; z < grid.dims.z; ++z)
+    for (uint32_t y = 0; y < grid.dims.y; ++y)
+    for (uint32_t x = 0; x < grid.dims.x; ++x) {
+      bounds3 const box = cluster_box(grid, frame, x, y, z);
+      uint32_t* list = &clusters.lists[(x + grid.dims.x * (y + grid.dims.y * z)) * stride];
+      // the count keeps growing past the capacity so overflow is seen
+      for (LightClusterSphere const& sphere : spheres) {
+        if (!sphere_overlaps(box, sphere.center, sphere.radius)) continue;
+        if (list[0] < grid.capacity) list[1 + list[0]] = uint32_t(sphere.lightID);
+        list[0]++;
+      }
+    }
+    return clusters;
+  }
+
+  auto Scene::check_light_clusters() noexcept -> size_t {
+    auto& buffers = m_gpuScene.lightClusters;
+    LightClusters const reference = cluster_lights_reference();
+    if (reference.lists.empty() || m_gpuScene.cameraBuffer.m_size == 0
+      || buffers.listBuffer.get() == nullptr || buffers.listBuffer->m_buffer == nullptr) return 0;
+    GFXContext::device()->wait_idle();
+    buffers.listBuffer->device_to_host();
+    std::vector<uint32_t> device(reference.lists.size(), 0);
+    if (buffers.listBuffer->m_host.size() >= device.size() * sizeof(uint32_t))
+      memcpy(device.data(), buffers.listBuffer->m_host.data(), device.size() * sizeof(uint32_t));
+    // only the pass writes the lists, the host copy is not kept
+    std::vector<std::byte>().swap(buffers.listBuffer->m_host);
+
+    LightClusterGrid const& grid = reference.grid;
+    uint32_t const stride = grid.capacity + 1;
+    ClusterFrame const frame(m_gpuScene.cameraBuffer[0]);
+    std::unordered_map<int32_t, LightClusterSphere> spheres;
+    for (LightClusterSphere sphere : light_cluster_spheres()) {
+      sphere.center = frame.to_camera(sphere.center);
+      spheres.emplace(sphere.lightID, sphere);
+    }
+    // the device rounds pow and the box differently, a light whose sphere
+    // only grazes the box may be binned on one side and not the other
+    auto grazes = [&](bounds3 const& box, uint32_t light) {
+      auto iter = spheres.find(int32_t(light));
+      if (iter == spheres.end()) return false;
+      float const radius = iter->second.radius;
+      return sphere_overlaps(box, iter->second.center, radius * 1.001f)
+        != sphere_overlaps(box, iter->second.center, radius * 0.999f);
+    };
+
+    size_t mismatched = 0;
+    for (uint32_t z = 0; z < grid.dims.z; ++z)
+    for (uint32_t y = 0; y < grid.dims.y; ++y)
+    for (uint32_t x = 0; x < grid.dims.x; ++x) {
+      size_t const base = (x + grid.dims.x * (y + grid.dims.y * z)) * stride;
+      uint32_t const host_count = reference.lists[base];
+      uint32_t const device_count = device[base];
+      // overflowing lists hold a prefix of the lights, only the overflow is compared
+      if (host_count > grid.capacity || device_count > grid.capacity) {
+        if ((host_count > grid.capacity) == (device_count > grid.capacity)) continue;
+      }
+      else {
+        std::vector<uint32_t> host_lights(reference.lists.begin() + base + 1,
+          reference.lists.begin() + base + 1 + host_count);
+        std::vector<uint32_t> device_lights(device.begin() + base + 1,
+          device.begin() + base + 1 + device_count);
+        std::sort(host_lights.begin(), host_lights.end());
+        std::sort(device_lights.begin(), device_lights.end());
+        std::vector<uint32_t> differ;
+        std::set_symmetric_difference(host_lights.begin(), host_lights.end(),
+          device_lights.begin(), device_lights.end(), std::back_inserter(differ));
+        bounds3 const box = cluster_box(grid, frame, x, y, z);
+        if (std::all_of(differ.begin(), differ.end(), [&](uint32_t light) { return grazes(box, light); }))
+          continue;
+      }
+      if (mismatched++ < 8)
+        se::error("gfx :: light clusters :: cluster ({}, {}, {}) holds {} lights on the device, {} on the host",
+          x, y, z, device_count, host_count);
+    }
+    if (mismatched > 0)
+      se::error("gfx :: light clusters :: {} of {} clusters differ from the reference",
+        mismatched, reference.lists.size() / stride);
+    return mismatched;
+  }
+
+  auto Scene::light_cluster_stats(LightClusters const& clusters) noexcept -> LightClusterStats {
+    LightClusterStats stats;
+    uint32_t const stride = clusters.grid.capacity + 1;
+    if (clusters.lists.empty()) return stats;
+    stats.clusters = clusters.lists.size() / stride;
+    size_t total = 0;
+    for (size_t i = 0; i < stats.clusters; ++i) {
+      uint32_t const count = clusters.lists[i * stride];
+      if (count == 0) continue;
+      stats.occupied++;
+      if (count > clusters.grid.capacity) stats.overflowed++;
+      stats.maxLights = std::max(stats.maxLights, count);
+      total += count;
+    }
+    stats.averageLights = float(total) / stats.clusters;
+    if (stats.occupied > 0) stats.averageOccupiedLights = float(total) / stats.occupied;
+    return stats;
+  }
+
+  auto Scene::update_gpu_light_clusters() noexcept -> void {
+    auto& clusters = m_gpuScene.lightClusters;
+    LightClusterConfig const& config = m_lightClusterConfig;
+
+    // the spheres follow the light buffer, which is rewritten on light changes
+    if (clusters.lightStamp != m_gpuScene.lightBuffer.m_buffer->m_hostStamp) {
+      std::vector<LightClusterSphere> spheres = light_cluster_spheres();
+      clusters.sphereCount = uint32_t(spheres.size());
+      // directional, environment and area lights alone do not need the pass
+      clusters.punctual = std::any_of(spheres.begin(), spheres.end(),
+        [&](LightClusterSphere const& sphere) {
+          LightTypeEnum const type = m_gpuScene.lightBuffer[sphere.lightID].light_type;
+          return type == LightTypeEnum::POINT || type == LightTypeEnum::SPOT; });
+      clusters.sphereBuffer->m_host.resize(std::max(spheres.size(), size_t(1)) * sizeof(LightClusterSphere));
+      if (!spheres.empty())
+        memcpy(clusters.sphereBuffer->m_host.data(), spheres.data(), spheres.size() * sizeof(LightClusterSphere));
+      clusters.sphereBuffer->m_hostStamp++;
+      clusters.lightStamp = m_gpuScene.lightBuffer.m_buffer->m_hostStamp;
+    }
+    clusters.sphereBuffer->host_to_device();
+
+    LightClusterGrid grid = {};
+    grid.dims = se::max(config.grid, uvec3{ 1 });
+    grid.capacity = std::max(config.capacity, 1u);
+    grid.cutoff = config.cutoff;
+    grid.lightCount = clusters.punctual ? clusters.sphereCount : 0;
+    if (m_gpuScene.cameraBuffer.m_size > 0) {
+      CameraData const& camera = m_gpuScene.cameraBuffer[0];
+      grid.znear = std::max(camera.nearZ, 1e-4f);
+      grid.zfar = std::max(camera.farZ, grid.znear * 2);
+    }
+    else {
+      grid.znear = 0.1f;
+      grid.zfar = 1000.f;
+      grid.lightCount = 0;
+    }
+    clusters.gridBuffer->m_host.resize(sizeof(LightClusterGrid));
+    if (memcmp(clusters.gridBuffer->m_host.data(), &grid, sizeof(grid)) != 0) {
+      memcpy(clusters.gridBuffer->m_host.data(), &grid, sizeof(grid));
+      clusters.gridBuffer->m_hostStamp++;
+    }
+    clusters.gridBuffer->host_to_device();
+    clusters.dims = grid.dims;
+    clusters.lightCount = grid.lightCount;
+
+    // the lists are only written by the cluster pass, the buffer is
+    // recreated when the grid or the capacity change its size
+    size_t const bytes = size_t(grid.dims.x) * grid.dims.y * grid.dims.z
+      * (grid.capacity + 1) * sizeof(uint32_t);
+    if (clusters.listBuffer.get() == nullptr || clusters.listBuffer->m_buffer == nullptr
+      || clusters.listBuffer->m_buffer->size() != bytes) {
+      clusters.listBuffer = GFXContext::create_buffer_desc(rhi::BufferDescriptor{
+        bytes, rhi::BufferUsageEnum::STORAGE | rhi::BufferUsageEnum::COPY_SRC,
+        rhi::BufferShareMode::EXCLUSIVE,
+        rhi::MemoryPropertyEnum::DEVICE_LOCAL_BIT });
+      clusters.listBuffer->m_job = "Scene light cluster list buffer";
+      clusters.listBuffer->m_usages = rhi::BufferUsageEnum::STORAGE | rhi::BufferUsageEnum::COPY_SRC;
+      clusters.listsEmpty = false;
+    }
+    clusters.dispatch = grid.lightCount > 0 || !clusters.listsEmpty;
+  }
+}
+}
@@ -0,0 +1,183 @@
+#include "se.gfx.hpp"
+#include "se.gfx.scene-loader.hpp"
+#include <unordered_set>
+
+namespace se {
+namespace gfx {
+  // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+  // ┃ Mesh Payload Hash                                                         ┃
+  // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+
+  // FNV-1a folded over 64-bit words, the payloads are little endian on every
+  // supported platform so the value is stable across runs and machines.
+  static constexpr uint64_t fnv_offset_basis = 14695981039346656037ull;
+  static constexpr uint64_t fnv_prime = 1099511628211ull;
+
+  static inline auto hash_bytes(uint64_t hash, void const* data, size_t size) noexcept -> uint64_t {
+    std::byte const* bytes = static_cast<std::byte const*>(data);
+    size_t const words = size / sizeof(uint64_t);
+    for (size_t i = 0; i < words; ++i) {
+      uint64_t word;
+      memcpy(&word, bytes + i * sizeof(uint64_t), sizeof(uint64_t));
+      hash = (hash ^ word) * fnv_prime;
+    }
+    for (size_t i = words * sizeof(uint64_t); i < size; ++i)
+      hash = (hash ^ uint64_t(bytes[i])) * fnv_prime;
+    return hash;
+  }
+
+  static inline auto hash_value(uint64_t hash, uint64_t value) noexcept -> uint64_t {
+    return hash_bytes(hash, &value, sizeof(uint64_t));
+  }
+
+  auto hash_mesh_payload(Mesh const& mesh,
+    std::vector<float> const& positions,
+    std::vector<float> const& vertices,
+    std::vector<uint32_t> const& indices) noexcept -> uint64_t {
+    uint64_t hash = fnv_offset_basis;
+    hash = hash_value(hash, positions.size());
+    hash = hash_value(hash, vertices.size());
+    hash = hash_value(hash, indices.size());
+    hash = hash_bytes(hash, positions.data(), positions.size() * sizeof(float));
+    hash = hash_bytes(hash, vertices.data(), vertices.size() * sizeof(float));
+    hash = hash_bytes(hash, indices.data(), indices.size() * sizeof(uint32_t));
+    hash = hash_value(hash, mesh.m_primitives.size());
+    for (auto const& primitive : mesh.m_primitives) {
+      hash = hash_value(hash, primitive.offset);
+      hash = hash_value(hash, primitive.size);
+      hash = hash_value(hash, primitive.baseVertex);
+      hash = hash_value(hash, primitive.numVertex);
+    }
+    // reserve 0 for meshes that were never hashed
+    return hash == 0 ? fnv_offset_basis : hash;
+  }
+
+  // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+  // ┃ Mesh Deduplication                                                        ┃
+  // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+
+  static inline auto buffer_bytes(BufferHandle const& buffer) noexcept -> size_t {
+    Buffer const* ptr = buffer.m_handle ? buffer.m_handle.handle().get() : nullptr;
+    return (ptr && ptr->m_buffer) ? ptr->m_buffer->size() : 0;
+  }
+
+  static inline auto payload_bytes(Mesh const& mesh) noexcept -> size_t {
+    return buffer_bytes(mesh.m_positionBuffer)
+      + buffer_bytes(mesh.m_vertexBuffer)
+      + buffer_bytes(mesh.m_indexBuffer);
+  }
+
+  static inline auto same_buffer_content(Buffer const* pa, Buffer const* pb) noexcept -> bool {
+    if (pa == pb) return true;
+    if (pa == nullptr || pb == nullptr) return false;
+    // a host copy that could not be read back is never trusted to the hash
+    if (pa->m_host.empty() || pb->m_host.empty()) return false;
+    return pa->m_host == pb->m_host;
+  }
+
+  static inline auto same_payload(Mesh& a, Mesh& b) noexcept -> bool {
+    if (a.m_contentHash != b.m_contentHash) return false;
+    if (a.m_encoding.mask() != b.m_encoding.mask()) return false;
+    if (a.m_primitives.size() != b.m_primitives.size()) return false;
+    if (!a.m_customPrimitives.empty() || !b.m_customPrimitives.empty()) return false;
+    for (size_t i = 0; i < a.m_primitives.size(); ++i) {
+      auto const& pa = a.m_primitives[i];
+      auto const& pb = b.m_primitives[i];
+      if (pa.offset != pb.offset || pa.size != pb.size ||
+        pa.baseVertex != pb.baseVertex || pa.numVertex != pb.numVertex)
+        return false;
+    }
+    if (a.m_positionBuffer.get() == b.m_positionBuffer.get()
+      && a.m_vertexBuffer.get() == b.m_vertexBuffer.get()
+      && a.m_indexBuffer.get() == b.m_indexBuffer.get())
+      return true;
+    // the hash only finds the candidates, merge on equal bytes alone
+    a.fetch_host(); b.fetch_host();
+    bool const same = same_buffer_content(a.m_positionBuffer.get(), b.m_positionBuffer.get())
+      && same_buffer_content(a.m_vertexBuffer.get(), b.m_vertexBuffer.get())
+      && same_buffer_content(a.m_indexBuffer.get(), b.m_indexBuffer.get());
+    a.release_host(); b.release_host();
+    return same;
+  }
+
+  static inline auto same_bindings(Mesh& a, Mesh& b) noexcept -> bool {
+    for (size_t i = 0; i < a.m_primitives.size(); ++i) {
+      auto& pa = a.m_primitives[i];
+      auto& pb = b.m_primitives[i];
+      if (pa.material.get() != pb.material.get() ||
+        pa.exterior.get() != pb.exterior.get() ||
+        pa.interior.get() != pb.interior.get())
+        return false;
+    }
+    return true;
+  }
+
+  static inline auto binding_key(Mesh& mesh) noexcept -> uint64_t {
+    uint64_t key = mesh.m_contentHash;
+    for (auto& primitive : mesh.m_primitives) {
+      key = hash_value(key, uint64_t(reinterpret_cast<uintptr_t>(primitive.material.get())));
+      key = hash_value(key, uint64_t(reinterpret_cast<uintptr_t>(primitive.exterior.get())));
+      key = hash_value(key, uint64_t(reinterpret_cast<uintptr_t>(primitive.interior.get())));
+    }
+    return key;
+  }
+
+  auto deduplicate_meshes(Scene& scene) noexcept -> MeshDeduplicationStats {
+    PROFILE_SCOPE_FUNCTION();
+    MeshDeduplicationStats stats;
+    // first mesh seen for each payload, and for each payload + bindings
+    std::unordered_map<uint64_t, MeshHandle> payloads;
+    std::unordered_map<uint64_t, MeshHandle> resources;
+    std::unordered_set<Mesh*> merged;
+
+    auto view = scene.m_registry.view<MeshRenderer>();
+    for (auto entity : view) {
+      MeshRenderer& renderer = view.get<MeshRenderer>(entity);
+      Mesh* mesh = renderer.m_mesh.get();
+      if (mesh == nullptr || mesh->m_contentHash == 0) continue;
+      // the byte counts read the device buffers
+      mesh->wait_buffers();
+
+      uint64_t const key = binding_key(*mesh);
+      auto resource = resources.find(key);
+      if (resource != resources.end()) {
+        Mesh* canonical = resource->second.get();
+        if (canonical == mesh) continue;
+        if (same_payload(*canonical, *mesh) && same_bindings(*canonical, *mesh)) {
+          // meshes used by several nodes are only counted once
+          if (merged.insert(mesh).second) {
+            stats.meshesMerged++;
+            if (mesh->m_positionBuffer.get() != canonical->m_positionBuffer.get())
+              stats.bytesSaved += payload_bytes(*mesh);
+          }
+          scene.m_registry.patch<MeshRenderer>(entity, [&](MeshRenderer& patched) {
+            patched.m_mesh = resource->second;
+            patched.m_dirtyToGPU = true; });
+        }
+        continue;
+      }
+      resources.emplace(key, renderer.m_mesh);
+
+      // same geometry but bound to other materials, share the buffers only
+      auto payload = payloads.find(mesh->m_contentHash);
+      if (payload == payloads.end()) {
+        payloads.emplace(mesh->m_contentHash, renderer.m_mesh);
+        continue;
+      }
+      Mesh* twin = payload->second.get();
+      if (twin->m_positionBuffer.get() == mesh->m_positionBuffer.get()) continue;
+      if (!same_payload(*twin, *mesh)) continue;
+      stats.buffersShared++;
+      stats.bytesSaved += payload_bytes(*mesh);
+      mesh->m_positionBuffer = twin->m_positionBuffer;
+      mesh->m_vertexBuffer = twin->m_vertexBuffer;
+      mesh->m_indexBuffer = twin->m_indexBuffer;
+    }
+
+    if (stats.meshesMerged > 0 || stats.buffersShared > 0)
+      se::info("gfx :: mesh deduplication :: merged {} meshes, shared buffers of {} meshes, saved {} bytes",
+        stats.meshesMerged, stats.buffersShared, stats.bytesSaved);
+    return stats;
+  }
+}
+}
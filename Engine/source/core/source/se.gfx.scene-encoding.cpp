@@ -0,0 +1,475 @@
+#include "se.gfx.hpp"
+#include "se.gfx.scene-loader.hpp"
+
+namespace se {
+namespace gfx {
+  // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+  // ┃ Attribute Encodings                                                       ┃
+  // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+  // Every encoding here has a matching decode in srenderer/spt-bindings.slang.
+
+  // valid directions never quantize to -32768, so the pair marks zero vectors
+  static constexpr uint32_t oct16_zero = 0x80008000u;
+  // the float layout is normal3, tangent3 and uv2
+  static constexpr size_t float_vertex_stride = 8;
+
+  static inline auto quantize_snorm16(float v) noexcept -> int16_t {
+    return int16_t(std::lround(std::clamp(v, -1.f, 1.f) * 32767.f));
+  }
+
+  static inline auto dequantize_snorm16(int16_t q) noexcept -> float {
+    return std::max(float(q) / 32767.f, -1.f);
+  }
+
+  static inline auto encode_oct16(vec3 n) noexcept -> uint32_t {
+    float const l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (!(l1 > 0.f)) return oct16_zero;
+    float x = n.x / l1, y = n.y / l1;
+    // fold the lower hemisphere over the diagonals
+    if (n.z < 0.f) {
+      float const fx = (1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f);
+      float const fy = (1.f - std::abs(x)) * (y >= 0.f ? 1.f : -1.f);
+      x = fx; y = fy;
+    }
+    return uint32_t(uint16_t(quantize_snorm16(x)))
+      | (uint32_t(uint16_t(quantize_snorm16(y))) << 16);
+  }
+
+  static inline auto decode_oct16(uint32_t word) noexcept -> vec3 {
+    if (word == oct16_zero) return vec3{ 0.f, 0.f, 0.f };
+    float const x = dequantize_snorm16(int16_t(word & 0xffff));
+    float const y = dequantize_snorm16(int16_t(word >> 16));
+    vec3 n = { x, y, 1.f - std::abs(x) - std::abs(y) };
+    float const t = std::max(-n.z, 0.f);
+    n.x += n.x >= 0.f ? -t : t;
+    n.y += n.y >= 0.f ? -t : t;
+    return se::normalize(n);
+  }
+
+  static inline auto encode_unorm16x2(float x, float y) noexcept -> uint32_t {
+    auto q = [](float v) { return uint32_t(std::lround(std::clamp(v, 0.f, 1.f) * 65535.f)); };
+    return q(x) | (q(y) << 16);
+  }
+
+  static inline auto encode_float16x2(float x, float y) noexcept -> uint32_t {
+    return uint32_t(uint16_t(half(x).hdata)) | (uint32_t(uint16_t(half(y).hdata)) << 16);
+  }
+
+  static inline auto decode_float16(uint32_t bits) noexcept -> float {
+    half h; h.hdata = short(uint16_t(bits));
+    return h.to_float();
+  }
+
+  template<class T>
+  static inline auto append(std::vector<std::byte>& bytes, T const& value) noexcept -> void {
+    size_t const size = bytes.size();
+    bytes.resize(size + sizeof(T));
+    memcpy(bytes.data() + size, &value, sizeof(T));
+  }
+
+  template<class T>
+  static inline auto load(std::vector<std::byte> const& bytes, size_t offset) noexcept -> T {
+    T value;
+    memcpy(&value, bytes.data() + offset, sizeof(T));
+    return value;
+  }
+
+  auto Mesh::vertex_stride() const noexcept -> uint32_t {
+    return vertex_stride(m_encoding);
+  }
+
+  auto Mesh::vertex_stride(Flags<MeshEncodingEnum> encoding) noexcept -> uint32_t {
+    uint32_t stride = 0;
+    stride += (encoding & MeshEncodingEnum::NORMAL_OCT16) ? 1 : 3;
+    stride += (encoding & MeshEncodingEnum::TANGENT_OCT16) ? 1 : 3;
+    stride += (encoding & (MeshEncodingEnum::TEXCOORD_FLOAT16
+      | MeshEncodingEnum::TEXCOORD_UNORM16)) ? 1 : 2;
+    return stride;
+  }
+
+  auto Mesh::position_frame(MeshPrimitive const& primitive) noexcept -> std::pair<vec3, vec3> {
+    vec3 const center = (primitive.max + primitive.min) * 0.5f;
+    vec3 extent = (primitive.max - primitive.min) * 0.5f;
+    // flat primitives still need an invertible frame
+    for (int i = 0; i < 3; ++i)
+      if (!(extent.data[i] > 0.f)) extent.data[i] = 1.f;
+    return { center, extent };
+  }
+
+  auto Mesh::wait_buffers() noexcept -> void {
+    for (Buffer* buffer : { m_positionBuffer.get(), m_indexBuffer.get(), m_vertexBuffer.get() })
+      if (buffer != nullptr) GFXContext::wait_upload(*buffer);
+  }
+
+  auto Mesh::fetch_host() noexcept -> void {
+    wait_buffers();
+    // a streamed payload off the device is read from its chunk instead
+    if (m_streaming.store && m_positionBuffer->m_buffer == nullptr
+      && m_positionBuffer->m_host.empty()) {
+      MeshPayload payload = m_streaming.store->read(m_streaming.chunk);
+      m_positionBuffer->m_host = std::move(payload.positions);
+      m_vertexBuffer->m_host = std::move(payload.vertices);
+      m_indexBuffer->m_host = std::move(payload.indices);
+      return;
+    }
+    std::vector<std::future<void>> readbacks;
+    for (Buffer* buffer : { m_positionBuffer.get(), m_indexBuffer.get(), m_vertexBuffer.get() })
+      if (buffer != nullptr && buffer->m_host.empty())
+        readbacks.emplace_back(buffer->device_to_host_async());
+    for (auto& readback : readbacks) readback.wait();
+  }
+
+  auto Mesh::release_host() noexcept -> void {
+    for (Buffer* buffer : { m_positionBuffer.get(), m_indexBuffer.get(), m_vertexBuffer.get() }) {
+      if (buffer == nullptr) continue;
+      // the store keeps the payload of a streamed mesh
+      if (m_streaming.store && buffer->m_buffer == nullptr)
+        std::vector<std::byte>().swap(buffer->m_host);
+      else buffer->release_host();
+    }
+  }
+
+  auto Mesh::host_index(size_t index) noexcept -> uint32_t {
+    std::vector<std::byte> const& host = m_indexBuffer->m_host;
+    if (m_encoding & MeshEncodingEnum::INDEX_UINT16)
+      return load<uint16_t>(host, index * sizeof(uint16_t));
+    return load<uint32_t>(host, index * sizeof(uint32_t));
+  }
+
+  auto Mesh::host_position(MeshPrimitive const& primitive, size_t vertex) noexcept -> vec3 {
+    std::vector<std::byte> const& host = m_positionBuffer->m_host;
+    if (m_encoding & MeshEncodingEnum::POSITION_SNORM16) {
+      auto [center, extent] = position_frame(primitive);
+      size_t const offset = vertex * sizeof(int16_t) * 4;
+      vec3 p;
+      for (int i = 0; i < 3; ++i)
+        p.data[i] = center.data[i] + extent.data[i]
+          * dequantize_snorm16(load<int16_t>(host, offset + i * sizeof(int16_t)));
+      return p;
+    }
+    return load<vec3>(host, vertex * sizeof(float) * 3);
+  }
+
+  auto Mesh::host_normal(size_t vertex) noexcept -> vec3 {
+    std::vector<std::byte> const& host = m_vertexBuffer->m_host;
+    size_t const offset = vertex * vertex_stride() * sizeof(uint32_t);
+    if (m_encoding & MeshEncodingEnum::NORMAL_OCT16)
+      return decode_oct16(load<uint32_t>(host, offset));
+    return load<vec3>(host, offset);
+  }
+
+  // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+  // ┃ Mesh Payload Encoding                                                     ┃
+  // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+
+  auto encode_mesh_payload(Mesh& mesh,
+    std::vector<float> const& positions,
+    std::vector<float> const& vertices,
+    std::vector<uint32_t> const& indices,
+    Flags<MeshEncodingEnum> encoding) noexcept -> MeshPayload {
+    size_t const vertex_count = positions.size() / 3;
+    // drop the encodings the payload does not allow
+    if (vertices.size() != vertex_count * float_vertex_stride)
+      encoding &= Flags<MeshEncodingEnum>(MeshEncodingEnum::POSITION_SNORM16)
+        | MeshEncodingEnum::INDEX_UINT16;
+    if (encoding & MeshEncodingEnum::INDEX_UINT16) {
+      for (auto const& primitive : mesh.m_primitives)
+        if (primitive.numVertex > 65536) {
+          encoding &= ~uint32_t(MeshEncodingEnum::INDEX_UINT16);
+          break;
+        }
+    }
+    if (encoding & MeshEncodingEnum::TEXCOORD_UNORM16) {
+      bool fits = true;
+      for (size_t v = 0; v < vertex_count && fits; ++v)
+        for (int i = 6; i < 8; ++i) {
+          float const uv = vertices[v * float_vertex_stride + i];
+          if (!(uv >= 0.f && uv <= 1.f)) fits = false;
+        }
+      // repeating texcoords keep their range in half floats
+      encoding &= ~uint32_t(fits ? MeshEncodingEnum::TEXCOORD_FLOAT16
+        : MeshEncodingEnum::TEXCOORD_UNORM16);
+      if (!fits) encoding |= MeshEncodingEnum::TEXCOORD_FLOAT16;
+    }
+    mesh.m_encoding = encoding;
+
+    MeshPayload payload;
+    // positions
+    if (encoding & MeshEncodingEnum::POSITION_SNORM16) {
+      payload.positions.reserve(vertex_count * sizeof(int16_t) * 4);
+      for (auto& primitive : mesh.m_primitives) {
+        // quantize against the exact bounds of the primitive
+        if (primitive.numVertex > 0) {
+          vec3 pmin = { positions[primitive.baseVertex * 3 + 0],
+            positions[primitive.baseVertex * 3 + 1], positions[primitive.baseVertex * 3 + 2] };
+          vec3 pmax = pmin;
+          for (size_t v = primitive.baseVertex; v < primitive.baseVertex + primitive.numVertex; ++v) {
+            vec3 const p = { positions[v * 3 + 0], positions[v * 3 + 1], positions[v * 3 + 2] };
+            pmin = se::min(pmin, p);
+            pmax = se::max(pmax, p);
+          }
+          primitive.min = pmin;
+          primitive.max = pmax;
+        }
+      }
+      // vertices not covered by any primitive keep a unit frame
+      std::vector<std::pair<vec3, vec3>> frames(vertex_count,
+        { vec3{ 0.f, 0.f, 0.f }, vec3{ 1.f, 1.f, 1.f } });
+      for (auto const& primitive : mesh.m_primitives)
+        for (size_t v = primitive.baseVertex; v < primitive.baseVertex + primitive.numVertex; ++v)
+          frames[v] = Mesh::position_frame(primitive);
+      for (size_t v = 0; v < vertex_count; ++v) {
+        auto const& [center, extent] = frames[v];
+        for (int i = 0; i < 3; ++i)
+          append(payload.positions, quantize_snorm16(
+            (positions[v * 3 + i] - center.data[i]) / extent.data[i]));
+        append(payload.positions, int16_t(0));
+      }
+    }
+    else {
+      payload.positions.resize(positions.size() * sizeof(float));
+      memcpy(payload.positions.data(), positions.data(), payload.positions.size());
+    }
+
+    // vertex attributes
+    if (!(encoding & (MeshEncodingEnum::NORMAL_OCT16 | MeshEncodingEnum::TANGENT_OCT16
+      | MeshEncodingEnum::TEXCOORD_FLOAT16 | MeshEncodingEnum::TEXCOORD_UNORM16))) {
+      payload.vertices.resize(vertices.size() * sizeof(float));
+      memcpy(payload.vertices.data(), vertices.data(), payload.vertices.size());
+    }
+    else {
+      payload.vertices.reserve(vertex_count * mesh.vertex_stride() * sizeof(uint32_t));
+      for (size_t v = 0; v < vertex_count; ++v) {
+        float const* vertex = vertices.data() + v * float_vertex_stride;
+        for (int attribute = 0; attribute < 2; ++attribute) {
+          float const* direction = vertex + attribute * 3;
+          MeshEncodingEnum const bit = attribute == 0
+            ? MeshEncodingEnum::NORMAL_OCT16 : MeshEncodingEnum::TANGENT_OCT16;
+          if (encoding & bit)
+            append(payload.vertices, encode_oct16({ direction[0], direction[1], direction[2] }));
+          else for (int i = 0; i < 3; ++i) append(payload.vertices, direction[i]);
+        }
+        if (encoding & MeshEncodingEnum::TEXCOORD_UNORM16)
+          append(payload.vertices, encode_unorm16x2(vertex[6], vertex[7]));
+        else if (encoding & MeshEncodingEnum::TEXCOORD_FLOAT16)
+          append(payload.vertices, encode_float16x2(vertex[6], vertex[7]));
+        else { append(payload.vertices, vertex[6]); append(payload.vertices, vertex[7]); }
+      }
+    }
+
+    // indices, padded to whole words for the shader reads
+    if (encoding & MeshEncodingEnum::INDEX_UINT16) {
+      payload.indices.reserve((indices.size() + 1) * sizeof(uint16_t));
+      for (uint32_t index : indices) append(payload.indices, uint16_t(index));
+      if (indices.size() % 2 == 1) append(payload.indices, uint16_t(0));
+    }
+    else {
+      payload.indices.resize(indices.size() * sizeof(uint32_t));
+      memcpy(payload.indices.data(), indices.data(), payload.indices.size());
+    }
+    return payload;
+  }
+
+  auto decode_mesh_payload(Mesh& mesh, MeshPayload const& payload) noexcept -> MeshPayload {
+    Flags<MeshEncodingEnum> const encoding = mesh.m_encoding;
+    if (!encoding) return payload;
+    MeshPayload decoded;
+    // positions
+    if (encoding & MeshEncodingEnum::POSITION_SNORM16) {
+      size_t const vertex_count = payload.positions.size() / (sizeof(int16_t) * 4);
+      std::vector<std::pair<vec3, vec3>> frames(vertex_count,
+        { vec3{ 0.f, 0.f, 0.f }, vec3{ 1.f, 1.f, 1.f } });
+      for (auto const& primitive : mesh.m_primitives)
+        for (size_t v = primitive.baseVertex; v < primitive.baseVertex + primitive.numVertex; ++v)
+          frames[v] = Mesh::position_frame(primitive);
+      decoded.positions.reserve(vertex_count * sizeof(float) * 3);
+      for (size_t v = 0; v < vertex_count; ++v)
+        for (int i = 0; i < 3; ++i) {
+          int16_t const q = load<int16_t>(payload.positions, (v * 4 + i) * sizeof(int16_t));
+          append(decoded.positions, frames[v].first.data[i]
+            + frames[v].second.data[i] * dequantize_snorm16(q));
+        }
+    }
+    else decoded.positions = payload.positions;
+    // vertex attributes
+    uint32_t const stride = mesh.vertex_stride();
+    if (stride != float_vertex_stride) {
+      size_t const vertex_count = payload.vertices.size() / (stride * sizeof(uint32_t));
+      decoded.vertices.reserve(vertex_count * float_vertex_stride * sizeof(float));
+      for (size_t v = 0; v < vertex_count; ++v) {
+        size_t offset = v * stride * sizeof(uint32_t);
+        for (int attribute = 0; attribute < 2; ++attribute) {
+          MeshEncodingEnum const bit = attribute == 0
+            ? MeshEncodingEnum::NORMAL_OCT16 : MeshEncodingEnum::TANGENT_OCT16;
+          vec3 direction;
+          if (encoding & bit) {
+            direction = decode_oct16(load<uint32_t>(payload.vertices, offset));
+            offset += sizeof(uint32_t);
+          }
+          else {
+            direction = load<vec3>(payload.vertices, offset);
+            offset += sizeof(float) * 3;
+          }
+          for (int i = 0; i < 3; ++i) append(decoded.vertices, direction.data[i]);
+        }
+        if (encoding & (MeshEncodingEnum::TEXCOORD_FLOAT16 | MeshEncodingEnum::TEXCOORD_UNORM16)) {
+          uint32_t const word = load<uint32_t>(payload.vertices, offset);
+          if (encoding & MeshEncodingEnum::TEXCOORD_UNORM16) {
+            append(decoded.vertices, float(word & 0xffff) / 65535.f);
+            append(decoded.vertices, float(word >> 16) / 65535.f);
+          }
+          else {
+            append(decoded.vertices, decode_float16(word & 0xffff));
+            append(decoded.vertices, decode_float16(word >> 16));
+          }
+        }
+        else {
+          append(decoded.vertices, load<float>(payload.vertices, offset));
+          append(decoded.vertices, load<float>(payload.vertices, offset + sizeof(float)));
+        }
+      }
+    }
+    else decoded.vertices = payload.vertices;
+    // indices
+    if (encoding & MeshEncodingEnum::INDEX_UINT16) {
+      size_t index_count = 0;
+      for (auto const& primitive : mesh.m_primitives) {
+        index_count = std::max(index_count, primitive.offset + primitive.size);
+        for (auto const& lod : primitive.lods)
+          index_count = std::max(index_count, lod.offset + lod.size);
+      }
+      decoded.indices.reserve(index_count * sizeof(uint32_t));
+      for (size_t i = 0; i < index_count; ++i)
+        append(decoded.indices, uint32_t(load<uint16_t>(payload.indices, i * sizeof(uint16_t))));
+    }
+    else decoded.indices = payload.indices;
+    return decoded;
+  }
+
+  auto mesh_buffer_usages() noexcept -> std::array<Flags<rhi::BufferUsageEnum>, 3> {
+    bool need_rt = bool(gfx::GFXContext::device()->from_which_adapter()->from_which_context()
+      ->get_context_extensions_flags() & rhi::ContextExtensionEnum::RAY_TRACING);
+    Flags<rhi::BufferUsageEnum> rt_usage = 0;
+    if (need_rt) rt_usage |= rhi::BufferUsageEnum::ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY;
+    return {
+      rhi::BufferUsageEnum::STORAGE | rhi::BufferUsageEnum::SHADER_DEVICE_ADDRESS | rt_usage,
+      rhi::BufferUsageEnum::STORAGE | rhi::BufferUsageEnum::SHADER_DEVICE_ADDRESS,
+      rhi::BufferUsageEnum::INDEX | rhi::BufferUsageEnum::SHADER_DEVICE_ADDRESS | rt_usage };
+  }
+
+  // create the device buffers of an encoded payload
+  static auto create_mesh_buffers(Mesh& mesh, MeshPayload& payload, bool keepHost) noexcept -> void {
+    auto const usages = mesh_buffer_usages();
+    auto create = [&](std::vector<std::byte>& data, Flags<rhi::BufferUsageEnum> usages,
+      char const* job) -> BufferHandle {
+      MiniBuffer buffer;
+      buffer.m_isReference = true;
+      buffer.m_data = data.data();
+      buffer.m_size = data.size();
+      BufferHandle handle = gfx::GFXContext::create_buffer_host(buffer, usages, keepHost);
+      handle->m_job = job;
+      return handle;
+    };
+    mesh.m_positionBuffer = create(payload.positions, usages[0], "Mesh position buffer");
+    mesh.m_indexBuffer = create(payload.indices, usages[2], "Mesh index buffer");
+    mesh.m_vertexBuffer = create(payload.vertices, usages[1], "Mesh vertex buffer");
+  }
+
+  auto upload_mesh_payload(Mesh& mesh,
+    std::vector<float> const& positions,
+    std::vector<float> const& vertices,
+    std::vector<uint32_t> const& indices,
+    bool keepHost) noexcept -> void {
+    PROFILE_SCOPE_NAME(UploadGPUBuffer);
+    MeshPayload payload = encode_mesh_payload(mesh, positions, vertices,
+      indices, defaultMeshLoadConfig.layout.encoding);
+    create_mesh_buffers(mesh, payload, keepHost);
+    PROFILE_SCOPE_STOP(UploadGPUBuffer);
+  }
+
+  // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+  // ┃ Mesh Proxy                                                                ┃
+  // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+
+  // the 12 outward facing triangles over the corners of a box, the bits
+  // of a corner select the max bound along x, y and z
+  static constexpr uint8_t box_triangles[36] = {
+    0, 2, 3, 0, 3, 1,  4, 5, 7, 4, 7, 6,
+    0, 4, 6, 0, 6, 2,  1, 3, 7, 1, 7, 5,
+    0, 1, 5, 0, 5, 4,  2, 6, 7, 2, 7, 3 };
+
+  auto build_mesh_proxy(Mesh& mesh) noexcept -> MeshHandle {
+    bool const snorm = bool(mesh.m_encoding & MeshEncodingEnum::POSITION_SNORM16);
+    bool const short_index = bool(mesh.m_encoding & MeshEncodingEnum::INDEX_UINT16);
+    size_t const position_stride = snorm ? sizeof(int16_t) * 4 : sizeof(float) * 3;
+    std::vector<std::byte> const& positions = mesh.m_positionBuffer->m_host;
+    std::vector<std::byte> const& vertices = mesh.m_vertexBuffer->m_host;
+    size_t const vertex_count = positions.size() / position_stride;
+    size_t const vertex_stride = vertex_count > 0 ? vertices.size() / vertex_count : 0;
+
+    MeshHandle proxy = GFXContext::create_mesh_empty();
+    proxy->m_name = mesh.m_name + " (proxy)";
+    proxy->m_encoding = mesh.m_encoding;
+    MeshPayload payload;
+    size_t index_count = 0;
+    auto push_index = [&](uint32_t index) {
+      if (short_index) append(payload.indices, uint16_t(index));
+      else append(payload.indices, index);
+      index_count++;
+    };
+    auto push_vertex = [&](size_t vertex) {
+      payload.positions.insert(payload.positions.end(), positions.begin() + vertex * position_stride,
+        positions.begin() + (vertex + 1) * position_stride);
+      payload.vertices.insert(payload.vertices.end(), vertices.begin() + vertex * vertex_stride,
+        vertices.begin() + (vertex + 1) * vertex_stride);
+    };
+
+    for (auto const& primitive : mesh.m_primitives) {
+      Mesh::MeshPrimitive& stand_in = proxy->m_primitives.emplace_back();
+      stand_in.material = primitive.material;
+      stand_in.exterior = primitive.exterior;
+      stand_in.interior = primitive.interior;
+      // the bounds are kept, so quantized positions copy over unchanged
+      stand_in.min = primitive.min;
+      stand_in.max = primitive.max;
+      stand_in.offset = index_count;
+      stand_in.baseVertex = payload.positions.size() / position_stride;
+      if (!primitive.lods.empty()) {
+        // the coarsest level with its vertices renumbered in order of use
+        Mesh::LOD const& coarse = primitive.lods.back();
+        std::unordered_map<uint32_t, uint32_t> remap;
+        for (size_t i = 0; i < coarse.size; ++i) {
+          uint32_t const index = mesh.host_index(coarse.offset + i);
+          auto [iter, inserted] = remap.emplace(index, uint32_t(remap.size()));
+          if (inserted) push_vertex(primitive.baseVertex + index);
+          push_index(iter->second);
+        }
+        stand_in.numVertex = remap.size();
+        stand_in.size = coarse.size;
+      }
+      else {
+        // a primitive without lods stands in as its bounding box
+        auto const [center, extent] = Mesh::position_frame(primitive);
+        for (int corner = 0; corner < 8; ++corner) {
+          vec3 const p = {
+            (corner & 1) ? primitive.max.x : primitive.min.x,
+            (corner & 2) ? primitive.max.y : primitive.min.y,
+            (corner & 4) ? primitive.max.z : primitive.min.z };
+          for (int i = 0; i < 3; ++i) {
+            if (snorm) append(payload.positions, quantize_snorm16((p.data[i] - center.data[i]) / extent.data[i]));
+            else append(payload.positions, p.data[i]);
+          }
+          if (snorm) append(payload.positions, int16_t(0));
+          payload.vertices.resize(payload.vertices.size() + vertex_stride);
+        }
+        for (uint8_t index : box_triangles) push_index(index);
+        stand_in.numVertex = 8;
+        stand_in.size = 36;
+      }
+    }
+    if (short_index && index_count % 2 == 1) append(payload.indices, uint16_t(0));
+    create_mesh_buffers(*proxy.get(), payload, false);
+    return proxy;
+  }
+}
+}
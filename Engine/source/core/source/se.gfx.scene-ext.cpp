@@ -1,2 +1,4 @@
 #define TINYGLTF_IMPLEMENTATION
+// external images are loaded by the scene loaders, in parallel
+#define TINYGLTF_NO_EXTERNAL_IMAGE
 #include <tinygltf/tiny_gltf.h>
\ No newline at end of file
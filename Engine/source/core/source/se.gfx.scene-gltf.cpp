@@ -4,6 +4,8 @@
 #include <imgui.h>
 #include "se.gfx.scene-loader.hpp"
 #include <span/span.hpp>
+#include <algorithm>
+#include <limits>
 
 namespace se {
   namespace gfx {
@@ -13,6 +15,7 @@ namespace se {
       std::unordered_map<int, Node> node2go;
       std::unordered_map<tinygltf::Texture const*, TextureHandle> textures;
       std::unordered_map<tinygltf::Material const*, MaterialHandle> materials;
+      std::unordered_map<int, MeshHandle> meshes;
     };
 
     auto loadGLTFMaterial(tinygltf::Material const* glmaterial, tinygltf::Model const* model,
@@ -134,383 +137,239 @@ namespace se {
       return mat;
     }
 
+    // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+    // ┃ Accessors                                                                 ┃
+    // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+
+    /** An accessor read in place from its buffer. Interleaved views are walked
+      * by their byte stride, only sparse accessors own a resolved copy. */
+    struct AccessorView {
+      unsigned char const* data = nullptr;
+      size_t count = 0;
+      size_t stride = 0;
+      int componentType = 0;
+      int components = 0;
+      bool normalized = false;
+      std::vector<unsigned char> dense;
+    };
+
+    static auto view_accessor(tinygltf::Model const* model, int index) noexcept -> AccessorView {
+      AccessorView view;
+      if (index < 0 || index >= int(model->accessors.size())) return view;
+      tinygltf::Accessor const& accessor = model->accessors[index];
+      int const component_size = tinygltf::GetComponentSizeInBytes(uint32_t(accessor.componentType));
+      int const components = tinygltf::GetNumComponentsInType(uint32_t(accessor.type));
+      if (component_size <= 0 || components <= 0) {
+        se::error("gfx :: gltf :: accessor {} has an unknown element type", index);
+        return view;
+      }
+      size_t const element = size_t(component_size) * components;
+      view.count = accessor.count;
+      view.componentType = accessor.componentType;
+      view.components = components;
+      view.normalized = accessor.normalized;
+      view.stride = element;
+      // size is the bytes of one element of the range, sparse indices are
+      // index sized while everything else holds accessor elements
+      auto bytes_of = [&](int buffer_view, size_t offset, size_t count, size_t stride, size_t size)
+        -> unsigned char const* {
+        if (buffer_view < 0 || buffer_view >= int(model->bufferViews.size())) return nullptr;
+        tinygltf::BufferView const& bv = model->bufferViews[buffer_view];
+        if (bv.buffer < 0 || bv.buffer >= int(model->buffers.size())) return nullptr;
+        tinygltf::Buffer const& buffer = model->buffers[bv.buffer];
+        size_t const begin = bv.byteOffset + offset;
+        if (count > 0 && begin + (count - 1) * stride + size > buffer.data.size()) return nullptr;
+        return buffer.data.data() + begin;
+      };
+      if (accessor.bufferView >= 0) {
+        tinygltf::BufferView const& bv = model->bufferViews[accessor.bufferView];
+        view.stride = bv.byteStride != 0 ? bv.byteStride : element;
+        view.data = bytes_of(accessor.bufferView, accessor.byteOffset, view.count, view.stride, element);
+        if (view.data == nullptr) {
+          se::error("gfx :: gltf :: accessor {} reads past the end of its buffer", index);
+          view.count = 0; return view;
+        }
+      }
+      if (!accessor.sparse.isSparse && accessor.bufferView >= 0) return view;
+
+      // sparse accessors patch a copy of the base values (zeros without a
+      // view), the substituted elements are scattered over the whole range
+      view.dense.assign(view.count * element, 0);
+      if (view.data != nullptr)
+        for (size_t i = 0; i < view.count; ++i)
+          memcpy(view.dense.data() + i * element, view.data + i * view.stride, element);
+      if (accessor.sparse.isSparse) {
+        auto const& sparse = accessor.sparse;
+        int const index_size = tinygltf::GetComponentSizeInBytes(uint32_t(sparse.indices.componentType));
+        unsigned char const* indices = index_size <= 0 ? nullptr : bytes_of(sparse.indices.bufferView,
+          sparse.indices.byteOffset, sparse.count, index_size, index_size);
+        unsigned char const* values = bytes_of(sparse.values.bufferView,
+          sparse.values.byteOffset, sparse.count, element, element);
+        if (indices == nullptr || values == nullptr) {
+          se::error("gfx :: gltf :: sparse accessor {} has invalid indices or values", index);
+        }
+        else for (int i = 0; i < sparse.count; ++i) {
+          uint32_t target = 0;
+          switch (sparse.indices.componentType) {
+          case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: target = indices[i]; break;
+          case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: { uint16_t v; memcpy(&v, indices + i * 2, 2); target = v; } break;
+          case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: memcpy(&target, indices + i * 4, 4); break;
+          default: break;
+          }
+          if (target < view.count)
+            memcpy(view.dense.data() + target * element, values + i * element, element);
+        }
+      }
+      view.data = view.dense.data();
+      view.stride = element;
+      return view;
+    }
+
     template <typename T>
-    struct ArrayAdapter {
-      /**
-       * Construct an array adapter.
-       * @param ptr Pointer to the start of the data, with offset applied
-       * @param count Number of elements in the array
-       * @param byte_stride Stride betweens elements in the array
-       */
-      ArrayAdapter(const unsigned char* ptr, size_t count, size_t byte_stride)
-        : dataPtr(ptr), elemCount(count), stride(byte_stride) {}
-
-      /// Returns a *copy* of a single element. Can't be used to modify it.
-      T operator[](size_t pos) const {
-        if (pos >= elemCount)
-          throw std::out_of_range(
-            "Tried to access beyond the last element of an array adapter with "
-            "count " +
-            std::to_string(elemCount) + " while getting elemnet number " +
-            std::to_string(pos));
-        return *(reinterpret_cast<const T*>(dataPtr + pos * stride));
+    static auto gather_as(AccessorView const& view, int n, float fill, float* dst, size_t dst_stride) noexcept -> void {
+      // normalized integers map to [0,1] or [-1,1], as the spec asks
+      float const scale = std::is_floating_point<T>::value ? 1.f : 1.f / float(std::numeric_limits<T>::max());
+      bool const normalize = view.normalized && !std::is_floating_point<T>::value;
+      int const m = std::min(n, view.components);
+      for (size_t i = 0; i < view.count; ++i) {
+        unsigned char const* src = view.data + i * view.stride;
+        float* out = dst + i * dst_stride;
+        for (int c = 0; c < m; ++c) {
+          T v; memcpy(&v, src + c * sizeof(T), sizeof(T));
+          out[c] = normalize ? std::max(float(v) * scale, -1.f) : float(v);
+        }
+        for (int c = m; c < n; ++c) out[c] = fill;
       }
-      /** Pointer to the bytes */
-      unsigned const char* dataPtr;
-      /** Number of elements in the array */
-      const size_t elemCount;
-      /** Stride in bytes between two elements */
-      const size_t stride;
-    };
+    }
+
+    /** write n floats of every element to dst, dst_stride floats apart */
+    static auto gather_floats(AccessorView const& view, int n, float* dst, size_t dst_stride, float fill = 0.f) noexcept -> bool {
+      switch (view.componentType) {
+      case TINYGLTF_COMPONENT_TYPE_FLOAT: gather_as<float>(view, n, fill, dst, dst_stride); return true;
+      case TINYGLTF_COMPONENT_TYPE_DOUBLE: gather_as<double>(view, n, fill, dst, dst_stride); return true;
+      case TINYGLTF_COMPONENT_TYPE_BYTE: gather_as<int8_t>(view, n, fill, dst, dst_stride); return true;
+      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: gather_as<uint8_t>(view, n, fill, dst, dst_stride); return true;
+      case TINYGLTF_COMPONENT_TYPE_SHORT: gather_as<int16_t>(view, n, fill, dst, dst_stride); return true;
+      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: gather_as<uint16_t>(view, n, fill, dst, dst_stride); return true;
+      default: return false;
+      }
+    }
+
+    auto read_gltf_floats(tinygltf::Model const& model, int accessor, int n, float fill) noexcept
+      -> std::vector<float> {
+      AccessorView const view = view_accessor(&model, accessor);
+      std::vector<float> floats(view.count * size_t(n));
+      if (view.count > 0 && !gather_floats(view, n, floats.data(), size_t(n), fill)) floats.clear();
+      return floats;
+    }
+
+    template <typename T>
+    static auto gather_indices_as(AccessorView const& view, uint32_t* dst) noexcept -> void {
+      for (size_t i = 0; i < view.count; ++i) {
+        T v; memcpy(&v, view.data + i * view.stride, sizeof(T));
+        dst[i] = uint32_t(v);
+      }
+    }
+
+    static auto gather_indices(AccessorView const& view, uint32_t* dst) noexcept -> bool {
+      switch (view.componentType) {
+      case TINYGLTF_COMPONENT_TYPE_BYTE: gather_indices_as<int8_t>(view, dst); return true;
+      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: gather_indices_as<uint8_t>(view, dst); return true;
+      case TINYGLTF_COMPONENT_TYPE_SHORT: gather_indices_as<int16_t>(view, dst); return true;
+      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: gather_indices_as<uint16_t>(view, dst); return true;
+      case TINYGLTF_COMPONENT_TYPE_INT: gather_indices_as<int32_t>(view, dst); return true;
+      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: gather_indices_as<uint32_t>(view, dst); return true;
+      default: return false;
+      }
+    }
 
     static inline auto loadGLTFMesh(tinygltf::Mesh const& gltfmesh,
       Node& gfxNode, Scene& scene, int node_id, tinygltf::Model const* model,
       glTFLoaderEnv& env) noexcept -> MeshHandle {
-      // Load meshes into Runtime resource managers.
-      rhi::Device* device = GFXContext::device();
       std::vector<uint32_t> indexBuffer_uint = {};
       std::vector<float> vertexBuffer = {};
       std::vector<float> PositionBuffer = {};
-      std::vector<uint64_t> JointIndexBuffer = {};
-      std::vector<float> JointweightsBuffer = {};
+      // the floats each layout entry takes in the vertex buffer
+      auto floats_of = [](MeshDataLayout::VertexInfo info) -> size_t {
+        switch (info) {
+        case MeshDataLayout::VertexInfo::NORMAL:
+        case MeshDataLayout::VertexInfo::TANGENT:
+        case MeshDataLayout::VertexInfo::COLOR: return 3;
+        case MeshDataLayout::VertexInfo::UV: return 2;
+        default: return 0;
+        }
+      };
+      size_t vertexStride = 0;
+      for (auto const& entry : defaultMeshLoadConfig.layout.layout)
+        vertexStride += floats_of(entry.info);
       // Create GFX mesh, and add it to resource manager
       size_t submesh_index_offset = 0;
       size_t submesh_vertex_offset = 0;
       MeshHandle mesh = GFXContext::create_mesh_empty();
       // For each primitive
       for (auto const& meshPrimitive : gltfmesh.primitives) {
-        std::vector<uint32_t> indexArray_uint = {};
-        std::vector<float> vertexBuffer_positionOnly = {};
-        std::vector<float> vertexBuffer_normalOnly = {};
-        std::vector<float> vertexBuffer_uvOnly = {};
-        std::vector<float> vertexBuffer_tangentOnly = {};
-        std::vector<uint64_t> vertexBuffer_joints = {};
-        std::vector<float> vertexBuffer_weights = {};
-        auto const& indicesAccessor = model->accessors[meshPrimitive.indices];
-        auto const& bufferView = model->bufferViews[indicesAccessor.bufferView];
-        auto const& buffer = model->buffers[bufferView.buffer];
-        auto const dataAddress =
-          buffer.data.data() + bufferView.byteOffset + indicesAccessor.byteOffset;
-        auto const byteStride = indicesAccessor.ByteStride(bufferView);
-        uint64_t const count = indicesAccessor.count;
-        se::vec3 positionMax, positionMin;
-        // first, get all indices
-        switch (indicesAccessor.componentType) {
-        case TINYGLTF_COMPONENT_TYPE_BYTE: {
-          ArrayAdapter<char> originIndexArray(dataAddress, count, byteStride);
-          for (size_t i = 0; i < count; ++i)
-            indexArray_uint.emplace_back(uint32_t(originIndexArray[i]));
-        } break;
-        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: {
-          ArrayAdapter<unsigned char> originIndexArray(dataAddress, count,
-            byteStride);
-          for (size_t i = 0; i < count; ++i)
-            indexArray_uint.emplace_back(uint32_t(originIndexArray[i]));
-        } break;
-        case TINYGLTF_COMPONENT_TYPE_SHORT: {
-          ArrayAdapter<short> originIndexArray(dataAddress, count, byteStride);
-          for (size_t i = 0; i < count; ++i)
-            indexArray_uint.emplace_back(uint32_t(originIndexArray[i]));
-        } break;
-        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
-          ArrayAdapter<unsigned short> originIndexArray(dataAddress, count,
-            byteStride);
-          for (size_t i = 0; i < count; ++i)
-            indexArray_uint.emplace_back(uint32_t(originIndexArray[i]));
-        } break;
-        case TINYGLTF_COMPONENT_TYPE_INT: {
-          ArrayAdapter<int> originIndexArray(dataAddress, count, byteStride);
-          for (size_t i = 0; i < count; ++i)
-            indexArray_uint.emplace_back(uint32_t(originIndexArray[i]));
-        } break;
-        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: {
-          ArrayAdapter<unsigned int> originIndexArray(dataAddress, count,
-            byteStride);
-          for (size_t i = 0; i < count; ++i)
-            indexArray_uint.emplace_back(uint32_t(originIndexArray[i]));
-        } break;
-        default:
-          break;
-        }
         // We re-arrange the indices so that it describe a simple list of
-        // triangles
-        switch (meshPrimitive.mode) {
-          // case TINYGLTF_MODE_TRIANGLE_FAN: // TODO
-          // case TINYGLTF_MODE_TRIANGLE_STRIP: // TODO
-        case TINYGLTF_MODE_TRIANGLES:  // this is the simpliest case to handle
-        {
-          for (auto const& attribute : meshPrimitive.attributes) {
-            auto const attribAccessor = model->accessors[attribute.second];
-            auto const& bufferView =
-              model->bufferViews[attribAccessor.bufferView];
-            auto const& buffer = model->buffers[bufferView.buffer];
-            auto const dataPtr = buffer.data.data() + bufferView.byteOffset +
-              attribAccessor.byteOffset;
-            auto const byte_stride = attribAccessor.ByteStride(bufferView);
-            auto const count = attribAccessor.count;
-            if (attribute.first == "POSITION") {
-              switch (attribAccessor.type) {
-              case TINYGLTF_TYPE_VEC3: {
-                positionMax = { (float)attribAccessor.maxValues[0], (float)attribAccessor.maxValues[1], (float)attribAccessor.maxValues[2] };
-                positionMin = { (float)attribAccessor.minValues[0], (float)attribAccessor.minValues[1], (float)attribAccessor.minValues[2] };
-                switch (attribAccessor.componentType) {
-                case TINYGLTF_COMPONENT_TYPE_FLOAT:
-                  // 3D vector of float
-                  ArrayAdapter<se::vec3> positions(dataPtr, count,
-                    byte_stride);
-                  for (size_t i = 0; i < count; ++i) {
-                    se::vec3 p0 = positions[i];
-                    // Put them in the array in the correct order
-                    vertexBuffer_positionOnly.push_back(p0.x);
-                    vertexBuffer_positionOnly.push_back(p0.y);
-                    vertexBuffer_positionOnly.push_back(p0.z);
-                  }
-                }
-                break;
-              case TINYGLTF_COMPONENT_TYPE_DOUBLE: {
-                switch (attribAccessor.type) {
-                case TINYGLTF_TYPE_VEC3: {
-                  ArrayAdapter<se::dvec3> positions(dataPtr, count,
-                    byte_stride);
-                  for (size_t i = 0; i < count; ++i) {
-                    se::dvec3 p0 = positions[i];
-                    // Put them in the array in the correct order
-                    vertexBuffer_positionOnly.push_back(p0.x);
-                    vertexBuffer_positionOnly.push_back(p0.y);
-                    vertexBuffer_positionOnly.push_back(p0.z);
-                  }
-                } break;
-                default:
-                  // TODO Handle error
-                  break;
-                }
-                break;
-              default:
-                break;
-              }
-              } break;
-              }
-            }
-            if (attribute.first == "NORMAL") {
-              switch (attribAccessor.type) {
-              case TINYGLTF_TYPE_VEC3: {
-                switch (attribAccessor.componentType) {
-                case TINYGLTF_COMPONENT_TYPE_FLOAT: {
-                  ArrayAdapter<se::vec3> normals(dataPtr, count,
-                    byte_stride);
-                  for (size_t i = 0; i < count; ++i) {
-                    se::vec3 n0 = normals[i];
-                    // Put them in the array in the correct order
-                    vertexBuffer_normalOnly.push_back(n0.x);
-                    vertexBuffer_normalOnly.push_back(n0.y);
-                    vertexBuffer_normalOnly.push_back(n0.z);
-                  }
-                } break;
-                case TINYGLTF_COMPONENT_TYPE_DOUBLE: {
-                  ArrayAdapter<se::dvec3> normals(dataPtr, count,
-                    byte_stride);
-                  for (size_t i = 0; i < count; ++i) {
-                    se::dvec3 n0 = normals[i];
-                    // Put them in the array in the correct order
-                    vertexBuffer_normalOnly.push_back(n0.x);
-                    vertexBuffer_normalOnly.push_back(n0.y);
-                    vertexBuffer_normalOnly.push_back(n0.z);
-                  }
-                } break;
-                }
-              }
-              }
-            }
-            if (attribute.first == "TEXCOORD_0") {
-              switch (attribAccessor.type) {
-              case TINYGLTF_TYPE_VEC2: {
-                switch (attribAccessor.componentType) {
-                case TINYGLTF_COMPONENT_TYPE_FLOAT: {
-                  ArrayAdapter<se::vec2> uvs(dataPtr, count, byte_stride);
-                  for (size_t i = 0; i < count; ++i) {
-                    se::vec2 uv0 = uvs[i];
-                    // Put them in the array in the correct order
-                    vertexBuffer_uvOnly.push_back(uv0.x);
-                    vertexBuffer_uvOnly.push_back(uv0.y);
-                  }
-                } break;
-                case TINYGLTF_COMPONENT_TYPE_DOUBLE: {
-                  ArrayAdapter<se::dvec2> uvs(dataPtr, count,
-                    byte_stride);
-                  for (size_t i = 0; i < count; ++i) {
-                    se::dvec2 uv0 = uvs[i];
-                    // Put them in the array in the correct order
-                    vertexBuffer_uvOnly.push_back(uv0.x);
-                    vertexBuffer_uvOnly.push_back(uv0.y);
-                  }
-                } break;
-                default:
-                  se::error("GFX :: tinygltf :: unrecognized vector type for UV");
-                }
-              } break;
-              default:
-                se::error("GFX :: tinygltf :: unreconized componant type for UV");
-              }
-            }
-            if (attribute.first == "TANGENT") {
-              switch (attribAccessor.type) {
-              case TINYGLTF_TYPE_VEC3: {
-                switch (attribAccessor.componentType) {
-                case TINYGLTF_COMPONENT_TYPE_FLOAT: {
-                  ArrayAdapter<se::vec3> tangents(dataPtr, count,
-                    byte_stride);
-                  for (size_t i = 0; i < count; ++i) {
-                    se::vec3 t0 = tangents[i];
-                    // Put them in the array in the correct order
-                    vertexBuffer_tangentOnly.push_back(t0.x);
-                    vertexBuffer_tangentOnly.push_back(t0.y);
-                    vertexBuffer_tangentOnly.push_back(t0.z);
-                  }
-                } break;
-                case TINYGLTF_COMPONENT_TYPE_DOUBLE: {
-                  ArrayAdapter<se::dvec3> tangents(dataPtr, count,
-                    byte_stride);
-                  // IMPORTANT: We need to reorder normals (and texture
-                  // coordinates into "facevarying" order) for each face
-                  // For each triangle :
-                  for (size_t i = 0; i < count; ++i) {
-                    se::dvec3 t0 = tangents[i];
-                    // Put them in the array in the correct order
-                    vertexBuffer_tangentOnly.push_back(t0.x);
-                    vertexBuffer_tangentOnly.push_back(t0.y);
-                    vertexBuffer_tangentOnly.push_back(t0.z);
-                  }
-                } break;
-                }
-              }
-              }
-            }
-            if (attribute.first == "JOINTS_0") {
-              switch (attribAccessor.type) {
-              case TINYGLTF_TYPE_VEC4: {
-                switch (attribAccessor.componentType) {
-                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
-                  ArrayAdapter<se::Vector4<uint16_t>> joints(dataPtr, count, byte_stride);
-                  for (size_t i = 0; i < count; ++i) {
-                    se::Vector4<uint16_t> j0 = joints[i];
-                    // Put them in the array in the correct order
-                    vertexBuffer_joints.push_back(j0.x);
-                    vertexBuffer_joints.push_back(j0.y);
-                    vertexBuffer_joints.push_back(j0.z);
-                    vertexBuffer_joints.push_back(j0.w);
-                  }
-                } break;
-                }
-              }
-              }
-            }
-            if (attribute.first == "WEIGHTS_0") {
-              switch (attribAccessor.type) {
-              case TINYGLTF_TYPE_VEC4: {
-                switch (attribAccessor.componentType) {
-                case TINYGLTF_COMPONENT_TYPE_FLOAT: {
-                  ArrayAdapter<se::vec4> weights(dataPtr, count, byte_stride);
-                  // For each triangle :
-                  for (size_t i = 0; i < count; ++i) {
-                    se::vec4 w0 = weights[i];
-                    // Put them in the array in the correct order
-                    vertexBuffer_weights.push_back(w0.x);
-                    vertexBuffer_weights.push_back(w0.y);
-                    vertexBuffer_weights.push_back(w0.z);
-                    vertexBuffer_weights.push_back(w0.w);
-                  }
-                } break;
-                case TINYGLTF_COMPONENT_TYPE_DOUBLE: {
-                  ArrayAdapter<se::dvec4> weights(dataPtr, count, byte_stride);
-                  // IMPORTANT: We need to reorder normals (and texture
-                  // coordinates into "facevarying" order) for each face
-                  // For each triangle :
-                  for (size_t i = 0; i < count; ++i) {
-                    se::dvec4 w0 = weights[i];
-                    // Put them in the array in the correct order
-                    vertexBuffer_weights.push_back(w0.x);
-                    vertexBuffer_weights.push_back(w0.y);
-                    vertexBuffer_weights.push_back(w0.z);
-                    vertexBuffer_weights.push_back(w0.w);
-                  }
-                } break;
-                }
-              }
-              }
-            }
-          }
-          break;
-        }
-        default:
+        // triangles, other modes are not handled yet
+        if (meshPrimitive.mode != TINYGLTF_MODE_TRIANGLES) {
           se::error("GFX :: tinygltf :: primitive mode not implemented");
-          break;
+          continue;
         }
-        // Compute the tangent vector if no provided
-        if (vertexBuffer_tangentOnly.size() == 0) {
-        }
-        // Assemble vertex buffer
-        PositionBuffer.insert(PositionBuffer.end(), vertexBuffer_positionOnly.begin(), vertexBuffer_positionOnly.end());
-        indexBuffer_uint.insert(indexBuffer_uint.end(), indexArray_uint.begin(), indexArray_uint.end());
-        size_t submehsVertexNumber = vertexBuffer_positionOnly.size() / 3;
-        for (size_t i = 0; i < submehsVertexNumber; ++i) {
-          for (auto const& entry : defaultMeshLoadConfig.layout.layout) {
-            if (entry.info == MeshDataLayout::VertexInfo::POSITION) {}
-            else if (entry.info == MeshDataLayout::VertexInfo::NORMAL) {
-              if (vertexBuffer_normalOnly.size() == 0) { // if normal is not provided
-                vertexBuffer.push_back(0.f);
-                vertexBuffer.push_back(0.f);
-                vertexBuffer.push_back(0.f);
-              }
-              else {
-                vertexBuffer.push_back(vertexBuffer_normalOnly[i * 3 + 0]);
-                vertexBuffer.push_back(vertexBuffer_normalOnly[i * 3 + 1]);
-                vertexBuffer.push_back(vertexBuffer_normalOnly[i * 3 + 2]);
-              }
-            }
-            else if (entry.info == MeshDataLayout::VertexInfo::UV) {
-              if (vertexBuffer_uvOnly.size() == 0) { // if uv is not provided
-                vertexBuffer.push_back(0.f);
-                vertexBuffer.push_back(0.f);
-              }
-              else {
-                if (vertexBuffer_uvOnly[i * 2 + 0] > 1) vertexBuffer_uvOnly[i * 2 + 0] -= int(vertexBuffer_uvOnly[i * 2 + 0]);
-                if (vertexBuffer_uvOnly[i * 2 + 1] > 1) vertexBuffer_uvOnly[i * 2 + 1] -= int(vertexBuffer_uvOnly[i * 2 + 1]);
-                vertexBuffer.push_back(vertexBuffer_uvOnly[i * 2 + 0]);
-                vertexBuffer.push_back(vertexBuffer_uvOnly[i * 2 + 1]);
-              }
-            }
-            else if (entry.info == MeshDataLayout::VertexInfo::TANGENT) {
-              vertexBuffer.push_back(0.f);
-              vertexBuffer.push_back(0.f);
-              vertexBuffer.push_back(0.f);
-              //vertexBuffer.push_back(vertexBuffer_tangentOnly[i * 3 + 0]);
-              //vertexBuffer.push_back(vertexBuffer_tangentOnly[i * 3 + 1]);
-              //vertexBuffer.push_back(vertexBuffer_tangentOnly[i * 3 + 2]);
-            }
-            else if (entry.info == MeshDataLayout::VertexInfo::COLOR) {
-              // Optional: vertex colors
-              vertexBuffer.push_back(0);
-              vertexBuffer.push_back(0);
-              vertexBuffer.push_back(0);
+        auto attribute_of = [&](char const* name) -> AccessorView {
+          auto iter = meshPrimitive.attributes.find(name);
+          if (iter == meshPrimitive.attributes.end()) return {};
+          return view_accessor(model, iter->second);
+        };
+        AccessorView const positions = attribute_of("POSITION");
+        size_t const vertexCount = positions.count;
+
+        // first, get all indices, straight into the merged index buffer
+        AccessorView const indices = view_accessor(model, meshPrimitive.indices);
+        indexBuffer_uint.resize(submesh_index_offset + indices.count);
+        if (indices.count > 0 && !gather_indices(indices, indexBuffer_uint.data() + submesh_index_offset))
+          se::error("GFX :: tinygltf :: unrecognized component type for indices");
+
+        // then the attributes, each read in place into its slot of the vertex
+        PositionBuffer.resize((submesh_vertex_offset + vertexCount) * 3);
+        gather_floats(positions, 3, PositionBuffer.data() + submesh_vertex_offset * 3, 3);
+        vertexBuffer.resize((submesh_vertex_offset + vertexCount) * vertexStride, 0.f);
+        float* vertices = vertexBuffer.data() + submesh_vertex_offset * vertexStride;
+        size_t offset = 0;
+        for (auto const& entry : defaultMeshLoadConfig.layout.layout) {
+          if (entry.info == MeshDataLayout::VertexInfo::NORMAL) {
+            // if normal is not provided it stays zero
+            AccessorView const normals = attribute_of("NORMAL");
+            if (normals.count == vertexCount)
+              gather_floats(normals, 3, vertices + offset, vertexStride);
+          }
+          else if (entry.info == MeshDataLayout::VertexInfo::UV) {
+            AccessorView const uvs = attribute_of("TEXCOORD_0");
+            if (uvs.count == vertexCount) {
+              if (!gather_floats(uvs, 2, vertices + offset, vertexStride))
+                se::error("GFX :: tinygltf :: unreconized componant type for UV");
+              for (size_t i = 0; i < vertexCount; ++i)
+                for (int c = 0; c < 2; ++c) {
+                  float& uv = vertices[i * vertexStride + offset + c];
+                  if (uv > 1) uv -= int(uv);
+                }
             }
-            else if (entry.info == MeshDataLayout::VertexInfo::CUSTOM) {}
           }
-        }
-
-        // Assemble skin buffer
-        if (vertexBuffer_joints.size() != 0) {
-          JointIndexBuffer.insert(JointIndexBuffer.end(), vertexBuffer_joints.begin(), vertexBuffer_joints.end());
-          JointweightsBuffer.insert(JointweightsBuffer.end(), vertexBuffer_weights.begin(), vertexBuffer_weights.end());
+          // tangents and colors are not loaded, they are left zero
+          offset += floats_of(entry.info);
         }
 
         // load Material
         Mesh::MeshPrimitive sePrimitive;
         sePrimitive.offset = submesh_index_offset;
-        sePrimitive.size = indexArray_uint.size();
+        sePrimitive.size = indices.count;
         sePrimitive.baseVertex = submesh_vertex_offset;
-        sePrimitive.numVertex = PositionBuffer.size() / 3 - submesh_vertex_offset;
-        sePrimitive.max = positionMax;
-        sePrimitive.min = positionMin;
+        sePrimitive.numVertex = vertexCount;
+        if (meshPrimitive.attributes.count("POSITION")) {
+          auto const& attribAccessor = model->accessors[meshPrimitive.attributes.at("POSITION")];
+          if (attribAccessor.maxValues.size() >= 3 && attribAccessor.minValues.size() >= 3) {
+            sePrimitive.max = { (float)attribAccessor.maxValues[0], (float)attribAccessor.maxValues[1], (float)attribAccessor.maxValues[2] };
+            sePrimitive.min = { (float)attribAccessor.minValues[0], (float)attribAccessor.minValues[1], (float)attribAccessor.minValues[2] };
+          }
+        }
         if (meshPrimitive.material != -1) {
           auto const& gltf_material = model->materials[meshPrimitive.material];
           sePrimitive.material = loadGLTFMaterial(&gltf_material, model, env, scene, defaultMeshLoadConfig);
@@ -526,57 +385,96 @@ namespace se {
         }
 
         mesh->m_primitives.emplace_back(std::move(sePrimitive));
-        // todo:: add material
         submesh_index_offset = indexBuffer_uint.size();
         submesh_vertex_offset = PositionBuffer.size() / 3;
       }
       // create mesh resource
-      { // register mesh
-        MiniBuffer buffer;
-        buffer.m_isReference = true;
-
-        buffer.m_data = PositionBuffer.data();
-        buffer.m_size = sizeof(float) * PositionBuffer.size();
-
-        bool need_rt = bool(gfx::GFXContext::device()->from_which_adapter()->from_which_context()
-          ->get_context_extensions_flags() & rhi::ContextExtensionEnum::RAY_TRACING);
-        Flags<rhi::BufferUsageEnum> rt_usage = 0;
-        if (need_rt) rt_usage |= rhi::BufferUsageEnum::ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY;
-
-        mesh->m_positionBuffer = gfx::GFXContext::create_buffer_host(buffer,
-          rhi::BufferUsageEnum::STORAGE |
-          rhi::BufferUsageEnum::SHADER_DEVICE_ADDRESS | rt_usage);
-        mesh->m_positionBuffer->m_job = "Mesh position buffer";
-        mesh->m_positionBuffer->m_host.resize(buffer.m_size);
-        memcpy(mesh->m_positionBuffer->m_host.data(), buffer.m_data, buffer.m_size);
-
-        buffer.m_data = indexBuffer_uint.data();
-        buffer.m_size = sizeof(uint32_t) * indexBuffer_uint.size();
-        mesh->m_indexBuffer = gfx::GFXContext::create_buffer_host(buffer,
-          rhi::BufferUsageEnum::INDEX |
-          rhi::BufferUsageEnum::SHADER_DEVICE_ADDRESS | rt_usage);
-        mesh->m_indexBuffer->m_job = "Mesh index buffer";
-        mesh->m_indexBuffer->m_host.resize(buffer.m_size);
-        memcpy(mesh->m_indexBuffer->m_host.data(), buffer.m_data, buffer.m_size);
-
-        buffer.m_data = vertexBuffer.data();
-        buffer.m_size = sizeof(uint32_t) * vertexBuffer.size();
-        mesh->m_vertexBuffer = gfx::GFXContext::create_buffer_host(buffer,
-          rhi::BufferUsageEnum::STORAGE |
-          rhi::BufferUsageEnum::SHADER_DEVICE_ADDRESS);
-        mesh->m_vertexBuffer->m_job = "Mesh vertex buffer";
-        mesh->m_vertexBuffer->m_host.resize(buffer.m_size);
-        memcpy(mesh->m_vertexBuffer->m_host.data(), buffer.m_data, buffer.m_size);
-      }
+      optimize_mesh(*mesh.get(), PositionBuffer, vertexBuffer, indexBuffer_uint);
+      mesh->m_contentHash = hash_mesh_payload(*mesh.get(), PositionBuffer, vertexBuffer, indexBuffer_uint);
+      upload_mesh_payload(*mesh.get(), PositionBuffer, vertexBuffer, indexBuffer_uint,
+        defaultMeshLoadConfig.residentOnHost);
       return mesh;
     }
 
+    /** read the per-instance transforms of EXT_mesh_gpu_instancing */
+    static inline auto loadGLTFInstances(tinygltf::Value const& extension,
+      tinygltf::Model const* model) noexcept -> std::vector<se::mat4> {
+      tinygltf::Value const& attributes = extension.Get("attributes");
+      auto view_of = [&](char const* name) -> AccessorView {
+        if (!attributes.Has(name)) return {};
+        return view_accessor(model, attributes.Get(name).GetNumberAsInt());
+      };
+      AccessorView const translation = view_of("TRANSLATION");
+      AccessorView const rotation = view_of("ROTATION");
+      AccessorView const scale = view_of("SCALE");
+      size_t const count = std::max({ translation.count, rotation.count, scale.count });
+
+      std::vector<se::vec3> translations(count, se::vec3{ 0.f, 0.f, 0.f });
+      std::vector<se::vec4> rotations(count, se::vec4{ 0.f, 0.f, 0.f, 1.f });
+      std::vector<se::vec3> scales(count, se::vec3{ 1.f, 1.f, 1.f });
+      gather_floats(translation, 3, reinterpret_cast<float*>(translations.data()), 3);
+      gather_floats(rotation, 4, reinterpret_cast<float*>(rotations.data()), 4);
+      gather_floats(scale, 3, reinterpret_cast<float*>(scales.data()), 3);
+
+      std::vector<se::mat4> instances(count);
+      for (size_t i = 0; i < count; ++i) {
+        se::vec4 const q = rotations[i];
+        instances[i] = se::mat4::translate(translations[i])
+          * (se::Quaternion{ q.x, q.y, q.z, q.w }.toMat4() * se::mat4::scale(scales[i]));
+      }
+      return instances;
+    }
+
+    // A glb holds a single BIN chunk, the one buffer without a uri. Every
+    // buffer is packed into it and the views are rebased onto their ranges,
+    // 8-byte aligned so double accessors stay aligned as well.
+    static auto pack_glb_buffers(tinygltf::Model& model) noexcept -> void {
+      if (model.buffers.size() <= 1) return;
+      std::vector<size_t> bases(model.buffers.size());
+      tinygltf::Buffer packed;
+      packed.name = "Packed Buffer";
+      for (size_t i = 0; i < model.buffers.size(); ++i) {
+        bases[i] = (packed.data.size() + 7) & ~size_t(7);
+        packed.data.resize(bases[i]);
+        packed.data.insert(packed.data.end(),
+          model.buffers[i].data.begin(), model.buffers[i].data.end());
+      }
+      for (tinygltf::BufferView& view : model.bufferViews) {
+        view.byteOffset += bases[view.buffer];
+        view.buffer = 0;
+      }
+      model.buffers.clear();
+      model.buffers.emplace_back(std::move(packed));
+    }
+
+    auto keep_encoded_image(tinygltf::Image* image, const int, std::string*, std::string*,
+      int, int, const unsigned char* bytes, int size, void*) -> bool {
+      image->image.assign(bytes, bytes + size);
+      image->as_is = true;
+      return true;
+    }
+
     auto Scene::load_gltf(std::string const& path) noexcept -> void {
       tinygltf::TinyGLTF loader;
       tinygltf::Model model;
       std::string err;
       std::string warn;
-      bool ret = loader.LoadASCIIFromFile(&model, &err, &warn, path);
+      bool ret = false;
+      loader.SetImageLoader(keep_encoded_image, nullptr);
+      m_sourceFiles.push_back(path);
+      if (Filesys::get_extension(path) == ".glb") {
+        // parse straight from the mapped file, the BIN chunk is copied once
+        // into the model buffer rather than read into a stream first
+        MappedFile file;
+        if (!file.open(path)) return;
+        if (file.size() > std::numeric_limits<unsigned int>::max()) {
+          se::error("gfx :: gltf :: {} is too large for a glb", path); return;
+        }
+        ret = loader.LoadBinaryFromMemory(&model, &err, &warn,
+          reinterpret_cast<unsigned char const*>(file.data()),
+          static_cast<unsigned int>(file.size()), Filesys::get_parent_path(path));
+      }
+      else ret = loader.LoadASCIIFromFile(&model, &err, &warn, path);
       if (!warn.empty()) {
         se::error("Scene::deserialize warn::" + warn); return;
       } if (!err.empty()) {
@@ -584,14 +482,42 @@ namespace se {
       } if (!ret) {
         se::error("Failed to parse glTF"); return;
       }
+      // buffers in files of their own, images are known by their textures
+      for (tinygltf::Buffer const& buffer : model.buffers)
+        if (!buffer.uri.empty() && buffer.uri.rfind("data:", 0) != 0)
+          m_sourceFiles.push_back(Filesys::get_parent_path(path) + "/" + buffer.uri);
+      load_gltf_model(model, Filesys::get_parent_path(path));
+    }
 
+    auto Scene::load_gltf_model(tinygltf::Model& model, std::string const& directory) noexcept -> void {
       glTFLoaderEnv env;
-      env.directory = Filesys::get_parent_path(path);
+      env.directory = directory;
 
       gfx::DeserializeData deserialize;
       deserialize.model = &model;
       deserialize.nodes.resize(model.nodes.size());
 
+      // every referenced image is decoded together and uploaded in batches,
+      // files are read on the workers, embedded ones were kept encoded
+      std::vector<std::string> image_files;
+      std::vector<ext::span<std::byte const>> image_bytes;
+      enum struct ImageSource { NONE, FILE, ENCODED, DECODED };
+      std::vector<std::pair<ImageSource, size_t>> image_slots(model.images.size(), { ImageSource::NONE, 0 });
+      for (size_t i = 0; i < model.images.size(); ++i) {
+        tinygltf::Image const& image_gltf = model.images[i];
+        if (image_gltf.as_is && !image_gltf.image.empty()) {
+          image_slots[i] = { ImageSource::ENCODED, image_bytes.size() };
+          image_bytes.emplace_back(reinterpret_cast<std::byte const*>(image_gltf.image.data()), image_gltf.image.size());
+        }
+        else if (!image_gltf.uri.empty()) {
+          image_slots[i] = { ImageSource::FILE, image_files.size() };
+          image_files.push_back(env.directory + "/" + image_gltf.uri);
+        }
+        else if (!image_gltf.image.empty()) image_slots[i] = { ImageSource::DECODED, 0 };
+      }
+      std::vector<TextureHandle> const file_textures = GFXContext::load_texture_files(image_files);
+      std::vector<TextureHandle> const byte_textures = GFXContext::load_texture_encoded(image_bytes);
+
       for (int i = 0; i < model.textures.size(); ++i) {
         tinygltf::Texture const& texture_gltf = model.textures[i];
         if (texture_gltf.extras.Has("dparam")) {
@@ -606,19 +532,20 @@ namespace se {
           //TextureHandle texture = gfx::GFXContext::create_buf_texture_desc(desc, default_value, num_aux, replica_num);
           //env.textures[&texture_gltf] = texture;
         }
-        else {
+        else if (texture_gltf.source >= 0 && texture_gltf.source < int(model.images.size())) {
           auto const& image_gltf = model.images[texture_gltf.source];
-          if (image_gltf.image.size() > 0) {
-            TextureHandle texture = gfx::GFXContext::load_texture_binary(
+          auto const slot = image_slots[texture_gltf.source];
+          TextureHandle texture;
+          if (slot.first == ImageSource::FILE) texture = file_textures[slot.second];
+          else if (slot.first == ImageSource::ENCODED) texture = byte_textures[slot.second];
+          else if (slot.first == ImageSource::DECODED) {
+            // decoded by tinygltf, when its default image loader was used
+            texture = gfx::GFXContext::load_texture_binary(
               image_gltf.width, image_gltf.height, image_gltf.component, 1, (const char*)image_gltf.image.data());
             texture->m_resourcePath = image_gltf.uri;
-            env.textures[&texture_gltf] = texture;
-          }
-          else {
-            std::string file_path = env.directory + "/" + image_gltf.uri;
-            TextureHandle texture = gfx::GFXContext::load_texture_file(file_path);
-            env.textures[&texture_gltf] = texture;
           }
+          if (texture.get() == nullptr) continue;
+          env.textures[&texture_gltf] = texture;
         }
       }
 
@@ -808,6 +735,7 @@ namespace se {
         auto& children = m_registry.get<NodeProperty>(deserialize.nodes[i].m_entity).children;
         for (auto& child_id : model.nodes[i].children) {
           children.push_back(deserialize.nodes[child_id]);
+          m_registry.get<NodeProperty>(deserialize.nodes[child_id].m_entity).parent = deserialize.nodes[i].m_entity;
         }
       }
       // register the scene root
@@ -852,12 +780,22 @@ namespace se {
         }
         // process the mesh
         if (gltfNode.mesh != -1) {
-          tinygltf::Mesh& mesh_gltf = model.meshes[gltfNode.mesh];
-          MeshHandle mesh = loadGLTFMesh(mesh_gltf, seNode, *this, i, &model, env);
+          // nodes referencing the same glTF mesh share the mesh resource
+          MeshHandle mesh;
+          auto mesh_iter = env.meshes.find(gltfNode.mesh);
+          if (mesh_iter != env.meshes.end()) mesh = mesh_iter->second;
+          else {
+            tinygltf::Mesh& mesh_gltf = model.meshes[gltfNode.mesh];
+            mesh = loadGLTFMesh(mesh_gltf, seNode, *this, i, &model, env);
+            env.meshes[gltfNode.mesh] = mesh;
+          }
           auto& mesh_renderer = m_registry.emplace<MeshRenderer>(seNode.m_entity);
           mesh_renderer.m_mesh = mesh;
           mesh_renderer.m_dirtyToFile = false;
           mesh_renderer.m_dirtyToGPU = true;
+          auto instancing = gltfNode.extensions.find("EXT_mesh_gpu_instancing");
+          if (instancing != gltfNode.extensions.end())
+            mesh_renderer.m_instances = loadGLTFInstances(instancing->second, &model);
 
           std::vector<int> emissive_primitives;
           for (int i = 0; i < mesh->m_primitives.size(); ++i) {
@@ -895,6 +833,8 @@ namespace se {
       for (auto& iter : Singleton<ComponentManager>::instance()->m_components) {
         iter.second.deserialize(deserialize);
       }
+      if (defaultMeshLoadConfig.deduplication)
+        deduplicate_meshes(*this);
     }
 
     auto Scene::save(std::string const& path) noexcept -> void {
@@ -918,64 +858,73 @@ namespace se {
       m.extras = tinygltf::Value(model_extra);
       m.scenes.emplace_back(scene);
       tinygltf::TinyGLTF gltf;
-      gltf.WriteGltfSceneToFile(&m, path,
-        false,  // embedImages
-        true,   // embedBuffers
-        true,   // pretty print
-        false); // write binary
+      bool const binary = Filesys::get_extension(path) == ".glb";
+      if (binary) pack_glb_buffers(m);
+      if (!gltf.WriteGltfSceneToFile(&m, path,
+        false,    // embedImages
+        true,     // embedBuffers
+        !binary,  // pretty print
+        binary))  // write binary
+        se::error("gfx :: gltf :: failed to write {}", path);
     }
 
-    SceneLoader::result_type SceneLoader::operator()(SceneLoader::from_gltf_tag, std::string const& path) {
+    SceneLoader::result_type SceneLoader::operator()(SceneLoader::from_gltf_tag, std::string const& path, bool cache) {
       SceneLoader::result_type scene = std::make_shared<Scene>();
-      scene->load_gltf(path);
+      if (cache) scene->load_cached(path, &Scene::load_gltf);
+      else scene->load_gltf(path);
       return scene;
     }
 
-    SceneLoader::result_type SceneLoader::operator()(SceneLoader::from_xml_tag, std::string const& path) {
+    SceneLoader::result_type SceneLoader::operator()(SceneLoader::from_xml_tag, std::string const& path, bool cache) {
       SceneLoader::result_type scene = std::make_shared<Scene>();
-      scene->load_xml(path);
+      if (cache) scene->load_cached(path, &Scene::load_xml);
+      else scene->load_xml(path);
       return scene;
     }
 
-    SceneLoader::result_type SceneLoader::operator()(SceneLoader::from_pbrt_tag, std::string const& path) {
+    SceneLoader::result_type SceneLoader::operator()(SceneLoader::from_pbrt_tag, std::string const& path, bool cache) {
       SceneLoader::result_type scene = std::make_shared<Scene>();
-      scene->load_pbrt(path);
+      if (cache) scene->load_cached(path, &Scene::load_pbrt);
+      else scene->load_pbrt(path);
       return scene;
     }
 
-    auto GFXContext::load_scene_gltf(std::string const& _path) noexcept -> SceneHandle {
+    auto GFXContext::load_scene_gltf(std::string const& _path, bool cache) noexcept -> SceneHandle {
       std::string path = Filesys::resolve_path(_path, {
         Configuration::string_property("engine_path"),
         Configuration::string_property("project_path"), });
       std::string name = Filesys::get_stem(path);
       UID const ruid = se::Resources::query_string_uid(path);
-      auto ret = Singleton<GFXContext>::instance()->m_scenes.load(ruid, SceneLoader::from_gltf_tag{}, path);
+      std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.scenes);
+      auto ret = Singleton<GFXContext>::instance()->m_scenes.load(ruid, SceneLoader::from_gltf_tag{}, path, cache);
       ret.first->second->m_name = name;
       ret.first->second->m_filepath = path;
       return SceneHandle{ ret.first->second };
     }
     
-    auto GFXContext::load_scene_xml(std::string const& _path) noexcept -> SceneHandle {
+    auto GFXContext::load_scene_xml(std::string const& _path, bool cache) noexcept -> SceneHandle {
       PROFILE_SCOPE_FUNCTION();
       std::string path = Filesys::resolve_path(_path, {
         Configuration::string_property("engine_path"),
         Configuration::string_property("project_path"), });
       std::string name = Filesys::get_stem(path);
       UID const ruid = se::Resources::query_string_uid(path);
-      auto ret = Singleton<GFXContext>::instance()->m_scenes.load(ruid, SceneLoader::from_xml_tag{}, path);
+      std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.scenes);
+      auto ret = Singleton<GFXContext>::instance()->m_scenes.load(ruid, SceneLoader::from_xml_tag{}, path, cache);
       ret.first->second->m_name = name;
       ret.first->second->m_filepath = path;
       return SceneHandle{ ret.first->second };
     }
 
-    auto GFXContext::load_scene_pbrt(std::string const& _path) noexcept -> SceneHandle {
+    auto GFXContext::load_scene_pbrt(std::string const& _path, bool cache) noexcept -> SceneHandle {
       PROFILE_SCOPE_FUNCTION();
       std::string path = Filesys::resolve_path(_path, {
         Configuration::string_property("engine_path"),
         Configuration::string_property("project_path"), });
       std::string name = Filesys::get_stem(path);
       UID const ruid = se::Resources::query_string_uid(path);
-      auto ret = Singleton<GFXContext>::instance()->m_scenes.load(ruid, SceneLoader::from_pbrt_tag{}, path);
+      std::lock_guard<std::recursive_mutex> lock(Singleton<GFXContext>::instance()->m_locks.scenes);
+      auto ret = Singleton<GFXContext>::instance()->m_scenes.load(ruid, SceneLoader::from_pbrt_tag{}, path, cache);
       ret.first->second->m_name = name;
       ret.first->second->m_filepath = path;
       return SceneHandle{ ret.first->second };
@@ -984,13 +933,7 @@ namespace se {
     auto GFXContext::frame_end() noexcept -> void {
       se::gfx::GFXContext::get_flights()->frame_end();
       se::gfx::GFXContext::clean_cache();
-
-      auto& jobs = Singleton<GFXContext>::instance()->m_jobsFrameEnd;
-      while (jobs.size() > 0) {
-        auto job = jobs.front();
-        job();
-        jobs.pop_front();
-      }
+      run_frame_end_jobs();
     }
 
     auto SerializeData::add_buffer(
@@ -1005,6 +948,59 @@ namespace se {
       return buffer_idx;
     }
 
+    auto SerializeData::add_mesh_buffers(Mesh& mesh) noexcept -> std::array<int32_t, 3> {
+      char const* names[3] = { "Position Buffer", "Index Buffer", "Vertex Buffer" };
+      std::array<BufferHandle, 3> const buffers = {
+        mesh.m_positionBuffer, mesh.m_indexBuffer, mesh.m_vertexBuffer };
+      // gltf only takes the float layout, decode the encoded meshes
+      auto float_payload = [&]() -> MeshPayload {
+        mesh.fetch_host();
+        MeshPayload payload = { mesh.m_positionBuffer->get_host(),
+          mesh.m_vertexBuffer->get_host(), mesh.m_indexBuffer->get_host() };
+        mesh.release_host();
+        if (mesh.m_encoding) payload = decode_mesh_payload(mesh, payload);
+        return payload;
+      };
+      if (incremental == nullptr) {
+        MeshPayload const payload = float_payload();
+        return { add_buffer(payload.positions, names[0]),
+          add_buffer(payload.indices, names[1]), add_buffer(payload.vertices, names[2]) };
+      }
+
+      // a mesh whose buffers are untouched keeps the chunk of the last save
+      bool const changed = incremental->changed(mesh);
+      IncrementalSaveState::MeshRecord& record = incremental->meshes[&mesh];
+      if (changed) {
+        MeshPayload payload = float_payload();
+        record.chunk = "mesh/" + std::to_string(incremental->nextChunk++);
+        record.buffers = buffers;
+        for (int i = 0; i < 3; ++i) record.stamps[i] = buffers[i]->m_hostStamp;
+        record.sizes = { payload.positions.size(), payload.indices.size(), payload.vertices.size() };
+        std::vector<std::byte> bytes = std::move(payload.positions);
+        bytes.insert(bytes.end(), payload.indices.begin(), payload.indices.end());
+        bytes.insert(bytes.end(), payload.vertices.begin(), payload.vertices.end());
+        chunks.emplace_back(record.chunk, std::move(bytes));
+      }
+      record.seen = true;
+
+      // the buffers name their range of the chunk instead of holding data
+      std::array<int32_t, 3> indices;
+      uint64_t offset = 0;
+      for (int i = 0; i < 3; ++i) {
+        tinygltf::Buffer buffer;
+        buffer.name = names[i];
+        buffer.uri = record.chunk;
+        tinygltf::Value::Object range;
+        range["offset"] = tinygltf::Value(double(offset));
+        range["size"] = tinygltf::Value(double(record.sizes[i]));
+        buffer.extras = tinygltf::Value(range);
+        indices[i] = int32_t(model->buffers.size());
+        model->buffers.emplace_back(std::move(buffer));
+        offset += record.sizes[i];
+      }
+      return indices;
+    }
+
     auto SerializeData::add_view_accessor(
       tinygltf::BufferView bufferView,
       tinygltf::Accessor accessor
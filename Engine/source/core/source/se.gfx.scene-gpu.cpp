@@ -14,193 +14,394 @@ namespace gfx {
     }
   }
 
-  auto update_node_transform(Node& node, se::mat4 const& mat, bool in_dirty) noexcept->void {
+  auto update_node_transform(Node& node, se::mat4 const& mat, bool in_dirty,
+    Scene::ChangeList& changes) noexcept->void {
     auto* _property = node.get_component<NodeProperty>();
     auto* _transform = node.get_component<Transform>();
     _transform->global = mat * _transform->local();
     bool dirty = in_dirty || _transform->is_dirty_to_gpu();
-    if (dirty && _property->name != "Camera")
+    if (dirty && _property->name != "Camera") {
       _transform->m_dirtyToGPU = true;
+      changes.record(node.m_entity, Scene::ChangeList::UPDATED);
+    }
     for (auto& child : _property->children) {
-      update_node_transform(child, _transform->global, dirty);
+      update_node_transform(child, _transform->global, dirty, changes);
+    }
+  }
+
+  // entities holding all the components that appear in any of the lists, each once
+  template<class... Component>
+  static auto changed_entities(ex::registry& registry,
+    std::initializer_list<Scene::ChangeList const*> lists) noexcept -> std::vector<ex::entity> {
+    std::vector<ex::entity> entities;
+    for (auto list = lists.begin(); list != lists.end(); ++list) {
+      for (auto const& [entity, change] : (*list)->entries) {
+        if (!registry.all_of<Component...>(entity)) continue;
+        if (std::any_of(lists.begin(), list, [&](Scene::ChangeList const* prior) {
+          return prior->entries.contains(entity); })) continue;
+        entities.push_back(entity);
+      }
     }
+    return entities;
   }
 
   auto Scene::update_transform() noexcept -> void {
-    se::mat4 identity;
-    for (auto& node : m_roots) {
-      update_node_transform(node, identity, false);
+    // only the subtrees below changed transforms are recomputed,
+    // each from its topmost changed node and the global of its parent
+    auto& changes = m_changes.transforms;
+    auto parent_of = [&](ex::entity entity) {
+      auto const* property = m_registry.try_get<NodeProperty>(entity);
+      return property ? property->parent : ex::entity(ex::null);
+    };
+    for (ex::entity entity : changed_entities<Transform, NodeProperty>(m_registry, { &changes })) {
+      bool covered = false;
+      for (ex::entity parent = parent_of(entity); parent != ex::null && !covered; parent = parent_of(parent))
+        covered = changes.entries.contains(parent);
+      if (covered) continue;
+      se::mat4 global;
+      ex::entity const parent = parent_of(entity);
+      if (auto const* transform = parent != ex::null ? m_registry.try_get<Transform>(parent) : nullptr)
+        global = transform->global;
+      Node node = { entity, &m_registry };
+      update_node_transform(node, global, true, changes);
     }
   }
 
   auto Scene::update_gpu_scene() noexcept -> void {
     update_transform();
+    update_gpu_streaming();
     update_gpu_meshes();
     update_gpu_camera();
+    update_gpu_views();
     update_gpu_lights();
+    update_gpu_light_clusters();
     update_gpu_medium();
     update_gpu_bvh();
+    update_gpu_lods();
 
-    auto node_view = m_registry.view<Transform>();
-    for (auto [entity, _transform] : node_view.each()) {
-      _transform.m_dirtyToGPU = false;
-    }
+    // the changes are consumed, an idle frame visits no entity
+    for (auto& [entity, change] : m_changes.transforms.entries)
+      if (auto* transform = m_registry.try_get<Transform>(entity))
+        transform->m_dirtyToGPU = false;
+    m_changes.clear();
 
     m_gpuScene.geometryBuffer.m_buffer->host_to_device();
   }
 
-  auto Scene::update_gpu_meshes() noexcept -> void {
-    auto node_view = m_registry.view<Transform, MeshRenderer>();
-    for (auto [entity, transform, mesh] : node_view.each()) {
-      // If the mesh resource itself is dirty, we update the reference to the mesh
-      if (mesh.m_mesh->m_dirtyToGPU) {
-        uint64_t vertex_address = mesh.m_mesh->m_vertexBuffer->m_buffer->get_device_address();
-        uint64_t pos_address = mesh.m_mesh->m_positionBuffer->m_buffer->get_device_address();
-        uint64_t index_address = mesh.m_mesh->m_indexBuffer->m_buffer->get_device_address();
-
-        auto iter = m_gpuScene.meshList.find(mesh.m_mesh.get());
-        if (iter == m_gpuScene.meshList.end()) {
-          int32_t index = m_gpuScene.positionBuffer.insert(pos_address);
-          m_gpuScene.vertexBuffer.insert(vertex_address);
-          m_gpuScene.indexBuffer.insert(index_address);
-          m_gpuScene.meshList[mesh.m_mesh.get()] = IndexInfo{ index, 0 };
-        }
-        else {
-          se::error("todo :: a mesh is dirty after first register");
-        }
-        mesh.m_mesh->m_dirtyToGPU = false;
-      }
+  // geometry records keep material and medium indices in 16 bits, one
+  // that does not fit is dropped rather than wrapped onto another record
+  static auto narrow_index(int32_t index) noexcept -> int16_t {
+    if (index < -1 || index > INT16_MAX) {
+      se::error("gfx :: scene :: index {} exceeds the 16-bit geometry record, it is dropped", index);
+      return -1;
+    }
+    return int16_t(index);
+  }
 
-      // The mesh get a uniform ID in the mesh-list
-      int16_t meshID = (int16_t)m_gpuScene.meshList[mesh.m_mesh.get()].assignedIndex;
-
-      // After we have the mesh resource ready,
-      // we take care of the material resource
-      for (auto& primitive : mesh.m_mesh->m_customPrimitives) {
-        MaterialHandle mat = primitive.material;
-        auto iter = m_gpuScene.materialList.find(mat.get());
-        if (iter == m_gpuScene.materialList.end()) {
-          MaterialInterpreterManager::init(mat.get(), mat->m_packet.bxdfType);
-          int32_t index = m_gpuScene.materialBuffer.insert(mat->m_packet);
-          m_gpuScene.materialList[mat.get()] = IndexInfo{ index, 0 };
-          mat->m_dirtyToGPU = false;
+  // the flags a geometry record derives from its object to world transform
+  static auto transform_flags(se::mat4 const& global) noexcept -> Flags<GeometryFlagEnum> {
+    vec3 const c0 = { global.data[0][0], global.data[1][0], global.data[2][0] };
+    vec3 const c1 = { global.data[0][1], global.data[1][1], global.data[2][1] };
+    vec3 const c2 = { global.data[0][2], global.data[1][2], global.data[2][2] };
+    Flags<GeometryFlagEnum> flags = 0;
+    if (se::dot(c0, se::cross(c1, c2)) < 0.f)
+      flags |= GeometryFlagEnum::ODD_NEGATIVE_SCALING;
+    float const scale2 = se::dot(c0, c0);
+    float const tolerance = 1e-5f * scale2;
+    if (std::abs(se::dot(c1, c1) - scale2) <= tolerance
+      && std::abs(se::dot(c2, c2) - scale2) <= tolerance
+      && std::abs(se::dot(c0, c1)) <= tolerance
+      && std::abs(se::dot(c0, c2)) <= tolerance
+      && std::abs(se::dot(c1, c2)) <= tolerance)
+      flags |= GeometryFlagEnum::SIMILARITY_TRANSFORM;
+    return flags;
+  }
+
+  // the geometry arena is addressed through the single entry of a table
+  static auto write_arena_address(DynamicVectorBufferView<uint64_t>& table, uint64_t address) noexcept -> void {
+    if (table.m_size == 0) table.insert(address);
+    else if (table[0] != address) table.update(0, address);
+  }
+
+  static auto hash_packet(Material::MaterialPacket const& packet) noexcept -> uint64_t {
+    uint64_t hash = 14695981039346656037ull;
+    uint64_t words[sizeof(Material::MaterialPacket) / sizeof(uint64_t)];
+    memcpy(words, &packet, sizeof(words));
+    for (uint64_t word : words) hash = (hash ^ word) * 1099511628211ull;
+    return hash;
+  }
+
+  auto Scene::update_gpu_materials() noexcept -> void {
+    auto& packets = m_gpuScene.materialPackets;
+    auto& buffer = m_gpuScene.materialBuffer;
+    std::vector<std::pair<size_t, size_t>> written;
+    size_t registered = 0;
+    std::vector<Material*> moved;
+
+    auto same_packet = [&](int32_t record, Material::MaterialPacket const& packet) {
+      return memcmp(&buffer[record], &packet, sizeof(Material::MaterialPacket)) == 0; };
+    auto write = [&](int32_t record, Material::MaterialPacket const& packet) {
+      buffer.update(record, packet);
+      written.emplace_back(record * sizeof(Material::MaterialPacket), sizeof(Material::MaterialPacket));
+    };
+    auto unlink = [&](int32_t record) {
+      auto [begin, end] = packets.equal_range(hash_packet(buffer[record]));
+      for (auto iter = begin; iter != end; ++iter)
+        if (iter->second == record) { packets.erase(iter); break; }
+    };
+    // find a record with the same content or append a new one
+    auto intern = [&](Material::MaterialPacket const& packet) -> int32_t {
+      uint64_t const hash = hash_packet(packet);
+      auto [begin, end] = packets.equal_range(hash);
+      for (auto iter = begin; iter != end; ++iter) {
+        if (!same_packet(iter->second, packet)) continue;
+        m_gpuScene.materialUsers[iter->second]++;
+        return iter->second;
+      }
+      int32_t const record = buffer.insert(packet);
+      written.emplace_back(record * sizeof(Material::MaterialPacket), sizeof(Material::MaterialPacket));
+      if (size_t(record) >= m_gpuScene.materialUsers.size())
+        m_gpuScene.materialUsers.resize(record + 1, 0);
+      m_gpuScene.materialUsers[record] = 1;
+      packets.emplace(hash, record);
+      return record;
+    };
+    auto upload = [&](Material* mat, bool fetch_texture) {
+      auto iter = m_gpuScene.materialList.find(mat);
+      if (iter != m_gpuScene.materialList.end() && !mat->m_dirtyToGPU) return;
+      MaterialInterpreterManager::init(mat, mat->m_packet.bxdfType);
+      if (iter == m_gpuScene.materialList.end()) {
+        if (fetch_texture) {
+          mat->m_packet.baseTex = mat->m_basecolorTex.get()
+            ? m_gpuScene.imagePool.try_fetch_index(mat->m_basecolorTex) : -1;
         }
-        else if (mat->m_dirtyToGPU == true) {
-          MaterialInterpreterManager::init(mat.get(), mat->m_packet.bxdfType);
-          m_gpuScene.materialBuffer.update(iter->second.assignedIndex, mat->m_packet);
-          mat->m_dirtyToGPU = false;
+        m_gpuScene.materialList[mat] = IndexInfo{ intern(mat->m_packet), 0 };
+        registered++;
+      }
+      else {
+        int32_t const record = iter->second.assignedIndex;
+        if (!same_packet(record, mat->m_packet)) {
+          if (m_gpuScene.materialUsers[record] == 1) {
+            // the only user rewrites its record in place
+            unlink(record);
+            write(record, mat->m_packet);
+            packets.emplace(hash_packet(mat->m_packet), record);
+          }
+          else {
+            // a shared record is left to the other users
+            m_gpuScene.materialUsers[record]--;
+            iter->second.assignedIndex = intern(mat->m_packet);
+            moved.push_back(mat);
+          }
         }
       }
-      for (auto& primitive : mesh.m_mesh->m_primitives) {
-        MaterialHandle mat = primitive.material;
-        if (!mat.get()) continue;
-        auto iter = m_gpuScene.materialList.find(mat.get());
-        if (iter == m_gpuScene.materialList.end()) {
-          MaterialInterpreterManager::init(mat.get(), mat->m_packet.bxdfType);
-          if (mat->m_basecolorTex.get()) {
-            mat->m_packet.baseTex = m_gpuScene.imagePool.try_fetch_index(mat->m_basecolorTex);
+      mat->m_dirtyToGPU = false;
+    };
+
+    // new or changed renderers register their materials
+    for (ex::entity entity : changed_entities<MeshRenderer>(m_registry, { &m_changes.renderers })) {
+      MeshRenderer& mesh = m_registry.get<MeshRenderer>(entity);
+      for (auto& primitive : mesh.m_mesh->m_customPrimitives)
+        if (primitive.material.get()) upload(primitive.material.get(), false);
+      for (auto& primitive : mesh.m_mesh->m_primitives)
+        if (primitive.material.get()) upload(primitive.material.get(), true);
+    }
+    // materials are resources rather than components, edits are found
+    // among the registered materials instead of through the renderers
+    for (auto& [material, info] : m_gpuScene.materialList)
+      if (material->m_dirtyToGPU) upload(material, false);
+    // geometry records hold the record index, a moved material patches it
+    // in the records of its renderers and leaves the other fields alone
+    for (Material* material : moved) {
+      auto users = m_gpuScene.materialRenderers.find(material);
+      if (users == m_gpuScene.materialRenderers.end()) continue;
+      int16_t const materialID = narrow_index(m_gpuScene.materialList[material].assignedIndex);
+      for (auto user = users->second.begin(); user != users->second.end();) {
+        ex::entity const entity = *user;
+        MeshRenderer* renderer = m_registry.valid(entity) ? m_registry.try_get<MeshRenderer>(entity) : nullptr;
+        auto records = renderer ? m_gpuScene.geometryList.find(entity) : m_gpuScene.geometryList.end();
+        bool uses = false;
+        // the records follow the custom primitives if there are any, else the primitives
+        auto patch = [&](auto const& primitives) {
+          for (size_t i = 0; i < primitives.size() && i < records->second.size(); ++i) {
+            if (primitives[i].material.get() != material) continue;
+            uses = true;
+            IndexInfo const& info = records->second[i];
+            for (int32_t k = 0; k < info.length; ++k) {
+              GeometryDrawData geometry = m_gpuScene.geometryBuffer[info.assignedIndex + k];
+              geometry.materialID = materialID;
+              m_gpuScene.geometryBuffer.update(info.assignedIndex + k, geometry);
+            }
           }
-          else mat->m_packet.baseTex = -1;
+        };
+        if (records != m_gpuScene.geometryList.end()) {
+          Mesh* drawn = renderer->m_mesh->drawn();
+          if (drawn->m_customPrimitives.size() > 0) patch(drawn->m_customPrimitives);
+          else patch(drawn->m_primitives);
+        }
+        user = uses ? std::next(user) : users->second.erase(user);
+      }
+    }
+    if (registered > 0) {
+      size_t const materials = m_gpuScene.materialList.size();
+      size_t const records = packets.size();
+      se::info("gfx :: materials :: {} materials share {} packets, deduplication removed {}",
+        materials, records, materials - records);
+    }
+    buffer.m_buffer->host_to_device_ranges(written);
+  }
+
+  auto Scene::update_gpu_meshes() noexcept -> void {
+    update_gpu_materials();
+    // removed renderers release their geometry records
+    bool renderers_changed = false;
+    for (auto& [entity, change] : m_changes.renderers.entries) {
+      if (change & (ChangeList::UPDATED | ChangeList::DESTROYED)) renderers_changed = true;
+      if (!(change & ChangeList::DESTROYED)) continue;
+      auto iter = m_gpuScene.geometryList.find(entity);
+      if (iter == m_gpuScene.geometryList.end()) continue;
+      for (auto& info : iter->second)
+        for (int32_t i = 0; i < info.length; ++i)
+          m_gpuScene.geometryBuffer.remove(info.assignedIndex + i);
+      m_gpuScene.geometryList.erase(iter);
+    }
 
-          int32_t index = m_gpuScene.materialBuffer.insert(mat->m_packet);
-          m_gpuScene.materialList[mat.get()] = IndexInfo{ index, 0 };
-          mat->m_dirtyToGPU = false;
+    for (ex::entity entity : changed_entities<Transform, MeshRenderer>(
+      m_registry, { &m_changes.transforms, &m_changes.renderers })) {
+      Transform& transform = m_registry.get<Transform>(entity);
+      MeshRenderer& mesh = m_registry.get<MeshRenderer>(entity);
+      // a streamed mesh off the device draws its proxy
+      Mesh* drawn = mesh.m_mesh->drawn();
+      // If the mesh resource is new, we register a reference to the mesh
+      auto mesh_iter = m_gpuScene.meshList.find(drawn);
+      if (mesh_iter == m_gpuScene.meshList.end()) {
+        int32_t index = 0;
+        drawn->wait_buffers();
+        if (m_geometryArena) {
+          m_gpuScene.geometryArena.insert(drawn);
         }
-        else if (mat->m_dirtyToGPU == true) {
-          MaterialInterpreterManager::init(mat.get(), mat->m_packet.bxdfType);
-          m_gpuScene.materialBuffer.update(iter->second.assignedIndex, mat->m_packet);
-          mat->m_dirtyToGPU = false;
+        else {
+          uint64_t vertex_address = drawn->m_vertexBuffer->m_buffer->get_device_address();
+          uint64_t pos_address = drawn->m_positionBuffer->m_buffer->get_device_address();
+          uint64_t index_address = drawn->m_indexBuffer->m_buffer->get_device_address();
+          index = m_gpuScene.positionBuffer.insert(pos_address);
+          m_gpuScene.vertexBuffer.insert(vertex_address);
+          m_gpuScene.indexBuffer.insert(index_address);
         }
+        mesh_iter = m_gpuScene.meshList.emplace(drawn, IndexInfo{ index, 0 }).first;
       }
+      else if (drawn->m_dirtyToGPU) {
+        se::error("todo :: a mesh is dirty after first register");
+      }
+      drawn->m_dirtyToGPU = false;
+
+      // The mesh get a uniform ID in the mesh-list
+      int16_t meshID = (int16_t)mesh_iter->second.assignedIndex;
 
       // Then we update the geometry,
-      if (transform.is_dirty_to_gpu() || mesh.is_dirty_to_gpu()) {
-
-        auto iter = m_gpuScene.geometryList.find(entity);
-
-        std::vector<IndexInfo> info_set;
-
-
-        if (mesh.m_mesh->m_customPrimitives.size() > 0) {
-          size_t index_subprimitive = 0;
-          for (auto& primitive : mesh.m_mesh->m_customPrimitives) {
-            GeometryDrawData geometry;
-            geometry.vertexOffset = 0;
-            geometry.indexOffset = 0;
-            geometry.indexSize = 0;
-            geometry.geometryTransform = transform.global;
-            geometry.geometryTransformInverse = se::inverse(transform.global);
-            geometry.oddNegativeScaling = transform.oddScaling;
-            geometry.materialID = primitive.material.get()
-              ? m_gpuScene.materialList[primitive.material.get()].assignedIndex : -1;            geometry.primitiveType = primitive.primitiveType;
-            geometry.lightID = -1;
-            geometry.mediumIDInterior = -1;
-            geometry.mediumIDExterior = -1;
-            if (primitive.exterior.get())
-              geometry.mediumIDExterior = m_gpuScene.mediumPool.try_fetch_index(primitive.exterior);
-            if (primitive.interior.get())
-              geometry.mediumIDInterior = m_gpuScene.mediumPool.try_fetch_index(primitive.interior);
-
-            if (iter == m_gpuScene.geometryList.end()) {
-              IndexInfo info;
-              info.assignedIndex = m_gpuScene.geometryBuffer.insert(geometry);
-              info.heartBeat = 0;
-              info_set.emplace_back(info);
-            }
-            else {
-              m_gpuScene.geometryBuffer.update(
-                iter->second[index_subprimitive].assignedIndex,
-                geometry
-              );
-            }
-            index_subprimitive++;
-          }
-        }
-        else if (mesh.m_mesh->m_primitives.size() > 0) {
-          size_t index_subprimitive = 0;
-          for (auto& primitive : mesh.m_mesh->m_primitives) {
-            GeometryDrawData geometry;
-            geometry.vertexOffset = primitive.baseVertex;
-            geometry.indexOffset = primitive.offset;
-            geometry.indexSize = primitive.size;
-            geometry.geometryTransform = transform.global;
-            geometry.geometryTransformInverse = se::inverse(transform.global);
-            geometry.oddNegativeScaling = transform.oddScaling;
-            geometry.materialID = primitive.material.get()
-              ? m_gpuScene.materialList[primitive.material.get()].assignedIndex : -1;
-            geometry.primitiveType = 0;
-            geometry.meshID = meshID;
-            geometry.lightID = -1;
-            geometry.mediumIDInterior = -1;
-            geometry.mediumIDExterior = -1;
-            if (primitive.exterior.get())
-              geometry.mediumIDExterior = m_gpuScene.mediumPool.try_fetch_index(primitive.exterior);
-            if (primitive.interior.get())
-              geometry.mediumIDInterior = m_gpuScene.mediumPool.try_fetch_index(primitive.interior);
-
-            if (iter == m_gpuScene.geometryList.end()) {
-              IndexInfo info;
-              info.assignedIndex = m_gpuScene.geometryBuffer.insert(geometry);
-              info.heartBeat = 0;
-              info_set.emplace_back(info);
-            }
-            else {
-              m_gpuScene.geometryBuffer.update(
-                iter->second[index_subprimitive].assignedIndex,
-                geometry
-              );
-            }
-            index_subprimitive++;
-          }
-        }
+      // each primitive owns one record per instance, and the records of a
+      // primitive are kept consecutive, so instanced draws and TLAS instances
+      // could address them by base index + instance index.
+      auto iter = m_gpuScene.geometryList.find(entity);
+      uint32_t const instance_count = mesh.instance_count();
+
+      // if the number of instances changed, release the previous ranges
+      if (iter != m_gpuScene.geometryList.end() && iter->second.size() > 0
+        && iter->second[0].length != int32_t(instance_count)) {
+        for (auto& info : iter->second)
+          for (int32_t i = 0; i < info.length; ++i)
+            m_gpuScene.geometryBuffer.remove(info.assignedIndex + i);
+        m_gpuScene.geometryList.erase(iter);
+        iter = m_gpuScene.geometryList.end();
+      }
 
+      std::vector<IndexInfo> info_set;
+      MeshRenderer const& renderer = mesh;
+      se::mat4 const& node_global = transform.global;
+      auto write_instances = [&](GeometryDrawData const& geometry, size_t index_subprimitive) {
+        std::vector<GeometryDrawData> instances(instance_count, geometry);
+        for (uint32_t i = 0; i < instance_count; ++i) {
+          se::mat4 const global = renderer.instance_transform(node_global, i);
+          instances[i].geometryTransform = global;
+          instances[i].flags = transform_flags(global).mask();
+        }
         if (iter == m_gpuScene.geometryList.end()) {
-          m_gpuScene.geometryList[entity] = info_set;
+          IndexInfo info;
+          info.assignedIndex = m_gpuScene.geometryBuffer.insert_consecutive(instances);
+          info.heartBeat = 0;
+          info.length = int32_t(instance_count);
+          info_set.emplace_back(info);
+        }
+        else {
+          int32_t const base = iter->second[index_subprimitive].assignedIndex;
+          for (uint32_t i = 0; i < instance_count; ++i)
+            m_gpuScene.geometryBuffer.update(base + i, instances[i]);
+        }
+      };
+
+      if (drawn->m_customPrimitives.size() > 0) {
+        size_t index_subprimitive = 0;
+        for (auto& primitive : drawn->m_customPrimitives) {
+          GeometryDrawData geometry;
+          geometry.vertexOffset = 0;
+          geometry.indexOffset = 0;
+          geometry.indexSize = 0;
+          geometry.lodIndexOffset = 0;
+          geometry.lodIndexSize = 0;
+          geometry.materialID = primitive.material.get()
+            ? narrow_index(m_gpuScene.materialList[primitive.material.get()].assignedIndex) : -1;
+          if (primitive.material.get()) m_gpuScene.materialRenderers[primitive.material.get()].insert(entity);
+          geometry.primitiveType = primitive.primitiveType;
+          geometry.meshID = meshID;
+          geometry.lightID = -1;
+          geometry.mediumIDInterior = -1;
+          geometry.mediumIDExterior = -1;
+          if (primitive.exterior.get())
+            geometry.mediumIDExterior = narrow_index(m_gpuScene.mediumPool.try_fetch_index(primitive.exterior));
+          if (primitive.interior.get())
+            geometry.mediumIDInterior = narrow_index(m_gpuScene.mediumPool.try_fetch_index(primitive.interior));
+          write_instances(geometry, index_subprimitive++);
         }
+      }
+      else if (drawn->m_primitives.size() > 0) {
+        size_t index_subprimitive = 0;
+        for (auto& primitive : drawn->m_primitives) {
+          GeometryDrawData geometry;
+          geometry.vertexOffset = primitive.baseVertex;
+          geometry.indexOffset = primitive.offset;
+          geometry.indexSize = primitive.size;
+          geometry.lodIndexOffset = primitive.offset;
+          geometry.lodIndexSize = primitive.size;
+          geometry.materialID = primitive.material.get()
+            ? narrow_index(m_gpuScene.materialList[primitive.material.get()].assignedIndex) : -1;
+          if (primitive.material.get()) m_gpuScene.materialRenderers[primitive.material.get()].insert(entity);
+          geometry.primitiveType = 0;
+          geometry.meshID = meshID;
+          geometry.lightID = -1;
+          geometry.mediumIDInterior = -1;
+          geometry.mediumIDExterior = -1;
+          if (primitive.exterior.get())
+            geometry.mediumIDExterior = narrow_index(m_gpuScene.mediumPool.try_fetch_index(primitive.exterior));
+          if (primitive.interior.get())
+            geometry.mediumIDInterior = narrow_index(m_gpuScene.mediumPool.try_fetch_index(primitive.interior));
+          geometry.encoding = uint16_t(drawn->m_encoding.mask());
+          if (drawn->m_encoding & MeshEncodingEnum::POSITION_SNORM16)
+            std::tie(geometry.positionCenter, geometry.positionExtent) = Mesh::position_frame(primitive);
+          if (auto const* allocation = m_gpuScene.geometryArena.find(drawn)) {
+            geometry.positionBase = uint32_t(allocation->position / sizeof(uint32_t));
+            geometry.vertexBase = uint32_t(allocation->vertex / sizeof(uint32_t));
+            geometry.indexBase = uint32_t(allocation->index / sizeof(uint32_t));
+          }
+          write_instances(geometry, index_subprimitive++);
+        }
+      }
 
-        mesh.m_dirtyToGPU = false;
+      if (iter == m_gpuScene.geometryList.end()) {
+        m_gpuScene.geometryList[entity] = info_set;
       }
 
+      mesh.m_dirtyToGPU = false;
+
       //for (auto& sub : _property.m_mesh->m_primitives) {
 
       //}
@@ -213,46 +414,105 @@ namespace gfx {
       //data.model->nodes.emplace_back(node);
     }
 
+    if (m_geometryArena) {
+      // meshes no renderer references any more release their ranges,
+      // only renderers that changed or went away could have dropped one
+      if (renderers_changed) {
+        int32_t const heart_beat = ++m_gpuScene.meshHeartBeat;
+        for (auto [entity, mesh] : m_registry.view<MeshRenderer>().each()) {
+          auto iter = m_gpuScene.meshList.find(mesh.m_mesh->drawn());
+          if (iter != m_gpuScene.meshList.end()) iter->second.heartBeat = heart_beat;
+        }
+        for (auto iter = m_gpuScene.meshList.begin(); iter != m_gpuScene.meshList.end();) {
+          if (iter->second.heartBeat == heart_beat) { ++iter; continue; }
+          m_gpuScene.geometryArena.remove(iter->first);
+          iter = m_gpuScene.meshList.erase(iter);
+        }
+      }
+      m_gpuScene.geometryArena.flush();
+      write_arena_address(m_gpuScene.positionBuffer, m_gpuScene.geometryArena.positions.address());
+      write_arena_address(m_gpuScene.indexBuffer, m_gpuScene.geometryArena.indices.address());
+      write_arena_address(m_gpuScene.vertexBuffer, m_gpuScene.geometryArena.vertices.address());
+    }
+
     m_gpuScene.positionBuffer.m_buffer->host_to_device();
     m_gpuScene.indexBuffer.m_buffer->host_to_device();
     m_gpuScene.vertexBuffer.m_buffer->host_to_device();
-    m_gpuScene.materialBuffer.m_buffer->host_to_device();
   }
 
   auto Scene::update_gpu_camera() noexcept -> void {
-    auto node_view = m_registry.view<gfx::Transform, Camera>();
-    for (auto [entity, transform, camera] : node_view.each()) {
-      auto texture_displayed = Singleton<editor::EditorContext>::instance()->m_viewportTexture;
-      if (texture_displayed.has_value()) {
-        float aspect_ratio = float(texture_displayed.value()->m_texture->width())
-          / texture_displayed.value()->m_texture->height();
-        if (aspect_ratio != camera.aspectRatio) {
-          camera.aspectRatio = aspect_ratio;
-          transform.m_dirtyToGPU = true;
-        }
+    // the viewport aspect ratio is not a component change, so the few
+    // cameras are checked against it directly
+    auto texture_displayed = Singleton<editor::EditorContext>::instance()->m_viewportTexture;
+    if (texture_displayed.has_value()) {
+      float aspect_ratio = float(texture_displayed.value()->m_texture->width())
+        / texture_displayed.value()->m_texture->height();
+      for (auto [entity, camera] : m_registry.view<Camera>().each()) {
+        if (aspect_ratio == camera.aspectRatio) continue;
+        camera.aspectRatio = aspect_ratio;
+        m_changes.cameras.record(entity, ChangeList::UPDATED);
       }
+    }
 
-      if (transform.is_dirty_to_gpu() || camera.is_dirty_to_gpu()) {
-        CameraData camData = CameraData(camera, transform);
+    // removed cameras release their records
+    for (auto& [entity, change] : m_changes.cameras.entries) {
+      if (!(change & ChangeList::DESTROYED)) continue;
+      auto find = m_gpuScene.cameraList.find(entity);
+      if (find == m_gpuScene.cameraList.end()) continue;
+      m_gpuScene.cameraBuffer.remove(find->second.assignedIndex);
+      m_gpuScene.cameraList.erase(find);
+    }
 
-        if (camera.medium.get() != nullptr) {
-          camData.mediumID = m_gpuScene.mediumPool.try_fetch_index(camera.medium);
-        }
+    for (ex::entity entity : changed_entities<Transform, Camera>(
+      m_registry, { &m_changes.transforms, &m_changes.cameras })) {
+      Transform& transform = m_registry.get<Transform>(entity);
+      Camera& camera = m_registry.get<Camera>(entity);
+      CameraData camData = CameraData(camera, transform);
 
-        // move to gpu buffer
-        auto find = m_gpuScene.cameraList.find(entity);
-        if (find == m_gpuScene.cameraList.end()) {
-          int32_t index = m_gpuScene.cameraBuffer.insert(camData);
-          m_gpuScene.cameraList[entity] = { index, 0 };
-        }
-        else m_gpuScene.cameraBuffer.m_buffer->copy_to_host(find->second.assignedIndex, camData);
-        // camera is no longer dirty
-        camera.m_dirtyToGPU = false;
+      if (camera.medium.get() != nullptr) {
+        camData.mediumID = m_gpuScene.mediumPool.try_fetch_index(camera.medium);
+      }
+
+      // move to gpu buffer
+      auto find = m_gpuScene.cameraList.find(entity);
+      if (find == m_gpuScene.cameraList.end()) {
+        int32_t index = m_gpuScene.cameraBuffer.insert(camData);
+        m_gpuScene.cameraList[entity] = { index, 0 };
       }
+      else m_gpuScene.cameraBuffer.m_buffer->copy_to_host(find->second.assignedIndex, camData);
+      // camera is no longer dirty
+      camera.m_dirtyToGPU = false;
     }
     m_gpuScene.cameraBuffer.m_buffer->host_to_device();
   }
 
+  auto Scene::View::camera_data() const noexcept -> CameraData {
+    Camera lens;
+    lens.yfov = yfov;
+    lens.aspectRatio = aspectRatio;
+    lens.znear = znear;
+    lens.zfar = zfar;
+    return CameraData(lens, eye, target, up);
+  }
+
+  auto Scene::set_views(std::vector<View> const& views) noexcept -> void {
+    m_views = views;
+    m_viewsDirty = true;
+  }
+
+  auto Scene::update_gpu_views() noexcept -> void {
+    if (!m_viewsDirty) return;
+    // the views are rewritten together, in view order
+    std::vector<CameraData> data;
+    data.reserve(m_views.size());
+    for (View const& view : m_views) data.push_back(view.camera_data());
+    m_gpuScene.viewBuffer.m_size = 0;
+    m_gpuScene.viewBuffer.m_freeList = {};
+    if (!data.empty()) m_gpuScene.viewBuffer.insert_consecutive(data);
+    m_gpuScene.viewBuffer.m_buffer->host_to_device();
+    m_viewsDirty = false;
+  }
+
   auto Scene::update_gpu_medium() noexcept -> void {
     //for (auto& pair : m_gpuScene.mediumPool.medium_loc_index) {
     //  if (pair.second.second->isDirty) {
@@ -268,12 +528,11 @@ namespace gfx {
   }
 
   auto Scene::update_gpu_lights() noexcept -> void {
-    auto node_light_view = m_registry.view<gfx::Transform, Light>();
     bool lights_dirty = false;
 
-    for (auto [entity, transform, light] : node_light_view.each()) {
-
-      if ((!transform.is_dirty_to_gpu()) && (!light.is_dirty_to_gpu())) continue;
+    for (ex::entity entity : changed_entities<Transform, Light>(
+      m_registry, { &m_changes.transforms, &m_changes.lights })) {
+      Light& light = m_registry.get<Light>(entity);
 
       switch (light.light.light_type) {
       case LightTypeEnum::MESH_PRIMITIVE: {
@@ -281,8 +540,10 @@ namespace gfx {
         std::vector<IndexInfo>& indices = m_gpuScene.geometryList[entity];
         // custom mesh primitives
         if (mesh->m_customPrimitives.size() > 0) {
-          for (size_t i = 0; i < mesh->m_customPrimitives.size(); ++i) {
-            int32_t geometry_index = indices[i].assignedIndex;
+          // every instance of the primitive is a separate emitter
+          for (size_t i = 0; i < mesh->m_customPrimitives.size(); ++i)
+          for (int32_t k = 0; k < indices[i].length; ++k) {
+            int32_t geometry_index = indices[i].assignedIndex + k;
             GeometryDrawData& geometry = m_gpuScene.geometryBuffer[geometry_index];
 
             LightData packet;
@@ -340,10 +601,15 @@ namespace gfx {
         }
         // triangle mesh primitives
         else {
-          for (size_t i = 0; i < mesh->m_primitives.size(); ++i) {
-            int32_t geometry_index = indices[i].assignedIndex;
+          // emitters are built from the host copies, read back if released
+          mesh->fetch_host();
+          // every instance of the primitive is a separate emitter
+          for (size_t i = 0; i < mesh->m_primitives.size(); ++i)
+          for (int32_t k = 0; k < indices[i].length; ++k) {
+            int32_t geometry_index = indices[i].assignedIndex + k;
             GeometryDrawData& geometry = m_gpuScene.geometryBuffer[geometry_index];
             std::vector<LightData> packets(geometry.indexSize / 3);
+            se::mat4 const inverse = se::inverse(mat4(geometry.geometryTransform));
             const vec3 emissive = mesh->m_primitives[i].material->m_packet.vec4Data1.xyz();
             const vec3 yuv = {
               0.299f * emissive.r + 0.587f * emissive.g + 0.114f * emissive.b,
@@ -355,10 +621,13 @@ namespace gfx {
               packets[j].uintscalar_0 = j;
               packets[j].uintscalar_1 = geometry_index;
               // todo (twoSided ? 2 : 1)
-              uvec3 indices = mesh->m_indexBuffer->read_from_host<uvec3>(j);
-              vec3 v0 = mesh->m_positionBuffer->read_from_host<vec3>(indices[0] + int(geometry.vertexOffset));
-              vec3 v1 = mesh->m_positionBuffer->read_from_host<vec3>(indices[1] + int(geometry.vertexOffset));
-              vec3 v2 = mesh->m_positionBuffer->read_from_host<vec3>(indices[2] + int(geometry.vertexOffset));
+              auto const& primitive = mesh->m_primitives[i];
+              uvec3 indices = { mesh->host_index(geometry.indexOffset + j * 3 + 0),
+                mesh->host_index(geometry.indexOffset + j * 3 + 1),
+                mesh->host_index(geometry.indexOffset + j * 3 + 2) };
+              vec3 v0 = mesh->host_position(primitive, indices[0] + int(geometry.vertexOffset));
+              vec3 v1 = mesh->host_position(primitive, indices[1] + int(geometry.vertexOffset));
+              vec3 v2 = mesh->host_position(primitive, indices[2] + int(geometry.vertexOffset));
               v0 = mul(mat4(geometry.geometryTransform), { v0, 1 }).xyz();
               v1 = mul(mat4(geometry.geometryTransform), { v1, 1 }).xyz();
               v2 = mul(mat4(geometry.geometryTransform), { v2, 1 }).xyz();
@@ -370,15 +639,15 @@ namespace gfx {
 
               normal3 n = normalize(normal3(cross(v1 - v0, v2 - v0)));
               // Ensure correct orientation of geometric normal for normal bounds
-              vec3 n0 = mesh->m_vertexBuffer->read_from_host<vec3>(indices[0] + int(geometry.vertexOffset), sizeof(float) * 8, 0);
-              vec3 n1 = mesh->m_vertexBuffer->read_from_host<vec3>(indices[1] + int(geometry.vertexOffset), sizeof(float) * 8, 0);
-              vec3 n2 = mesh->m_vertexBuffer->read_from_host<vec3>(indices[2] + int(geometry.vertexOffset), sizeof(float) * 8, 0);
-              n0 = mul(mat4(geometry.geometryTransformInverse), { n0, 0 }).xyz();
-              n1 = mul(mat4(geometry.geometryTransformInverse), { n1, 0 }).xyz();
-              n2 = mul(mat4(geometry.geometryTransformInverse), { n2, 0 }).xyz();
+              vec3 n0 = mesh->host_normal(indices[0] + int(geometry.vertexOffset));
+              vec3 n1 = mesh->host_normal(indices[1] + int(geometry.vertexOffset));
+              vec3 n2 = mesh->host_normal(indices[2] + int(geometry.vertexOffset));
+              n0 = mul(inverse, { n0, 0 }).xyz();
+              n1 = mul(inverse, { n1, 0 }).xyz();
+              n2 = mul(inverse, { n2, 0 }).xyz();
               //normal3 ns = normalize(n0 + n1 + n2);
               //n = faceForward(n, ns);
-              n *= geometry.oddNegativeScaling;
+              n *= geometry.odd_negative_scaling();
 
               vec3 power = yuv * M_FLOAT_PI * area;
               packets[j].floatvec_0 = { power , n.x };
@@ -390,6 +659,7 @@ namespace gfx {
             geometry.lightID = light_index;
             m_gpuScene.lightList[entity].push_back({ light_index, 0, int32_t(packets.size()) });
           }
+          mesh->release_host();
         }
         break;
       }
@@ -417,10 +687,38 @@ namespace gfx {
 
     bool should_rebuilt_tlas = false;
 
-    auto node_view = m_registry.view<Transform, MeshRenderer>();
-    for (auto [entity, transform, mesh] : node_view.each()) {
-      if (mesh.m_mesh->m_customPrimitives.size() > 0) {
-        for (auto& primitive : mesh.m_mesh->m_customPrimitives) {
+    // The TLAS instance index is used as geometry ID in the shaders,
+    // so every instance is written to the slot of its geometry record.
+    // Free slots hold no BLAS, so none of them points to a released or
+    // evicted one, and create_tlas leaves them inactive.
+    rhi::BLASInstance free_slot;
+    free_slot.mask = 0;
+    auto write_instance = [&](int32_t index, rhi::BLASInstance const& instance) {
+      if (index >= int32_t(m_gpuScene.tlas.desc.instances.size()))
+        m_gpuScene.tlas.desc.instances.resize(index + 1, free_slot);
+      m_gpuScene.tlas.desc.instances[index] = instance;
+    };
+
+    // removed renderers free the instances of their old slots
+    for (auto& [entity, change] : m_changes.renderers.entries) {
+      if (!(change & ChangeList::DESTROYED)) continue;
+      auto iter = m_gpuScene.tlas.instanceList.find(entity);
+      if (iter == m_gpuScene.tlas.instanceList.end()) continue;
+      for (auto& info : iter->second)
+        for (int32_t i = 0; i < info.length; ++i)
+          m_gpuScene.tlas.desc.instances[info.assignedIndex + i] = free_slot;
+      m_gpuScene.tlas.instanceList.erase(iter);
+      should_rebuilt_tlas = true;
+    }
+
+    for (ex::entity entity : changed_entities<Transform, MeshRenderer>(
+      m_registry, { &m_changes.transforms, &m_changes.renderers })) {
+      Transform& transform = m_registry.get<Transform>(entity);
+      MeshRenderer& mesh = m_registry.get<MeshRenderer>(entity);
+      // newly resident meshes come without BLAS and get one built here
+      Mesh* drawn = mesh.m_mesh->drawn();
+      if (drawn->m_customPrimitives.size() > 0) {
+        for (auto& primitive : drawn->m_customPrimitives) {
           // if BLAS not exist, create one
           if (primitive.primBlas == nullptr) {
             should_rebuilt_tlas = true;
@@ -436,94 +734,85 @@ namespace gfx {
         }
       }
       else {
-        for (auto& primitive : mesh.m_mesh->m_primitives) {
+        for (auto& primitive : drawn->m_primitives) {
           // if BLAS not exist, create one
           if (primitive.primBlas == nullptr) {
             should_rebuilt_tlas = true;
             primitive.blasDesc.allowCompaction = true;
-            primitive.blasDesc.triangleGeometries.push_back(rhi::BLASTriangleGeometry{
-              mesh.m_mesh->m_positionBuffer->m_buffer.get(),
-              mesh.m_mesh->m_indexBuffer->m_buffer.get(),
-              rhi::IndexFormat::UINT32_T,
+            Flags<MeshEncodingEnum> const encoding = drawn->m_encoding;
+            bool const short_index = bool(encoding & MeshEncodingEnum::INDEX_UINT16);
+            // meshes in the geometry arena are built from its shared pools
+            auto const* allocation = m_gpuScene.geometryArena.find(drawn);
+            if (allocation == nullptr) drawn->wait_buffers();
+            rhi::BLASTriangleGeometry geometry = {
+              allocation ? m_gpuScene.geometryArena.positions.buffer.get()
+                : drawn->m_positionBuffer->m_buffer.get(),
+              allocation ? m_gpuScene.geometryArena.indices.buffer.get()
+                : drawn->m_indexBuffer->m_buffer.get(),
+              short_index ? rhi::IndexFormat::UINT16_t : rhi::IndexFormat::UINT32_T,
               uint32_t(primitive.numVertex - 1),
               uint32_t(primitive.baseVertex),
               uint32_t(primitive.size / 3),
-              uint32_t(primitive.offset * sizeof(uint32_t)),
+              uint32_t(primitive.offset * (short_index ? sizeof(uint16_t) : sizeof(uint32_t))
+                + (allocation ? allocation->index : 0)),
               rhi::AffineTransformMatrix{},
               (uint32_t)rhi::BLASGeometryEnum::NO_DUPLICATE_ANY_HIT_INVOCATION
               | (uint32_t)rhi::BLASGeometryEnum::OPAQUE_GEOMETRY,
-              0 });
+              0 };
+            // quantized positions are built as SNORM16 and expanded back to
+            // the primitive bounds by the geometry transform
+            if (encoding & MeshEncodingEnum::POSITION_SNORM16) {
+              auto const [center, extent] = Mesh::position_frame(primitive);
+              geometry.vertexFormat = rhi::BLASTriangleGeometry::VertexFormat::RGBA16_SNORM;
+              geometry.vertexStride = 4 * sizeof(int16_t);
+              geometry.transform = rhi::AffineTransformMatrix(
+                se::mat4::translate(center) * se::mat4::scale(extent));
+            }
+            if (allocation) geometry.vertexByteOffset = uint32_t(allocation->position);
+            primitive.blasDesc.triangleGeometries.push_back(geometry);
             primitive.primBlas = GFXContext::device()->create_blas(primitive.blasDesc);
           }
         }
       }
 
+      std::vector<IndexInfo> const& geometries = m_gpuScene.geometryList[entity];
       auto iter = m_gpuScene.tlas.instanceList.find(entity);
-      if (iter == m_gpuScene.tlas.instanceList.end()) {
-        if (mesh.m_mesh->m_customPrimitives.size() > 0) {
-          for (auto& primitive : mesh.m_mesh->m_customPrimitives) {
-            should_rebuilt_tlas = true;
-            // update the instance of the mesh resource
-            rhi::BLASInstance instance;
-            instance.blas = primitive.primBlas.get();
-            instance.transform = transform.global;
-            instance.instanceCustomIndex = primitive.primitiveType; // geometry_start
-            instance.instanceShaderBindingTableRecordOffset = 0;
-
-            int32_t index = m_gpuScene.tlas.desc.instances.size();
-            m_gpuScene.tlas.desc.instances.push_back(instance);
-            m_gpuScene.tlas.instanceList[entity].push_back(IndexInfo{ index });
-          }
-        }
-        else {
-          for (auto& primitive : mesh.m_mesh->m_primitives) {
-            should_rebuilt_tlas = true;
-            // update the instance of the mesh resource
-            rhi::BLASInstance instance;
-            instance.blas = primitive.primBlas.get();
-            instance.transform = transform.global;
-            instance.instanceCustomIndex = 0; // geometry_start
-            instance.instanceShaderBindingTableRecordOffset = 0;
-
-            int32_t index = m_gpuScene.tlas.desc.instances.size();
-            m_gpuScene.tlas.desc.instances.push_back(instance);
-            m_gpuScene.tlas.instanceList[entity].push_back(IndexInfo{ index });
-          }
-        }
+      bool const is_new = iter == m_gpuScene.tlas.instanceList.end();
+      bool const ranges_changed = !is_new && (iter->second.size() != geometries.size()
+        || (geometries.size() > 0 && iter->second[0].assignedIndex != geometries[0].assignedIndex));
+
+      // the geometry records moved, free the instances of the old slots
+      if (ranges_changed) {
+        for (auto& info : iter->second)
+          for (int32_t i = 0; i < info.length; ++i)
+            m_gpuScene.tlas.desc.instances[info.assignedIndex + i] = free_slot;
       }
-      else if (transform.is_dirty_to_gpu()) {
-        size_t instance_offset = 0;
-        if (mesh.m_mesh->m_customPrimitives.size() > 0) {
-          for (auto& primitive : mesh.m_mesh->m_customPrimitives) {
-            should_rebuilt_tlas = true;
-            // update the instance of the mesh resource
-            rhi::BLASInstance instance;
-            instance.blas = primitive.primBlas.get();
-            instance.transform = transform.global;
-            instance.instanceCustomIndex = primitive.primitiveType; // geometry_start
-            instance.instanceShaderBindingTableRecordOffset = 0;
-
-            int32_t index = m_gpuScene.tlas.instanceList[entity][instance_offset++].assignedIndex;
-            m_gpuScene.tlas.desc.instances[index] = instance;
-          }
-        }
-        else {
-          for (auto& primitive : mesh.m_mesh->m_primitives) {
-            should_rebuilt_tlas = true;
-            // update the instance of the mesh resource
-            rhi::BLASInstance instance;
-            instance.blas = primitive.primBlas.get();
-            instance.transform = transform.global;
-            instance.instanceCustomIndex = 0; // geometry_start
-            instance.instanceShaderBindingTableRecordOffset = 0;
-
-            int32_t index = m_gpuScene.tlas.instanceList[entity][instance_offset++].assignedIndex;
-            m_gpuScene.tlas.desc.instances[index] = instance;
-          }
-        }
-
 
+      // all instances of a primitive share the same BLAS
+      size_t index_subprimitive = 0;
+      MeshRenderer const& renderer = mesh;
+      se::mat4 const& node_global = transform.global;
+      auto push_instances = [&](rhi::BLAS* blas, uint32_t custom_index) {
+        IndexInfo const& info = geometries[index_subprimitive++];
+        for (int32_t i = 0; i < info.length; ++i) {
+          rhi::BLASInstance instance;
+          instance.blas = blas;
+          instance.transform = renderer.instance_transform(node_global, i);
+          instance.instanceCustomIndex = custom_index;
+          instance.instanceShaderBindingTableRecordOffset = 0;
+          write_instance(info.assignedIndex + i, instance);
+        }
+      };
+      if (drawn->m_customPrimitives.size() > 0) {
+        for (auto& primitive : drawn->m_customPrimitives)
+          push_instances(primitive.primBlas.get(), primitive.primitiveType);
       }
+      else {
+        for (auto& primitive : drawn->m_primitives)
+          push_instances(primitive.primBlas.get(), 0);
+      }
+      m_gpuScene.tlas.instanceList[entity] = geometries;
+      should_rebuilt_tlas = true;
     }
 
     if (should_rebuilt_tlas) {
@@ -533,7 +822,116 @@ namespace gfx {
     }
   }
 
+  auto Scene::view_metrics() noexcept -> std::vector<ViewMetrics> {
+    std::vector<ViewMetrics> metrics;
+    // a multiview frame renders its views only
+    for (View const& view : m_views)
+      metrics.push_back(ViewMetrics{ view.eye,
+        2.f * std::tan(se::radians(view.yfov) * 0.5f) / float(view.height), view.znear, true });
+    if (!metrics.empty()) return metrics;
+
+    // the camera the shaders read as scene_read_camera(0)
+    Camera const* camera = nullptr;
+    Transform const* camera_transform = nullptr;
+    auto camera_view = m_registry.view<Transform, Camera>();
+    for (auto [entity, transform, component] : camera_view.each()) {
+      auto find = m_gpuScene.cameraList.find(entity);
+      if (find != m_gpuScene.cameraList.end() && find->second.assignedIndex == 0) {
+        camera = &component;
+        camera_transform = &transform;
+      }
+    }
+    if (camera == nullptr) return metrics;
+
+    float viewport_height = 1080.f;
+    auto texture_displayed = Singleton<editor::EditorContext>::instance()->m_viewportTexture;
+    if (texture_displayed.has_value())
+      viewport_height = float(texture_displayed.value()->m_texture->height());
+    // world space size of a pixel at unit distance, or at any distance
+    // for an orthographic camera
+    bool const perspective = camera->projectType == Camera::ProjectType::PERSPECTIVE;
+    float const pixel_size = perspective
+      ? 2.f * std::tan(se::radians(camera->yfov) * 0.5f) / viewport_height
+      : 2.f * camera->bottom_top / viewport_height;
+    metrics.push_back(ViewMetrics{ camera_transform->translation, pixel_size, camera->znear, perspective });
+    return metrics;
+  }
+
+  auto Scene::pixel_scale(std::vector<ViewMetrics> const& views, Transform const& transform,
+    MeshRenderer const& renderer, vec3 center, float radius) noexcept -> float {
+    // measured to the bounding sphere, the nearest instance in any view decides
+    float pixels = 0.f;
+    for (uint32_t i = 0; i < renderer.instance_count(); ++i) {
+      se::mat4 const global = renderer.instance_transform(transform.global, i);
+      vec3 const center_ws = mul(global, { center, 1.f }).xyz();
+      float scale = 0.f;
+      for (int axis = 0; axis < 3; ++axis) {
+        vec3 unit = { 0.f, 0.f, 0.f }; unit.data[axis] = 1.f;
+        scale = std::max(scale, se::length(mul(global, { unit, 0.f }).xyz()));
+      }
+      for (ViewMetrics const& view : views) {
+        float const distance = view.perspective ? std::max(se::distance(center_ws, view.eye)
+          - radius * scale, view.znear) : 1.f;
+        pixels = std::max(pixels, scale / (distance * view.pixelSize));
+      }
+    }
+    return pixels;
+  }
+
+  auto Scene::update_gpu_lods() noexcept -> void {
+    std::vector<ViewMetrics> const metrics = view_metrics();
+    if (metrics.empty()) return;
+
+    bool changed = false;
+    auto select = [&](ex::entity entity, Transform const& transform, MeshRenderer const& renderer) {
+      auto iter = m_gpuScene.geometryList.find(entity);
+      if (iter == m_gpuScene.geometryList.end()) return;
+      Mesh* drawn = renderer.m_mesh->drawn();
+      if (!drawn->m_customPrimitives.empty()) return;
+      auto& primitives = drawn->m_primitives;
+      for (size_t p = 0; p < primitives.size() && p < iter->second.size(); ++p) {
+        Mesh::MeshPrimitive const& primitive = primitives[p];
+        IndexInfo const& info = iter->second[p];
+        // instances of a primitive are drawn together, so the nearest one decides
+        size_t lod = 0;
+        if (m_lodPixelError >= 0.f && !primitive.lods.empty()) {
+          vec3 const center = (primitive.max + primitive.min) * 0.5f;
+          float const radius = se::length(primitive.max - primitive.min) * 0.5f;
+          float const error_scale = pixel_scale(metrics, transform, renderer, center, radius);
+          while (lod < primitive.lods.size()
+            && primitive.lods[lod].error * error_scale <= m_lodPixelError) lod++;
+        }
+        for (int32_t i = 0; i < info.length; ++i) {
+          GeometryDrawData& draw = m_gpuScene.geometryBuffer[info.assignedIndex + i];
+          if (draw.lod == lod) continue;
+          draw.lod = uint16_t(lod);
+          draw.lodIndexOffset = uint32_t(lod == 0 ? primitive.offset : primitive.lods[lod - 1].offset);
+          draw.lodIndexSize = uint32_t(lod == 0 ? primitive.size : primitive.lods[lod - 1].size);
+          changed = true;
+        }
+      }
+    };
+
+    // a moved camera revisits every renderer, otherwise only changed ones
+    auto& view = m_gpuScene.lodView;
+    bool const view_changed = !view.valid || view.views != metrics || !m_changes.cameras.entries.empty()
+      || view.pixelError != m_lodPixelError;
+    view = { metrics, m_lodPixelError, true };
+    if (view_changed) {
+      for (auto [entity, transform, renderer] : m_registry.view<Transform, MeshRenderer>().each())
+        select(entity, transform, renderer);
+    }
+    else {
+      for (ex::entity entity : changed_entities<Transform, MeshRenderer>(
+        m_registry, { &m_changes.transforms, &m_changes.renderers }))
+        select(entity, m_registry.get<Transform>(entity), m_registry.get<MeshRenderer>(entity));
+    }
+    if (changed) m_gpuScene.geometryBuffer.m_buffer->m_hostStamp++;
+  }
+
   auto Scene::draw_meshes(rhi::RenderPassEncoder* encoder, int32_t geometryID_offset) noexcept -> void {
+    // one instanced draw per primitive, the shader reads the record
+    // at geometryID + SV_InstanceID
     for (auto& iter : m_gpuScene.geometryList) {
       for (auto& index_info : iter.second) {
         int geometryID = index_info.assignedIndex;
@@ -541,22 +939,28 @@ namespace gfx {
         encoder->push_constants(&geometryID, se::rhi::ShaderStageEnum::VERTEX
           | se::rhi::ShaderStageEnum::FRAGMENT,
           geometryID_offset, sizeof(int32_t));
-        encoder->draw(draw.indexSize, 1, 0, 0);
+        encoder->draw(draw.lodIndexSize, index_info.length, 0, 0);
       }
     }
   }
 
   auto Scene::GPUScene::ImagePool::try_fetch_index(TextureHandle texture) noexcept -> int {
     auto iter = texture_loc_index.find(texture->m_uid);
-    if (iter == texture_loc_index.end()) {
-      int index = texture_loc_index.size();
-      texture_loc_index[texture->m_uid] = { index, texture };
-      prim_t.push_back(texture->get_srv(0, 1, 0, 1));
-      SamplerHandle sampler = GFXContext::create_sampler_desc(rhi::SamplerDescriptor{});
-      prim_s.push_back(sampler.get()->m_sampler.get());
-      return index;
+    if (iter != texture_loc_index.end()) return iter->second.first;
+    rhi::TextureView* view = texture->get_srv(0, 1, 0, 1);
+    auto slot = view_loc_index.find(view);
+    if (slot != view_loc_index.end()) {
+      texture_loc_index[texture->m_uid] = { slot->second, texture };
+      return slot->second;
     }
-    return iter->second.first;
+    int index = int(prim_t.size());
+    texture_loc_index[texture->m_uid] = { index, texture };
+    view_loc_index[view] = index;
+    prim_t.push_back(view);
+    if (sampler.get() == nullptr)
+      sampler = GFXContext::create_sampler_desc(rhi::SamplerDescriptor{});
+    prim_s.push_back(sampler->m_sampler.get());
+    return index;
   }
 
   auto Scene::GPUScene::MediumPool::try_fetch_index(MediumHandle handle) noexcept -> int {
@@ -633,6 +1037,12 @@ namespace gfx {
     return rhi::BindingResource{ {cameraBuffer.m_buffer->m_buffer.get(), 0, cameraBuffer.m_buffer->m_buffer->size()} };
   }
 
+  auto Scene::GPUScene::binding_resource_view() noexcept -> rhi::BindingResource {
+    // without views the single view is the main camera
+    if (viewBuffer.m_size == 0) return binding_resource_camera();
+    return rhi::BindingResource{ {viewBuffer.m_buffer->m_buffer.get(), 0, viewBuffer.m_buffer->m_buffer->size()} };
+  }
+
   auto Scene::GPUScene::binding_resource_geometry() noexcept -> rhi::BindingResource {
     return rhi::BindingResource{ {geometryBuffer.m_buffer->m_buffer.get(), 0, geometryBuffer.m_buffer->m_buffer->size()} };
   }
@@ -671,6 +1081,18 @@ namespace gfx {
     return rhi::BindingResource{ {lightSampler.trailBuffer->m_buffer.get(), 0, lightSampler.trailBuffer->m_buffer->size()} };
   }
 
+  auto Scene::GPUScene::binding_resource_light_cluster_grid() noexcept -> rhi::BindingResource {
+    return rhi::BindingResource{ {lightClusters.gridBuffer->m_buffer.get(), 0, lightClusters.gridBuffer->m_buffer->size()} };
+  }
+
+  auto Scene::GPUScene::binding_resource_light_cluster_spheres() noexcept -> rhi::BindingResource {
+    return rhi::BindingResource{ {lightClusters.sphereBuffer->m_buffer.get(), 0, lightClusters.sphereBuffer->m_buffer->size()} };
+  }
+
+  auto Scene::GPUScene::binding_resource_light_cluster_lists() noexcept -> rhi::BindingResource {
+    return rhi::BindingResource{ {lightClusters.listBuffer->m_buffer.get(), 0, lightClusters.listBuffer->m_buffer->size()} };
+  }
+
   auto Scene::GPUScene::binding_resource_tlas() noexcept -> rhi::BindingResource {
     return rhi::BindingResource{ {tlas.prim.get()} };
   }
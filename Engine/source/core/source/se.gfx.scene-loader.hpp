@@ -1,5 +1,7 @@
 #pragma once
 #include <se.rhi.hpp>
+#include <map>
+#include <set>
 
 namespace se {
 namespace gfx {
@@ -23,6 +25,8 @@ namespace gfx {
     std::vector<Entry> layout;
     /* index format */
     rhi::IndexFormat format;
+    /* storage encodings applied at upload */
+    Flags<MeshEncodingEnum> encoding = 0;
   };
 
   inline MeshDataLayout defaultMeshDataLayout = { {
@@ -41,11 +45,189 @@ namespace gfx {
     bool residentOnHost = true;
     bool residentOnDevice = false;
     bool deduplication = false;
+    /** reorder triangles and vertices of each primitive for cache and fetch locality */
+    bool optimizeVertexOrder = false;
+    /** build meshlets with bounds and normal cones for each primitive */
+    bool buildMeshlets = false;
+    uint32_t meshletMaxVertices = 64;
+    uint32_t meshletMaxTriangles = 124;
+    /** number of simplified levels built for each primitive, 0 disables lods */
+    uint32_t lodLevels = 0;
+    /** triangle ratio between consecutive levels */
+    float lodReduction = 0.5f;
+    /** largest error of a level, relative to the primitive bounds radius */
+    float lodMaxError = 0.05f;
   };
 
   inline MeshLoaderConfig defaultMeshLoadConfig = { defaultMeshDataLayout, true, true, false, false };
 
+  /** Statistics of a mesh deduplication pass */
+  struct MeshDeduplicationStats {
+    /** meshes replaced by an identical mesh resource */
+    size_t meshesMerged = 0;
+    /** meshes aliasing the buffers of an identical payload */
+    size_t buffersShared = 0;
+    /** device bytes no longer needed by the scene */
+    size_t bytesSaved = 0;
+  };
+
+  /** Stable 64-bit hash over the position, vertex and index payloads and the
+   * primitive ranges of a mesh, independent of run and resource ids, so it can
+   * also key an on-disk cache. */
+  auto hash_mesh_payload(Mesh const& mesh,
+    std::vector<float> const& positions,
+    std::vector<float> const& vertices,
+    std::vector<uint32_t> const& indices) noexcept -> uint64_t;
+
+  /** Merge meshes with identical payloads in the scene. Meshes whose primitives
+   * also bind the same materials and media become one resource, sharing the
+   * buffers and BLAS, the others only share the buffers. */
+  auto deduplicate_meshes(Scene& scene) noexcept -> MeshDeduplicationStats;
+
+  /** Read n floats of every element of a glTF accessor, walking interleaved
+   * views by their byte stride and resolving sparse substitution; missing
+   * components are filled. Empty for an invalid or out of range accessor. */
+  auto read_gltf_floats(tinygltf::Model const& model, int accessor, int n,
+    float fill = 0.f) noexcept -> std::vector<float>;
+
+  /** Reorder the triangles of an indexed list for post-transform vertex cache
+   * hits, using Forsyth's linear-speed algorithm. Deterministic. */
+  auto optimize_vertex_cache(uint32_t* indices, size_t indexCount,
+    size_t vertexCount) noexcept -> void;
+
+  /** Renumber the vertices in order of first use by the indices, unreferenced
+   * vertices go last. Returns the old to new vertex remap. */
+  auto optimize_vertex_fetch(uint32_t* indices, size_t indexCount,
+    size_t vertexCount) noexcept -> std::vector<uint32_t>;
+
+  /** Split an indexed triangle list into meshlets, in triangle order, and fill
+   * the meshlet arrays of the primitive. Positions are 3 floats per vertex. */
+  auto build_meshlets(Mesh::MeshPrimitive& primitive, uint32_t const* indices,
+    size_t indexCount, float const* positions, size_t vertexCount,
+    uint32_t maxVertices, uint32_t maxTriangles) noexcept -> void;
+
+  /** Run the import stages enabled in the config on the host payloads of a
+   * mesh before upload, the primitives are processed in parallel. */
+  auto optimize_mesh(Mesh& mesh,
+    std::vector<float>& positions,
+    std::vector<float>& vertices,
+    std::vector<uint32_t>& indices,
+    MeshLoaderConfig const& config = defaultMeshLoadConfig) noexcept -> void;
+
+  /** A level of detail produced by simplify_lod_chain */
+  struct MeshLODLevel {
+    std::vector<uint32_t> indices;
+    float error;
+  };
+
+  /** Simplify an indexed triangle list by quadric error edge collapses into
+   * a chain of levels, each with about reduction times the triangles of the
+   * previous one. Vertices are never moved or added, attribute seams and
+   * open borders are locked, and the chain stops once the error would
+   * exceed maxError. Indices of the levels address the same vertices. */
+  auto simplify_lod_chain(uint32_t const* indices, size_t indexCount,
+    float const* positions, float const* attributes, size_t stride,
+    size_t vertexCount, uint32_t levelCount, float reduction,
+    float maxError) noexcept -> std::vector<MeshLODLevel>;
+
+  /** Host payloads of a mesh in their storage encoding */
+  struct MeshPayload {
+    std::vector<std::byte> positions;
+    std::vector<std::byte> vertices;
+    std::vector<std::byte> indices;
+  };
+
+  /** Encode the float payloads of a mesh. Encodings the data does not allow
+   * are dropped, the applied ones are recorded in mesh.m_encoding. */
+  auto encode_mesh_payload(Mesh& mesh,
+    std::vector<float> const& positions,
+    std::vector<float> const& vertices,
+    std::vector<uint32_t> const& indices,
+    Flags<MeshEncodingEnum> encoding) noexcept -> MeshPayload;
+
+  /** Decode an encoded payload back into the float layout. */
+  auto decode_mesh_payload(Mesh& mesh,
+    MeshPayload const& payload) noexcept -> MeshPayload;
+
+  /** Usages of the position, vertex and index buffers of a mesh */
+  auto mesh_buffer_usages() noexcept -> std::array<Flags<rhi::BufferUsageEnum>, 3>;
+
+  /** Encode the payloads with the layout of the loader config and create
+   * the device buffers of the mesh, optionally keeping host copies. */
+  auto upload_mesh_payload(Mesh& mesh,
+    std::vector<float> const& positions,
+    std::vector<float> const& vertices,
+    std::vector<uint32_t> const& indices,
+    bool keepHost) noexcept -> void;
+
+  /** Mesh payloads on disk, one chunk per payload holding its position,
+   * vertex and index bytes back to back. The chunk table is written last,
+   * so a store is written in one pass and a chunk is read by one seek. */
+  struct GeometryStore {
+    struct Chunk {
+      uint64_t offset;
+      uint64_t positions;
+      uint64_t vertices;
+      uint64_t indices;
+    };
+    std::string m_path;
+    std::vector<Chunk> m_chunks;
+
+    /** write count payloads, the payload of chunk i is asked for in order */
+    static auto write(std::string const& path, size_t count,
+      std::function<MeshPayload(size_t)> const& payload) noexcept -> std::shared_ptr<GeometryStore>;
+    /** read the chunk table of a written store */
+    static auto open(std::string const& path) noexcept -> std::shared_ptr<GeometryStore>;
+    /** read one chunk, safe to call from any thread */
+    auto read(int32_t chunk) const noexcept -> MeshPayload;
+    auto chunk_bytes(int32_t chunk) const noexcept -> uint64_t;
+  };
+
+  /** Named chunks in one file, written by incremental scene saves. A save
+   * appends the changed chunks after the old table and a new table after
+   * them, then patches the header; stale chunks and tables are dropped by
+   * compacting once they outweigh the live chunks. */
+  struct SceneArchive {
+    struct Chunk {
+      uint64_t offset;
+      uint64_t size;
+    };
+    std::string m_path;
+    std::map<std::string, Chunk> m_chunks;
+    // end of the chunk data, where the current table starts
+    uint64_t m_end = 0;
+    // the document last written, only touched by the saving worker
+    uint64_t m_documentHash = 0;
+
+    /** start an empty archive, replacing the file */
+    static auto create(std::string const& path) noexcept -> std::shared_ptr<SceneArchive>;
+    /** read the chunk table of a written archive */
+    static auto open(std::string const& path) noexcept -> std::shared_ptr<SceneArchive>;
+    auto read(std::string const& name) const noexcept -> std::vector<std::byte>;
+    /** the bytes of a chunk in a mapping of the archive file, empty if
+     * the chunk is missing or lies past the end of the mapping */
+    auto view(MappedFile const& file, std::string const& name) const noexcept -> ext::span<std::byte const>;
+    /** write the chunks, replacing those of the same name, and keep only
+     * the live chunks in the table */
+    auto commit(std::vector<std::pair<std::string, std::vector<std::byte>>> const& chunks,
+      std::set<std::string> const& live) noexcept -> bool;
+    auto live_bytes() const noexcept -> uint64_t;
+  };
+
+  /** Build the stand-in of a mesh from its host payload: the coarsest lod of
+   * every primitive with only the vertices it uses, or the bounding box of a
+   * primitive without lods. */
+  auto build_mesh_proxy(Mesh& mesh) noexcept -> MeshHandle;
+
+  /** A tinygltf image loader that keeps the encoded bytes, so the scene
+   * loader decodes all images of a file together on the workers. */
+  auto keep_encoded_image(tinygltf::Image* image, const int, std::string*, std::string*,
+    int, int, const unsigned char* bytes, int size, void*) -> bool;
+
   auto load_obj_mesh(std::string path, Scene& scene) noexcept -> MeshHandle;
+  /** Binary files are read from a mapping of the file, others by happly.
+   * Faces are fan triangulated, every triangle gets its own corners. */
+  auto load_ply_mesh(std::string path, Scene& scene) noexcept -> MeshHandle;
   auto nanovdb_loader(std::string file_name, MediumHandle& medium) noexcept -> void;
 }
 }
\ No newline at end of file
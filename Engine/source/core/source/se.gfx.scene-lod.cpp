@@ -0,0 +1,252 @@
+#include "se.gfx.hpp"
+#include "se.gfx.scene-loader.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace se {
+namespace gfx {
+  // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+  // ┃ Quadric Error Metric                                                      ┃
+  // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+
+  /** Sum of area weighted plane quadrics, evaluated as the mean squared
+   * distance to the accumulated planes. */
+  struct Quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+    double b0 = 0, b1 = 0, b2 = 0, c = 0, w = 0;
+
+    auto add_plane(vec3 n, float d, double weight) noexcept -> void {
+      a00 += weight * n.x * n.x; a01 += weight * n.x * n.y; a02 += weight * n.x * n.z;
+      a11 += weight * n.y * n.y; a12 += weight * n.y * n.z; a22 += weight * n.z * n.z;
+      b0 += weight * n.x * d; b1 += weight * n.y * d; b2 += weight * n.z * d;
+      c += weight * d * d; w += weight;
+    }
+
+    auto operator+=(Quadric const& q) noexcept -> Quadric& {
+      a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+      b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c; w += q.w;
+      return *this;
+    }
+
+    auto error(vec3 p) const noexcept -> double {
+      double const x = p.x, y = p.y, z = p.z;
+      double const e = a00 * x * x + a11 * y * y + a22 * z * z
+        + 2 * (a01 * x * y + a02 * x * z + a12 * y * z)
+        + 2 * (b0 * x + b1 * y + b2 * z) + c;
+      return w > 0 ? std::max(e / w, 0.0) : 0.0;
+    }
+  };
+
+  // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+  // ┃ Edge Collapse Simplifier                                                  ┃
+  // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+
+  /** Group vertices with bitwise equal keys, each vertex is mapped to the
+   * smallest vertex of its group so the result is deterministic. */
+  static auto weld_vertices(size_t vertexCount, float const* positions,
+    float const* attributes, size_t stride) noexcept -> std::vector<uint32_t> {
+    auto compare = [&](uint32_t a, uint32_t b) -> int {
+      int order = memcmp(positions + a * 3, positions + b * 3, sizeof(float) * 3);
+      if (order == 0 && attributes != nullptr && stride > 0)
+        order = memcmp(attributes + a * stride, attributes + b * stride, sizeof(float) * stride);
+      return order;
+    };
+    std::vector<uint32_t> order(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) order[v] = uint32_t(v);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+      int const c = compare(a, b);
+      return c != 0 ? c < 0 : a < b; });
+    std::vector<uint32_t> weld(vertexCount);
+    for (size_t i = 0; i < vertexCount;) {
+      size_t j = i + 1;
+      while (j < vertexCount && compare(order[i], order[j]) == 0) ++j;
+      for (size_t k = i; k < j; ++k) weld[order[k]] = order[i];
+      i = j;
+    }
+    return weld;
+  }
+
+  static inline auto vertex_position(float const* positions, uint32_t v) noexcept -> vec3 {
+    return vec3{ positions[v * 3 + 0], positions[v * 3 + 1], positions[v * 3 + 2] };
+  }
+
+  static inline auto edge_key(uint32_t a, uint32_t b) noexcept -> uint64_t {
+    return (uint64_t(a) << 32) | b;
+  }
+
+  auto simplify_lod_chain(uint32_t const* indices, size_t indexCount,
+    float const* positions, float const* attributes, size_t stride,
+    size_t vertexCount, uint32_t levelCount, float reduction,
+    float maxError) noexcept -> std::vector<MeshLODLevel> {
+    std::vector<MeshLODLevel> levels;
+    if (levelCount == 0 || vertexCount == 0 || indexCount < 6) return levels;
+
+    // vertices equal in every attribute are the same vertex, while vertices
+    // only sharing a position sit on an attribute seam
+    std::vector<uint32_t> const canonical = weld_vertices(vertexCount, positions, attributes, stride);
+    std::vector<uint32_t> const position_id = weld_vertices(vertexCount, positions, nullptr, 0);
+
+    std::vector<uint32_t> triangles;
+    triangles.reserve(indexCount);
+    for (size_t i = 0; i + 2 < indexCount; i += 3) {
+      uint32_t const a = canonical[indices[i + 0]];
+      uint32_t const b = canonical[indices[i + 1]];
+      uint32_t const c = canonical[indices[i + 2]];
+      if (a == b || b == c || c == a) continue;
+      triangles.insert(triangles.end(), { a, b, c });
+    }
+
+    // lock seams, open borders and non-manifold edges, the collapses never
+    // move a locked vertex so the silhouette and uv layout stay intact
+    std::vector<char> locked(vertexCount, 0);
+    {
+      std::vector<uint32_t> wedge_owner(vertexCount, UINT32_MAX);
+      for (size_t v = 0; v < vertexCount; ++v) {
+        if (canonical[v] != v) continue;
+        uint32_t& owner = wedge_owner[position_id[v]];
+        if (owner == UINT32_MAX) owner = uint32_t(v);
+        else { locked[owner] = 1; locked[v] = 1; }
+      }
+      std::vector<uint64_t> edges;
+      edges.reserve(triangles.size());
+      for (size_t t = 0; t < triangles.size(); t += 3)
+        for (int e = 0; e < 3; ++e)
+          edges.push_back(edge_key(position_id[triangles[t + e]],
+            position_id[triangles[t + (e + 1) % 3]]));
+      std::sort(edges.begin(), edges.end());
+      std::vector<char> locked_position(vertexCount, 0);
+      for (size_t i = 0; i < edges.size(); ++i) {
+        uint32_t const a = uint32_t(edges[i] >> 32), b = uint32_t(edges[i]);
+        bool const duplicated = (i > 0 && edges[i - 1] == edges[i])
+          || (i + 1 < edges.size() && edges[i + 1] == edges[i]);
+        bool const border = !std::binary_search(edges.begin(), edges.end(), edge_key(b, a));
+        if (duplicated || border) locked_position[a] = locked_position[b] = 1;
+      }
+      for (size_t v = 0; v < vertexCount; ++v)
+        if (locked_position[position_id[v]]) locked[canonical[v]] = 1;
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t t = 0; t < triangles.size(); t += 3) {
+      vec3 const p0 = vertex_position(positions, triangles[t + 0]);
+      vec3 const p1 = vertex_position(positions, triangles[t + 1]);
+      vec3 const p2 = vertex_position(positions, triangles[t + 2]);
+      vec3 normal = se::cross(p1 - p0, p2 - p0);
+      float const area = se::length(normal) * 0.5f;
+      if (!(area > 0.f)) continue;
+      normal = normal * (0.5f / area);
+      float const d = -se::dot(normal, p0);
+      for (int k = 0; k < 3; ++k) quadrics[triangles[t + k]].add_plane(normal, d, area);
+    }
+
+    struct Collapse { double cost; uint32_t from, to; };
+    std::vector<uint32_t> adjacency_offset, adjacency;
+    std::vector<uint32_t> collapse_to(vertexCount);
+    std::vector<char> touched(vertexCount);
+    double const max_cost = double(maxError) * double(maxError);
+    float error = 0.f;
+
+    // run one collapse pass, every vertex takes part in at most one collapse
+    auto collapse_pass = [&](size_t target) -> size_t {
+      size_t const triangle_count = triangles.size() / 3;
+      adjacency_offset.assign(vertexCount + 1, 0);
+      for (uint32_t v : triangles) adjacency_offset[v + 1]++;
+      for (size_t v = 0; v < vertexCount; ++v) adjacency_offset[v + 1] += adjacency_offset[v];
+      adjacency.resize(triangles.size());
+      {
+        std::vector<uint32_t> fill(adjacency_offset.begin(), adjacency_offset.end() - 1);
+        for (size_t t = 0; t < triangles.size(); t += 3)
+          for (int k = 0; k < 3; ++k) adjacency[fill[triangles[t + k]]++] = uint32_t(t / 3);
+      }
+
+      std::vector<uint64_t> edges;
+      edges.reserve(triangles.size());
+      for (size_t t = 0; t < triangles.size(); t += 3)
+        for (int e = 0; e < 3; ++e) {
+          uint32_t const a = triangles[t + e], b = triangles[t + (e + 1) % 3];
+          edges.push_back(edge_key(std::min(a, b), std::max(a, b)));
+        }
+      std::sort(edges.begin(), edges.end());
+      edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+      std::vector<Collapse> collapses;
+      collapses.reserve(edges.size());
+      for (uint64_t edge : edges) {
+        uint32_t const a = uint32_t(edge >> 32), b = uint32_t(edge);
+        Collapse best = { std::numeric_limits<double>::max(), a, b };
+        if (!locked[a]) best = { quadrics[a].error(vertex_position(positions, b)), a, b };
+        if (!locked[b]) {
+          double const cost = quadrics[b].error(vertex_position(positions, a));
+          if (cost < best.cost) best = { cost, b, a };
+        }
+        if (best.cost <= max_cost) collapses.push_back(best);
+      }
+      std::sort(collapses.begin(), collapses.end(), [](Collapse const& x, Collapse const& y) {
+        if (x.cost != y.cost) return x.cost < y.cost;
+        return edge_key(x.from, x.to) < edge_key(y.from, y.to); });
+
+      for (size_t v = 0; v < vertexCount; ++v) collapse_to[v] = uint32_t(v);
+      std::fill(touched.begin(), touched.end(), 0);
+      size_t applied = 0, removed = 0;
+      for (Collapse const& collapse : collapses) {
+        if (removed >= triangle_count - target) break;
+        if (touched[collapse.from] || touched[collapse.to]) continue;
+        // reject collapses flipping a remaining triangle around the vertex
+        vec3 const target_position = vertex_position(positions, collapse.to);
+        bool flipped = false;
+        size_t shared = 0;
+        for (uint32_t i = adjacency_offset[collapse.from]; i < adjacency_offset[collapse.from + 1]; ++i) {
+          uint32_t const* triangle = triangles.data() + adjacency[i] * 3;
+          if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) {
+            shared++; continue;
+          }
+          vec3 p[3], q[3];
+          for (int k = 0; k < 3; ++k) {
+            p[k] = vertex_position(positions, triangle[k]);
+            q[k] = triangle[k] == collapse.from ? target_position : p[k];
+          }
+          vec3 const before = se::cross(p[1] - p[0], p[2] - p[0]);
+          vec3 const after = se::cross(q[1] - q[0], q[2] - q[0]);
+          if (se::dot(before, after) <= 0.f) { flipped = true; break; }
+        }
+        if (flipped) continue;
+
+        collapse_to[collapse.from] = collapse.to;
+        quadrics[collapse.to] += quadrics[collapse.from];
+        error = std::max(error, float(std::sqrt(collapse.cost)));
+        touched[collapse.from] = touched[collapse.to] = 1;
+        for (uint32_t i = adjacency_offset[collapse.from]; i < adjacency_offset[collapse.from + 1]; ++i)
+          for (int k = 0; k < 3; ++k) touched[triangles[adjacency[i] * 3 + k]] = 1;
+        removed += shared;
+        applied++;
+      }
+      if (applied == 0) return 0;
+
+      size_t write = 0;
+      for (size_t t = 0; t < triangles.size(); t += 3) {
+        uint32_t const a = collapse_to[triangles[t + 0]];
+        uint32_t const b = collapse_to[triangles[t + 1]];
+        uint32_t const c = collapse_to[triangles[t + 2]];
+        if (a == b || b == c || c == a) continue;
+        triangles[write++] = a; triangles[write++] = b; triangles[write++] = c;
+      }
+      triangles.resize(write);
+      return applied;
+    };
+
+    // one continuous simplification, each level is a snapshot of it so the
+    // quadrics and the error keep accumulating against the source surface
+    size_t previous = triangles.size() / 3;
+    while (levels.size() < levelCount) {
+      size_t const target = std::max<size_t>(size_t(double(previous) * reduction), 1);
+      while (triangles.size() / 3 > target && collapse_pass(target) > 0) {}
+      size_t const current = triangles.size() / 3;
+      // stop when the error bound or the locked vertices stall the chain
+      if (current == 0 || double(current) > double(previous) * 0.95) break;
+      levels.push_back(MeshLODLevel{ triangles, error });
+      previous = current;
+    }
+    return levels;
+  }
+}
+}
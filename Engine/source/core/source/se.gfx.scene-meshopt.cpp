@@ -0,0 +1,372 @@
+#include "se.gfx.hpp"
+#include "se.gfx.scene-loader.hpp"
+#include <future>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <chrono>
+
+namespace se {
+namespace gfx {
+  // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+  // ┃ Vertex Cache Optimization                                                 ┃
+  // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+
+  // Forsyth's scoring against a simulated LRU cache, the constants are the
+  // ones of the original write-up. Ties always resolve to the lowest triangle.
+  static constexpr int cache_size = 32;
+  static constexpr float cache_decay_power = 1.5f;
+  static constexpr float last_triangle_score = 0.75f;
+  static constexpr float valence_boost_scale = 2.0f;
+  static constexpr float valence_boost_power = 0.5f;
+
+  static inline auto vertex_cache_score(int cache_position, uint32_t remaining) noexcept -> float {
+    // vertices without triangles left are never picked again
+    if (remaining == 0) return -1.f;
+    float score = 0.f;
+    if (cache_position >= 0) {
+      // the last triangle's vertices get a fixed score, so that
+      // strips are not favored over fans
+      if (cache_position < 3) score = last_triangle_score;
+      else {
+        float const scaler = 1.f / (cache_size - 3);
+        score = std::pow(1.f - (cache_position - 3) * scaler, cache_decay_power);
+      }
+    }
+    // boost vertices with few triangles left, to get rid of lone ones
+    score += valence_boost_scale * std::pow(float(remaining), -valence_boost_power);
+    return score;
+  }
+
+  auto optimize_vertex_cache(uint32_t* indices, size_t indexCount,
+    size_t vertexCount) noexcept -> void {
+    size_t const face_count = indexCount / 3;
+    if (face_count == 0 || vertexCount == 0) return;
+    // triangles adjacent to each vertex, live ones first
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < face_count * 3; ++i) offsets[indices[i] + 1]++;
+    for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+    std::vector<uint32_t> adjacency(face_count * 3);
+    std::vector<uint32_t> remaining(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) remaining[v] = 0;
+    for (size_t f = 0; f < face_count; ++f)
+      for (int k = 0; k < 3; ++k) {
+        uint32_t const v = indices[f * 3 + k];
+        adjacency[offsets[v] + remaining[v]++] = uint32_t(f);
+      }
+
+    std::vector<int> cache_position(vertexCount, -1);
+    std::vector<float> vertex_score(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+      vertex_score[v] = vertex_cache_score(-1, remaining[v]);
+    std::vector<float> triangle_score(face_count);
+    std::vector<uint8_t> emitted(face_count, 0);
+    int64_t best = 0;
+    for (size_t f = 0; f < face_count; ++f) {
+      triangle_score[f] = vertex_score[indices[f * 3 + 0]]
+        + vertex_score[indices[f * 3 + 1]] + vertex_score[indices[f * 3 + 2]];
+      if (triangle_score[f] > triangle_score[best]) best = int64_t(f);
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(face_count * 3);
+    std::vector<uint32_t> cache, next_cache;
+    cache.reserve(cache_size + 3);
+    next_cache.reserve(cache_size + 3);
+    size_t cursor = 0;
+    while (true) {
+      if (best < 0) {
+        // no candidate around the cache, restart from the first live triangle
+        while (cursor < face_count && emitted[cursor]) ++cursor;
+        if (cursor == face_count) break;
+        best = int64_t(cursor);
+      }
+      uint32_t const* triangle = indices + best * 3;
+      emitted[best] = 1;
+      output.insert(output.end(), triangle, triangle + 3);
+      // retire the triangle from the adjacency of its vertices
+      for (int k = 0; k < 3; ++k) {
+        uint32_t const v = triangle[k];
+        uint32_t* begin = adjacency.data() + offsets[v];
+        uint32_t* end = begin + remaining[v];
+        uint32_t* found = std::find(begin, end, uint32_t(best));
+        std::swap(*found, *(end - 1));
+        remaining[v]--;
+      }
+      // move the vertices to the front of the cache
+      next_cache.clear();
+      for (int k = 0; k < 3; ++k)
+        if (std::find(next_cache.begin(), next_cache.end(), triangle[k]) == next_cache.end())
+          next_cache.push_back(triangle[k]);
+      for (uint32_t v : cache)
+        if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+          next_cache.push_back(v);
+      for (size_t i = 0; i < next_cache.size(); ++i) {
+        uint32_t const v = next_cache[i];
+        cache_position[v] = i < cache_size ? int(i) : -1;
+        vertex_score[v] = vertex_cache_score(cache_position[v], remaining[v]);
+      }
+      // rescore the live triangles touching the cache and pick the best one
+      best = -1;
+      float best_score = -1.f;
+      for (uint32_t v : next_cache) {
+        for (uint32_t a = 0; a < remaining[v]; ++a) {
+          uint32_t const f = adjacency[offsets[v] + a];
+          triangle_score[f] = vertex_score[indices[f * 3 + 0]]
+            + vertex_score[indices[f * 3 + 1]] + vertex_score[indices[f * 3 + 2]];
+          if (triangle_score[f] > best_score ||
+            (triangle_score[f] == best_score && int64_t(f) < best)) {
+            best_score = triangle_score[f];
+            best = int64_t(f);
+          }
+        }
+      }
+      if (next_cache.size() > cache_size) next_cache.resize(cache_size);
+      std::swap(cache, next_cache);
+    }
+    memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+  }
+
+  // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+  // ┃ Vertex Fetch Optimization                                                 ┃
+  // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+
+  auto optimize_vertex_fetch(uint32_t* indices, size_t indexCount,
+    size_t vertexCount) noexcept -> std::vector<uint32_t> {
+    std::vector<uint32_t> remap(vertexCount, uint32_t(-1));
+    uint32_t next = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+      uint32_t& v = indices[i];
+      if (remap[v] == uint32_t(-1)) remap[v] = next++;
+      v = remap[v];
+    }
+    for (size_t v = 0; v < vertexCount; ++v)
+      if (remap[v] == uint32_t(-1)) remap[v] = next++;
+    return remap;
+  }
+
+  // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+  // ┃ Meshlet Generation                                                        ┃
+  // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+
+  static inline auto load_position(float const* positions, uint32_t v) noexcept -> vec3 {
+    return vec3{ positions[v * 3 + 0], positions[v * 3 + 1], positions[v * 3 + 2] };
+  }
+
+  static auto compute_meshlet_bounds(Mesh::Meshlet& meshlet,
+    Mesh::MeshPrimitive const& primitive, float const* positions) noexcept -> void {
+    uint32_t const* vertices = primitive.meshletVertices.data() + meshlet.vertexOffset;
+    uint8_t const* triangles = primitive.meshletTriangles.data() + meshlet.triangleOffset;
+    // bounding sphere around the center of the box
+    vec3 pmin = load_position(positions, vertices[0]);
+    vec3 pmax = pmin;
+    for (uint32_t i = 1; i < meshlet.vertexCount; ++i) {
+      vec3 const p = load_position(positions, vertices[i]);
+      pmin = se::min(pmin, p);
+      pmax = se::max(pmax, p);
+    }
+    meshlet.center = (pmin + pmax) * 0.5f;
+    meshlet.radius = 0.f;
+    for (uint32_t i = 0; i < meshlet.vertexCount; ++i)
+      meshlet.radius = std::max(meshlet.radius,
+        se::distance(meshlet.center, load_position(positions, vertices[i])));
+
+    // normal cone from the face normals, degenerate triangles are skipped
+    std::vector<vec3> normals;
+    std::vector<vec3> corners;
+    normals.reserve(meshlet.triangleCount);
+    corners.reserve(meshlet.triangleCount);
+    vec3 axis = { 0.f, 0.f, 0.f };
+    for (uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+      vec3 const p0 = load_position(positions, vertices[triangles[t * 3 + 0]]);
+      vec3 const p1 = load_position(positions, vertices[triangles[t * 3 + 1]]);
+      vec3 const p2 = load_position(positions, vertices[triangles[t * 3 + 2]]);
+      vec3 const n = se::cross(p1 - p0, p2 - p0);
+      float const area = se::length(n);
+      if (area <= 0.f) continue;
+      normals.push_back(n * (1.f / area));
+      corners.push_back(p0);
+      axis = axis + normals.back();
+    }
+    meshlet.coneAxis = { 0.f, 0.f, 0.f };
+    meshlet.coneApex = meshlet.center;
+    meshlet.coneCutoff = 1.f;
+    float const axis_length = se::length(axis);
+    if (normals.empty() || axis_length <= 0.f) return;
+    axis = axis * (1.f / axis_length);
+    float min_dot = 1.f;
+    for (vec3 const& n : normals) min_dot = std::min(min_dot, se::dot(n, axis));
+    // wider than ~84 degrees, the cone would hardly ever cull anything
+    if (min_dot <= 0.1f) return;
+    // pull the apex back so every triangle plane faces away from it
+    float max_t = 0.f;
+    for (size_t i = 0; i < normals.size(); ++i) {
+      float const dc = se::dot(meshlet.center - corners[i], normals[i]);
+      float const dn = se::dot(axis, normals[i]);
+      max_t = std::max(max_t, dc / dn);
+    }
+    meshlet.coneAxis = axis;
+    meshlet.coneApex = meshlet.center - axis * max_t;
+    meshlet.coneCutoff = std::sqrt(1.f - min_dot * min_dot);
+  }
+
+  auto build_meshlets(Mesh::MeshPrimitive& primitive, uint32_t const* indices,
+    size_t indexCount, float const* positions, size_t vertexCount,
+    uint32_t maxVertices, uint32_t maxTriangles) noexcept -> void {
+    primitive.meshlets.clear();
+    primitive.meshletVertices.clear();
+    primitive.meshletTriangles.clear();
+    // triangles store local indices as bytes
+    maxVertices = std::min<uint32_t>(std::max<uint32_t>(maxVertices, 3), 256);
+    maxTriangles = std::max<uint32_t>(maxTriangles, 1);
+    size_t const face_count = indexCount / 3;
+    if (face_count == 0) return;
+
+    // local index of each vertex in the open meshlet, stamped by meshlet
+    std::vector<uint32_t> local(vertexCount, 0);
+    std::vector<uint32_t> stamp(vertexCount, uint32_t(-1));
+    Mesh::Meshlet meshlet = {};
+    auto flush = [&]() {
+      if (meshlet.triangleCount == 0) return;
+      compute_meshlet_bounds(meshlet, primitive, positions);
+      primitive.meshlets.push_back(meshlet);
+      meshlet = {};
+      meshlet.vertexOffset = uint32_t(primitive.meshletVertices.size());
+      meshlet.triangleOffset = uint32_t(primitive.meshletTriangles.size());
+    };
+
+    for (size_t f = 0; f < face_count; ++f) {
+      uint32_t const* triangle = indices + f * 3;
+      uint32_t const id = uint32_t(primitive.meshlets.size());
+      uint32_t fresh = 0;
+      for (int k = 0; k < 3; ++k)
+        if (stamp[triangle[k]] != id &&
+          (k < 1 || triangle[k] != triangle[0]) &&
+          (k < 2 || triangle[k] != triangle[1])) fresh++;
+      if (meshlet.vertexCount + fresh > maxVertices ||
+        meshlet.triangleCount + 1 > maxTriangles) {
+        flush();
+      }
+      uint32_t const current = uint32_t(primitive.meshlets.size());
+      for (int k = 0; k < 3; ++k) {
+        uint32_t const v = triangle[k];
+        if (stamp[v] != current) {
+          stamp[v] = current;
+          local[v] = meshlet.vertexCount++;
+          primitive.meshletVertices.push_back(v);
+        }
+        primitive.meshletTriangles.push_back(uint8_t(local[v]));
+      }
+      meshlet.triangleCount++;
+    }
+    flush();
+  }
+
+  // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+  // ┃ Import Stage                                                              ┃
+  // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+
+  auto optimize_mesh(Mesh& mesh,
+    std::vector<float>& positions,
+    std::vector<float>& vertices,
+    std::vector<uint32_t>& indices,
+    MeshLoaderConfig const& config) noexcept -> void {
+    if (!config.optimizeVertexOrder && !config.buildMeshlets && config.lodLevels == 0) return;
+    PROFILE_SCOPE_FUNCTION();
+    size_t const vertex_total = positions.size() / 3;
+    if (vertex_total == 0) return;
+    // the attribute stride follows the layout the loader assembled
+    size_t const stride = vertices.size() / vertex_total;
+
+    // primitives own disjoint index and vertex ranges, so they are
+    // processed independently and the result does not depend on scheduling
+    size_t const primitive_count = mesh.m_primitives.size();
+    std::vector<std::vector<MeshLODLevel>> lod_levels(primitive_count);
+    std::atomic<int64_t> lod_microseconds = 0;
+    auto process = [&](size_t index) {
+      Mesh::MeshPrimitive& primitive = mesh.m_primitives[index];
+      uint32_t* primitive_indices = indices.data() + primitive.offset;
+      size_t const index_count = primitive.size;
+      size_t const vertex_count = primitive.numVertex;
+      float* primitive_positions = positions.data() + primitive.baseVertex * 3;
+      if (config.optimizeVertexOrder) {
+        optimize_vertex_cache(primitive_indices, index_count, vertex_count);
+        std::vector<uint32_t> remap = optimize_vertex_fetch(
+          primitive_indices, index_count, vertex_count);
+        std::vector<float> old_positions(primitive_positions,
+          primitive_positions + vertex_count * 3);
+        for (size_t v = 0; v < vertex_count; ++v)
+          memcpy(primitive_positions + remap[v] * 3,
+            old_positions.data() + v * 3, sizeof(float) * 3);
+        if (stride > 0) {
+          float* primitive_vertices = vertices.data() + primitive.baseVertex * stride;
+          std::vector<float> old_vertices(primitive_vertices,
+            primitive_vertices + vertex_count * stride);
+          for (size_t v = 0; v < vertex_count; ++v)
+            memcpy(primitive_vertices + remap[v] * stride,
+              old_vertices.data() + v * stride, sizeof(float) * stride);
+        }
+      }
+      if (config.buildMeshlets) {
+        build_meshlets(primitive, primitive_indices, index_count,
+          primitive_positions, vertex_count,
+          config.meshletMaxVertices, config.meshletMaxTriangles);
+      }
+      if (config.lodLevels > 0) {
+        auto const start = std::chrono::steady_clock::now();
+        float const radius = se::length(primitive.max - primitive.min) * 0.5f;
+        lod_levels[index] = simplify_lod_chain(primitive_indices, index_count,
+          primitive_positions, stride > 0 ? vertices.data() + primitive.baseVertex * stride : nullptr,
+          stride, vertex_count, config.lodLevels, config.lodReduction, config.lodMaxError * radius);
+        if (config.optimizeVertexOrder)
+          for (auto& level : lod_levels[index])
+            optimize_vertex_cache(level.indices.data(), level.indices.size(), vertex_count);
+        lod_microseconds += std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start).count();
+      }
+    };
+
+    size_t const worker_count = std::min<size_t>(primitive_count,
+      std::max<unsigned>(std::thread::hardware_concurrency(), 1u));
+    if (worker_count <= 1) {
+      for (size_t i = 0; i < primitive_count; ++i) process(i);
+    }
+    else {
+      std::atomic<size_t> next = 0;
+      auto worker = [&]() {
+        for (size_t i = next++; i < primitive_count; i = next++)
+          process(i);
+      };
+      std::vector<std::future<void>> jobs;
+      jobs.reserve(worker_count);
+      for (size_t i = 0; i < worker_count; ++i)
+        jobs.emplace_back(std::async(std::launch::async, worker));
+      for (auto& job : jobs) job.get();
+    }
+    if (config.lodLevels == 0) return;
+
+    // append the levels behind the full detail indices in primitive order,
+    // and report the triangles and the largest error of every level
+    std::vector<size_t> level_triangles(config.lodLevels, 0);
+    std::vector<float> level_errors(config.lodLevels, 0.f);
+    size_t base_triangles = 0;
+    for (size_t i = 0; i < primitive_count; ++i) {
+      Mesh::MeshPrimitive& primitive = mesh.m_primitives[i];
+      primitive.lods.clear();
+      base_triangles += primitive.size / 3;
+      for (size_t k = 0; k < lod_levels[i].size(); ++k) {
+        MeshLODLevel const& level = lod_levels[i][k];
+        primitive.lods.push_back(Mesh::LOD{ indices.size(), level.indices.size(), level.error });
+        indices.insert(indices.end(), level.indices.begin(), level.indices.end());
+        level_triangles[k] += level.indices.size() / 3;
+        level_errors[k] = std::max(level_errors[k], level.error);
+      }
+    }
+    se::info("gfx :: lod :: {} primitives, {} triangles, built in {:.2f} ms of cpu time",
+      primitive_count, base_triangles, lod_microseconds.load() / 1000.0);
+    for (size_t k = 0; k < config.lodLevels && level_triangles[k] > 0; ++k)
+      se::info("gfx :: lod :: level {} :: {} triangles, max error {:.4g}",
+        k + 1, level_triangles[k], level_errors[k]);
+  }
+}
+}
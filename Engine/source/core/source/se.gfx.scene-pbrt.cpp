@@ -110,16 +110,6 @@ namespace gfx {
     medium->packet.boundMax = bound.pMax;
   }
 
-  std::string loadFileAsString(const std::string& filePath) {
-    std::ifstream file(filePath); // Open the file
-    if (!file) {
-      throw std::runtime_error("Unable to open file");
-    }
-    std::stringstream buffer;
-    buffer << file.rdbuf(); // Read the file's content into the stringstream
-    return buffer.str(); // Return the string content
-  }
-
   auto loadPbrtDefineddMesh(std::vector<tiny_pbrt_loader::Point3f> p,
     std::vector<int> indices, Scene& scene) noexcept -> MeshHandle {
     // load obj file
@@ -271,45 +261,10 @@ namespace gfx {
       submesh_index_offset = global_index_offset;
       submesh_vertex_offset += positionBufferV.size() / 3 - submesh_vertex_offset;
     }
-    { // register mesh
-      PROFILE_SCOPE_NAME(UploadGPUBuffer);
-      MiniBuffer buffer;
-      buffer.m_isReference = true;
-
-      buffer.m_data = positionBufferV.data();
-      buffer.m_size = sizeof(float) * positionBufferV.size();
-
-      bool need_rt = bool(gfx::GFXContext::device()->from_which_adapter()->from_which_context()
-        ->get_context_extensions_flags() & rhi::ContextExtensionEnum::RAY_TRACING);
-      Flags<rhi::BufferUsageEnum> rt_usage = 0;
-      if (need_rt) rt_usage |= rhi::BufferUsageEnum::ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY;
-
-      mesh->m_positionBuffer = gfx::GFXContext::create_buffer_host(buffer,
-        rhi::BufferUsageEnum::STORAGE |
-        rhi::BufferUsageEnum::SHADER_DEVICE_ADDRESS | rt_usage);
-      mesh->m_positionBuffer->m_job = "Mesh position buffer";
-      mesh->m_positionBuffer->m_host.resize(buffer.m_size);
-      memcpy(mesh->m_positionBuffer->m_host.data(), buffer.m_data, buffer.m_size);
-
-      buffer.m_data = indexBufferWV.data();
-      buffer.m_size = sizeof(uint32_t) * indexBufferWV.size();
-      mesh->m_indexBuffer = gfx::GFXContext::create_buffer_host(buffer,
-        rhi::BufferUsageEnum::INDEX |
-        rhi::BufferUsageEnum::SHADER_DEVICE_ADDRESS | rt_usage);
-      mesh->m_indexBuffer->m_job = "Mesh index buffer";
-      mesh->m_indexBuffer->m_host.resize(buffer.m_size);
-      memcpy(mesh->m_indexBuffer->m_host.data(), buffer.m_data, buffer.m_size);
-
-      buffer.m_data = vertexBufferV.data();
-      buffer.m_size = sizeof(uint32_t) * vertexBufferV.size();
-      mesh->m_vertexBuffer = gfx::GFXContext::create_buffer_host(buffer,
-        rhi::BufferUsageEnum::STORAGE |
-        rhi::BufferUsageEnum::SHADER_DEVICE_ADDRESS);
-      mesh->m_vertexBuffer->m_job = "Mesh vertex buffer";
-      mesh->m_vertexBuffer->m_host.resize(buffer.m_size);
-      memcpy(mesh->m_vertexBuffer->m_host.data(), buffer.m_data, buffer.m_size);
-      PROFILE_SCOPE_STOP(UploadGPUBuffer);
-    }
+    optimize_mesh(*mesh.get(), positionBufferV, vertexBufferV, indexBufferWV);
+    mesh->m_contentHash = hash_mesh_payload(*mesh.get(), positionBufferV, vertexBufferV, indexBufferWV);
+    upload_mesh_payload(*mesh.get(), positionBufferV, vertexBufferV, indexBufferWV,
+      defaultMeshLoadConfig.residentOnHost);
     return mesh;
   }
 
@@ -337,9 +292,14 @@ namespace gfx {
   }
 
 	auto Scene::load_pbrt(std::string const& path) noexcept -> void {
-		std::string fileContent = loadFileAsString(path);
+		if (!std::filesystem::exists(path)) {
+			se::error("gfx :: pbrt :: scene file '{}' does not exist", path);
+			return;
+		}
 		std::string dir_path = std::filesystem::path(path).parent_path().string();
-		std::unique_ptr<tiny_pbrt_loader::BasicScene> scene_pbrt = tiny_pbrt_loader::load_scene_from_string(fileContent, dir_path);
+		// tokenized from a mapping of the file, not from a copy of it
+		std::unique_ptr<tiny_pbrt_loader::BasicScene> scene_pbrt = tiny_pbrt_loader::load_scene_from_file(path);
+    m_sourceFiles.insert(m_sourceFiles.end(), scene_pbrt->files.begin(), scene_pbrt->files.end());
 		std::string prefix = dir_path + "/";
 
     // camera
@@ -384,6 +344,7 @@ namespace gfx {
       std::string type = medium.dict.GetOneString("type", "");
       if (type == "nanovdb") {
         std::string filename = prefix + medium.dict.GetOneString("filename", "");
+        m_sourceFiles.push_back(filename);
         nanovdb_loader(filename, medium_handle);
         medium_handle->packet.type = Medium::MediumType::GridMedium;
 
@@ -412,8 +373,8 @@ namespace gfx {
         medium_handle->packet.scale = scale;
         medium_handle->packet.aniso = { g };
 
-        std::vector<tiny_pbrt_loader::Float> const& p0 = medium.dict.GetAllFloats("p0");
-        std::vector<tiny_pbrt_loader::Float> const& p1 = medium.dict.GetAllFloats("p1");
+        auto const& p0 = medium.dict.GetAllFloats("p0");
+        auto const& p1 = medium.dict.GetAllFloats("p1");
 
         bounds3 bound;
         bound.pMin = { float(p0[0]), float(p0[1]), float(p0[2]) };
@@ -520,12 +481,11 @@ namespace gfx {
         }
     };
 
-    for (auto& shape : scene_pbrt->shapes) {
+    // creates the mesh renderer of a shape on the node, the node transform
+    // is set to the object-to-render transform of the shape
+    auto load_shape = [&](tiny_pbrt_loader::ShapeSceneEntity& shape, Node& node) -> MeshRenderer* {
       std::vector<tiny_pbrt_loader::Point3f> p = shape.dict.GetPoint3fArray("P");
       std::vector<int> idx = shape.dict.GetIntArray("indices");
-      auto node = create_node(shape.name);
-      m_roots.push_back(node);
-      NodeProperty* prop = node.get_component<NodeProperty>();
       Transform* transformComponent = node.get_component<Transform>();
       auto& pbrt_trans = shape.renderFromObject;
       FillTransfromFromPBRT(pbrt_trans, *transformComponent);
@@ -535,6 +495,16 @@ namespace gfx {
         MeshRenderer& mesh_renderer = node.add_component<MeshRenderer>();
         mesh_renderer.m_mesh = loadPbrtDefineddMesh(p, idx, *this);
         handle_material_medium(shape, mesh_renderer);
+        return &mesh_renderer;
+      }
+      else if (shape.name == "plymesh") {
+        std::string filename = prefix + shape.dict.GetOneString("filename", "");
+        MeshHandle mesh = load_ply_mesh(filename, *this);
+        if (mesh.get() == nullptr) return nullptr;
+        MeshRenderer& mesh_renderer = node.add_component<MeshRenderer>();
+        mesh_renderer.m_mesh = mesh;
+        handle_material_medium(shape, mesh_renderer);
+        return &mesh_renderer;
       }
       else if (shape.name == "sphere") {
         const float radius = shape.dict.GetOneFloat("radius", 1.f);
@@ -553,8 +523,47 @@ namespace gfx {
         mesh_renderer.m_mesh = mesh;
 
         handle_material_medium(shape, mesh_renderer);
+        return &mesh_renderer;
+      }
+      return nullptr;
+    };
+
+    for (auto& shape : scene_pbrt->shapes) {
+      auto node = create_node(shape.name);
+      m_roots.push_back(node);
+      load_shape(shape, node);
+    }
+
+    // object instances: each shape of a definition is loaded only once,
+    // and all the uses of the definition become instances of that node,
+    // so they share the mesh buffers and the BLAS
+    std::unordered_map<std::string, std::vector<se::mat4>> instance_uses;
+    for (auto& instance : scene_pbrt->instances)
+      instance_uses[instance.name].push_back(pbrt_mat_to_semat4x4(instance.renderFromInstance));
+
+    for (auto& definition : scene_pbrt->instanceDefinitions) {
+      auto iter = instance_uses.find(definition.name);
+      if (iter == instance_uses.end()) continue;
+      for (auto& shape : definition.shapes) {
+        auto node = create_node(definition.name);
+        m_roots.push_back(node);
+        MeshRenderer* mesh_renderer = load_shape(shape, node);
+        if (mesh_renderer == nullptr) continue;
+        // bake the shape transform into every instance,
+        // the node itself stays at the origin
+        Transform* transformComponent = node.get_component<Transform>();
+        se::mat4 const shape_local = transformComponent->local();
+        mesh_renderer->m_instances.reserve(iter->second.size());
+        for (se::mat4 const& render_from_instance : iter->second)
+          mesh_renderer->m_instances.push_back(render_from_instance * shape_local);
+        transformComponent->translation = { 0.f, 0.f, 0.f };
+        transformComponent->scale = { 1.f, 1.f, 1.f };
+        transformComponent->rotation = { 0.f, 0.f, 0.f, 1.f };
       }
     }
+
+    if (defaultMeshLoadConfig.deduplication)
+      deduplicate_meshes(*this);
 	}
 
 }
@@ -0,0 +1,446 @@
+#include "se.gfx.hpp"
+#include "se.gfx.scene-loader.hpp"
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <happly/happly.hpp>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SE_PLY_SSE2
+#endif
+
+namespace se {
+namespace gfx {
+  // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+  // ┃ Binary PLY                                                                ┃
+  // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+  // Binary files are read from a mapping: the header is parsed once, the
+  // positions are gathered from the vertex records and byte swapped in bulk,
+  // and the face lists are fan triangulated in place. ASCII files and layouts
+  // the reader does not know go through happly.
+
+  enum struct PlyScalar : uint8_t { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64 };
+
+  struct PlyProperty {
+    std::string name;
+    PlyScalar type;
+    // count type of a list, type is then the type of its items
+    PlyScalar countType;
+    bool isList = false;
+  };
+
+  struct PlyElement {
+    std::string name;
+    size_t count = 0;
+    std::vector<PlyProperty> properties;
+  };
+
+  struct PlyHeader {
+    bool bigEndian = false;
+    std::vector<PlyElement> elements;
+    // offset of the first element record in the file
+    size_t bodyOffset = 0;
+  };
+
+  // positions and triangle indices, the same for both readers
+  struct PlyMesh {
+    std::vector<float> positions;
+    std::vector<uint32_t> indices;
+  };
+
+  static auto ply_scalar(std::string_view name, PlyScalar& type) noexcept -> bool {
+    static constexpr std::pair<std::string_view, PlyScalar> names[] = {
+      { "char", PlyScalar::Int8 },      { "int8", PlyScalar::Int8 },
+      { "uchar", PlyScalar::UInt8 },    { "uint8", PlyScalar::UInt8 },
+      { "short", PlyScalar::Int16 },    { "int16", PlyScalar::Int16 },
+      { "ushort", PlyScalar::UInt16 },  { "uint16", PlyScalar::UInt16 },
+      { "int", PlyScalar::Int32 },      { "int32", PlyScalar::Int32 },
+      { "uint", PlyScalar::UInt32 },    { "uint32", PlyScalar::UInt32 },
+      { "float", PlyScalar::Float32 },  { "float32", PlyScalar::Float32 },
+      { "double", PlyScalar::Float64 }, { "float64", PlyScalar::Float64 } };
+    for (auto const& [n, t] : names)
+      if (n == name) { type = t; return true; }
+    return false;
+  }
+
+  static auto ply_scalar_size(PlyScalar type) noexcept -> size_t {
+    switch (type) {
+    case PlyScalar::Int8: case PlyScalar::UInt8: return 1;
+    case PlyScalar::Int16: case PlyScalar::UInt16: return 2;
+    case PlyScalar::Float64: return 8;
+    default: return 4;
+    }
+  }
+
+  static inline auto ply_is_integer(PlyScalar type) noexcept -> bool {
+    return type != PlyScalar::Float32 && type != PlyScalar::Float64;
+  }
+
+  static inline auto byteswap16(uint16_t x) noexcept -> uint16_t {
+    return uint16_t((x >> 8) | (x << 8));
+  }
+
+  static inline auto byteswap32(uint32_t x) noexcept -> uint32_t {
+    return (x >> 24) | ((x >> 8) & 0xff00u) | ((x << 8) & 0xff0000u) | (x << 24);
+  }
+
+  static inline auto byteswap64(uint64_t x) noexcept -> uint64_t {
+    return (uint64_t(byteswap32(uint32_t(x))) << 32) | byteswap32(uint32_t(x >> 32));
+  }
+
+  // swaps count words of data in place, data needs no alignment
+  static auto byteswap32(void* data, size_t count) noexcept -> void {
+    std::byte* bytes = static_cast<std::byte*>(data);
+    size_t i = 0;
+#ifdef SE_PLY_SSE2
+    for (; i + 4 <= count; i += 4) {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(bytes + i * 4));
+      // swap the halves of every word, then the bytes of every half
+      x = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+      x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + i * 4), x);
+    }
+#endif
+    for (; i < count; ++i) {
+      uint32_t v; std::memcpy(&v, bytes + i * 4, 4);
+      v = byteswap32(v); std::memcpy(bytes + i * 4, &v, 4);
+    }
+  }
+
+  static auto byteswap64(void* data, size_t count) noexcept -> void {
+    std::byte* bytes = static_cast<std::byte*>(data);
+    size_t i = 0;
+#ifdef SE_PLY_SSE2
+    for (; i + 2 <= count; i += 2) {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(bytes + i * 8));
+      x = _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1));
+      x = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+      x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + i * 8), x);
+    }
+#endif
+    for (; i < count; ++i) {
+      uint64_t v; std::memcpy(&v, bytes + i * 8, 8);
+      v = byteswap64(v); std::memcpy(bytes + i * 8, &v, 8);
+    }
+  }
+
+  static inline auto host_big_endian() noexcept -> bool {
+    uint16_t const one = 1;
+    uint8_t first; std::memcpy(&first, &one, 1);
+    return first == 0;
+  }
+
+  // reads a list count or an index, negative values come out huge and
+  // are caught by the range check of the indices
+  static inline auto ply_read_integer(std::byte const* p, PlyScalar type, bool swap) noexcept -> uint32_t {
+    switch (type) {
+    case PlyScalar::Int8: return uint32_t(int32_t(int8_t(p[0])));
+    case PlyScalar::UInt8: return uint32_t(uint8_t(p[0]));
+    case PlyScalar::Int16: case PlyScalar::UInt16: {
+      uint16_t v; std::memcpy(&v, p, 2); if (swap) v = byteswap16(v);
+      return type == PlyScalar::Int16 ? uint32_t(int32_t(int16_t(v))) : uint32_t(v);
+    }
+    default: {
+      uint32_t v; std::memcpy(&v, p, 4);
+      return swap ? byteswap32(v) : v;
+    }
+    }
+  }
+
+  static auto parse_ply_header(ext::span<std::byte const> file, PlyHeader& header) noexcept -> bool {
+    std::string_view const text(reinterpret_cast<char const*>(file.data()), file.size());
+    size_t pos = 0;
+    bool first = true, format = false;
+    while (pos < text.size()) {
+      size_t end = text.find('\n', pos);
+      if (end == std::string_view::npos) return false;
+      std::string_view line = text.substr(pos, end - pos);
+      pos = end + 1;
+      if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+      // split the line into at most 5 words
+      std::string_view words[5]; size_t count = 0;
+      for (size_t i = 0; i < line.size() && count < 5;) {
+        while (i < line.size() && line[i] == ' ') ++i;
+        size_t const j = std::min(line.find(' ', i), line.size());
+        if (j > i) words[count++] = line.substr(i, j - i);
+        i = j;
+      }
+      if (first) {
+        if (count != 1 || words[0] != "ply") return false;
+        first = false;
+      }
+      else if (count == 0 || words[0] == "comment" || words[0] == "obj_info") {}
+      else if (words[0] == "format") {
+        if (count < 2) return false;
+        if (words[1] == "binary_little_endian") header.bigEndian = false;
+        else if (words[1] == "binary_big_endian") header.bigEndian = true;
+        else return false;
+        format = true;
+      }
+      else if (words[0] == "element" && count == 3) {
+        PlyElement element;
+        element.name = words[1];
+        auto const [ptr, ec] = std::from_chars(words[2].data(), words[2].data() + words[2].size(), element.count);
+        if (ec != std::errc()) return false;
+        header.elements.emplace_back(std::move(element));
+      }
+      else if (words[0] == "property" && !header.elements.empty()) {
+        PlyProperty property;
+        if (count == 5 && words[1] == "list") {
+          property.isList = true;
+          if (!ply_scalar(words[2], property.countType) || !ply_scalar(words[3], property.type)) return false;
+          if (!ply_is_integer(property.countType)) return false;
+          property.name = words[4];
+        }
+        else if (count == 3) {
+          if (!ply_scalar(words[1], property.type)) return false;
+          property.name = words[2];
+        }
+        else return false;
+        header.elements.back().properties.emplace_back(std::move(property));
+      }
+      else if (words[0] == "end_header") {
+        header.bodyOffset = pos;
+        return format;
+      }
+      else return false;
+    }
+    return false;
+  }
+
+  // record size of an element without lists, 0 if it has any
+  static auto ply_record_size(PlyElement const& element) noexcept -> size_t {
+    size_t size = 0;
+    for (auto const& property : element.properties) {
+      if (property.isList) return 0;
+      size += ply_scalar_size(property.type);
+    }
+    return size;
+  }
+
+  // gathers the x, y and z properties of count records into out, swapped
+  // to the host order and converted to float
+  template <typename T>
+  static auto ply_gather_positions(std::byte const* records, size_t count, size_t stride,
+    size_t const offsets[3], bool swap, float* out) noexcept -> void {
+    std::vector<T> raw;
+    T* values;
+    if constexpr (std::is_same_v<T, float>) values = out;
+    else { raw.resize(count * 3); values = raw.data(); }
+    if (stride == 3 * sizeof(T) && offsets[0] == 0 && offsets[1] == sizeof(T) && offsets[2] == 2 * sizeof(T))
+      std::memcpy(values, records, count * stride);
+    else
+      for (size_t i = 0; i < count; ++i)
+        for (size_t c = 0; c < 3; ++c)
+          std::memcpy(&values[i * 3 + c], records + i * stride + offsets[c], sizeof(T));
+    if (swap) {
+      if constexpr (sizeof(T) == 4) byteswap32(values, count * 3);
+      else byteswap64(values, count * 3);
+    }
+    if constexpr (!std::is_same_v<T, float>)
+      for (size_t i = 0; i < count * 3; ++i) out[i] = float(values[i]);
+  }
+
+  // reads a binary file, false if it is not one or has a layout left to happly
+  static auto read_ply_binary(std::string const& path, PlyMesh& mesh) noexcept -> bool {
+    MappedFile file;
+    if (!file.open(path)) return false;
+    PlyHeader header;
+    if (!parse_ply_header(file.as_span(), header)) return false;
+    bool const swap = header.bigEndian != host_big_endian();
+
+    std::byte const* cursor = file.data() + header.bodyOffset;
+    std::byte const* const end = file.data() + file.size();
+    bool haveVertices = false, haveFaces = false;
+    for (auto const& element : header.elements) {
+      if (haveVertices && haveFaces) break;
+      size_t const recordSize = ply_record_size(element);
+      if (element.name == "vertex") {
+        if (recordSize == 0) return false;
+        if (size_t(end - cursor) / recordSize < element.count) return false;
+        size_t offsets[3] = {}; int found = 0;
+        PlyScalar type = PlyScalar::Float32;
+        size_t offset = 0;
+        for (auto const& property : element.properties) {
+          int const c = property.name == "x" ? 0 : property.name == "y" ? 1 : property.name == "z" ? 2 : -1;
+          if (c >= 0) {
+            if (found != 0 && property.type != type) return false;
+            type = property.type; offsets[c] = offset; found |= 1 << c;
+          }
+          offset += ply_scalar_size(property.type);
+        }
+        if (found != 7) return false;
+        mesh.positions.resize(element.count * 3);
+        if (type == PlyScalar::Float32)
+          ply_gather_positions<float>(cursor, element.count, recordSize, offsets, swap, mesh.positions.data());
+        else if (type == PlyScalar::Float64)
+          ply_gather_positions<double>(cursor, element.count, recordSize, offsets, swap, mesh.positions.data());
+        else return false;
+        cursor += element.count * recordSize;
+        haveVertices = true;
+      }
+      else if (element.name == "face") {
+        // one index list, with fixed size properties around it
+        PlyProperty const* list = nullptr;
+        size_t before = 0, after = 0;
+        for (auto const& property : element.properties) {
+          if (property.isList) {
+            if (list != nullptr || !ply_is_integer(property.type)) return false;
+            if (property.name != "vertex_indices" && property.name != "vertex_index") return false;
+            list = &property;
+          }
+          else (list ? after : before) += ply_scalar_size(property.type);
+        }
+        if (list == nullptr) return false;
+        size_t const countSize = ply_scalar_size(list->countType);
+        size_t const indexSize = ply_scalar_size(list->type);
+        PlyScalar const countType = list->countType, indexType = list->type;
+        mesh.indices.clear();
+        mesh.indices.reserve(element.count * 3);
+        for (size_t f = 0; f < element.count; ++f) {
+          if (size_t(end - cursor) < before + countSize) return false;
+          cursor += before;
+          uint32_t const n = ply_read_integer(cursor, countType, swap);
+          cursor += countSize;
+          if (size_t(end - cursor) / indexSize < n || size_t(end - cursor) - n * indexSize < after) return false;
+          if (n == 3 && indexSize == 4) {
+            // the common case, a triangle of 32-bit indices
+            size_t const base = mesh.indices.size();
+            mesh.indices.resize(base + 3);
+            std::memcpy(&mesh.indices[base], cursor, 12);
+            if (swap) byteswap32(&mesh.indices[base], 3);
+          }
+          else if (n >= 3) {
+            // fan around the first corner
+            uint32_t const v0 = ply_read_integer(cursor, indexType, swap);
+            uint32_t prev = ply_read_integer(cursor + indexSize, indexType, swap);
+            for (uint32_t k = 2; k < n; ++k) {
+              uint32_t const v = ply_read_integer(cursor + k * indexSize, indexType, swap);
+              mesh.indices.insert(mesh.indices.end(), { v0, prev, v });
+              prev = v;
+            }
+          }
+          cursor += n * indexSize + after;
+        }
+        haveFaces = true;
+      }
+      else {
+        // skip elements before the ones we read, a list in them is left to happly
+        if (recordSize == 0 && element.count != 0) return false;
+        if (size_t(end - cursor) / std::max<size_t>(recordSize, 1) < element.count) return false;
+        cursor += element.count * recordSize;
+      }
+    }
+    return haveVertices && haveFaces;
+  }
+
+  static auto read_ply_happly(std::string const& path, PlyMesh& mesh) noexcept -> bool {
+    try {
+      happly::PLYData ply(path);
+      std::vector<std::array<double, 3>> const positions = ply.getVertexPositions();
+      std::vector<std::vector<size_t>> const faces = ply.getFaceIndices<size_t>();
+      mesh.positions.resize(positions.size() * 3);
+      for (size_t i = 0; i < positions.size(); ++i)
+        for (size_t c = 0; c < 3; ++c)
+          mesh.positions[i * 3 + c] = float(positions[i][c]);
+      mesh.indices.clear();
+      for (auto const& face : faces)
+        for (size_t k = 2; k < face.size(); ++k)
+          mesh.indices.insert(mesh.indices.end(),
+            { uint32_t(face[0]), uint32_t(face[k - 1]), uint32_t(face[k]) });
+    }
+    catch (std::exception const& e) {
+      se::error("gfx :: ply :: failed to read '{}': {}", path, e.what());
+      return false;
+    }
+    return true;
+  }
+
+  auto load_ply_mesh(std::string path, Scene& scene) noexcept -> MeshHandle {
+    PROFILE_SCOPE_FUNCTION();
+    scene.m_sourceFiles.push_back(path);
+    if (!std::filesystem::exists(path)) {
+      se::error("gfx :: ply :: mesh file '{}' does not exist", path);
+      return MeshHandle{};
+    }
+    PlyMesh ply;
+    if (!read_ply_binary(path, ply) && !read_ply_happly(path, ply))
+      return MeshHandle{};
+    size_t const vertexCount = ply.positions.size() / 3;
+    for (uint32_t index : ply.indices)
+      if (index >= vertexCount) {
+        se::error("gfx :: ply :: '{}' has a face index out of range", path);
+        return MeshHandle{};
+      }
+
+    // floats of a vertex besides the position, in layout order
+    size_t vertexStride = 0;
+    for (auto const& entry : defaultMeshDataLayout.layout) {
+      switch (entry.info) {
+      case MeshDataLayout::VertexInfo::POSITION:
+        if (entry.format != rhi::VertexFormat::FLOAT32X3) {
+          se::error("gfx :: ply :: unwanted vertex format for POSITION attributes.");
+          return MeshHandle{};
+        } break;
+      case MeshDataLayout::VertexInfo::UV: vertexStride += 2; break;
+      case MeshDataLayout::VertexInfo::CUSTOM: break;
+      default: vertexStride += 3; break;
+      }
+    }
+
+    // every triangle gets its own corners with the face normal
+    size_t const cornerCount = ply.indices.size();
+    std::vector<float> positionBufferV(defaultMeshLoadConfig.usePositionBuffer ? cornerCount * 3 : 0);
+    std::vector<float> vertexBufferV(cornerCount * vertexStride, 0.f);
+    std::vector<uint32_t> indexBufferWV(cornerCount);
+    vec3 position_max = vec3(-1e9);
+    vec3 position_min = vec3(1e9);
+    float* vertex = vertexBufferV.data();
+    for (size_t t = 0; t < cornerCount / 3; ++t) {
+      vec3 positions[3];
+      for (size_t v = 0; v < 3; ++v) {
+        float const* p = &ply.positions[size_t(ply.indices[t * 3 + v]) * 3];
+        positions[v] = { p[0], p[1], p[2] };
+        position_min = se::min(position_min, positions[v]);
+        position_max = se::max(position_max, positions[v]);
+      }
+      vec3 const normal = normalize(cross(positions[1] - positions[0], positions[2] - positions[0]));
+      for (size_t v = 0; v < 3; ++v) {
+        size_t const corner = t * 3 + v;
+        if (defaultMeshLoadConfig.usePositionBuffer) {
+          positionBufferV[corner * 3 + 0] = positions[v].x;
+          positionBufferV[corner * 3 + 1] = positions[v].y;
+          positionBufferV[corner * 3 + 2] = positions[v].z;
+        }
+        for (auto const& entry : defaultMeshDataLayout.layout) {
+          if (entry.info == MeshDataLayout::VertexInfo::NORMAL) {
+            vertex[0] = normal.x; vertex[1] = normal.y; vertex[2] = normal.z;
+          }
+          // uv, tangent and color stay zero
+          if (entry.info == MeshDataLayout::VertexInfo::UV) vertex += 2;
+          else if (entry.info != MeshDataLayout::VertexInfo::POSITION &&
+            entry.info != MeshDataLayout::VertexInfo::CUSTOM) vertex += 3;
+        }
+        indexBufferWV[corner] = uint32_t(corner);
+      }
+    }
+
+    // create mesh resource
+    MeshHandle mesh = GFXContext::create_mesh_empty();
+    Mesh::MeshPrimitive sePrimitive;
+    sePrimitive.offset = 0;
+    sePrimitive.size = cornerCount;
+    sePrimitive.baseVertex = 0;
+    sePrimitive.numVertex = cornerCount;
+    sePrimitive.max = position_max;
+    sePrimitive.min = position_min;
+    mesh.get()->m_primitives.emplace_back(std::move(sePrimitive));
+
+    optimize_mesh(*mesh.get(), positionBufferV, vertexBufferV, indexBufferWV);
+    mesh->m_contentHash = hash_mesh_payload(*mesh.get(), positionBufferV, vertexBufferV, indexBufferWV);
+    upload_mesh_payload(*mesh.get(), positionBufferV, vertexBufferV, indexBufferWV, false);
+    return mesh;
+  }
+}
+}
@@ -0,0 +1,370 @@
+#include "se.gfx.hpp"
+#include "se.gfx.scene-loader.hpp"
+#include <algorithm>
+#include <fstream>
+#include <future>
+#include <numeric>
+#include <unordered_set>
+
+namespace se {
+namespace gfx {
+  // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+  // ┃ Geometry Store                                                            ┃
+  // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+
+  static constexpr char store_magic[8] = { 'S', 'E', 'G', 'E', 'O', 0, 0, 1 };
+
+  // magic, then the offset and the size of the chunk table
+  struct StoreHeader {
+    char magic[8];
+    uint64_t tableOffset;
+    uint64_t chunkCount;
+  };
+
+  auto GeometryStore::write(std::string const& path, size_t count,
+    std::function<MeshPayload(size_t)> const& payload) noexcept -> std::shared_ptr<GeometryStore> {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      se::error("gfx :: streaming :: cannot write geometry store {}", path);
+      return nullptr;
+    }
+    auto store = std::make_shared<GeometryStore>();
+    store->m_path = path;
+    StoreHeader header = {};
+    file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    uint64_t offset = sizeof(header);
+    for (size_t i = 0; i < count; ++i) {
+      MeshPayload const chunk_payload = payload(i);
+      Chunk chunk = { offset, chunk_payload.positions.size(),
+        chunk_payload.vertices.size(), chunk_payload.indices.size() };
+      for (auto const* bytes : { &chunk_payload.positions, &chunk_payload.vertices, &chunk_payload.indices })
+        file.write(reinterpret_cast<char const*>(bytes->data()), std::streamsize(bytes->size()));
+      offset += chunk.positions + chunk.vertices + chunk.indices;
+      store->m_chunks.push_back(chunk);
+    }
+    file.write(reinterpret_cast<char const*>(store->m_chunks.data()),
+      std::streamsize(store->m_chunks.size() * sizeof(Chunk)));
+    memcpy(header.magic, store_magic, sizeof(store_magic));
+    header.tableOffset = offset;
+    header.chunkCount = store->m_chunks.size();
+    file.seekp(0);
+    file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    if (!file) {
+      se::error("gfx :: streaming :: failed writing geometry store {}", path);
+      return nullptr;
+    }
+    return store;
+  }
+
+  auto GeometryStore::open(std::string const& path) noexcept -> std::shared_ptr<GeometryStore> {
+    std::ifstream file(path, std::ios::binary);
+    StoreHeader header = {};
+    if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header))
+      || memcmp(header.magic, store_magic, sizeof(store_magic)) != 0) {
+      se::error("gfx :: streaming :: {} is not a geometry store", path);
+      return nullptr;
+    }
+    auto store = std::make_shared<GeometryStore>();
+    store->m_path = path;
+    store->m_chunks.resize(header.chunkCount);
+    file.seekg(std::streamoff(header.tableOffset));
+    if (!file.read(reinterpret_cast<char*>(store->m_chunks.data()),
+      std::streamsize(header.chunkCount * sizeof(Chunk)))) {
+      se::error("gfx :: streaming :: truncated chunk table in {}", path);
+      return nullptr;
+    }
+    return store;
+  }
+
+  auto GeometryStore::read(int32_t chunk) const noexcept -> MeshPayload {
+    MeshPayload payload;
+    if (chunk < 0 || chunk >= int32_t(m_chunks.size())) return payload;
+    Chunk const& entry = m_chunks[chunk];
+    // a stream per read, so reads of different threads never share a cursor
+    std::ifstream file(m_path, std::ios::binary);
+    file.seekg(std::streamoff(entry.offset));
+    payload.positions.resize(entry.positions);
+    payload.vertices.resize(entry.vertices);
+    payload.indices.resize(entry.indices);
+    for (auto* bytes : { &payload.positions, &payload.vertices, &payload.indices })
+      file.read(reinterpret_cast<char*>(bytes->data()), std::streamsize(bytes->size()));
+    if (!file) se::error("gfx :: streaming :: failed reading chunk {} of {}", chunk, m_path);
+    return payload;
+  }
+
+  auto GeometryStore::chunk_bytes(int32_t chunk) const noexcept -> uint64_t {
+    Chunk const& entry = m_chunks[chunk];
+    return entry.positions + entry.vertices + entry.indices;
+  }
+
+  // ┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓
+  // ┃ Geometry Streamer                                                         ┃
+  // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
+
+  /** Residency of the chunks of a geometry store. A chunk is the payload of
+   * the meshes sharing one set of buffers, they become resident together. */
+  struct GeometryStreamer {
+    struct Chunk {
+      std::vector<MeshHandle> meshes;
+      uint64_t bytes = 0;
+      vec3 center;
+      float radius = 0.f;
+      // projected radius in pixels at the last scoring
+      float pixels = 0.f;
+      bool resident = false;
+      bool wanted = false;
+      // the payload being read, valid while loading
+      std::future<MeshPayload> load;
+      // the arena takes a copy of the payload, the buffers are dropped after
+      bool arenaCopied = false;
+    };
+    std::shared_ptr<GeometryStore> store;
+    std::vector<Chunk> chunks;
+    uint64_t residentBytes = 0;
+    uint64_t frame = 0;
+    std::vector<Scene::ViewMetrics> scoredViews;
+
+    // device objects of evicted chunks, kept until no frame in flight reads them
+    struct Retired {
+      uint64_t frame;
+      std::vector<std::unique_ptr<rhi::Buffer>> buffers;
+      std::vector<std::unique_ptr<rhi::BLAS>> blases;
+    };
+    std::vector<Retired> retired;
+    static constexpr uint64_t retireFrames = 3;
+  };
+
+  // the scene no longer references the device payload of the mesh
+  static auto unregister_mesh(Scene::GPUScene& gpu, bool arena, Mesh* mesh) noexcept -> void {
+    auto iter = gpu.meshList.find(mesh);
+    if (iter == gpu.meshList.end()) return;
+    if (arena) gpu.geometryArena.remove(mesh);
+    else {
+      gpu.positionBuffer.remove(iter->second.assignedIndex);
+      gpu.vertexBuffer.remove(iter->second.assignedIndex);
+      gpu.indexBuffer.remove(iter->second.assignedIndex);
+    }
+    gpu.meshList.erase(iter);
+  }
+
+  static auto evict(Scene::GPUScene& gpu, bool arena, GeometryStreamer& streamer,
+    GeometryStreamer::Chunk& chunk) noexcept -> void {
+    GeometryStreamer::Retired retired = { streamer.frame };
+    for (MeshHandle& handle : chunk.meshes) {
+      Mesh* mesh = handle.get();
+      unregister_mesh(gpu, arena, mesh);
+      for (auto& primitive : mesh->m_primitives) {
+        for (auto* blas : { &primitive.primBlas, &primitive.backBlas,
+          &primitive.primUVBlas, &primitive.backUVBlas })
+          if (*blas) retired.blases.emplace_back(std::move(*blas));
+        // rebuilt from the buffers of the next residency
+        primitive.blasDesc.triangleGeometries.clear();
+      }
+      mesh->m_streaming.resident = false;
+    }
+    Mesh* mesh = chunk.meshes.front().get();
+    for (Buffer* buffer : { mesh->m_positionBuffer.get(), mesh->m_vertexBuffer.get(), mesh->m_indexBuffer.get() }) {
+      if (buffer->m_buffer) retired.buffers.emplace_back(std::move(buffer->m_buffer));
+      if (buffer->m_previous) retired.buffers.emplace_back(std::move(buffer->m_previous));
+      std::vector<std::byte>().swap(buffer->m_host);
+    }
+    streamer.retired.emplace_back(std::move(retired));
+    if (chunk.resident) streamer.residentBytes -= chunk.bytes;
+    chunk.resident = false;
+    chunk.arenaCopied = false;
+  }
+
+  static auto make_resident(GeometryStreamer& streamer, GeometryStreamer::Chunk& chunk,
+    MeshPayload& payload) noexcept -> void {
+    Mesh* mesh = chunk.meshes.front().get();
+    auto const usages = mesh_buffer_usages();
+    Buffer* buffers[3] = { mesh->m_positionBuffer.get(), mesh->m_vertexBuffer.get(), mesh->m_indexBuffer.get() };
+    std::vector<std::byte>* bytes[3] = { &payload.positions, &payload.vertices, &payload.indices };
+    for (int i = 0; i < 3; ++i)
+      buffers[i]->m_buffer = GFXContext::device()->create_device_local_buffer(
+        static_cast<void const*>(bytes[i]->data()), uint32_t(bytes[i]->size()), usages[i]);
+    for (MeshHandle& handle : chunk.meshes)
+      handle->m_streaming.resident = true;
+    streamer.residentBytes += chunk.bytes;
+    chunk.resident = true;
+  }
+
+  auto Scene::stream_geometry(std::string const& path) noexcept -> bool {
+    // emitters build their lights from the payload, they stay resident
+    std::unordered_set<Mesh*> emitters;
+    for (auto [entity, renderer, light] : m_registry.view<MeshRenderer, Light>().each())
+      emitters.insert(renderer.m_mesh.get());
+    // meshes sharing the buffers of a deduplicated payload share a chunk
+    std::vector<std::vector<MeshHandle>> groups;
+    std::unordered_map<Buffer*, size_t> group_of;
+    std::unordered_set<Mesh*> seen;
+    for (auto [entity, renderer] : m_registry.view<MeshRenderer>().each()) {
+      Mesh* mesh = renderer.m_mesh.get();
+      if (mesh == nullptr || !seen.insert(mesh).second) continue;
+      if (mesh->m_streaming.store || emitters.count(mesh) > 0) continue;
+      if (mesh->m_primitives.empty() || !mesh->m_customPrimitives.empty()) continue;
+      auto [iter, inserted] = group_of.emplace(mesh->m_positionBuffer.get(), groups.size());
+      if (inserted) groups.emplace_back();
+      groups[iter->second].push_back(renderer.m_mesh);
+    }
+    if (groups.empty()) {
+      se::info("gfx :: streaming :: no mesh of scene {} to stream", m_name);
+      return false;
+    }
+
+    // one chunk at a time, the host copies are dropped once written
+    std::shared_ptr<GeometryStore> store = GeometryStore::write(path, groups.size(),
+      [&](size_t i) -> MeshPayload {
+        Mesh* mesh = groups[i].front().get();
+        mesh->fetch_host();
+        for (MeshHandle& handle : groups[i])
+          handle->m_streaming.proxy = build_mesh_proxy(*handle.get());
+        return MeshPayload{ mesh->m_positionBuffer->m_host,
+          mesh->m_vertexBuffer->m_host, mesh->m_indexBuffer->m_host };
+      });
+    if (store == nullptr) return false;
+
+    auto streamer = m_gpuScene.streamer ? m_gpuScene.streamer : std::make_shared<GeometryStreamer>();
+    if (streamer->store) {
+      se::error("gfx :: streaming :: scene {} already streams from {}", m_name, streamer->store->m_path);
+      return false;
+    }
+    streamer->store = store;
+    uint64_t stored = 0;
+    for (size_t i = 0; i < groups.size(); ++i) {
+      GeometryStreamer::Chunk chunk;
+      chunk.meshes = std::move(groups[i]);
+      chunk.bytes = store->chunk_bytes(int32_t(i));
+      // the sphere around the bounds of all primitives
+      Mesh* mesh = chunk.meshes.front().get();
+      vec3 pmin = mesh->m_primitives.front().min, pmax = mesh->m_primitives.front().max;
+      for (auto const& primitive : mesh->m_primitives) {
+        pmin = se::min(pmin, primitive.min);
+        pmax = se::max(pmax, primitive.max);
+      }
+      chunk.center = (pmin + pmax) * 0.5f;
+      chunk.radius = (pmax - pmin).length() * 0.5f;
+      for (MeshHandle& handle : chunk.meshes) {
+        handle->m_streaming.store = store;
+        handle->m_streaming.chunk = int32_t(i);
+      }
+      chunk.resident = true;
+      streamer->residentBytes += chunk.bytes;
+      evict(m_gpuScene, m_geometryArena, *streamer, chunk);
+      stored += chunk.bytes;
+      streamer->chunks.emplace_back(std::move(chunk));
+    }
+    m_gpuScene.streamer = streamer;
+    // every renderer of a streamed mesh switches to its proxy
+    for (auto entity : m_registry.view<MeshRenderer>())
+      if (m_registry.get<MeshRenderer>(entity).m_mesh->m_streaming.store)
+        m_registry.patch<MeshRenderer>(entity, [](MeshRenderer& renderer) { renderer.m_dirtyToGPU = true; });
+    se::info("gfx :: streaming :: {} chunks, {} MB moved from scene {} to {}",
+      streamer->chunks.size(), stored >> 20, m_name, path);
+    return true;
+  }
+
+  auto Scene::update_gpu_streaming() noexcept -> void {
+    if (m_gpuScene.streamer == nullptr) return;
+    GeometryStreamer& streamer = *m_gpuScene.streamer;
+    streamer.frame++;
+    // device objects of evictions no frame in flight can read any more
+    streamer.retired.erase(std::remove_if(streamer.retired.begin(), streamer.retired.end(),
+      [&](GeometryStreamer::Retired const& retired) {
+        return retired.frame + GeometryStreamer::retireFrames <= streamer.frame; }),
+      streamer.retired.end());
+    // the arena copied the chunks made resident last update
+    if (m_geometryArena) {
+      for (auto& chunk : streamer.chunks) {
+        if (!chunk.resident || chunk.arenaCopied) continue;
+        Mesh* mesh = chunk.meshes.front().get();
+        if (m_gpuScene.geometryArena.find(mesh->drawn()) == nullptr) continue;
+        GeometryStreamer::Retired retired = { streamer.frame };
+        for (Buffer* buffer : { mesh->m_positionBuffer.get(), mesh->m_vertexBuffer.get(), mesh->m_indexBuffer.get() })
+          if (buffer->m_buffer) retired.buffers.emplace_back(std::move(buffer->m_buffer));
+        streamer.retired.emplace_back(std::move(retired));
+        chunk.arenaCopied = true;
+      }
+    }
+
+    // score the chunks by their largest projected radius, again only when
+    // the view or the renderers moved
+    std::vector<ViewMetrics> const views = view_metrics();
+    if (views.empty()) return;
+    bool const view_changed = streamer.scoredViews != views;
+    if (view_changed || !m_changes.transforms.entries.empty() || !m_changes.renderers.entries.empty()) {
+      for (auto& chunk : streamer.chunks) chunk.pixels = 0.f;
+      for (auto [entity, transform, renderer] : m_registry.view<Transform, MeshRenderer>().each()) {
+        int32_t const index = renderer.m_mesh->m_streaming.chunk;
+        if (index < 0 || renderer.m_mesh->m_streaming.store != streamer.store) continue;
+        GeometryStreamer::Chunk& chunk = streamer.chunks[index];
+        chunk.pixels = std::max(chunk.pixels, chunk.radius
+          * pixel_scale(views, transform, renderer, chunk.center, chunk.radius));
+      }
+      streamer.scoredViews = views;
+    }
+
+    // the largest chunks on screen are wanted, as many as the budget holds
+    std::vector<size_t> order(streamer.chunks.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return streamer.chunks[a].pixels > streamer.chunks[b].pixels; });
+    uint64_t planned = 0;
+    for (size_t index : order) {
+      GeometryStreamer::Chunk& chunk = streamer.chunks[index];
+      chunk.wanted = chunk.pixels >= m_streamingConfig.minPixels
+        && planned + chunk.bytes <= m_streamingConfig.budget;
+      if (chunk.wanted) planned += chunk.bytes;
+    }
+
+    std::unordered_set<Mesh*> switched;
+    for (auto& chunk : streamer.chunks) {
+      if (chunk.resident && !chunk.wanted) {
+        evict(m_gpuScene, m_geometryArena, streamer, chunk);
+        for (MeshHandle& handle : chunk.meshes) switched.insert(handle.get());
+      }
+    }
+    // finished reads become resident if still wanted
+    uint32_t loading = 0;
+    for (auto& chunk : streamer.chunks) {
+      if (!chunk.load.valid()) continue;
+      if (chunk.load.wait_for(std::chrono::seconds(0)) != std::future_status::ready) { loading++; continue; }
+      MeshPayload payload = chunk.load.get();
+      if (!chunk.wanted) continue;
+      make_resident(streamer, chunk, payload);
+      for (MeshHandle& handle : chunk.meshes) switched.insert(handle.get());
+    }
+    // start reads in order of screen size
+    for (size_t index : order) {
+      if (loading >= m_streamingConfig.maxLoads) break;
+      GeometryStreamer::Chunk& chunk = streamer.chunks[index];
+      if (!chunk.wanted) break;
+      if (chunk.resident || chunk.load.valid()) continue;
+      chunk.load = std::async(std::launch::async,
+        [store = streamer.store, index]() { return store->read(int32_t(index)); });
+      loading++;
+    }
+
+    // renderers of switched meshes rewrite their records and TLAS instances
+    if (!switched.empty()) {
+      for (auto entity : m_registry.view<MeshRenderer>())
+        if (switched.count(m_registry.get<MeshRenderer>(entity).m_mesh.get()) > 0)
+          m_registry.patch<MeshRenderer>(entity, [](MeshRenderer& renderer) { renderer.m_dirtyToGPU = true; });
+    }
+  }
+
+  auto Scene::streaming_stats() const noexcept -> StreamingStats {
+    StreamingStats stats;
+    if (m_gpuScene.streamer == nullptr) return stats;
+    GeometryStreamer const& streamer = *m_gpuScene.streamer;
+    stats.chunks = streamer.chunks.size();
+    for (auto const& chunk : streamer.chunks) {
+      if (chunk.resident) stats.resident++;
+      if (chunk.load.valid()) stats.loading++;
+      stats.storedBytes += chunk.bytes;
+    }
+    stats.residentBytes = streamer.residentBytes;
+    return stats;
+  }
+}
+}
@@ -1,11 +1,15 @@
 #include <tinyparser-mitsuba.h>
+#include <tinyxml2.h>
 #include "se.gfx.hpp"
 #include "se.gfx.scene-loader.hpp"
 #include "se.editor.hpp"
+#include <cstring>
 #include <filesystem>
+#include <functional>
+#include <string_view>
+#include <unordered_set>
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tinyobjloader/tiny_obj_loader.h>
-#include <happly/happly.hpp>
 
 namespace se {
 namespace gfx {
@@ -118,6 +122,33 @@ namespace gfx {
     return texture;
   }
 
+  // objects may be referenced from several places, each is visited once
+  static auto gatherXMLTextures(TPM_NAMESPACE::Object const* node,
+    std::unordered_set<TPM_NAMESPACE::Object const*>& visited,
+    std::vector<TPM_NAMESPACE::Object const*>& textures) noexcept -> void {
+    if (node == nullptr || !visited.insert(node).second) return;
+    if (node->type() == TPM_NAMESPACE::OT_TEXTURE && node->properties().count("filename"))
+      textures.push_back(node);
+    for (auto& child : node->anonymousChildren()) gatherXMLTextures(child.get(), visited, textures);
+    for (auto& child : node->namedChildren()) gatherXMLTextures(child.second.get(), visited, textures);
+  }
+
+  // decode all texture files of the scene together, before the materials
+  // ask for them one at a time
+  auto preloadXMLTextures(TPM_NAMESPACE::Object const* root,
+    xmlLoaderEnv* env) noexcept -> void {
+    std::vector<TPM_NAMESPACE::Object const*> nodes;
+    std::unordered_set<TPM_NAMESPACE::Object const*> visited;
+    gatherXMLTextures(root, visited, nodes);
+    std::vector<std::string> paths;
+    paths.reserve(nodes.size());
+    for (auto* node : nodes)
+      paths.push_back(env->directory + "/" + node->property("filename").getString());
+    std::vector<TextureHandle> textures = GFXContext::load_texture_files(paths);
+    for (size_t i = 0; i < nodes.size(); ++i)
+      if (textures[i].get() != nullptr) env->textures[nodes[i]] = textures[i];
+  }
+
   auto loadXMLMaterial(TPM_NAMESPACE::Object const* node,
     xmlLoaderEnv* env) noexcept -> gfx::MaterialHandle {
     PROFILE_SCOPE_FUNCTION();
@@ -240,6 +271,7 @@ namespace gfx {
 
   auto load_obj_mesh(std::string path, Scene& scene) noexcept -> MeshHandle {
     PROFILE_SCOPE_FUNCTION();
+    scene.m_sourceFiles.push_back(path);
     // load obj file
     tinyobj::ObjReaderConfig reader_config;
     reader_config.mtl_search_path =
@@ -433,21 +465,16 @@ namespace gfx {
             }
           }
 
-          if (defaultMeshLoadConfig.deduplication) {
-            se::error("obj vertex deduplication is not impl yet.");
-          }
-          else {
-            vertexBufferV.insert(vertexBufferV.end(), vertex.begin(),
-              vertex.end());
-            positionBufferV.insert(positionBufferV.end(), position.begin(),
-              position.end());
-            // index filling
-            if (defaultMeshLoadConfig.layout.format == rhi::IndexFormat::UINT16_t)
-              indexBufferWV.push_back(vertex_offset);
-            else if (defaultMeshLoadConfig.layout.format == rhi::IndexFormat::UINT32_T)
-              indexBufferWV.push_back(vertex_offset);
-            ++vertex_offset;
-          }
+          vertexBufferV.insert(vertexBufferV.end(), vertex.begin(),
+            vertex.end());
+          positionBufferV.insert(positionBufferV.end(), position.begin(),
+            position.end());
+          // index filling
+          if (defaultMeshLoadConfig.layout.format == rhi::IndexFormat::UINT16_t)
+            indexBufferWV.push_back(vertex_offset);
+          else if (defaultMeshLoadConfig.layout.format == rhi::IndexFormat::UINT32_T)
+            indexBufferWV.push_back(vertex_offset);
+          ++vertex_offset;
         }
         index_offset += fv;
         // per-face material
@@ -468,204 +495,10 @@ namespace gfx {
       submesh_index_offset = global_index_offset;
       submesh_vertex_offset += positionBufferV.size() / 3 - submesh_vertex_offset;
     }
-    { // register mesh
-      PROFILE_SCOPE_NAME(UploadGPUBuffer);
-      MiniBuffer buffer;
-      buffer.m_isReference = true;
-
-      buffer.m_data = positionBufferV.data();
-      buffer.m_size = sizeof(float) * positionBufferV.size();
-
-      bool need_rt = bool(gfx::GFXContext::device()->from_which_adapter()->from_which_context()
-        ->get_context_extensions_flags() & rhi::ContextExtensionEnum::RAY_TRACING);
-      Flags<rhi::BufferUsageEnum> rt_usage = 0;
-      if (need_rt) rt_usage |= rhi::BufferUsageEnum::ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY;
-
-      mesh->m_positionBuffer = gfx::GFXContext::create_buffer_host(buffer,
-        rhi::BufferUsageEnum::STORAGE |
-        rhi::BufferUsageEnum::SHADER_DEVICE_ADDRESS | rt_usage);
-      mesh->m_positionBuffer->m_job = "Mesh position buffer";
-      mesh->m_positionBuffer->m_host.resize(buffer.m_size);
-      memcpy(mesh->m_positionBuffer->m_host.data(), buffer.m_data, buffer.m_size);
-
-      buffer.m_data = indexBufferWV.data();
-      buffer.m_size = sizeof(uint32_t) * indexBufferWV.size();
-      mesh->m_indexBuffer = gfx::GFXContext::create_buffer_host(buffer,
-        rhi::BufferUsageEnum::INDEX |
-        rhi::BufferUsageEnum::SHADER_DEVICE_ADDRESS | rt_usage);
-      mesh->m_indexBuffer->m_job = "Mesh index buffer";
-      mesh->m_indexBuffer->m_host.resize(buffer.m_size);
-      memcpy(mesh->m_indexBuffer->m_host.data(), buffer.m_data, buffer.m_size);
-
-      buffer.m_data = vertexBufferV.data();
-      buffer.m_size = sizeof(uint32_t) * vertexBufferV.size();
-      mesh->m_vertexBuffer = gfx::GFXContext::create_buffer_host(buffer,
-        rhi::BufferUsageEnum::STORAGE |
-        rhi::BufferUsageEnum::SHADER_DEVICE_ADDRESS);
-      mesh->m_vertexBuffer->m_job = "Mesh vertex buffer";
-      mesh->m_vertexBuffer->m_host.resize(buffer.m_size);
-      memcpy(mesh->m_vertexBuffer->m_host.data(), buffer.m_data, buffer.m_size);
-      PROFILE_SCOPE_STOP(UploadGPUBuffer);
-    }
-    return mesh;
-  }
-
-  auto loadPlyMesh(std::string path, Scene& scene) noexcept -> MeshHandle {
-    PROFILE_SCOPE_FUNCTION();
-    // Construct a data object by reading from file
-    happly::PLYData plyIn(path);
-    // Get mesh-style data from the object
-    std::vector<std::array<double, 3>> vPos = plyIn.getVertexPositions();
-    std::vector<std::vector<size_t>> fInd = plyIn.getFaceIndices<size_t>();
-
-    std::vector<float> vertexBufferV = {};
-    std::vector<float> positionBufferV = {};
-    std::vector<uint32_t> indexBufferWV = {};
-    // create mesh resource
-    MeshHandle mesh = GFXContext::create_mesh_empty();
-
-    // translate the shape to se format
-    uint32_t vertex_offset = 0;
-    vec3 position_max = vec3(-1e9);
-    vec3 position_min = vec3(1e9);
-    // Loop over faces(polygon)
-    size_t index_offset = 0;
-    for (size_t f = 0; f < fInd.size(); f++) {
-      std::vector<size_t> const& faceInd = fInd[f];
-      // require tangent
-      if (faceInd.size() != 3) {
-        se::error(
-          "GFX :: SceneNodeLoader_obj :: non-triangle geometry not "
-          "supported when required TANGENT attribute now.");
-        return MeshHandle{};
-      }
-
-      vec3 tangent = {};
-      vec3 bitangent = {};
-
-      vec3 positions[3];
-      for (size_t v = 0; v < 3; v++) {
-        // index finding
-        size_t idx = faceInd[index_offset + v];
-        positions[v] = { float(vPos[idx][0]), float(vPos[idx][1]), float(vPos[idx][2]) };
-      }
-      vec3 edge1 = positions[1] - positions[0];
-      vec3 edge2 = positions[2] - positions[0];
-      vec3 normal = normalize(cross(edge1, edge2));
-
-      // Loop over vertices in the face.
-      for (size_t v = 0; v < faceInd.size(); v++) {
-        // index finding
-        size_t idx = faceInd[index_offset + v];
-        // atrributes filling
-        std::vector<float> vertex = {};
-        std::vector<float> position = {};
-
-        for (auto const& entry : defaultMeshDataLayout.layout) {
-          // vertex position
-          if (entry.info == MeshDataLayout::VertexInfo::POSITION) {
-            if (entry.format == rhi::VertexFormat::FLOAT32X3) {
-              float vx = vPos[idx][0];
-              float vy = vPos[idx][1];
-              float vz = vPos[idx][2];
-              vertex.push_back(vx);
-              vertex.push_back(vy);
-              vertex.push_back(vz);
-              position_min = se::min(position_min, vec3{ vx,vy,vz });
-              position_max = se::max(position_max, vec3{ vx,vy,vz });
-              if (defaultMeshLoadConfig.usePositionBuffer) {
-                position.push_back(vx);
-                position.push_back(vy);
-                position.push_back(vz);
-              }
-            }
-            else {
-              se::error(
-                "GFX :: SceneNodeLoader_obj :: unwanted vertex format for "
-                "POSITION attributes.");
-              return MeshHandle{};
-            }
-          }
-          else if (entry.info == MeshDataLayout::VertexInfo::NORMAL) {
-            vertex.push_back(normal.x);
-            vertex.push_back(normal.y);
-            vertex.push_back(normal.z);
-          }
-          else if (entry.info == MeshDataLayout::VertexInfo::UV) {
-            vertex.push_back(0);
-            vertex.push_back(0);
-          }
-          else if (entry.info == MeshDataLayout::VertexInfo::TANGENT) {
-            vertex.push_back(tangent.x);
-            vertex.push_back(tangent.y);
-            vertex.push_back(tangent.z);
-          }
-          else if (entry.info == MeshDataLayout::VertexInfo::COLOR) {
-            vertex.push_back(0);
-            vertex.push_back(0);
-            vertex.push_back(0);
-          }
-          else if (entry.info == MeshDataLayout::VertexInfo::CUSTOM) {
-          }
-        }
-        //
-        {
-          vertexBufferV.insert(vertexBufferV.end(), vertex.begin() + 3, vertex.end());
-          positionBufferV.insert(positionBufferV.end(), position.begin(), position.end());
-          // index filling
-          if (defaultMeshLoadConfig.layout.format == rhi::IndexFormat::UINT16_t)
-            indexBufferWV.push_back(vertex_offset);
-          else if (defaultMeshLoadConfig.layout.format == rhi::IndexFormat::UINT32_T)
-            indexBufferWV.push_back(vertex_offset);
-          ++vertex_offset;
-        }
-      }
-
-    }
-
-    index_offset += fInd.size() * 3;
-
-    // load Material
-    Mesh::MeshPrimitive sePrimitive;
-    sePrimitive.offset = 0;
-    sePrimitive.size = index_offset;
-    sePrimitive.baseVertex = 0;
-    sePrimitive.numVertex = positionBufferV.size() / 3 - 0;
-    sePrimitive.max = position_max;
-    sePrimitive.min = position_min;
-    mesh.get()->m_primitives.emplace_back(std::move(sePrimitive));
-
-    { // register mesh
-      MiniBuffer buffer;
-      buffer.m_isReference = true;
-
-      buffer.m_data = positionBufferV.data();
-      buffer.m_size = sizeof(float) * positionBufferV.size();
-
-      bool need_rt = bool(gfx::GFXContext::device()->from_which_adapter()->from_which_context()
-        ->get_context_extensions_flags() & rhi::ContextExtensionEnum::RAY_TRACING);
-      Flags<rhi::BufferUsageEnum> rt_usage = 0;
-      if (need_rt) rt_usage |= rhi::BufferUsageEnum::ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY;
-
-      mesh->m_positionBuffer = gfx::GFXContext::create_buffer_host(buffer,
-        rhi::BufferUsageEnum::STORAGE |
-        rhi::BufferUsageEnum::SHADER_DEVICE_ADDRESS | rt_usage);
-      mesh->m_positionBuffer->m_job = "Mesh position buffer";
-
-      buffer.m_data = indexBufferWV.data();
-      buffer.m_size = sizeof(uint32_t) * indexBufferWV.size();
-      mesh->m_indexBuffer = gfx::GFXContext::create_buffer_host(buffer,
-        rhi::BufferUsageEnum::INDEX |
-        rhi::BufferUsageEnum::SHADER_DEVICE_ADDRESS | rt_usage);
-      mesh->m_indexBuffer->m_job = "Mesh index buffer";
-
-      buffer.m_data = vertexBufferV.data();
-      buffer.m_size = sizeof(uint32_t) * vertexBufferV.size();
-      mesh->m_vertexBuffer = gfx::GFXContext::create_buffer_host(buffer,
-        rhi::BufferUsageEnum::STORAGE |
-        rhi::BufferUsageEnum::SHADER_DEVICE_ADDRESS);
-      mesh->m_vertexBuffer->m_job = "Mesh vertex buffer";
-    }
+    optimize_mesh(*mesh.get(), positionBufferV, vertexBufferV, indexBufferWV);
+    mesh->m_contentHash = hash_mesh_payload(*mesh.get(), positionBufferV, vertexBufferV, indexBufferWV);
+    upload_mesh_payload(*mesh.get(), positionBufferV, vertexBufferV, indexBufferWV,
+      defaultMeshLoadConfig.residentOnHost);
     return mesh;
   }
 
@@ -793,7 +626,7 @@ namespace gfx {
     else if (node->pluginType() == "ply") {
       std::string filename = node->property("filename").getString();
       std::string obj_path = env->directory + "/" + filename;
-      MeshHandle mesh = loadPlyMesh(obj_path, *scene);
+      MeshHandle mesh = load_ply_mesh(obj_path, *scene);
 
       auto& mesh_renderer = gfxNode.add_component<MeshRenderer>();
       mesh_renderer.m_mesh = mesh;
@@ -919,6 +752,28 @@ namespace gfx {
     }
   }
 
+  // the files an <include> pulls in, which the parser finds in the scene
+  // directory; one that is missing is listed still, the cache key then fails
+  static auto list_xml_includes(std::string const& path, std::string const& directory,
+    std::vector<std::string>& files) noexcept -> void {
+    MappedFile file;
+    if (!file.open(path)) return;
+    std::string_view const text(reinterpret_cast<char const*>(file.data()), file.size());
+    if (text.find("<include") == std::string_view::npos) return;
+    tinyxml2::XMLDocument xml;
+    if (xml.Parse(text.data(), text.size()) != tinyxml2::XML_SUCCESS) return;
+    std::function<void(tinyxml2::XMLElement const*)> visit = [&](tinyxml2::XMLElement const* element) {
+      for (auto child = element->FirstChildElement(); child; child = child->NextSiblingElement()) {
+        char const* filename = child->Attribute("filename");
+        if (std::strcmp(child->Name(), "include") != 0 || filename == nullptr) { visit(child); continue; }
+        std::string const included = directory + "/" + filename;
+        files.push_back(included);
+        list_xml_includes(included, directory, files);
+      }
+    };
+    if (xml.RootElement()) visit(xml.RootElement());
+  }
+
 	auto Scene::load_xml(std::string const& path) noexcept -> void {
     TPM_NAMESPACE::SceneLoader loader;
     try {
@@ -926,7 +781,14 @@ namespace gfx {
       auto scene_xml = loader.loadFromFile(path.c_str());
       xmlLoaderEnv env;
       env.directory = std::filesystem::path(path).parent_path().string();
+      m_sourceFiles.push_back(path);
+      list_xml_includes(path, env.directory, m_sourceFiles);
       PROFILE_SCOPE_STOP(XMLRead);
+      preloadXMLTextures(&scene_xml, &env);
+
+      // shapegroups referenced by instances, in the order of first use
+      std::vector<std::pair<TPM_NAMESPACE::Object const*, std::vector<se::mat4>>> instance_groups;
+      std::unordered_map<TPM_NAMESPACE::Object const*, size_t> group_index;
 
       auto process_xml_node = [&](
         TPM_NAMESPACE::Object* obj
@@ -1055,6 +917,35 @@ namespace gfx {
             break;
           }
           case TPM_NAMESPACE::OT_SHAPE: {
+            // shape groups are only loaded through their instances
+            if (obj->pluginType() == "shapegroup") break;
+            if (obj->pluginType() == "instance") {
+              TPM_NAMESPACE::Object const* group = nullptr;
+              for (auto& child : obj->anonymousChildren())
+                if (child->type() == TPM_NAMESPACE::OT_SHAPE) group = child.get();
+              for (auto& child : obj->namedChildren())
+                if (child.second->type() == TPM_NAMESPACE::OT_SHAPE) group = child.second.get();
+              if (group == nullptr || group->pluginType() != "shapegroup") {
+                se::error("gfx :: xml loader :: instance without a shapegroup: " + obj->id());
+                break;
+              }
+              TPM_NAMESPACE::Transform transform =
+                obj->property("to_world").getTransform();
+              se::mat4 mat = {
+                transform.matrix[0],  transform.matrix[1],  transform.matrix[2],
+                transform.matrix[3],  transform.matrix[4],  transform.matrix[5],
+                transform.matrix[6],  transform.matrix[7],  transform.matrix[8],
+                transform.matrix[9],  transform.matrix[10], transform.matrix[11],
+                transform.matrix[12], transform.matrix[13], transform.matrix[14],
+                transform.matrix[15] };
+              auto iter = group_index.find(group);
+              if (iter == group_index.end()) {
+                iter = group_index.emplace(group, instance_groups.size()).first;
+                instance_groups.emplace_back(group, std::vector<se::mat4>{});
+              }
+              instance_groups[iter->second].second.push_back(mat);
+              break;
+            }
             Node node = create_node(obj->id());
             loadXMLMesh(obj, &env, node, this);
             m_roots.push_back(node);
@@ -1080,6 +971,31 @@ namespace gfx {
         process_xml_node(object.second.get());
       }
 
+      // each shape of a group is loaded only once, and all the instances
+      // of the group become instance transforms of that node
+      for (auto& group : instance_groups) {
+        for (auto& shape : group.first->anonymousChildren()) {
+          if (shape->type() != TPM_NAMESPACE::OT_SHAPE) continue;
+          Node node = create_node(group.first->id());
+          loadXMLMesh(shape.get(), &env, node, this);
+          MeshRenderer* mesh_renderer = node.get_component<MeshRenderer>();
+          if (mesh_renderer != nullptr) {
+            // bake the shape transform into the instances
+            Transform* transformComponent = node.get_component<Transform>();
+            se::mat4 const shape_local = transformComponent->local();
+            mesh_renderer->m_instances.reserve(group.second.size());
+            for (se::mat4 const& instance : group.second)
+              mesh_renderer->m_instances.push_back(instance * shape_local);
+            transformComponent->translation = { 0.f, 0.f, 0.f };
+            transformComponent->scale = { 1.f, 1.f, 1.f };
+            transformComponent->rotation = { 0.f, 0.f, 0.f, 1.f };
+          }
+          m_roots.push_back(node);
+        }
+      }
+
+      if (defaultMeshLoadConfig.deduplication)
+        deduplicate_meshes(*this);
     }
     catch (...) {
       se::error("gfx :: load xml failed!");
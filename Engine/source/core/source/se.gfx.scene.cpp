@@ -6,6 +6,14 @@ namespace se {
   namespace gfx {
     Scene::Scene() { reset(); }
 
+    // the signals of a component feed its change list
+    template<class T>
+    static auto connect_changes(ex::registry& registry, Scene::ChangeList& list) noexcept -> void {
+      registry.on_construct<T>().template connect<&Scene::ChangeList::on_construct>(list);
+      registry.on_update<T>().template connect<&Scene::ChangeList::on_update>(list);
+      registry.on_destroy<T>().template connect<&Scene::ChangeList::on_destroy>(list);
+    }
+
     auto Scene::create_node(std::string const& name) noexcept -> Node {
       auto entity = m_registry.create();
       auto node = Node{ entity, &m_registry };
@@ -20,11 +28,26 @@ namespace se {
       auto node = Node{ entity, &m_registry };
       m_registry.emplace<NodeProperty>(entity, name);
       m_registry.get<NodeProperty>(parent.m_entity).children.push_back(node);
+      m_registry.get<NodeProperty>(entity).parent = parent.m_entity;
       return node;
     }
 
     auto Scene::reset() noexcept -> void {
       m_registry = ex::registry{};
+      m_changes.clear();
+      connect_changes<Transform>(m_registry, m_changes.transforms);
+      connect_changes<MeshRenderer>(m_registry, m_changes.renderers);
+      connect_changes<Light>(m_registry, m_changes.lights);
+      connect_changes<Camera>(m_registry, m_changes.cameras);
+      // every serialized component counts for the incremental save
+      m_fileChanges.entries.clear();
+      connect_changes<NodeProperty>(m_registry, m_fileChanges);
+      connect_changes<Transform>(m_registry, m_fileChanges);
+      connect_changes<MeshRenderer>(m_registry, m_fileChanges);
+      connect_changes<Light>(m_registry, m_fileChanges);
+      connect_changes<Camera>(m_registry, m_fileChanges);
+      if (m_incrementalSave.pending.valid()) m_incrementalSave.pending.wait();
+      m_incrementalSave = {};
       m_roots.clear();
       m_filepath = "";
       m_name = "";
@@ -49,12 +72,25 @@ namespace se {
       m_gpuScene.vertexBuffer.m_buffer->m_job = "Scene vertex buffer";
       m_gpuScene.vertexBuffer.m_buffer->m_usages = rhi::BufferUsageEnum::STORAGE;
 
+      m_gpuScene.geometryArena.positions.job = "Scene arena position buffer";
+      m_gpuScene.geometryArena.positions.usages = rhi::BufferUsageEnum::STORAGE;
+      m_gpuScene.geometryArena.indices.job = "Scene arena index buffer";
+      m_gpuScene.geometryArena.indices.usages = rhi::BufferUsageEnum::STORAGE | rhi::BufferUsageEnum::INDEX;
+      m_gpuScene.geometryArena.vertices.job = "Scene arena vertex buffer";
+      m_gpuScene.geometryArena.vertices.usages = rhi::BufferUsageEnum::STORAGE;
+
       m_gpuScene.cameraBuffer = DynamicVectorBufferView<CameraData>();
       m_gpuScene.cameraBuffer.m_buffer = GFXContext::create_buffer_empty();
       m_gpuScene.cameraBuffer.m_buffer->m_job = "Scene camera buffer";
       m_gpuScene.cameraBuffer.m_buffer->m_usages = rhi::BufferUsageEnum::STORAGE;
       m_gpuScene.cameraBuffer.m_buffer->m_memoryCopyMode = gfx::Buffer::MemoryCopyMode::COHERENT_MAPPING;
 
+      m_gpuScene.viewBuffer = DynamicVectorBufferView<CameraData>();
+      m_gpuScene.viewBuffer.m_buffer = GFXContext::create_buffer_empty();
+      m_gpuScene.viewBuffer.m_buffer->m_job = "Scene view buffer";
+      m_gpuScene.viewBuffer.m_buffer->m_usages = rhi::BufferUsageEnum::STORAGE;
+      m_gpuScene.viewBuffer.m_buffer->m_memoryCopyMode = gfx::Buffer::MemoryCopyMode::COHERENT_MAPPING;
+
       m_gpuScene.geometryBuffer = DynamicVectorBufferView<GeometryDrawData>();
       m_gpuScene.geometryBuffer.m_buffer = GFXContext::create_buffer_empty();
       m_gpuScene.geometryBuffer.m_buffer->m_job = "Scene geometry buffer";
@@ -78,6 +114,15 @@ namespace se {
       m_gpuScene.lightSampler.trailBuffer->m_job = "Scene light-bvh trail buffer";
       m_gpuScene.lightSampler.trailBuffer->m_usages = rhi::BufferUsageEnum::STORAGE;
 
+      m_gpuScene.lightClusters.gridBuffer = GFXContext::create_buffer_empty();
+      m_gpuScene.lightClusters.gridBuffer->m_job = "Scene light cluster grid buffer";
+      m_gpuScene.lightClusters.gridBuffer->m_usages = rhi::BufferUsageEnum::STORAGE;
+      m_gpuScene.lightClusters.gridBuffer->m_memoryCopyMode = gfx::Buffer::MemoryCopyMode::COHERENT_MAPPING;
+
+      m_gpuScene.lightClusters.sphereBuffer = GFXContext::create_buffer_empty();
+      m_gpuScene.lightClusters.sphereBuffer->m_job = "Scene light cluster sphere buffer";
+      m_gpuScene.lightClusters.sphereBuffer->m_usages = rhi::BufferUsageEnum::STORAGE;
+
       m_gpuScene.mediumPool.medium_buffer = DynamicVectorBufferView<Medium::MediumPacket>();
       m_gpuScene.mediumPool.medium_buffer.m_buffer = GFXContext::create_buffer_empty();
       m_gpuScene.mediumPool.medium_buffer.m_buffer->m_job = "Scene medium desc buffer buffer";
@@ -184,7 +229,7 @@ namespace se {
           if (load_path != "") {
             reset();
             std::string extension = Filesys::get_extension(load_path);
-            if (extension == ".gltf")
+            if (extension == ".gltf" || extension == ".glb")
               load_gltf(load_path);
             else {
               se::error("Reload scene with unknown file extension {}", extension);
@@ -230,7 +275,7 @@ namespace se {
       for (auto& iter : m_gpuScene.geometryList) {
         for (auto& index_info : iter.second) {
           int geometryID = index_info.assignedIndex;
-          if (geometryID == index) {
+          if (index >= geometryID && index < geometryID + index_info.length) {
             Node node = { iter.first, &m_registry };
             std::function<void()> fn = std::bind(&draw_scene_node, this, node, nullptr);
             se::editor::EditorContext::set_inspector_callback(fn);
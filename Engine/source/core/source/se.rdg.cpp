@@ -175,6 +175,11 @@ namespace rdg {
     return *this;
   }
 
+  auto TextureInfo::with_view_layers() noexcept -> TextureInfo& {
+    m_perView = true;
+    return *this;
+  }
+
   auto TextureInfo::with_samples(uint32_t _samples) noexcept
     -> TextureInfo& {
     m_samples = _samples;
@@ -542,6 +547,18 @@ namespace rdg {
       { "se_lightbvh_trails",   scene->gpu_scene()->binding_resource_lightbvh_trail() },
       { "se_scene_buffer",      scene->gpu_scene()->binding_resource_sceneinfo() },
 		});
+    // only multiview shaders declare the views
+    if (m_reflection.bindingInfo.find("se_view_buffers") != m_reflection.bindingInfo.end())
+      update_binding(context, "se_view_buffers", scene->gpu_scene()->binding_resource_view());
+    // neither do all shaders read the light clusters
+    auto reflected = [&](char const* name) {
+      return m_reflection.bindingInfo.find(name) != m_reflection.bindingInfo.end(); };
+    if (reflected("se_light_cluster_grid"))
+      update_binding(context, "se_light_cluster_grid", scene->gpu_scene()->binding_resource_light_cluster_grid());
+    if (reflected("se_light_cluster_spheres"))
+      update_binding(context, "se_light_cluster_spheres", scene->gpu_scene()->binding_resource_light_cluster_spheres());
+    if (reflected("se_light_cluster_lists"))
+      update_binding(context, "se_light_cluster_lists", scene->gpu_scene()->binding_resource_light_cluster_lists());
   }
 
   auto PipelinePass::update_bindings(
@@ -747,6 +764,11 @@ namespace rdg {
     return m_passEncoders[context->flightIdx].get();
   }
 
+  auto ComputePass::dispatch_views(rdg::RenderContext* context, RenderData const& renderData,
+    uint32_t x, uint32_t y) noexcept -> void {
+    m_passEncoders[context->flightIdx]->dispatch_workgroups(x, y, renderData.m_graph->m_viewCount);
+  }
+
   auto ComputePass::generate_marker() noexcept -> void {
     m_marker.name = m_identifier;
     m_marker.color = { 0.6, 0.721, 0.780, 1. };
@@ -844,6 +866,18 @@ namespace rdg {
     m_standardSize = { width, height, 1 };
   }
 
+  auto Graph::set_view_count(uint32_t views) noexcept -> void {
+    if (views == 0 || views > 32) {
+      se::error("RDG :: {} views requested, a multiview pass renders 1 to 32", views);
+      return;
+    }
+    m_viewCount = views;
+  }
+
+  auto view_mask(uint32_t views) noexcept -> uint32_t {
+    return views >= 32 ? ~0u : (1u << views) - 1u;
+  }
+
   auto Graph::get_output() noexcept -> std::optional<gfx::TextureHandle> {
     uint32_t id = se::Resources::query_string_uid(m_outputPass);
     auto const& iter_pass = m_passes.find(id);
@@ -860,12 +894,12 @@ namespace rdg {
     return m_renderData.get_texture_id(m_outputResource);
   }
 
-  auto toTextureDescriptor(TextureInfo const& info, se::ivec3 ref_size) noexcept -> rhi::TextureDescriptor {
+  auto toTextureDescriptor(TextureInfo const& info, se::ivec3 ref_size, uint32_t views) noexcept -> rhi::TextureDescriptor {
     uvec3 size = info.get_size(ref_size);
     return rhi::TextureDescriptor{
       size,
       info.m_levels,
-      info.m_layers,
+      info.m_perView ? views : info.m_layers,
       info.m_samples,
       size.z == 1 ? rhi::TextureDimension::TEX2D
                   : rhi::TextureDimension::TEX3D,
@@ -1067,7 +1101,7 @@ namespace rdg {
         if (internal.second.m_type == ResourceInfo::Type::Texture) {
           size_t rid = resourceID++;
           m_textureResources[rid] = TextureResource{};
-          m_textureResources[rid].m_desc = toTextureDescriptor(internal.second.m_info.texture, m_standardSize);
+          m_textureResources[rid].m_desc = toTextureDescriptor(internal.second.m_info.texture, m_standardSize, m_viewCount);
           m_textureResources[rid].m_name = "RDG::" + pass->m_identifier + "::" + internal.first;
           m_textureResources[rid].m_cosumeHistories.push_back({ m_flattenedPasses[i], internal.second.m_info.texture.m_consumeHistories });
           internal.second.m_devirtualizeID = rid;
@@ -1087,7 +1121,7 @@ namespace rdg {
         if (output.second.m_type == ResourceInfo::Type::Texture) {
           size_t rid = resourceID++;
           m_textureResources[rid] = TextureResource{};
-          m_textureResources[rid].m_desc = toTextureDescriptor(output.second.m_info.texture, m_standardSize);
+          m_textureResources[rid].m_desc = toTextureDescriptor(output.second.m_info.texture, m_standardSize, m_viewCount);
           m_textureResources[rid].m_name = "RDG::" + pass->m_identifier + "::" + output.first;
           m_textureResources[rid].m_cosumeHistories.push_back({ m_flattenedPasses[i], output.second.m_info.texture.m_consumeHistories });
           output.second.m_devirtualizeID = rid;
@@ -1112,14 +1146,14 @@ namespace rdg {
           if (!internal.second.m_info.texture.m_reference.get()) {
             size_t rid = internal.second.m_prev->m_devirtualizeID;
             internal.second.m_devirtualizeID = rid;
-            rhi::TextureDescriptor desc = toTextureDescriptor(internal.second.m_info.texture, m_standardSize);
+            rhi::TextureDescriptor desc = toTextureDescriptor(internal.second.m_info.texture, m_standardSize, m_viewCount);
             m_textureResources[rid].m_desc.usage |= desc.usage;
             m_textureResources[rid].m_cosumeHistories.push_back(
               { m_flattenedPasses[i], internal.second.m_info.texture.m_consumeHistories});
           } else {
             size_t rid = resourceID++;
             m_textureResources[rid] = TextureResource{};
-            m_textureResources[rid].m_desc = toTextureDescriptor(internal.second.m_info.texture, m_standardSize);
+            m_textureResources[rid].m_desc = toTextureDescriptor(internal.second.m_info.texture, m_standardSize, m_viewCount);
             m_textureResources[rid].m_cosumeHistories.push_back(
               { m_flattenedPasses[i], internal.second.m_info.texture.m_consumeHistories});
             internal.second.m_devirtualizeID = rid;
@@ -1142,7 +1176,7 @@ namespace rdg {
           }
           size_t rid = inout.second.m_prev->m_devirtualizeID;
           inout.second.m_devirtualizeID = rid;
-          rhi::TextureDescriptor desc = toTextureDescriptor(inout.second.m_info.texture, m_standardSize);
+          rhi::TextureDescriptor desc = toTextureDescriptor(inout.second.m_info.texture, m_standardSize, m_viewCount);
           m_textureResources[rid].m_desc.usage |= desc.usage;
           m_textureResources[rid].m_cosumeHistories.push_back(
             { m_flattenedPasses[i], inout.second.m_info.texture.m_consumeHistories});
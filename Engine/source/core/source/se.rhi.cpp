@@ -2285,6 +2285,12 @@ namespace rhi {
     else {
       *pFeature2Tail = &features12;
       pFeature2Tail = &(features12.pNext);
+      // multiview is a vulkan 1.1 feature, chained with ray tracing already
+      if (m_context->get_context_extensions_flags() &
+        ContextExtensionEnum::MULTIVIEW) {
+        *pFeature2Tail = &features11;
+        pFeature2Tail = &(features11.pNext);
+      }
     }
     if (m_context->get_context_extensions_flags() &
       ContextExtensionEnum::ATOMIC_FLOAT) {
@@ -2298,6 +2304,14 @@ namespace rhi {
       ;
     }
     vkGetPhysicalDeviceFeatures2(m_physicalDevice, &features2);
+    // the query filled in what is supported, request multiview explicitly
+    bool multiview = false;
+    if (m_context->get_context_extensions_flags() &
+      ContextExtensionEnum::MULTIVIEW) {
+      multiview = features11.multiview == VK_TRUE;
+      if (!multiview) se::error("VULKAN :: multiview requested, but not supported!");
+      features11.multiview = multiview ? VK_TRUE : VK_FALSE;
+    }
     if (pNextChainTail == nullptr)
       *pNextChainHead = &features2;
     else
@@ -2314,6 +2328,14 @@ namespace rhi {
     else device->m_debugLayerEnabled = false;
 
     device->m_adapter = this;
+    if (multiview) {
+      VkPhysicalDeviceMultiviewProperties multiviewProperties{
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_PROPERTIES };
+      VkPhysicalDeviceProperties2 prop2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+      prop2.pNext = &multiviewProperties;
+      vkGetPhysicalDeviceProperties2(get_vk_physical_device(), &prop2);
+      device->m_maxMultiviewViews = multiviewProperties.maxMultiviewViewCount;
+    }
     if (vkCreateDevice(get_vk_physical_device(), &createInfo, nullptr,
       &device->m_device) != VK_SUCCESS) {
       se::error("VULKAN :: failed to create logical device!");
@@ -4154,6 +4176,7 @@ namespace rhi {
     switch (format) {
     case se::rhi::BLASTriangleGeometry::VertexFormat::RGB32: return VK_FORMAT_R32G32B32_SFLOAT;
     case se::rhi::BLASTriangleGeometry::VertexFormat::RG32: return VK_FORMAT_R32G32_SFLOAT;
+    case se::rhi::BLASTriangleGeometry::VertexFormat::RGBA16_SNORM: return VK_FORMAT_R16G16B16A16_SNORM;
     default: return VK_FORMAT_R32G32B32_SFLOAT;
     }
   }
@@ -4351,6 +4374,9 @@ namespace rhi {
     std::vector<VkAccelerationStructureInstanceKHR> instances(
       descriptor.instances.size());
     for (int i = 0; i < instances.size(); ++i) {
+      // free slots stay zero, an instance without a reference is inactive
+      if (descriptor.instances[i].blas == nullptr || descriptor.instances[i].mask == 0)
+        continue;
       // frst get the device address of one or more BLASs
       VkAccelerationStructureDeviceAddressInfoKHR addressInfo = {};
       addressInfo.sType =
@@ -5035,6 +5061,18 @@ namespace rhi {
   // ┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛
   //
 
+  // a view mask needs the multiview feature, no more views than the device
+  // draws at once, and a layer per view in every attachment
+  static auto valid_view_mask(Device* device, RenderPassDescriptor const& desc) noexcept -> bool {
+    uint32_t views = 0;
+    for (uint32_t mask = desc.viewMask; mask != 0; mask >>= 1) ++views;
+    if (views > device->m_maxMultiviewViews) return false;
+    for (auto const& colorAttach : desc.colorAttachments)
+      if (colorAttach.view->m_descriptor.arrayLayerCount < views) return false;
+    TextureView const* depth = desc.depthStencilAttachment.view;
+    return depth == nullptr || depth->m_descriptor.arrayLayerCount >= views;
+  }
+
   RenderPass::RenderPass(Device* device, RenderPassDescriptor const& desc)
     : m_device(device) {
     // color attachments
@@ -5097,6 +5135,18 @@ namespace rhi {
     renderPassInfo.pAttachments = attachments.data();
     renderPassInfo.subpassCount = 1;
     renderPassInfo.pSubpasses = &subpass;
+    // the views of a multiview pass are correlated, they see the same scene
+    VkRenderPassMultiviewCreateInfo multiviewInfo{};
+    if (desc.viewMask != 0 && !valid_view_mask(device, desc))
+      se::error("VULKAN :: view mask {} is not drawable, rendering a single view", desc.viewMask);
+    else if (desc.viewMask != 0) {
+      multiviewInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO;
+      multiviewInfo.subpassCount = 1;
+      multiviewInfo.pViewMasks = &desc.viewMask;
+      multiviewInfo.correlationMaskCount = 1;
+      multiviewInfo.pCorrelationMasks = &desc.viewMask;
+      renderPassInfo.pNext = &multiviewInfo;
+    }
     if (vkCreateRenderPass(device->get_vk_device(), &renderPassInfo, nullptr,
       &m_renderPass) != VK_SUCCESS) {
       se::error("VULKAN :: failed to create render pass!");
@@ -2,6 +2,7 @@
 #include <yaml-cpp/yaml.h>
 #include <fstream>
 #include <filesystem>
+#include <atomic>
 #include <imgui.h>
 #include <se.gfx.hpp>
 #ifdef _WIN32
@@ -9,6 +10,9 @@
 #elif defined(__linux__)
     #include <unistd.h>
     #include <limits.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
 #endif
 
 namespace glfw_static {
@@ -805,9 +809,78 @@ namespace impl {
     return false;
   }
   
+  MappedFile::~MappedFile() { close(); }
+  MappedFile::MappedFile(MappedFile&& f) noexcept
+    : m_data(f.m_data), m_size(f.m_size), m_mapping(f.m_mapping) {
+    f.m_data = nullptr; f.m_size = 0; f.m_mapping = nullptr;
+  }
+  auto MappedFile::operator=(MappedFile&& f) noexcept -> MappedFile& {
+    if (this == &f) return *this;
+    close(); m_data = f.m_data; m_size = f.m_size; m_mapping = f.m_mapping;
+    f.m_data = nullptr; f.m_size = 0; f.m_mapping = nullptr; return *this;
+  }
+
+  auto MappedFile::open(std::string const& path) noexcept -> bool {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileW(Platform::string_cast(path).c_str(), GENERIC_READ,
+      FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      se::error("Core.IO :: MappedFile :: failed to open '{}'", path); return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) { CloseHandle(file); return false; }
+    // an empty file can't be mapped, it is an empty view instead
+    if (size.QuadPart == 0) { CloseHandle(file); return true; }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) {
+      se::error("Core.IO :: MappedFile :: failed to map '{}'", path); return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+      CloseHandle(mapping);
+      se::error("Core.IO :: MappedFile :: failed to map '{}'", path); return false;
+    }
+    m_mapping = mapping;
+    m_data = static_cast<std::byte const*>(view);
+    m_size = size_t(size.QuadPart);
+#else
+    int const fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      se::error("Core.IO :: MappedFile :: failed to open '{}'", path); return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) { ::close(fd); return false; }
+    // an empty file can't be mapped, it is an empty view instead
+    if (info.st_size == 0) { ::close(fd); return true; }
+    void* view = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+      se::error("Core.IO :: MappedFile :: failed to map '{}'", path); return false;
+    }
+    m_data = static_cast<std::byte const*>(view);
+    m_size = size_t(info.st_size);
+#endif
+    return true;
+  }
+
+  auto MappedFile::close() noexcept -> void {
+    if (m_data != nullptr) {
+#ifdef _WIN32
+      UnmapViewOfFile(m_data);
+      CloseHandle(m_mapping);
+#else
+      munmap(const_cast<std::byte*>(m_data), m_size);
+#endif
+    }
+    m_data = nullptr; m_size = 0; m_mapping = nullptr;
+  }
+  
   auto Resources::query_runtime_uid() noexcept -> UID {
-    static UID counter = 1'000'000'000;  // Avoid collision with file-based hashes
-    return counter++;
+    // Avoid collision with file-based hashes, resources are created from any thread
+    static std::atomic<UID> counter{ 1'000'000'000 };
+    return counter.fetch_add(1, std::memory_order_relaxed);
   }
 
   auto Resources::query_string_uid(std::string const& str) noexcept -> UID {
@@ -0,0 +1,159 @@
+#include <se.gfx.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+// EntityMap against std::unordered_map: random inserts, lookups and erases
+// on recycled entities must leave both holding the same records, and the
+// swap-remove erase must keep erase-while-iterating loops visiting every
+// record once. Then times both; pass entity counts to time other sizes,
+//   test-entity-map 10000 100000 1000000
+// reproduces the table the EntityMap change was measured with.
+
+namespace {
+  int failures = 0;
+
+  auto expect(bool condition, char const* what) -> void {
+    if (condition) return;
+    std::fprintf(stderr, "FAILED :: %s\n", what);
+    ++failures;
+  }
+
+  using Map = se::gfx::EntityMap<int>;
+  using Hashed = std::unordered_map<ex::entity, int>;
+
+  auto same(Map const& map, Hashed const& hashed) -> bool {
+    if (map.size() != hashed.size()) return false;
+    for (auto const& [entity, value] : map) {
+      auto iter = hashed.find(entity);
+      if (iter == hashed.end() || iter->second != value) return false;
+    }
+    return true;
+  }
+
+  // destroyed entities come back with a new version, the stale handle
+  // must not find the record of the new one
+  auto recycled() -> void {
+    ex::registry registry;
+    Map map;
+    ex::entity const old = registry.create();
+    map[old] = 1;
+    map.erase(old);
+    registry.destroy(old);
+    ex::entity const fresh = registry.create();
+    expect(ex::to_entity(fresh) == ex::to_entity(old) && fresh != old, "entity recycled");
+    map[fresh] = 2;
+    expect(!map.contains(old) && map.find(old) == map.end(), "stale entity not found");
+    expect(map.erase(old) == 0 && map.size() == 1, "stale entity not erased");
+    expect(map.find(fresh)->second == 2, "recycled entity found");
+  }
+
+  auto randomized() -> void {
+    ex::registry registry;
+    std::mt19937 random(7);
+    std::vector<ex::entity> alive;
+    Map map;
+    Hashed hashed;
+    for (int step = 0; step < 20000; ++step) {
+      int const op = int(random() % 4);
+      if (op == 0 || alive.empty()) {
+        ex::entity const entity = registry.create();
+        alive.push_back(entity);
+        map[entity] = step;
+        hashed[entity] = step;
+      }
+      else {
+        size_t const at = random() % alive.size();
+        ex::entity const entity = alive[at];
+        if (op == 1) {
+          map[entity] += 1;
+          hashed[entity] += 1;
+        }
+        else if (op == 2) {
+          expect(map.erase(entity) == hashed.erase(entity), "erase count");
+          registry.destroy(entity);
+          alive[at] = alive.back();
+          alive.pop_back();
+        }
+        else {
+          auto iter = map.find(entity);
+          expect(iter != map.end() && iter->second == hashed[entity], "lookup");
+        }
+      }
+    }
+    expect(same(map, hashed), "randomized contents");
+
+    // the loop shape the scene uses to drop records while walking them
+    size_t const before = map.size();
+    size_t visited = 0;
+    for (auto iter = map.begin(); iter != map.end();) {
+      ++visited;
+      if (iter->second % 2 == 0) {
+        hashed.erase(iter->first);
+        iter = map.erase(iter);
+      }
+      else ++iter;
+    }
+    expect(visited == before, "every record visited once");
+    expect(same(map, hashed), "erase while iterating");
+    for (auto const& [entity, value] : map) expect(value % 2 != 0, "every even record erased");
+  }
+
+  template <class F>
+  auto time_ms(F&& body) -> double {
+    auto const start = std::chrono::steady_clock::now();
+    body();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  // insert, shuffled lookup, iterate and shuffled erase, unordered_map first
+  template <class M>
+  auto measure(std::vector<ex::entity> const& entities, std::vector<ex::entity> const& shuffled,
+    double (&ms)[4]) -> long long {
+    long long sum = 0;
+    M map;
+    ms[0] = time_ms([&] { for (ex::entity entity : entities) map[entity] = int(ex::to_entity(entity)); });
+    ms[1] = time_ms([&] { for (ex::entity entity : shuffled) sum += map.find(entity)->second; });
+    ms[2] = time_ms([&] { for (auto const& record : map) sum += record.second; });
+    ms[3] = time_ms([&] { for (ex::entity entity : shuffled) map.erase(entity); });
+    return sum + (long long)map.size();
+  }
+
+  auto bench(size_t count) -> void {
+    ex::registry registry;
+    std::vector<ex::entity> entities(count);
+    registry.create(entities.begin(), entities.end());
+    std::vector<ex::entity> shuffled = entities;
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(11));
+    // the heap the first map leaves behind slows the second one, so the
+    // two take turns and the best of the rounds is kept
+    double hashed[4], dense[4];
+    std::fill(std::begin(hashed), std::end(hashed), 1e30);
+    std::fill(std::begin(dense), std::end(dense), 1e30);
+    for (int round = 0; round < 3; ++round) {
+      double ms[4];
+      // the sums keep the loops from being optimized away
+      long long const a = measure<Hashed>(entities, shuffled, ms);
+      for (int i = 0; i < 4; ++i) hashed[i] = std::min(hashed[i], ms[i]);
+      long long const b = measure<Map>(entities, shuffled, ms);
+      for (int i = 0; i < 4; ++i) dense[i] = std::min(dense[i], ms[i]);
+      expect(a == b, "timed maps agree");
+    }
+    std::printf("%8zu  insert %6.2f / %6.2f  lookup %6.2f / %6.2f  iterate %6.2f / %6.2f  erase %6.2f / %6.2f\n",
+      count, hashed[0], dense[0], hashed[1], dense[1], hashed[2], dense[2], hashed[3], dense[3]);
+  }
+}
+
+int main(int argc, char** argv) {
+  recycled();
+  randomized();
+  std::printf("entity map timings, unordered_map / EntityMap, ms\n");
+  if (argc < 2) bench(10000);
+  for (int i = 1; i < argc; ++i) bench(size_t(std::strtoull(argv[i], nullptr, 10)));
+  if (failures == 0) std::printf("entity map :: all passed\n");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+#include <se.gfx.hpp>
+#include "se.gfx.scene-loader.hpp"
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Round trips of glTF accessors through read_gltf_floats: values written
+// into a buffer in some layout must read back as the dense floats.
+
+namespace {
+  int failures = 0;
+
+  auto expect(bool condition, char const* what) -> void {
+    if (condition) return;
+    std::fprintf(stderr, "FAILED :: %s\n", what);
+    ++failures;
+  }
+
+  auto same(std::vector<float> const& a, std::vector<float> const& b) -> bool {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+  }
+
+  // append the bytes of a value to the buffer, returning their offset
+  template <class T>
+  auto put(tinygltf::Buffer& buffer, T const& value) -> size_t {
+    size_t const offset = buffer.data.size();
+    buffer.data.resize(offset + sizeof(T));
+    std::memcpy(buffer.data.data() + offset, &value, sizeof(T));
+    return offset;
+  }
+
+  auto add_view(tinygltf::Model& model, size_t offset, size_t length, int stride = 0) -> int {
+    tinygltf::BufferView view;
+    view.buffer = 0;
+    view.byteOffset = offset;
+    view.byteLength = length;
+    view.byteStride = stride;
+    model.bufferViews.push_back(view);
+    return int(model.bufferViews.size()) - 1;
+  }
+
+  auto add_accessor(tinygltf::Model& model, int view, size_t offset, size_t count,
+    int type, int component = TINYGLTF_COMPONENT_TYPE_FLOAT) -> int {
+    tinygltf::Accessor accessor;
+    accessor.bufferView = view;
+    accessor.byteOffset = offset;
+    accessor.count = count;
+    accessor.type = type;
+    accessor.componentType = component;
+    accessor.sparse.isSparse = false;
+    model.accessors.push_back(accessor);
+    return int(model.accessors.size()) - 1;
+  }
+
+  // positions and uvs of three vertices in one interleaved view
+  auto interleaved() -> void {
+    tinygltf::Model model;
+    model.buffers.emplace_back();
+    std::vector<float> const positions = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+    std::vector<float> const uvs = { .1f, .2f, .3f, .4f, .5f, .6f };
+    for (int i = 0; i < 3; ++i) {
+      for (int c = 0; c < 3; ++c) put(model.buffers[0], positions[i * 3 + c]);
+      for (int c = 0; c < 2; ++c) put(model.buffers[0], uvs[i * 2 + c]);
+    }
+    int const view = add_view(model, 0, model.buffers[0].data.size(), 20);
+    int const position = add_accessor(model, view, 0, 3, TINYGLTF_TYPE_VEC3);
+    int const uv = add_accessor(model, view, 12, 3, TINYGLTF_TYPE_VEC2);
+    expect(same(se::gfx::read_gltf_floats(model, position, 3), positions), "interleaved positions");
+    expect(same(se::gfx::read_gltf_floats(model, uv, 2), uvs), "interleaved uvs");
+    // components past the accessor type take the fill
+    expect(same(se::gfx::read_gltf_floats(model, uv, 3, 1.f),
+      { .1f, .2f, 1.f, .3f, .4f, 1.f, .5f, .6f, 1.f }), "filled components");
+  }
+
+  // a padded stride whose last element ends exactly at the buffer end,
+  // and normalized shorts in a view starting past the buffer begin
+  auto strided() -> void {
+    tinygltf::Model model;
+    model.buffers.emplace_back();
+    std::vector<float> const values = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    for (int i = 0; i < 3; ++i) {
+      for (int c = 0; c < 3; ++c) put(model.buffers[0], values[i * 3 + c]);
+      if (i < 2) put(model.buffers[0], -1.f);
+    }
+    int const view = add_view(model, 0, model.buffers[0].data.size(), 16);
+    int const accessor = add_accessor(model, view, 0, 3, TINYGLTF_TYPE_VEC3);
+    expect(same(se::gfx::read_gltf_floats(model, accessor, 3), values), "strided vec3");
+    // one more element would read past the buffer and is refused
+    model.accessors[accessor].count = 4;
+    expect(se::gfx::read_gltf_floats(model, accessor, 3).empty(), "strided overrun refused");
+
+    size_t const begin = put(model.buffers[0], uint16_t(0));
+    put(model.buffers[0], uint16_t(0xffff));
+    put(model.buffers[0], uint16_t(0x8000));
+    int const shorts = add_view(model, begin, 6);
+    int const normalized = add_accessor(model, shorts, 0, 3, TINYGLTF_TYPE_SCALAR,
+      TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT);
+    model.accessors[normalized].normalized = true;
+    std::vector<float> const unorm = se::gfx::read_gltf_floats(model, normalized, 1);
+    expect(unorm.size() == 3 && unorm[0] == 0.f && unorm[1] == 1.f
+      && unorm[2] > .5f && unorm[2] < .5001f, "normalized shorts");
+  }
+
+  // sparse substitution over a base view and over zeros, with the indices
+  // as the last bytes of the buffer
+  auto sparse() -> void {
+    tinygltf::Model model;
+    model.buffers.emplace_back();
+    for (float v : { 0.f, 0.f, 0.f, 1.f, 1.f, 1.f, 2.f, 2.f, 2.f, 3.f, 3.f, 3.f })
+      put(model.buffers[0], v);
+    size_t const values = model.buffers[0].data.size();
+    for (float v : { 7.f, 7.f, 7.f, 9.f, 9.f, 9.f }) put(model.buffers[0], v);
+    size_t const indices = put(model.buffers[0], uint8_t(1));
+    put(model.buffers[0], uint8_t(3));
+    int const base_view = add_view(model, 0, values);
+    int const values_view = add_view(model, values, indices - values);
+    int const indices_view = add_view(model, indices, 2);
+
+    auto make_sparse = [&](int base) {
+      int const accessor = add_accessor(model, base, 0, 4, TINYGLTF_TYPE_VEC3);
+      auto& sparse = model.accessors[accessor].sparse;
+      sparse.isSparse = true;
+      sparse.count = 2;
+      sparse.indices.bufferView = indices_view;
+      sparse.indices.byteOffset = 0;
+      sparse.indices.componentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+      sparse.values.bufferView = values_view;
+      sparse.values.byteOffset = 0;
+      return accessor;
+    };
+    expect(same(se::gfx::read_gltf_floats(model, make_sparse(base_view), 3),
+      { 0, 0, 0, 7, 7, 7, 2, 2, 2, 9, 9, 9 }), "sparse over a view");
+    expect(same(se::gfx::read_gltf_floats(model, make_sparse(-1), 3),
+      { 0, 0, 0, 7, 7, 7, 0, 0, 0, 9, 9, 9 }), "sparse over zeros");
+  }
+}
+
+int main() {
+  interleaved();
+  strided();
+  sparse();
+  if (failures == 0) std::printf("gltf accessors :: all passed\n");
+  return failures == 0 ? 0 : 1;
+}
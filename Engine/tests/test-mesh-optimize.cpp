@@ -0,0 +1,168 @@
+#include <se.gfx.hpp>
+#include "se.gfx.scene-loader.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// The vertex cache and fetch reorders must only permute: every triangle,
+// with its winding and the data of its vertices, has to survive them.
+
+namespace {
+  int failures = 0;
+
+  auto expect(bool condition, char const* what) -> void {
+    if (condition) return;
+    std::fprintf(stderr, "FAILED :: %s\n", what);
+    ++failures;
+  }
+
+  // a grid of quads with shuffled triangles, plus a degenerate triangle,
+  // a repeated one and a vertex no triangle uses
+  auto grid(size_t side, uint32_t seed) -> std::vector<uint32_t> {
+    std::vector<std::vector<uint32_t>> triangles;
+    for (uint32_t y = 0; y + 1 < side; ++y)
+      for (uint32_t x = 0; x + 1 < side; ++x) {
+        uint32_t const v = uint32_t(y * side + x);
+        triangles.push_back({ v, v + 1, uint32_t(v + side) });
+        triangles.push_back({ v + 1, uint32_t(v + side + 1), uint32_t(v + side) });
+      }
+    triangles.push_back({ 0, 0, 1 });
+    triangles.push_back(triangles[3]);
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(seed));
+    std::vector<uint32_t> indices;
+    for (auto const& triangle : triangles) indices.insert(indices.end(), triangle.begin(), triangle.end());
+    return indices;
+  }
+
+  // the triangles as the data of their corners, each rotated to start at
+  // its smallest corner so the winding is kept, then sorted
+  auto triangle_set(std::vector<uint32_t> const& indices, size_t first, size_t count,
+    std::vector<float> const& data, size_t stride) -> std::vector<std::vector<float>> {
+    std::vector<std::vector<float>> triangles;
+    for (size_t t = 0; t < count / 3; ++t) {
+      std::vector<float> corners[3];
+      for (int k = 0; k < 3; ++k) {
+        uint32_t const v = indices[first + t * 3 + k];
+        corners[k].assign(data.begin() + v * stride, data.begin() + (v + 1) * stride);
+      }
+      int const start = int(std::min_element(corners, corners + 3) - corners);
+      std::vector<float> triangle;
+      for (int k = 0; k < 3; ++k)
+        triangle.insert(triangle.end(), corners[(start + k) % 3].begin(), corners[(start + k) % 3].end());
+      triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+  }
+
+  auto vertex_ids(std::vector<uint32_t> const& indices) -> std::vector<float> {
+    std::vector<float> ids(*std::max_element(indices.begin(), indices.end()) + 2);
+    for (size_t v = 0; v < ids.size(); ++v) ids[v] = float(v);
+    return ids;
+  }
+
+  // the index passes alone, the vertices are identified by their index
+  auto reorders() -> void {
+    std::vector<uint32_t> indices = grid(24, 3);
+    std::vector<float> const ids = vertex_ids(indices);
+    size_t const vertex_count = ids.size();
+    auto const before = triangle_set(indices, 0, indices.size(), ids, 1);
+
+    se::gfx::optimize_vertex_cache(indices.data(), indices.size(), vertex_count);
+    expect(triangle_set(indices, 0, indices.size(), ids, 1) == before, "vertex cache keeps the triangles");
+
+    std::vector<uint32_t> remap = se::gfx::optimize_vertex_fetch(indices.data(), indices.size(), vertex_count);
+    std::vector<uint32_t> sorted = remap;
+    std::sort(sorted.begin(), sorted.end());
+    bool permutation = true;
+    for (size_t v = 0; v < sorted.size(); ++v) permutation &= sorted[v] == v;
+    expect(permutation && remap.size() == vertex_count, "vertex fetch remap is a permutation");
+    // the remapped ids are the old vertices seen through the new numbering
+    std::vector<float> moved(vertex_count);
+    for (size_t v = 0; v < vertex_count; ++v) moved[remap[v]] = ids[v];
+    expect(triangle_set(indices, 0, indices.size(), moved, 1) == before, "vertex fetch keeps the triangles");
+    uint32_t next = 0;
+    bool first_use = true;
+    for (uint32_t v : indices) {
+      first_use &= v <= next;
+      if (v == next) ++next;
+    }
+    expect(first_use, "vertices numbered in order of first use");
+  }
+
+  // the import stage over two primitives, moving positions and attributes
+  auto import_stage() -> void {
+    se::gfx::Mesh mesh;
+    std::vector<uint32_t> indices;
+    std::vector<float> positions, vertices;
+    size_t const stride = 4;
+    size_t base_vertex = 0;
+    for (size_t side : { 9, 13 }) {
+      std::vector<uint32_t> const local = grid(side, uint32_t(side));
+      size_t const vertex_count = side * side + 1;
+      se::gfx::Mesh::MeshPrimitive& primitive = mesh.m_primitives.emplace_back();
+      primitive.offset = indices.size();
+      primitive.size = local.size();
+      primitive.baseVertex = base_vertex;
+      primitive.numVertex = vertex_count;
+      indices.insert(indices.end(), local.begin(), local.end());
+      for (size_t v = 0; v < vertex_count; ++v) {
+        float const id = float(base_vertex + v);
+        positions.insert(positions.end(), { id, id * 2.f, -id });
+        vertices.insert(vertices.end(), { id * .5f, id + 1.f, 0.f, -id * .25f });
+      }
+      base_vertex += vertex_count;
+    }
+    // positions and attributes of a vertex side by side
+    auto joined = [&]() {
+      std::vector<float> data;
+      for (size_t v = 0; v < base_vertex; ++v) {
+        data.insert(data.end(), positions.begin() + v * 3, positions.begin() + v * 3 + 3);
+        data.insert(data.end(), vertices.begin() + v * stride, vertices.begin() + (v + 1) * stride);
+      }
+      return data;
+    };
+    auto primitive_sets = [&]() {
+      std::vector<float> const data = joined();
+      std::vector<std::vector<std::vector<float>>> sets;
+      for (auto const& primitive : mesh.m_primitives) {
+        std::vector<uint32_t> global(indices.begin() + primitive.offset,
+          indices.begin() + primitive.offset + primitive.size);
+        for (uint32_t& v : global) v += uint32_t(primitive.baseVertex);
+        sets.push_back(triangle_set(global, 0, global.size(), data, 3 + stride));
+      }
+      return sets;
+    };
+    auto const before = primitive_sets();
+    std::vector<float> vertex_set = joined();
+
+    se::gfx::MeshLoaderConfig config;
+    config.optimizeVertexOrder = true;
+    se::gfx::optimize_mesh(mesh, positions, vertices, indices, config);
+
+    expect(primitive_sets() == before, "import stage keeps the triangles of every primitive");
+    bool in_range = true;
+    for (auto const& primitive : mesh.m_primitives)
+      for (size_t i = 0; i < primitive.size; ++i)
+        in_range &= indices[primitive.offset + i] < primitive.numVertex;
+    expect(in_range, "indices stay inside their primitive");
+    // vertices are moved and not lost, the unused ones included
+    std::vector<float> after = joined();
+    auto records = [&](std::vector<float> const& data) {
+      std::vector<std::vector<float>> out;
+      for (size_t v = 0; v < base_vertex; ++v)
+        out.emplace_back(data.begin() + v * (3 + stride), data.begin() + (v + 1) * (3 + stride));
+      std::sort(out.begin(), out.end());
+      return out;
+    };
+    expect(records(after) == records(vertex_set), "import stage keeps every vertex");
+  }
+}
+
+int main() {
+  reorders();
+  import_stage();
+  if (failures == 0) std::printf("mesh optimize :: all passed\n");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+#include "ex.tinyprbrtloader.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Import parses files in parallel and splices them back in statement
+// order, so a scene written with Import must load into the same entities
+// as the one written with Include, as long as the imported files keep
+// their graphics state changes inside attribute blocks, as pbrt asks.
+// Transforms are given as matrices, which is what the loader reads.
+
+namespace {
+  using namespace tiny_pbrt_loader;
+
+  // every file of the scene, "@" stands for the directive under test
+  struct SceneFile {
+    char const* path;
+    char const* text;
+  };
+
+  SceneFile const files[] = {
+    { "main.pbrt", R"(WorldBegin
+MakeNamedMaterial "plastic" "string type" "coateddiffuse"
+Material "diffuse"
+AttributeBegin
+  ConcatTransform [2 0 0 0  0 2 0 0  0 0 2 0  0 0 0 1]
+  @ "geo/a.pbrt"
+AttributeEnd
+Shape "cylinder" "float radius" 7
+@ "geo/nested.pbrt"
+Material "conductor"
+ObjectBegin "obj"
+  @ "geo/object.pbrt"
+ObjectEnd
+AttributeBegin
+  ConcatTransform [1 0 0 0  0 1 0 0  0 0 1 0  0 2 0 1]
+  ObjectInstance "obj"
+AttributeEnd
+NamedMaterial "metal"
+Shape "sphere" "float radius" 8
+)" },
+    // the first sphere takes the material of the main file, the second its own
+    { "geo/a.pbrt", R"(AttributeBegin
+  ConcatTransform [1 0 0 0  0 1 0 0  0 0 1 0  1 0 0 1]
+  Shape "sphere" "float radius" 1
+  Material "conductor"
+  Shape "sphere" "float radius" 2
+AttributeEnd
+)" },
+    { "geo/nested.pbrt", R"(AttributeBegin
+  Material "dielectric"
+  Shape "disk" "float radius" 3
+  @ "geo/inner.pbrt"
+  Shape "disk" "float radius" 4
+AttributeEnd
+)" },
+    // a named material defined in an import is seen by the main file
+    { "geo/inner.pbrt", R"(AttributeBegin
+  NamedMaterial "plastic"
+  ConcatTransform [0 1 0 0  -1 0 0 0  0 0 1 0  0 0 0 1]
+  Shape "disk" "float radius" 5
+AttributeEnd
+MakeNamedMaterial "metal" "string type" "conductor"
+)" },
+    // the object is closed by the main file, which restores the state
+    { "geo/object.pbrt", R"(Shape "sphere" "float radius" 6
+Material "coateddiffuse"
+Shape "sphere" "float radius" 9
+)" },
+  };
+
+  auto write_scene(std::filesystem::path const& root, char const* directive) -> void {
+    for (SceneFile const& file : files) {
+      std::string text = file.text;
+      for (size_t at = text.find('@'); at != std::string::npos; at = text.find('@', at))
+        text.replace(at, 1, directive);
+      std::filesystem::path const path = root / file.path;
+      std::filesystem::create_directories(path.parent_path());
+      std::ofstream(path, std::ios::binary) << text;
+    }
+  }
+
+  auto describe_transform(std::ostringstream& out, TransformData const& transform) -> void {
+    for (auto const& row : transform.m)
+      for (Float v : row) out << ' ' << v;
+  }
+
+  auto describe_shape(BasicScene const& scene, ShapeSceneEntity const& shape) -> std::string {
+    std::ostringstream out;
+    out << shape.name << " r=" << shape.dict.GetOneFloat("radius", 0) << " material=";
+    // indices depend on the order materials were added, their types do not
+    if (shape.materialIndex < 0) out << "named";
+    else out << scene.materials[shape.materialIndex].name;
+    describe_transform(out, shape.renderFromObject);
+    return out.str();
+  }
+
+  // the entities of a scene, one line each, in an order independent of
+  // the order materials and definitions were merged in
+  auto describe(BasicScene const& scene) -> std::vector<std::string> {
+    std::vector<std::string> lines;
+    for (ShapeSceneEntity const& shape : scene.shapes)
+      lines.push_back("shape " + describe_shape(scene, shape));
+    std::vector<std::string> definitions;
+    for (InstanceDefinitionSceneEntity const& definition : scene.instanceDefinitions) {
+      std::string line = "object " + definition.name;
+      for (ShapeSceneEntity const& shape : definition.shapes)
+        line += " | " + describe_shape(scene, shape);
+      definitions.push_back(line);
+    }
+    for (InstanceSceneEntity const& instance : scene.instances) {
+      std::ostringstream out;
+      out << "instance " << instance.name;
+      describe_transform(out, instance.renderFromInstance);
+      lines.push_back(out.str());
+    }
+    std::vector<std::string> named;
+    for (auto const& [name, material] : scene.namedMaterials)
+      named.push_back("named " + name + " " + material.dict.GetOneString("type", ""));
+    std::sort(definitions.begin(), definitions.end());
+    std::sort(named.begin(), named.end());
+    lines.insert(lines.end(), definitions.begin(), definitions.end());
+    lines.insert(lines.end(), named.begin(), named.end());
+    return lines;
+  }
+}
+
+int main() {
+  std::filesystem::path const root =
+    std::filesystem::temp_directory_path() / "se-test-pbrt-import";
+  std::filesystem::remove_all(root);
+  write_scene(root / "include", "Include");
+  write_scene(root / "import", "Import");
+
+  std::unique_ptr<BasicScene> included = load_scene_from_file((root / "include" / "main.pbrt").string());
+  std::vector<std::string> const expected = describe(*included);
+  int failures = 0;
+  // parsed in parallel, so run it a few times to shake out the order
+  for (int run = 0; run < 8; ++run) {
+    std::unique_ptr<BasicScene> imported = load_scene_from_file((root / "import" / "main.pbrt").string());
+    std::vector<std::string> const lines = describe(*imported);
+    if (lines == expected) continue;
+    ++failures;
+    std::fprintf(stderr, "FAILED :: run %d, import and include differ\n", run);
+    for (size_t i = 0; i < std::max(lines.size(), expected.size()); ++i) {
+      std::string const a = i < expected.size() ? expected[i] : "<none>";
+      std::string const b = i < lines.size() ? lines[i] : "<none>";
+      if (a != b) std::fprintf(stderr, "  include: %s\n  import:  %s\n", a.c_str(), b.c_str());
+    }
+  }
+  // the scene is not trivially equal, check it holds what the files say
+  if (expected.size() != 11 || included->shapes.size() != 7) {
+    ++failures;
+    std::fprintf(stderr, "FAILED :: expected 7 shapes and 11 entities, got %zu and %zu\n",
+      included->shapes.size(), expected.size());
+  }
+  std::filesystem::remove_all(root);
+  if (failures == 0) std::printf("pbrt import :: all passed\n");
+  return failures == 0 ? 0 : 1;
+}